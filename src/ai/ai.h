@@ -21,7 +21,7 @@
 
 #pragma once
 
-#define AI_API_VERSION 7
+#define AI_API_VERSION 8
 
 /**
  * @brief Forward declaration of entity type, since
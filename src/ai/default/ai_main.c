@@ -55,9 +55,10 @@ ai_locals_t *Ai_GetLocals(const g_entity_t *ent) {
 }
 
 /**
- * @brief
+ * @brief Populates the line of sight trace from the bot's eyes to the specified entity.
+ * @return False if the bot isn't even facing the entity, and so can not see it.
  */
-static _Bool Ai_CanSee(const g_entity_t *self, const g_entity_t *other) {
+static _Bool Ai_CanSee_Request(const g_entity_t *self, const g_entity_t *other, g_trace_request_t *req) {
 
 	// see if we're even facing the object
 	ai_locals_t *ai = Ai_GetLocals(self);
@@ -70,13 +71,43 @@ static _Bool Ai_CanSee(const g_entity_t *self, const g_entity_t *other) {
 		return false;
 	}
 
-	cm_trace_t tr = aim.gi->Trace(ai->eye_origin, other->s.origin, Box3_Zero(), self, CONTENTS_MASK_CLIP_PROJECTILE);
+	*req = (g_trace_request_t) {
+		.start = ai->eye_origin,
+		.end = other->s.origin,
+		.bounds = Box3_Zero(),
+		.skip = self,
+		.contents = CONTENTS_MASK_CLIP_PROJECTILE
+	};
 
-	if (tr.ent == other) {
+	return true;
+}
+
+/**
+ * @return True if the specified line of sight trace reached the specified entity.
+ */
+static _Bool Ai_CanSee_Trace(const g_entity_t *other, const cm_trace_t *tr) {
+
+	if (tr->ent == other) {
 		return true;
 	}
 
-	return Box3_ContainsPoint(Box3_Expand(other->abs_bounds, 1.f), tr.end);
+	return Box3_ContainsPoint(Box3_Expand(other->abs_bounds, 1.f), tr->end);
+}
+
+/**
+ * @brief
+ */
+static _Bool Ai_CanSee(const g_entity_t *self, const g_entity_t *other) {
+
+	g_trace_request_t req;
+
+	if (!Ai_CanSee_Request(self, other, &req)) {
+		return false;
+	}
+
+	const cm_trace_t tr = aim.gi->Trace(req.start, req.end, req.bounds, req.skip, req.contents);
+
+	return Ai_CanSee_Trace(other, &tr);
 }
 
 /**
@@ -96,6 +127,38 @@ static inline _Bool Ai_CanTarget(const g_entity_t *self, const g_entity_t *other
 	return Ai_IsTargetable(self, other) && Ai_CanSee(self, other);
 }
 
+/**
+ * @return The first client that the bot can target, or NULL. Line of sight to every
+ * targetable client is resolved in a single trace batch.
+ */
+static g_entity_t *Ai_FindTarget(const g_entity_t *self) {
+
+	g_entity_t *candidates[MAX_CLIENTS];
+	g_trace_request_t requests[MAX_CLIENTS];
+	cm_trace_t traces[MAX_CLIENTS];
+
+	size_t count = 0;
+
+	for (int32_t i = 1; i <= sv_max_clients->integer; i++) {
+
+		g_entity_t *ent = ENTITY_FOR_NUM(i);
+
+		if (Ai_IsTargetable(self, ent) && Ai_CanSee_Request(self, ent, &requests[count])) {
+			candidates[count++] = ent;
+		}
+	}
+
+	aim.gi->TraceBatch(requests, traces, count);
+
+	for (size_t i = 0; i < count; i++) {
+		if (Ai_CanSee_Trace(candidates[i], &traces[i])) {
+			return candidates[i];
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * @brief Executes a console command as if the bot typed it.
  */
@@ -595,18 +658,7 @@ static uint32_t Ai_FuncGoal_Hunt(g_entity_t *self, pm_cmd_t *cmd) {
 	}
 
 	// we lost our enemy, start looking for a new one
-	g_entity_t *player = NULL;
-
-	for (int32_t i = 1; i <= sv_max_clients->integer; i++) {
-
-		g_entity_t *ent = ENTITY_FOR_NUM(i);
-
-		if (Ai_CanTarget(self, ent)) {
-
-			player = ent;
-			break;
-		}
-	}
+	g_entity_t *player = Ai_FindTarget(self);
 
 	// found one, set it up
 	if (player) {
@@ -1535,6 +1587,8 @@ static void Ai_State(uint32_t frame_num) {
  */
 static void Ai_Frame(void) {
 
+	const uint64_t start = aim.gi->ProfileBegin();
+
 	if (ai_level.time > 1000) {
 		if (!ai_level.load_finished) {
 
@@ -1542,6 +1596,8 @@ static void Ai_Frame(void) {
 			ai_level.load_finished = true;
 		}
 	}
+
+	aim.gi->ProfileEnd("Ai_Frame", start);
 }
 
 /**
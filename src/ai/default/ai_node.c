@@ -118,7 +118,36 @@ guint Ai_Node_Count(void) {
 }
 
 /**
- * @brief
+ * @brief A node within range of Ai_Node_FindClosest.
+ */
+typedef struct {
+	ai_node_id_t id;
+	float dist;
+} ai_node_candidate_t;
+
+/**
+ * @brief GCompareFunc for ai_node_candidate_t, ordering by distance and then by id.
+ */
+static gint Ai_Node_CandidateCmp(gconstpointer a, gconstpointer b) {
+
+	const ai_node_candidate_t *c0 = (const ai_node_candidate_t *) a;
+	const ai_node_candidate_t *c1 = (const ai_node_candidate_t *) b;
+
+	if (c0->dist != c1->dist) {
+		return c0->dist < c1->dist ? -1 : 1;
+	}
+
+	return c0->id < c1->id ? -1 : c0->id > c1->id;
+}
+
+/**
+ * @brief The number of candidate nodes tested for visibility in each trace batch.
+ */
+#define AI_NODE_VISIBLE_BATCH 16
+
+/**
+ * @brief Finds the closest node to `position`. When `only_visible` is set, candidates are
+ * tested for visibility in batches, nearest first, until one is found to be visible.
  */
 ai_node_id_t Ai_Node_FindClosest(const vec3_t position, const float max_distance, const bool only_visible, const bool prefer_level) {
 
@@ -129,6 +158,8 @@ ai_node_id_t Ai_Node_FindClosest(const vec3_t position, const float max_distance
 	float closest_dist = 0;
 	const float dist_squared = max_distance * max_distance;
 
+	GArray *candidates = only_visible ? g_array_new(false, false, sizeof(ai_node_candidate_t)) : NULL;
+
 	for (guint i = 0; i < ai_nodes->len; i++) {
 		const ai_node_t *node = &g_array_index(ai_nodes, ai_node_t, i);
 
@@ -139,10 +170,49 @@ ai_node_id_t Ai_Node_FindClosest(const vec3_t position, const float max_distance
 		}
 		const float dist = Vec3_LengthSquared(dir);
 
-		if (dist < dist_squared && (closest == NODE_INVALID || dist < closest_dist) && (!only_visible || Ai_Node_Visible(position, i))) {
-			closest = i;
-			closest_dist = dist;
+		if (dist < dist_squared) {
+
+			if (candidates) {
+				g_array_append_vals(candidates, &(const ai_node_candidate_t) {
+					.id = i,
+					.dist = dist
+				}, 1);
+			} else if (closest == NODE_INVALID || dist < closest_dist) {
+				closest = i;
+				closest_dist = dist;
+			}
+		}
+	}
+
+	if (candidates) {
+		g_array_sort(candidates, Ai_Node_CandidateCmp);
+
+		g_trace_request_t requests[AI_NODE_VISIBLE_BATCH];
+		cm_trace_t traces[AI_NODE_VISIBLE_BATCH];
+
+		for (guint i = 0; i < candidates->len && closest == NODE_INVALID; i += AI_NODE_VISIBLE_BATCH) {
+			const guint count = MIN(candidates->len - i, AI_NODE_VISIBLE_BATCH);
+
+			for (guint j = 0; j < count; j++) {
+				requests[j] = (g_trace_request_t) {
+					.start = position,
+					.end = Ai_Node_GetPosition(g_array_index(candidates, ai_node_candidate_t, i + j).id),
+					.bounds = Box3_Zero(),
+					.contents = CONTENTS_SOLID | CONTENTS_WINDOW
+				};
+			}
+
+			aim.gi->TraceBatch(requests, traces, count);
+
+			for (guint j = 0; j < count; j++) {
+				if (traces[j].fraction == 1.0f) {
+					closest = g_array_index(candidates, ai_node_candidate_t, i + j).id;
+					break;
+				}
+			}
 		}
+
+		g_array_free(candidates, true);
 	}
 
 	return closest;
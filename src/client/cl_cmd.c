@@ -73,7 +73,7 @@ static void Cl_WriteMovementCommand(mem_buf_t *buf) {
 
 	Net_WriteByte(buf, CL_CMD_MOVE);
 
-	if (!cl.frame.valid || (cls.demo_file && Fs_Tell(cls.demo_file) == 0)) {
+	if (!cl.frame.valid) {
 		Net_WriteLong(buf, -1);
 	} else {
 		Net_WriteLong(buf, cl.frame.frame_num);
@@ -120,8 +120,15 @@ void Cl_SendCommands(void) {
 		case CL_CONNECTED:
 		case CL_LOADING:
 
-			if (cls.net_chan.message.size || delta > 1000) {
-				Netchan_Transmit(&cls.net_chan, NULL, 0);
+			if (cls.net_chan.message.size || cls.download.ack || delta > 1000) {
+				mem_buf_t buf;
+				byte data[64];
+
+				Mem_InitBuffer(&buf, data, sizeof(data));
+
+				Cl_WriteDownloadAck(&buf);
+
+				Netchan_Transmit(&cls.net_chan, buf.data, buf.size);
 				cl.packet_counter[cl.sample_index]++;
 			}
 
@@ -134,12 +141,14 @@ void Cl_SendCommands(void) {
 			Cl_FinalizeMovementCommand();
 
 			mem_buf_t buf;
-			byte data[sizeof(cl_cmd_t) * 3];
+			byte data[sizeof(cl_cmd_t) * 3 + 64];
 
 			Mem_InitBuffer(&buf, data, sizeof(data));
 
 			Cl_WriteMovementCommand(&buf);
 
+			Cl_WriteDownloadAck(&buf);
+
 			Netchan_Transmit(&cls.net_chan, buf.data, buf.size);
 			cl.packet_counter[cl.sample_index]++;
 
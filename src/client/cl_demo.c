@@ -22,8 +22,18 @@
 #include "cl_local.h"
 
 /**
- * @brief Writes server_data, config_strings, and baselines once a non-delta
- * compressed frame arrives from the server.
+ * @brief Writes the message to the demo as a block, and clears it.
+ */
+static void Cl_WriteDemoBlock(mem_buf_t *msg, int32_t flags) {
+
+	Net_WriteDemoBlock(cls.demo, msg->data, msg->size, cl.frame.time, flags);
+
+	msg->size = 0;
+}
+
+/**
+ * @brief Writes server_data, config_strings, and baselines when recording begins.
+ * Each message is flagged as a frame, so that playback delivers them in series.
  */
 static void Cl_WriteDemoHeader(void) {
 	static entity_state_t null_state;
@@ -46,10 +56,7 @@ static void Cl_WriteDemoHeader(void) {
 	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
 		if (*cl.config_strings[i] != '\0') {
 			if (msg.size + strlen(cl.config_strings[i]) + 32 > msg.max_size) { // write it out
-				const int32_t len = LittleLong((int32_t) msg.size);
-				Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-				Fs_Write(cls.demo_file, msg.data, msg.size, 1);
-				msg.size = 0;
+				Cl_WriteDemoBlock(&msg, DEMO_BLOCK_FRAME);
 			}
 
 			Net_WriteByte(&msg, SV_CMD_CONFIG_STRING);
@@ -66,10 +73,7 @@ static void Cl_WriteDemoHeader(void) {
 		}
 
 		if (msg.size + 64 > msg.max_size) { // write it out
-			const int32_t len = LittleLong((int32_t) msg.size);
-			Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-			Fs_Write(cls.demo_file, msg.data, msg.size, 1);
-			msg.size = 0;
+			Cl_WriteDemoBlock(&msg, DEMO_BLOCK_FRAME);
 		}
 
 		Net_WriteByte(&msg, SV_CMD_BASELINE);
@@ -80,57 +84,223 @@ static void Cl_WriteDemoHeader(void) {
 	Net_WriteString(&msg, "precache 0\n");
 
 	// write it to the demo file
-
-	const int32_t len = LittleLong((int32_t) msg.size);
-
-	Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-	Fs_Write(cls.demo_file, msg.data, msg.size, 1);
+	Cl_WriteDemoBlock(&msg, DEMO_BLOCK_FRAME);
 
 	Com_Debug(DEBUG_CLIENT, "Demo started\n");
 	// the rest of the demo file will be individual frames
 }
 
 /**
- * @brief Dumps the current net message, prefixed by the length.
+ * @return The last frame written to the demo, if it is still available to delta
+ * compress the current frame from, or NULL.
  */
-void Cl_WriteDemoMessage(void) {
+static const cl_frame_t *Cl_DemoDeltaFrame(void) {
 
-	if (!cls.demo_file) {
-		return;
+	if (cls.demo_frame_num <= 0) {
+		return NULL;
+	}
+
+	const cl_frame_t *frame = &cl.frames[cls.demo_frame_num & PACKET_MASK];
+
+	if (!frame->valid || frame->frame_num != cls.demo_frame_num) {
+		return NULL;
+	}
+
+	if (cl.entity_state - frame->entity_state > ENTITY_STATE_BACKUP - PACKET_BACKUP) {
+		return NULL;
 	}
 
-	if (!Fs_Tell(cls.demo_file)) {
-		if (cl.frame.delta_frame_num < 0) {
-			Com_Debug(DEBUG_CLIENT, "Received uncompressed frame, writing demo header..\n");
-			Cl_WriteDemoHeader();
+	return frame;
+}
+
+/**
+ * @brief Writes the current frame, delta compressed from the specified frame, which
+ * is the previous frame written to the demo, or NULL for an uncompressed frame. This
+ * way, every frame in the demo may be decoded from the frame that precedes it.
+ */
+static void Cl_WriteDemoFrame(mem_buf_t *msg, const cl_frame_t *from) {
+	static player_state_t null_state;
+
+	const cl_frame_t *to = &cl.frame;
+
+	Net_WriteByte(msg, SV_CMD_FRAME);
+	Net_WriteLong(msg, to->frame_num);
+	Net_WriteLong(msg, from ? from->frame_num : -1);
+	Net_WriteByte(msg, Mini(cl.suppress_count, FRAME_PACKED - 1));
+
+	Net_WriteDeltaPlayerState(msg, from ? &from->ps : &null_state, &to->ps);
+
+	const int32_t from_num_entities = from ? from->num_entities : 0;
+	const entity_state_t *old_state = NULL, *new_state = NULL;
+	int32_t old_index = 0, new_index = 0;
+
+	while (new_index < to->num_entities || old_index < from_num_entities) {
+		uint16_t old_num, new_num;
+
+		if (new_index >= to->num_entities) {
+			new_num = 0xffff;
+		} else {
+			new_state = &cl.entity_states[(to->entity_state + new_index) & ENTITY_STATE_MASK];
+			new_num = new_state->number;
+		}
+
+		if (old_index >= from_num_entities) {
+			old_num = 0xffff;
 		} else {
-			return; // wait for an uncompressed packet
+			old_state = &cl.entity_states[(from->entity_state + old_index) & ENTITY_STATE_MASK];
+			old_num = old_state->number;
+		}
+
+		if (new_num == old_num) { // delta update from old position
+			Net_WriteDeltaEntity(msg, old_state, new_state, false);
+			old_index++;
+			new_index++;
+			continue;
+		}
+
+		if (new_num < old_num) { // this is a new entity, send it from the baseline
+			Net_WriteDeltaEntity(msg, &cl.entities[new_num].baseline, new_state, true);
+			new_index++;
+			continue;
+		}
+
+		if (new_num > old_num) { // the old entity isn't present in the new message
+			Net_WriteShort(msg, old_num);
+			Net_WriteShort(msg, U_REMOVE);
+			old_index++;
+			continue;
+		}
+	}
+
+	Net_WriteShort(msg, 0); // end of entities
+}
+
+/**
+ * @brief Writes a keyframe, which carries every config string that is set, and the
+ * current frame, uncompressed. Playback may seek to any keyframe, regardless of the
+ * state it is seeking from.
+ */
+static void Cl_WriteDemoKeyframe(void) {
+	mem_buf_t msg;
+	byte buffer[MAX_MSG_SIZE];
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+	Net_WriteDemoKeyframe(cls.demo, cl.frame.time);
+
+	for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
+
+		// strings cleared since recording began must be cleared when seeking, too
+		const _Bool modified = cls.demo_config_strings[i >> 5] & (1u << (i & 31));
+
+		if (*cl.config_strings[i] != '\0' || modified) {
+			if (msg.size + strlen(cl.config_strings[i]) + 32 > msg.max_size) { // write it out
+				Cl_WriteDemoBlock(&msg, DEMO_BLOCK_KEYFRAME);
+			}
+
+			Net_WriteByte(&msg, SV_CMD_CONFIG_STRING);
+			Net_WriteShort(&msg, i);
+			Net_WriteString(&msg, cl.config_strings[i]);
+		}
+	}
+
+	// leave ample room for the frame
+	if (msg.size > msg.max_size / 2) {
+		Cl_WriteDemoBlock(&msg, DEMO_BLOCK_KEYFRAME);
+	}
+
+	Cl_WriteDemoFrame(&msg, NULL);
+
+	Cl_WriteDemoBlock(&msg, DEMO_BLOCK_KEYFRAME | DEMO_BLOCK_FRAME);
+
+	cls.demo_keyframe_time = cl.frame.time;
+}
+
+/**
+ * @brief Flags the specified config string as modified, so that keyframes carry it
+ * even once it has been cleared.
+ */
+void Cl_DemoConfigString(int32_t index) {
+
+	if (cls.demo) {
+		cls.demo_config_strings[index >> 5] |= (1u << (index & 31));
+	}
+}
+
+/**
+ * @brief Dumps the current net message to the demo, with its timecode. If the message
+ * contains a valid frame, the frame is rewritten to delta compress from the previous frame
+ * in the demo, and a keyframe is written if one is due. Recording begins with the first
+ * valid frame, but every message after that is written, so that level changes and the
+ * server data and config strings which accompany them are preserved.
+ *
+ * @param payload The offset of the payload within the message, following the packet header.
+ * @param frame_start The offset of the frame within the message, or 0.
+ * @param frame_end The offset following the frame within the message, or 0.
+ */
+void Cl_WriteDemoMessage(size_t payload, size_t frame_start, size_t frame_end) {
+
+	if (!cls.demo) {
+		return;
+	}
+
+	if (cls.demo->num_blocks == 0) {
+		if (!cl.frame.valid) {
+			return; // wait for a frame we can write in full
 		}
+		Cl_WriteDemoHeader();
 	}
 
-	// the first eight bytes are just packet sequencing stuff
-	const int32_t len = LittleLong((int32_t) (net_message.size - 8));
+	mem_buf_t msg;
+	byte buffer[MAX_MSG_SIZE];
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+	// the packet header is just sequencing stuff, and flags if compression was negotiated
+	const byte *data = net_message.data;
+
+	if (frame_end && cl.frame.valid) {
+		Mem_WriteBuffer(&msg, data + payload, frame_start - payload);
+		Cl_WriteDemoFrame(&msg, Cl_DemoDeltaFrame());
+		Mem_WriteBuffer(&msg, data + frame_end, net_message.size - frame_end);
+
+		Cl_WriteDemoBlock(&msg, DEMO_BLOCK_FRAME);
+
+		cls.demo_frame_num = cl.frame.frame_num;
+
+		const uint32_t interval = Maxf(cl_demo_keyframe_interval->value, 0.1f) * 1000;
+
+		if (cl.frame.time - cls.demo_keyframe_time >= interval) {
+			Cl_WriteDemoKeyframe();
+		}
+	} else {
+		if (frame_end) { // an invalid frame is dropped, but not the messages around it
+			Mem_WriteBuffer(&msg, data + payload, frame_start - payload);
+			Mem_WriteBuffer(&msg, data + frame_end, net_message.size - frame_end);
+		} else {
+			Mem_WriteBuffer(&msg, data + payload, net_message.size - payload);
+		}
 
-	Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-	Fs_Write(cls.demo_file, net_message.data + 8, len, 1);
+		if (msg.size) {
+			Cl_WriteDemoBlock(&msg, 0);
+		}
+	}
 }
 
 /**
  * @brief Stop recording a demo
  */
 void Cl_Stop_f(void) {
-	int32_t len = -1;
 
-	if (!cls.demo_file) {
+	if (!cls.demo) {
 		Com_Print("Not recording a demo\n");
 		return;
 	}
 
-	// finish up
-	Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-	Fs_Close(cls.demo_file);
+	// finish up, writing the keyframe index
+	Net_CloseDemo(cls.demo);
 
-	cls.demo_file = NULL;
+	cls.demo = NULL;
 	Com_Print("Stopped demo\n");
 }
 
@@ -146,7 +316,7 @@ void Cl_Record_f(void) {
 		return;
 	}
 
-	if (cls.demo_file) {
+	if (cls.demo) {
 		Com_Print("Already recording\n");
 		return;
 	}
@@ -159,11 +329,16 @@ void Cl_Record_f(void) {
 	g_snprintf(cls.demo_filename, sizeof(cls.demo_filename), "demos/%s.demo", Cmd_Argv(1));
 
 	// open the demo file
-	if (!(cls.demo_file = Fs_OpenWrite(cls.demo_filename))) {
+	if (!(cls.demo = Net_CreateDemo(cls.demo_filename))) {
 		Com_Warn("Couldn't open %s\n", cls.demo_filename);
 		return;
 	}
 
+	cls.demo_frame_num = 0;
+	cls.demo_keyframe_time = 0;
+
+	memset(cls.demo_config_strings, 0, sizeof(cls.demo_config_strings));
+
 	Com_Print("Recording to %s\n", cls.demo_filename);
 }
 
@@ -184,9 +359,19 @@ static void Cl_AdjustDemoPlayback(float delta) {
 }
 
 /**
- * @brief
+ * @brief fast_forward [seconds]
+ *
+ * Increases the playback rate, or seeks forward by the specified number of seconds.
  */
 void Cl_FastForward_f(void) {
+
+	if (Cmd_Argc() > 1) {
+		if (cl.demo_server) {
+			Cbuf_AddText(va("demo_seek +%s\n", Cmd_Argv(1)));
+		}
+		return;
+	}
+
 	Cl_AdjustDemoPlayback(DEMO_PLAYBACK_STEP);
 }
 
@@ -25,13 +25,15 @@
  * @brief Parse the player_state_t for the current frame from the server, using delta
  * compression for all fields where possible.
  */
-static void Cl_ParsePlayerState(const cl_frame_t *delta_frame, cl_frame_t *frame) {
+static void Cl_ParsePlayerState(const cl_frame_t *delta_frame, cl_frame_t *frame, _Bool packed) {
 	static player_state_t null_state;
 
-	if (delta_frame && delta_frame->valid) {
-		Net_ReadDeltaPlayerState(&net_message, &delta_frame->ps, &frame->ps);
+	const player_state_t *from = (delta_frame && delta_frame->valid) ? &delta_frame->ps : &null_state;
+
+	if (packed) {
+		Net_ReadPackedDeltaPlayerState(&net_message, from, &frame->ps);
 	} else {
-		Net_ReadDeltaPlayerState(&net_message, &null_state, &frame->ps);
+		Net_ReadDeltaPlayerState(&net_message, from, &frame->ps);
 	}
 
 	if (cl.demo_server) { // if playing a demo, force freeze
@@ -86,7 +88,8 @@ static void Cl_ResetTrails(cl_entity_t *ent) {
  * @brief Reads deltas from the given base and adds the resulting entity to the
  * current frame.
  */
-static void Cl_ReadDeltaEntity(cl_frame_t *frame, const entity_state_t *from, uint16_t number, uint16_t bits) {
+static void Cl_ReadDeltaEntity(cl_frame_t *frame, const entity_state_t *from, uint16_t number, uint16_t bits,
+                               _Bool packed) {
 
 	cl_entity_t *ent = &cl.entities[number];
 
@@ -95,7 +98,11 @@ static void Cl_ReadDeltaEntity(cl_frame_t *frame, const entity_state_t *from, ui
 
 	frame->num_entities++;
 
-	Net_ReadDeltaEntity(&net_message, from, to, number, bits);
+	if (packed) {
+		Net_ReadPackedDeltaEntity(&net_message, from, to, number, bits);
+	} else {
+		Net_ReadDeltaEntity(&net_message, from, to, number, bits);
+	}
 
 	// check to see if the delta was successful and valid
 	if (!Cl_ValidDeltaEntity(frame, ent, from, to)) {
@@ -117,7 +124,7 @@ static void Cl_ReadDeltaEntity(cl_frame_t *frame, const entity_state_t *from, ui
 /**
  * @brief An svc_packetentities has just been parsed, deal with the rest of the data stream.
  */
-static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
+static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame, _Bool packed) {
 
 	frame->entity_state = cl.entity_state;
 	frame->num_entities = 0;
@@ -133,9 +140,17 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 	}
 
 	int32_t index = 0;
+	uint32_t number = 0;
 
 	while (true) {
-		const uint16_t number = Net_ReadShort(&net_message);
+
+		// packed frames encode entity numbers relative to one another
+		if (packed) {
+			const uint32_t delta = Net_ReadVarUInt(&net_message, 4);
+			number = delta ? number + delta : 0;
+		} else {
+			number = (uint16_t) Net_ReadShort(&net_message);
+		}
 
 		if (number >= MAX_ENTITIES) {
 			Com_Error(ERROR_DROP, "Bad number: %i\n", number);
@@ -156,7 +171,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 				Com_Print("   unchanged: %i\n", from_number);
 			}
 
-			Cl_ReadDeltaEntity(frame, from, from_number, 0);
+			Cl_ReadDeltaEntity(frame, from, from_number, 0, packed);
 
 			index++;
 
@@ -169,7 +184,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 		}
 
 		// now deal with the new entity
-		const uint16_t bits = Net_ReadShort(&net_message);
+		const uint16_t bits = packed ? Net_ReadPackedEntityBits(&net_message) : Net_ReadShort(&net_message);
 
 		if (bits & U_REMOVE) { // remove it, no delta
 
@@ -199,7 +214,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 				Com_Print("   delta: %i\n", number);
 			}
 
-			Cl_ReadDeltaEntity(frame, from, number, bits);
+			Cl_ReadDeltaEntity(frame, from, number, bits, packed);
 
 			index++;
 
@@ -219,7 +234,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 				Com_Print("   baseline: %i\n", number);
 			}
 
-			Cl_ReadDeltaEntity(frame, &cl.entities[number].baseline, number, bits);
+			Cl_ReadDeltaEntity(frame, &cl.entities[number].baseline, number, bits, packed);
 
 			continue;
 		}
@@ -232,7 +247,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 			Com_Print("   unchanged: %i\n", from_number);
 		}
 
-		Cl_ReadDeltaEntity(frame, from, from_number, 0);
+		Cl_ReadDeltaEntity(frame, from, from_number, 0, packed);
 
 		index++;
 
@@ -261,7 +276,10 @@ void Cl_ParseFrame(void) {
 	cl.frame.frame_num = Net_ReadLong(&net_message);
 	cl.frame.delta_frame_num = Net_ReadLong(&net_message);
 
-	cl.suppress_count += Net_ReadByte(&net_message);
+	const int32_t suppress_count = Net_ReadByte(&net_message);
+
+	const _Bool packed = (suppress_count & FRAME_PACKED) != 0;
+	cl.suppress_count += suppress_count & ~FRAME_PACKED;
 
 	if (cl_draw_net_messages->integer == 3) {
 		Com_Print("   frame:%i  delta:%i\n", cl.frame.frame_num, cl.frame.delta_frame_num);
@@ -293,9 +311,14 @@ void Cl_ParseFrame(void) {
 
 	cl.frame.valid = true;
 
-	Cl_ParsePlayerState(cl.delta_frame, &cl.frame);
+	Cl_ParsePlayerState(cl.delta_frame, &cl.frame, packed);
 
-	Cl_ParseEntities(cl.delta_frame, &cl.frame);
+	Cl_ParseEntities(cl.delta_frame, &cl.frame, packed);
+
+	// packed frames end on a bit boundary, so realign for subsequent commands
+	if (packed) {
+		Mem_AlignBits(&net_message);
+	}
 
 	// set the simulation time for the frame
 	cl.frame.time = cl.frame.frame_num * QUETOO_TICK_MILLIS;
@@ -27,6 +27,7 @@
 #include "server/server.h"
 
 cvar_t *cl_chat_sound;
+cvar_t *cl_demo_keyframe_interval;
 cvar_t *cl_draw_counters;
 cvar_t *cl_draw_position;
 cvar_t *cl_draw_net_graph;
@@ -76,8 +77,8 @@ static void Cl_SendConnect(void) {
 		addr.port = htons(PORT_SERVER);
 	}
 
-	Netchan_OutOfBandPrint(NS_UDP_CLIENT, &addr, "connect %i %i %u \"%s\"\n", PROTOCOL_MAJOR,
-	                       qport->integer, cls.challenge, Cvar_UserInfo());
+	Netchan_OutOfBandPrint(NS_UDP_CLIENT, &addr, "connect %i %i %u \"%s\" %u\n", PROTOCOL_MAJOR,
+	                       qport->integer, cls.challenge, Cvar_UserInfo(), PROTOCOL_EXTENSIONS);
 
 	cvar_user_info_modified = false;
 }
@@ -291,7 +292,7 @@ void Cl_Disconnect(void) {
 
 	Cl_ClearState();
 
-	if (cls.demo_file) {
+	if (cls.demo) {
 		Cl_Stop_f();
 	}
 
@@ -389,12 +390,27 @@ static void Cl_ConnectionlessPacket(void) {
 
 		cls.state = CL_CONNECTED;
 
-		if (Cmd_Argc() == 2) { // http download url
+		if (Cmd_Argc() >= 2) { // http download url
 			g_strlcpy(cls.download_url, Cmd_Argv(1), sizeof(cls.download_url));
 		} else {
 			cls.download_url[0] = '\0';
 		}
 
+		// the protocol extensions the server enabled for us, if any
+		const uint32_t extensions = Cmd_Argc() >= 3 ? (uint32_t) strtoul(Cmd_Argv(2), NULL, 0) : 0;
+
+		cls.net_chan.compress = (extensions & PROTOCOL_COMPRESSION) != 0;
+
+		return;
+	}
+
+	// streamed download fragment from the server we are connected to
+	if (!g_strcmp0(c, "download_fragment")) {
+		if (cls.state < CL_CONNECTED || !Net_CompareNetaddr(&net_from, &cls.net_chan.remote_address)) {
+			Com_Debug(DEBUG_CLIENT, "%s: Unsolicited download fragment\n", Net_NetaddrToString(&net_from));
+			return;
+		}
+		Cl_ParseDownloadFragment();
 		return;
 	}
 
@@ -529,6 +545,7 @@ static void Cl_InitLocal(void) {
 
 	// register our variables
 	cl_chat_sound = Cvar_Add("cl_chat_sound", "misc/chat", CVAR_ARCHIVE, "Path to the sound that is made when a chat message is received");
+	cl_demo_keyframe_interval = Cvar_Add("cl_demo_keyframe_interval", "2", CVAR_ARCHIVE, "Time, in seconds, between the keyframes of recorded demos, to which playback may seek");
 	cl_draw_counters = Cvar_Add("cl_draw_counters", "1", CVAR_ARCHIVE, "Draw the speed, fps and pps counters at the bottom-right");
 	cl_draw_position = Cvar_Add("cl_draw_position", "0", CVAR_DEVELOPER, "Draw your current position to the screen");
 	cl_draw_net_graph = Cvar_Add("cl_draw_net_graph", "1", CVAR_ARCHIVE, "Draw the net graph at the bottom-right");
@@ -560,7 +577,7 @@ static void Cl_InitLocal(void) {
 	Cmd_Add("ping", Cl_Ping_f, CMD_CLIENT, NULL);
 	Cmd_Add("servers", Cl_Servers_f, CMD_CLIENT, NULL);
 	Cmd_Add("record", Cl_Record_f, CMD_CLIENT, NULL);
-	Cmd_Add("fast_forward", Cl_FastForward_f, CMD_CLIENT, NULL);
+	Cmd_Add("fast_forward", Cl_FastForward_f, CMD_CLIENT, "Increase the demo playback rate, or seek forward by the specified number of seconds");
 	Cmd_Add("servers_list", Cl_Servers_List_f, CMD_CLIENT, NULL);
 	Cmd_Add("slow_motion", Cl_SlowMotion_f, CMD_CLIENT, NULL);
 	Cmd_Add("stop", Cl_Stop_f, CMD_CLIENT, NULL);
@@ -609,6 +626,8 @@ void Cl_Frame(const uint32_t msec) {
 		return;
 	}
 
+	PROFILE_SCOPE("Cl_Frame");
+
 	// update the simulation time
 	cl.time += msec;
 
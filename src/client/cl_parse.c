@@ -183,6 +183,8 @@ int32_t Cl_ParseConfigString(void) {
 	strcpy(cl.config_strings[i], Net_ReadString(&net_message));
 	const char *s = cl.config_strings[i];
 
+	Cl_DemoConfigString(i);
+
 	if (i > CS_MODELS && i < CS_MODELS + MAX_MODELS) {
 		if (cls.state == CL_ACTIVE) {
 			cl.models[i - CS_MODELS] = R_LoadModel(s);
@@ -205,6 +207,151 @@ int32_t Cl_ParseConfigString(void) {
 	return i;
 }
 
+/**
+ * @brief Closes the completed download, adds it to the search path if it is an archive,
+ * and requests the next download, if any.
+ */
+static void Cl_FinishDownload(void) {
+
+	Fs_Close(cls.download.file);
+	cls.download.file = NULL;
+
+	cls.download.stream = false;
+
+	// add new archives to the search path
+	if (Fs_Rename(cls.download.tempname, cls.download.name)) {
+		if (strstr(cls.download.name, ".pk3")) {
+			Fs_AddToSearchPath(cls.download.name);
+		}
+	} else {
+		Com_Error(ERROR_DROP, "Failed to rename %s\n", cls.download.name);
+	}
+
+	// get another file if needed
+	Cl_RequestNextDownload();
+}
+
+/**
+ * @brief Opens the temporary file for the current download, if it's not opened yet.
+ */
+static _Bool Cl_OpenDownload(void) {
+
+	if (!cls.download.file) {
+
+		if (!(cls.download.file = Fs_OpenWrite(cls.download.tempname))) {
+			Com_Warn("Failed to open %s\n", cls.download.tempname);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief The server has begun streaming the current download to us.
+ */
+static void Cl_ParseDownloadStream(void) {
+
+	const uint8_t id = Net_ReadByte(&net_message);
+	const int32_t size = Net_ReadLong(&net_message);
+	const int32_t offset = Net_ReadLong(&net_message);
+
+	if (!Cl_OpenDownload()) {
+		Cl_RequestNextDownload();
+		return;
+	}
+
+	cls.download.stream = true;
+	cls.download.id = id;
+	cls.download.size = size;
+	cls.download.num_fragments = (size - offset + DOWNLOAD_FRAGMENT_SIZE - 1) / DOWNLOAD_FRAGMENT_SIZE;
+	cls.download.base = 0;
+	cls.download.received = 0;
+	cls.download.ack = false;
+
+	Com_Debug(DEBUG_CLIENT, "Streaming %s from %d of %d bytes\n", cls.download.name, offset, size);
+
+	if (cls.download.num_fragments <= 0) {
+		Cl_FinishDownload();
+	}
+}
+
+/**
+ * @brief A fragment of the current streamed download has been received out of band.
+ * Fragments are buffered until they can be written to the file in order.
+ */
+void Cl_ParseDownloadFragment(void) {
+
+	const uint8_t id = Net_ReadByte(&net_message);
+	const int32_t fragment = Net_ReadLong(&net_message);
+	const int32_t len = Net_ReadShort(&net_message);
+
+	if (len <= 0 || len > DOWNLOAD_FRAGMENT_SIZE || len > (int32_t) (net_message.size - net_message.read)) {
+		Com_Debug(DEBUG_CLIENT, "Invalid download fragment %d (%d bytes)\n", fragment, len);
+		return;
+	}
+
+	const byte *data = net_message.data + net_message.read;
+	net_message.read += len;
+
+	if (!cls.download.stream || id != cls.download.id) {
+		return; // a late fragment of a previous download, or an unannounced stream
+	}
+
+	if (fragment < 0 || fragment >= cls.download.num_fragments) {
+		Com_Warn("Invalid download fragment %d (%d bytes)\n", fragment, len);
+		return;
+	}
+
+	cls.download.ack = true;
+
+	if (fragment < cls.download.base || fragment >= cls.download.base + DOWNLOAD_WINDOW) {
+		return; // a retransmission of a fragment we already have, so just acknowledge it
+	}
+
+	const int32_t slot = fragment % DOWNLOAD_WINDOW;
+
+	memcpy(cls.download.fragments[slot], data, len);
+	cls.download.fragment_len[slot] = len;
+
+	cls.download.received |= 1ull << (fragment - cls.download.base);
+
+	// write every fragment that is now contiguous with the file
+	while (cls.download.received & 1) {
+		const int32_t i = cls.download.base % DOWNLOAD_WINDOW;
+
+		Fs_Write(cls.download.file, cls.download.fragments[i], 1, cls.download.fragment_len[i]);
+
+		cls.download.received >>= 1;
+		cls.download.base++;
+	}
+
+	if (cls.download.base == cls.download.num_fragments) {
+
+		// reliably acknowledge the final fragment, so that the server closes the file
+		Net_WriteByte(&cls.net_chan.message, CL_CMD_STRING);
+		Net_WriteString(&cls.net_chan.message, va("download_ack %u %d 0", cls.download.id, cls.download.base));
+
+		cls.download.ack = false;
+
+		Cl_FinishDownload();
+	}
+}
+
+/**
+ * @brief Writes the pending acknowledgement of streamed download fragments, if any.
+ */
+void Cl_WriteDownloadAck(mem_buf_t *buf) {
+
+	if (cls.download.stream && cls.download.ack) {
+		Net_WriteByte(buf, CL_CMD_STRING);
+		Net_WriteString(buf, va("download_ack %u %d %" PRIu64, cls.download.id, cls.download.base,
+		                        cls.download.received));
+
+		cls.download.ack = false;
+	}
+}
+
 /**
  * @brief A download message has been received from the server.
  */
@@ -213,6 +360,12 @@ static void Cl_ParseDownload(void) {
 
 	// read the data
 	size = Net_ReadShort(&net_message);
+
+	if (size == DOWNLOAD_STREAM) {
+		Cl_ParseDownloadStream();
+		return;
+	}
+
 	percent = Net_ReadByte(&net_message);
 	if (size < 0) {
 		Com_Debug(DEBUG_CLIENT, "Server does not have this file\n");
@@ -226,14 +379,10 @@ static void Cl_ParseDownload(void) {
 	}
 
 	// open the file if not opened yet
-	if (!cls.download.file) {
-
-		if (!(cls.download.file = Fs_OpenWrite(cls.download.tempname))) {
-			net_message.read += size;
-			Com_Warn("Failed to open %s\n", cls.download.tempname);
-			Cl_RequestNextDownload();
-			return;
-		}
+	if (!Cl_OpenDownload()) {
+		net_message.read += size;
+		Cl_RequestNextDownload();
+		return;
 	}
 
 	Fs_Write(cls.download.file, net_message.data + net_message.read, 1, size);
@@ -244,20 +393,7 @@ static void Cl_ParseDownload(void) {
 		Net_WriteByte(&cls.net_chan.message, CL_CMD_STRING);
 		Net_WriteString(&cls.net_chan.message, "next_download");
 	} else {
-		Fs_Close(cls.download.file);
-		cls.download.file = NULL;
-
-		// add new archives to the search path
-		if (Fs_Rename(cls.download.tempname, cls.download.name)) {
-			if (strstr(cls.download.name, ".pk3")) {
-				Fs_AddToSearchPath(cls.download.name);
-			}
-		} else {
-			Com_Error(ERROR_DROP, "Failed to rename %s\n", cls.download.name);
-		}
-
-		// get another file if needed
-		Cl_RequestNextDownload();
+		Cl_FinishDownload();
 	}
 }
 
@@ -434,6 +570,11 @@ void Cl_ParseServerMessage(void) {
 
 	cl.suppress_count = 0;
 
+	// Netchan_Process has read past the packet header, to the payload
+	const size_t payload = net_message.read;
+
+	size_t frame_start = 0, frame_end = 0;
+
 	cmd = SV_CMD_BAD;
 
 	// parse the message
@@ -482,7 +623,9 @@ void Cl_ParseServerMessage(void) {
 				Com_Error(ERROR_DROP, "Server dropped connection\n");
 
 			case SV_CMD_FRAME:
+				frame_start = net_message.read - 1;
 				Cl_ParseFrame();
+				frame_end = net_message.read;
 				break;
 
 			case SV_CMD_PRINT:
@@ -522,5 +665,5 @@ void Cl_ParseServerMessage(void) {
 
 	Cl_AddNetGraph();
 
-	Cl_WriteDemoMessage();
+	Cl_WriteDemoMessage(payload, frame_start, frame_end);
 }
@@ -26,7 +26,9 @@
 #ifdef __CL_LOCAL_H__
 _Bool Cl_CheckOrDownloadFile(const char *filename);
 int32_t Cl_ParseConfigString(void);
+void Cl_ParseDownloadFragment(void);
 void Cl_ParseServerMessage(void);
+void Cl_WriteDownloadAck(mem_buf_t *buf);
 void Cl_Download_f(void);
 void Cl_Precache_f(void);
 #endif /* __CL_LOCAL_H__ */
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "net/net_demo.h"
 #include "net/net_types.h"
 #include "renderer/r_types.h"
 #include "sound/s_types.h"
@@ -407,6 +408,20 @@ typedef struct {
 	file_t *file;
 	char tempname[MAX_OS_PATH];
 	char name[MAX_OS_PATH];
+
+	/**
+	 * @brief Streamed downloads (PROTOCOL_STREAMED_DOWNLOADS) buffer the fragments that
+	 * arrive ahead of the file, until the fragments preceding them arrive.
+	 */
+	_Bool stream;
+	uint8_t id; // identifies the stream in fragments and acknowledgements
+	int32_t size; // the total file size
+	int32_t num_fragments;
+	int32_t base; // the next fragment to be written to the file
+	uint64_t received; // bit n is set if fragment base + n is buffered
+	uint16_t fragment_len[DOWNLOAD_WINDOW];
+	byte fragments[DOWNLOAD_WINDOW][DOWNLOAD_FRAGMENT_SIZE]; // by fragment % DOWNLOAD_WINDOW
+	_Bool ack; // an acknowledgement is pending
 } cl_download_t;
 
 // server information, for finding network games
@@ -472,7 +487,23 @@ typedef struct {
 	cl_download_t download; // current download (udp or http)
 
 	char demo_filename[MAX_OS_PATH];
-	file_t *demo_file;
+	demo_t *demo;
+
+	/**
+	 * @brief The last frame written to the demo, from which the next is delta compressed.
+	 */
+	int32_t demo_frame_num;
+
+	/**
+	 * @brief The time of the last keyframe written to the demo.
+	 */
+	uint32_t demo_keyframe_time;
+
+	/**
+	 * @brief The config strings modified since the demo was started, which keyframes
+	 * must carry even if they have since been cleared.
+	 */
+	uint32_t demo_config_strings[MAX_CONFIG_STRINGS / 32];
 
 	GList *servers; // list of cl_server_info_t from all sources
 
@@ -158,62 +158,79 @@ void R_CompileAtlas(r_atlas_t *atlas) {
 		levels = MIN(levels, floorf(log2f(MAX(node->w, node->h)) + 1));
 	}
 
-	for (int32_t width = 256; atlas->image->width == 0; width += 512) {
+	// binary search the smallest width to which the images pack, and blit only that
 
-		if (width > r_config.max_texture_size) {
-			Com_Error(ERROR_DROP, "Atlas exceeds GL_MAX_TEXTURE_SIZE\n");
+	const int32_t steps = (r_config.max_texture_size - 256) / 512;
+
+	if (steps < 0 || Atlas_Pack(atlas->atlas, 0, 256 + steps * 512, 256 + steps * 512)) {
+		Com_Error(ERROR_DROP, "Atlas exceeds GL_MAX_TEXTURE_SIZE\n");
+	}
+
+	int32_t lo = 0, hi = steps;
+	while (lo < hi) {
+		const int32_t mid = (lo + hi) / 2;
+		const int32_t width = 256 + mid * 512;
+
+		if (Atlas_Pack(atlas->atlas, 0, width, width) == 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
 		}
+	}
 
-		SDL_Surface *surf = SDL_CreateRGBSurfaceWithFormat(0, width, width, 32, SDL_PIXELFORMAT_RGBA32);
-		if (Atlas_Compile(atlas->atlas, 0, surf) == 0) {
+	const int32_t width = 256 + lo * 512;
 
-			atlas->image->width = width;
-			atlas->image->height = width;
-			atlas->image->target = GL_TEXTURE_2D;
-			atlas->image->format = GL_RGBA;
+	Atlas_Pack(atlas->atlas, 0, width, width);
 
-			R_SetupImage(atlas->image);
+	SDL_Surface *surf = SDL_CreateRGBSurfaceWithFormat(0, width, width, 32, SDL_PIXELFORMAT_RGBA32);
 
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	Atlas_Blit(atlas->atlas, surf);
 
-			if (r_texture_storage->integer && GL_ARB_texture_storage) {
-				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surf->w, surf->h, GL_RGBA, GL_UNSIGNED_BYTE, surf->pixels);
-			} else {
-				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surf->w, surf->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surf->pixels);
-			}
+	atlas->image->width = width;
+	atlas->image->height = width;
+	atlas->image->target = GL_TEXTURE_2D;
+	atlas->image->format = GL_RGBA;
 
-			for (GLsizei i = 1; i < levels; i++) {
-				SDL_Surface *mip_surf = SDL_CreateRGBSurfaceWithFormat(0, width >> i, width >> i, 32, SDL_PIXELFORMAT_RGBA32);
+	R_SetupImage(atlas->image);
 
-				for (guint l = 0; l < atlas->atlas->nodes->len; l++) {
-					const atlas_node_t *node = g_ptr_array_index(atlas->atlas->nodes, l);
-					const r_atlas_image_t *atlas_image = node->data;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
 
-					SDL_BlitScaled(surf, &(const SDL_Rect) {
-						.x = node->x, .y = node->y, .w = atlas_image->image.width, .h = atlas_image->image.height
-					}, mip_surf, &(SDL_Rect) {
-						.x = node->x >> i, .y = node->y >> i, .w = node->w >> i, .h = node->h >> i
-					});
-				}
-				
-				if (r_texture_storage->integer && GL_ARB_texture_storage) {
-					glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, mip_surf->w, mip_surf->h, GL_RGBA, GL_UNSIGNED_BYTE, mip_surf->pixels);
-				} else {
-					glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, mip_surf->w, mip_surf->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip_surf->pixels);
-				}
+	if (r_texture_storage->integer && GL_ARB_texture_storage) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surf->w, surf->h, GL_RGBA, GL_UNSIGNED_BYTE, surf->pixels);
+	} else {
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surf->w, surf->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surf->pixels);
+	}
 
-				R_GetError(NULL);
+	for (GLsizei i = 1; i < levels; i++) {
+		SDL_Surface *mip_surf = SDL_CreateRGBSurfaceWithFormat(0, width >> i, width >> i, 32, SDL_PIXELFORMAT_RGBA32);
 
-				SDL_FreeSurface(mip_surf);
-			}
+		for (guint l = 0; l < atlas->atlas->nodes->len; l++) {
+			const atlas_node_t *node = g_ptr_array_index(atlas->atlas->nodes, l);
+			const r_atlas_image_t *atlas_image = node->data;
 
-			g_ptr_array_foreach(atlas->atlas->nodes, R_CompileAtlas_Node, atlas);
+			SDL_BlitScaled(surf, &(const SDL_Rect) {
+				.x = node->x, .y = node->y, .w = atlas_image->image.width, .h = atlas_image->image.height
+			}, mip_surf, &(SDL_Rect) {
+				.x = node->x >> i, .y = node->y >> i, .w = node->w >> i, .h = node->h >> i
+			});
+		}
+		
+		if (r_texture_storage->integer && GL_ARB_texture_storage) {
+			glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, mip_surf->w, mip_surf->h, GL_RGBA, GL_UNSIGNED_BYTE, mip_surf->pixels);
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, mip_surf->w, mip_surf->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip_surf->pixels);
 		}
 
-		SDL_FreeSurface(surf);
+		R_GetError(NULL);
 
-		atlas->dirty = false;
+		SDL_FreeSurface(mip_surf);
 	}
 
+	g_ptr_array_foreach(atlas->atlas->nodes, R_CompileAtlas_Node, atlas);
+
+	SDL_FreeSurface(surf);
+
+	atlas->dirty = false;
+
 	R_RegisterDependency((r_media_t *) atlas, (r_media_t *) atlas->image);
 }
@@ -630,8 +630,8 @@ static void R_LoadBspModel(r_model_t *mod, void *buffer) {
 	mod->bsp = Mem_LinkMalloc(sizeof(r_bsp_model_t), mod);
 	mod->bsp->cm = Cm_Bsp();
 
-	// load in lumps that the renderer needs
-	Bsp_LoadLumps(file, &mod->bsp->cm->file, R_BSP_LUMPS);
+	// reference the lumps that the renderer needs in the mapped file
+	Bsp_MapLumps(file, &mod->bsp->cm->file, R_BSP_LUMPS);
 
 	R_LoadModelMaterials(mod);
 	R_LoadBspEntities(mod->bsp);
@@ -651,10 +651,11 @@ static void R_LoadBspModel(r_model_t *mod, void *buffer) {
 	R_LoadBspDepthPassElements(mod->bsp);
 	R_LoadBspOcclusionQueries(mod->bsp);
 
+	Bsp_UnloadLumps(&mod->bsp->cm->file, R_BSP_LUMPS);
+
+	// the lightgrid debugging view outlives the mapped file, so it needs a copy
 	if (r_draw_bsp_lightgrid->value) {
-		Bsp_UnloadLumps(&mod->bsp->cm->file, R_BSP_LUMPS & ~(1 << BSP_LUMP_LIGHTGRID));
-	} else {
-		Bsp_UnloadLumps(&mod->bsp->cm->file, R_BSP_LUMPS);
+		Bsp_LoadLump(file, &mod->bsp->cm->file, BSP_LUMP_LIGHTGRID);
 	}
 
 	Com_Debug(DEBUG_RENDERER, "!================================\n");
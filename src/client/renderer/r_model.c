@@ -81,11 +81,20 @@ r_model_t *R_LoadModel(const char *name) {
 
 		void *buf = NULL;
 
-		Fs_Load(path, &buf);
+		// the world's large lumps are referenced in place for the duration of the load
+		if (IS_BSP_MODEL(mod)) {
+			Fs_Map(path, &buf);
 
-		format->Load(mod, buf);
+			format->Load(mod, buf);
 
-		Fs_Free(buf);
+			Fs_Unmap(buf);
+		} else {
+			Fs_Load(path, &buf);
+
+			format->Load(mod, buf);
+
+			Fs_Free(buf);
+		}
 
 		mod->radius = Box3_Radius(mod->bounds);
 
@@ -47,7 +47,8 @@ static bsp_lump_meta_t bsp_lump_meta[BSP_LUMP_LAST] = {
 	BSP_LUMP_NUM_STRUCT(leafs, MAX_BSP_LEAFS),
 	BSP_LUMP_NUM_STRUCT(models, MAX_BSP_MODELS),
 	BSP_LUMP_SIZE_STRUCT(lightmap, MAX_BSP_LIGHTMAP_SIZE),
-	BSP_LUMP_SIZE_STRUCT(lightgrid, MAX_BSP_LIGHTGRID_SIZE)
+	BSP_LUMP_SIZE_STRUCT(lightgrid, MAX_BSP_LIGHTGRID_SIZE),
+	BSP_LUMP_SIZE_STRUCT(vis, MAX_BSP_VIS_SIZE)
 };
 
 /**
@@ -328,6 +329,17 @@ static void Bsp_SwapLightgrid(void *lump, const int32_t num) {
 	lightgrid->size = LittleVec3i(lightgrid->size);
 }
 
+/**
+ * @brief Swap function.
+ */
+static void Bsp_SwapVis(void *lump, const int32_t num) {
+
+	bsp_vis_t *vis = (bsp_vis_t *) lump;
+
+	vis->num_clusters = LittleLong(vis->num_clusters);
+	vis->cluster_bytes = LittleLong(vis->cluster_bytes);
+}
+
 /**
  * @brief Swap entry point.
  */
@@ -350,6 +362,7 @@ static void Bsp_SwapLump(const bsp_lump_id_t lump_id, void *lump, int32_t count)
 		Bsp_SwapModels,
 		Bsp_SwapLightmap,
 		Bsp_SwapLightgrid,
+		Bsp_SwapVis,
 	};
 
 	if (swap[lump_id]) {
@@ -359,13 +372,25 @@ static void Bsp_SwapLump(const bsp_lump_id_t lump_id, void *lump, int32_t count)
 	}
 }
 
+/**
+ * @return The number of lumps in the header of the specified BSP file.
+ */
+static bsp_lump_id_t Bsp_NumLumps(const bsp_header_t *file) {
+
+	if (LittleLong(file->version) == BSP_VERSION_NO_VIS) {
+		return BSP_LUMP_VIS;
+	}
+
+	return BSP_LUMP_LAST;
+}
+
 /**
  * @brief Calculates the effective size of the BSP file.
  */
 int64_t Bsp_Size(const bsp_header_t *file) {
 	int64_t total = 0;
 
-	for (bsp_lump_id_t lump = BSP_LUMP_FIRST; lump < BSP_LUMP_LAST; lump++) {
+	for (bsp_lump_id_t lump = BSP_LUMP_FIRST; lump < Bsp_NumLumps(file); lump++) {
 		total += LittleLong(file->lumps[lump].file_len);
 	}
 
@@ -382,11 +407,13 @@ int32_t Bsp_Verify(const bsp_header_t *file) {
 		return -1;
 	}
 
-	if (LittleLong(file->version) != BSP_VERSION) {
+	const int32_t version = LittleLong(file->version);
+
+	if (version != BSP_VERSION && version != BSP_VERSION_NO_VIS) {
 		return -1;
 	}
 
-	return BSP_VERSION;
+	return version;
 }
 
 /**
@@ -394,6 +421,12 @@ int32_t Bsp_Verify(const bsp_header_t *file) {
  */
 static void Bsp_GetLumpPosition(const bsp_header_t *file, const bsp_lump_id_t lump_id, bsp_lump_t *lump) {
 
+	// older versions have fewer lumps, and their header is shorter
+	if (lump_id >= Bsp_NumLumps(file)) {
+		*lump = (bsp_lump_t) { 0, 0 };
+		return;
+	}
+
 	*lump = file->lumps[lump_id];
 	lump->file_len = LittleLong(lump->file_len);
 	lump->file_ofs = LittleLong(lump->file_ofs);
@@ -472,15 +505,18 @@ void Bsp_UnloadLump(bsp_file_t *bsp, const bsp_lump_id_t lump_id) {
 		return;
 	}
 
-	// free memory
+	// free memory, unless the lump references a mapped file
 	if (*lump_data) {
-		Mem_Free(*lump_data);
+		if (!(bsp->mapped_lumps & (bsp_lump_id_t) (1 << lump_id))) {
+			Mem_Free(*lump_data);
+		}
 		*lump_data = NULL;
 	}
 
 	*lump_count = 0;
 
 	bsp->loaded_lumps &= ~((bsp_lump_id_t) (1 << lump_id));
+	bsp->mapped_lumps &= ~((bsp_lump_id_t) (1 << lump_id));
 }
 
 /**
@@ -496,10 +532,35 @@ void Bsp_UnloadLumps(bsp_file_t *bsp, const bsp_lump_id_t lump_bits) {
 }
 
 /**
- * @brief Load a lump into memory from the specified BSP file. Returns false
- * if an error occured during the load that is recoverable.
+ * @return True if the specified lump may reference the file buffer in place: the lump
+ * must be stored in native byte order, and must be suitably aligned within the buffer.
  */
-_Bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_id) {
+static _Bool Bsp_CanMapLump(const bsp_header_t *file, const bsp_lump_id_t lump_id, const bsp_lump_t *lump) {
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+	const byte *src = ((const byte *) file) + lump->file_ofs;
+
+	if (((uintptr_t) src) % sizeof(int32_t)) {
+		return false;
+	}
+
+	// the entity string must be null-terminated within the file
+	if (lump_id == BSP_LUMP_ENTITIES && src[lump->file_len - 1] != '\0') {
+		return false;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief Load a lump into memory from the specified BSP file, optionally referencing
+ * the file buffer rather than copying it. Returns false if an error occured during the
+ * load that is recoverable.
+ */
+static _Bool Bsp_LoadLump_(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_id, _Bool map) {
 
 	int32_t *lump_count;
 	void **lump_data;
@@ -535,15 +596,23 @@ _Bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_
 	}
 
 	if (*lump_count) {
-		*lump_data = Mem_TagMalloc(lump.file_len, MEM_TAG_BSP | (lump_id << 16));
 
-		// blit the data into memory
-		if (lump.file_ofs && lump.file_len) {
-			const byte *src = ((const byte *) file) + lump.file_ofs;
+		// reference the data in place, if we can
+		if (map && lump.file_ofs && Bsp_CanMapLump(file, lump_id, &lump)) {
+			*lump_data = (void *) (((const byte *) file) + lump.file_ofs);
+
+			bsp->mapped_lumps |= (bsp_lump_id_t) (1 << lump_id);
+		} else {
+			*lump_data = Mem_TagMalloc(lump.file_len, MEM_TAG_BSP | (lump_id << 16));
+
+			// blit the data into memory
+			if (lump.file_ofs && lump.file_len) {
+				const byte *src = ((const byte *) file) + lump.file_ofs;
 
-			memcpy(*lump_data, src, lump.file_len);
+				memcpy(*lump_data, src, lump.file_len);
 
-			Bsp_SwapLump(lump_id, *lump_data, *lump_count);
+				Bsp_SwapLump(lump_id, *lump_data, *lump_count);
+			}
 		}
 	}
 
@@ -552,6 +621,14 @@ _Bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_
 	return true;
 }
 
+/**
+ * @brief Load a lump into memory from the specified BSP file. Returns false
+ * if an error occured during the load that is recoverable.
+ */
+_Bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_id) {
+	return Bsp_LoadLump_(file, bsp, lump_id, false);
+}
+
 /**
  * @brief Loads the specified lumps into memory. If a failure occurs at any point during
  * loading, it will stop trying to load more and return false.
@@ -569,6 +646,51 @@ _Bool Bsp_LoadLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id
 	return true;
 }
 
+/**
+ * @brief Maps the specified lumps from the BSP file, referencing the file buffer in
+ * place rather than copying it wherever possible. The file buffer must therefore outlive
+ * the lumps, and the lumps must be treated as read-only. Lumps which can not be mapped
+ * (e.g. on big-endian hosts) are loaded as with Bsp_LoadLumps.
+ */
+_Bool Bsp_MapLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_bits) {
+
+	for (bsp_lump_id_t lump = BSP_LUMP_FIRST; lump < BSP_LUMP_LAST; lump++) {
+		if (lump_bits & (bsp_lump_id_t) (1 << lump)) {
+			if (!Bsp_LoadLump_(file, bsp, lump, true)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Copies any lumps which reference a mapped file buffer (see Bsp_MapLumps), so
+ * that the file may be unmapped while the lumps remain loaded.
+ */
+void Bsp_CopyMappedLumps(bsp_file_t *bsp) {
+
+	for (bsp_lump_id_t lump = BSP_LUMP_FIRST; lump < BSP_LUMP_LAST; lump++) {
+		if (!(bsp->mapped_lumps & (bsp_lump_id_t) (1 << lump))) {
+			continue;
+		}
+
+		int32_t *lump_count;
+		void **lump_data;
+
+		Bsp_GetLumpOffsets(bsp, lump, &lump_count, &lump_data);
+
+		const size_t len = bsp_lump_meta[lump].type_size * *lump_count;
+		void *data = Mem_TagMalloc(len, MEM_TAG_BSP | (lump << 16));
+
+		memcpy(data, *lump_data, len);
+		*lump_data = data;
+
+		bsp->mapped_lumps &= ~((bsp_lump_id_t) (1 << lump));
+	}
+}
+
 /**
  * @brief Allocates data for the specified lump in the BSP. If the lump is already loaded,
  * the data will either be expanded or truncated to the specified count. Note that "count"
@@ -600,6 +722,17 @@ void Bsp_AllocLump(bsp_file_t *bsp, const bsp_lump_id_t lump_id, const size_t co
 	// calculate size
 	const size_t lump_type_size = bsp_lump_meta[lump_id].type_size;
 
+	// mapped lumps must be copied before they can be resized
+	if (bsp->mapped_lumps & (bsp_lump_id_t) (1 << lump_id)) {
+		void *data = Mem_TagMalloc(lump_type_size * count, MEM_TAG_BSP | (lump_id << 16));
+
+		memcpy(data, *lump_data, lump_type_size * Mini((int32_t) count, *lump_count));
+		*lump_data = data;
+
+		bsp->mapped_lumps &= ~((bsp_lump_id_t) (1 << lump_id));
+		return;
+	}
+
 	*lump_data = Mem_Realloc(*lump_data, lump_type_size * count);
 }
 
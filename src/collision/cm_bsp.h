@@ -6,7 +6,13 @@
  * @brief BSP file identification.
  */
 #define BSP_IDENT (('P' << 24) + ('S' << 16) + ('B' << 8) + 'I') // "IBSP"
-#define BSP_VERSION	71
+#define BSP_VERSION	72
+
+/**
+ * @brief The previous BSP version, which predates BSP_LUMP_VIS. These maps are still loaded,
+ * and are treated as having no visibility data (everything is visible).
+ */
+#define BSP_VERSION_NO_VIS 71
 
 /**
  * @brief BSP file format limits.
@@ -29,6 +35,7 @@
 #define MAX_BSP_PORTALS				0x20000
 #define MAX_BSP_LIGHTMAP_SIZE		0x60000000
 #define MAX_BSP_LIGHTGRID_SIZE		0x2400000
+#define MAX_BSP_VIS_SIZE			0x1000000
 #define MAX_BSP_OCCLUSION_QUERIES	0x40
 
 /**
@@ -122,6 +129,7 @@ typedef enum {
 	BSP_LUMP_MODELS,
 	BSP_LUMP_LIGHTMAP,
 	BSP_LUMP_LIGHTGRID,
+	BSP_LUMP_VIS,
 	BSP_LUMP_LAST
 } bsp_lump_id_t;
 
@@ -292,6 +300,17 @@ typedef struct {
 	vec3i_t size;
 } bsp_lightgrid_t;
 
+/**
+ * @brief Cluster visibility is stored as uncompressed bit vectors, one row per cluster.
+ * @details The potentially visible set (PVS) rows immediately follow this header, and are
+ * in turn followed by the potentially hearable set (PHS) rows. Each row is `cluster_bytes`
+ * long, with one bit per cluster.
+ */
+typedef struct {
+	int32_t num_clusters;
+	int32_t cluster_bytes;
+} bsp_vis_t;
+
 /**
  * @brief BSP file lumps in their native file formats. The data is stored as pointers
  * so that we don't take up an ungodly amount of space (285 MB of memory!).
@@ -347,7 +366,16 @@ typedef struct {
 	int32_t lightgrid_size;
 	bsp_lightgrid_t *lightgrid;
 
+	int32_t vis_size;
+	bsp_vis_t *vis;
+
 	bsp_lump_id_t loaded_lumps;
+
+	/**
+	 * @brief The loaded lumps which reference the file buffer they were mapped from,
+	 * rather than owning a copy of it. See Bsp_MapLumps.
+	 */
+	bsp_lump_id_t mapped_lumps;
 } bsp_file_t;
 
 int32_t Bsp_Verify(const bsp_header_t *file);
@@ -357,5 +385,7 @@ void Bsp_UnloadLump(bsp_file_t *bsp, const bsp_lump_id_t lump_id);
 void Bsp_UnloadLumps(bsp_file_t *bsp, const bsp_lump_id_t lump_bits);
 _Bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_id);
 _Bool Bsp_LoadLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_bits);
+_Bool Bsp_MapLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_bits);
+void Bsp_CopyMappedLumps(bsp_file_t *bsp);
 void Bsp_AllocLump(bsp_file_t *bsp, const bsp_lump_id_t lump_id, const size_t count);
 void Bsp_Write(file_t *file, const bsp_file_t *bsp);
@@ -78,8 +78,8 @@ static void Cm_LoadBspPlanes(void) {
 	const int32_t num_planes = cm_bsp.file.num_planes;
 	const bsp_plane_t *in = cm_bsp.file.planes;
 
-	cm_bsp_plane_t *out = cm_bsp.planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * (num_planes + 12),
-	                                      MEM_TAG_COLLISION); // extra for box hull
+	cm_bsp_plane_t *out = cm_bsp.planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * num_planes,
+	                                      MEM_TAG_COLLISION);
 
 	for (int32_t i = 0; i < num_planes; i++, in++, out++) {
 		*out = Cm_Plane(in->normal, in->dist);
@@ -94,8 +94,8 @@ static void Cm_LoadBspNodes(void) {
 	const int32_t num_nodes = cm_bsp.file.num_nodes;
 	const bsp_node_t *in = cm_bsp.file.nodes;
 
-	cm_bsp_node_t *out = cm_bsp.nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * (num_nodes + 6),
-	                                    MEM_TAG_COLLISION); // extra for box hull
+	cm_bsp_node_t *out = cm_bsp.nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * num_nodes,
+	                                    MEM_TAG_COLLISION);
 
 	for (int32_t i = 0; i < num_nodes; i++, in++, out++) {
 
@@ -116,8 +116,8 @@ static void Cm_LoadBspLeafs(void) {
 	const int32_t num_leafs = cm_bsp.file.num_leafs;
 	const bsp_leaf_t *in = cm_bsp.file.leafs;
 
-	cm_bsp_leaf_t *out = cm_bsp.leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * (num_leafs + 1),
-	                                    MEM_TAG_COLLISION); // extra for box hull
+	cm_bsp_leaf_t *out = cm_bsp.leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * num_leafs,
+	                                    MEM_TAG_COLLISION);
 
 	for (int32_t i = 0; i < num_leafs; i++, in++, out++) {
 
@@ -136,8 +136,8 @@ static void Cm_LoadBspLeafBrushes(void) {
 	const int32_t num_leaf_brushes = cm_bsp.file.num_leaf_brushes;
 	const int32_t *in = cm_bsp.file.leaf_brushes;
 
-	int32_t *out = cm_bsp.leaf_brushes = Mem_TagMalloc(sizeof(int32_t) * (num_leaf_brushes + 1),
-	                                      MEM_TAG_COLLISION); // extra for box hull
+	int32_t *out = cm_bsp.leaf_brushes = Mem_TagMalloc(sizeof(int32_t) * num_leaf_brushes,
+	                                      MEM_TAG_COLLISION);
 
 	for (int32_t i = 0; i < num_leaf_brushes; i++, in++, out++) {
 
@@ -156,25 +156,15 @@ static void Cm_LoadBspBrushSides(void) {
 	const bsp_brush_side_t *in = cm_bsp.file.brush_sides;
 
 	cm_bsp_brush_side_t *out = cm_bsp.brush_sides = Mem_TagMalloc(sizeof(cm_bsp_brush_side_t) *
-				(num_brush_sides + 6), MEM_TAG_COLLISION); // extra for box hull
+				num_brush_sides, MEM_TAG_COLLISION);
 
 	for (int32_t i = 0; i < num_brush_sides; i++, in++, out++) {
 
-		const int32_t p = in->plane_num;
-
-		if (p >= cm_bsp.file.num_planes) {
-			Com_Error(ERROR_DROP, "Brush side %d has invalid plane %d\n", i, p);
-		}
-
-		out->plane = &cm_bsp.planes[p];
+		out->plane = &cm_bsp.planes[in->plane_num];
 
 		if (in->texinfo < 0) {
 			out->texinfo = &null_texinfo;
 		} else {
-			if (in->texinfo >= cm_bsp.file.num_texinfo) {
-				Com_Error(ERROR_DROP, "Brush side %d has invalid texinfo %d\n", i, in->texinfo);
-			}
-
 			out->texinfo = &cm_bsp.texinfos[in->texinfo];
 		}
 	}
@@ -188,8 +178,8 @@ static void Cm_LoadBspBrushes(void) {
 	const int32_t num_brushes = cm_bsp.file.num_brushes;
 	const bsp_brush_t *in = cm_bsp.file.brushes;
 
-	cm_bsp_brush_t *out = cm_bsp.brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * (num_brushes + 1),
-										   MEM_TAG_COLLISION); // extra for box hull
+	cm_bsp_brush_t *out = cm_bsp.brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * num_brushes,
+										   MEM_TAG_COLLISION);
 
 	for (int32_t i = 0; i < num_brushes; i++, in++, out++) {
 
@@ -218,6 +208,64 @@ static void Cm_LoadBspInlineModels(void) {
 	}
 }
 
+/**
+ * @brief Verifies that every brush side references a valid plane and texinfo, so that
+ * Cm_LoadBspBrushSides need not raise an error while the file is mapped.
+ */
+static _Bool Cm_VerifyBspBrushSides(void) {
+
+	const bsp_brush_side_t *in = cm_bsp.file.brush_sides;
+	for (int32_t i = 0; i < cm_bsp.file.num_brush_sides; i++, in++) {
+
+		if (in->plane_num < 0 || in->plane_num >= cm_bsp.file.num_planes) {
+			Com_Warn("Brush side %d has invalid plane %d\n", i, in->plane_num);
+			return false;
+		}
+
+		if (in->texinfo >= cm_bsp.file.num_texinfo) {
+			Com_Warn("Brush side %d has invalid texinfo %d\n", i, in->texinfo);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Verifies that the visibility rows, and any leaf cluster that indexes them, lie within
+ * the visibility lump. Maps without visibility data are always valid.
+ */
+static _Bool Cm_VerifyBspVis(void) {
+
+	if (cm_bsp.file.vis_size == 0) {
+		return true;
+	}
+
+	if (cm_bsp.file.vis_size < (int32_t) sizeof(bsp_vis_t)) {
+		return false;
+	}
+
+	const bsp_vis_t *vis = cm_bsp.file.vis;
+
+	if (vis->num_clusters < 0 || vis->cluster_bytes != (vis->num_clusters + 7) >> 3) {
+		return false;
+	}
+
+	const int64_t rows = 2 * (int64_t) vis->num_clusters * vis->cluster_bytes;
+	if ((int64_t) sizeof(bsp_vis_t) + rows > cm_bsp.file.vis_size) {
+		return false;
+	}
+
+	const bsp_leaf_t *leaf = cm_bsp.file.leafs;
+	for (int32_t i = 0; i < cm_bsp.file.num_leafs; i++, leaf++) {
+		if (leaf->cluster >= vis->num_clusters) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * @brief
  */
@@ -272,7 +320,8 @@ static void Cm_LoadBspMaterials(const char *name) {
 	(1 << BSP_LUMP_LEAF_BRUSHES) | \
 	(1 << BSP_LUMP_BRUSHES) | \
 	(1 << BSP_LUMP_BRUSH_SIDES) | \
-	(1 << BSP_LUMP_MODELS)
+	(1 << BSP_LUMP_MODELS) | \
+	(1 << BSP_LUMP_VIS)
 
 /**
  * @brief Loads in the BSP and all sub-models for collision detection. This
@@ -315,23 +364,38 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 		return &cm_bsp.models[0];
 	}
 
-	// load the common BSP structure and the lumps we need
-	bsp_header_t *file;
+	// map the common BSP structure and reference the lumps we need
+	void *buffer;
 
-	if (Fs_Load(name, (void **) &file) == -1) {
+	if (Fs_Map(name, &buffer) == -1) {
 		Com_Error(ERROR_DROP, "Failed to load %s\n", name);
 	}
 
+	const bsp_header_t *file = buffer;
+
 	if (Bsp_Verify(file) == -1) {
-		Fs_Free(file);
+		Fs_Unmap(buffer);
 		Com_Error(ERROR_DROP, "Failed to verify %s\n", name);
 	}
 
-	if (!Bsp_LoadLumps(file, &cm_bsp.file, CM_BSP_LUMPS)) {
-		Fs_Free(file);
+	if (!Bsp_MapLumps(file, &cm_bsp.file, CM_BSP_LUMPS)) {
+		Bsp_UnloadLumps(&cm_bsp.file, BSP_LUMPS_ALL);
+		Fs_Unmap(buffer);
 		Com_Error(ERROR_DROP, "Lump error loading %s\n", name);
 	}
 
+	if (!Cm_VerifyBspVis()) {
+		Bsp_UnloadLumps(&cm_bsp.file, BSP_LUMPS_ALL);
+		Fs_Unmap(buffer);
+		Com_Error(ERROR_DROP, "Invalid visibility data in %s\n", name);
+	}
+
+	if (!Cm_VerifyBspBrushSides()) {
+		Bsp_UnloadLumps(&cm_bsp.file, BSP_LUMPS_ALL);
+		Fs_Unmap(buffer);
+		Com_Error(ERROR_DROP, "Invalid brush sides in %s\n", name);
+	}
+
 	// in theory, by this point the BSP is valid - now we have to create the cm_
 	// structures out of the raw file data
 	if (size) {
@@ -341,8 +405,6 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 
 	g_strlcpy(cm_bsp.name, name, sizeof(cm_bsp.name));
 
-	Fs_Free(file);
-
 	Cm_LoadBspMaterials(name);
 
 	Cm_LoadBspEntities();
@@ -355,7 +417,11 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 	Cm_LoadBspBrushes();
 	Cm_LoadBspInlineModels();
 
-	Cm_InitBoxHull();
+	// the lumps that outlive the load (e.g. vis, entities) must not reference the file,
+	// which could otherwise be truncated or locked beneath us for the life of the level
+	Bsp_CopyMappedLumps(&cm_bsp.file);
+
+	Fs_Unmap(buffer);
 
 	return &cm_bsp.models[0];
 }
@@ -423,6 +489,90 @@ int32_t Cm_LeafCluster(const int32_t leaf_num) {
 	return cm_bsp.leafs[leaf_num].cluster;
 }
 
+/**
+ * @return The number of visibility clusters, or 0 if the BSP has no visibility data.
+ */
+int32_t Cm_NumClusters(void) {
+
+	if (cm_bsp.file.vis_size == 0) {
+		return 0;
+	}
+
+	return cm_bsp.file.vis->num_clusters;
+}
+
+/**
+ * @return The visibility row at the specified offset for the given cluster, or `NULL`.
+ */
+static const byte *Cm_ClusterVis(const int32_t cluster, const int32_t offset) {
+
+	if (cluster < 0 || cluster >= Cm_NumClusters()) {
+		return NULL;
+	}
+
+	const bsp_vis_t *vis = cm_bsp.file.vis;
+	const byte *rows = (const byte *) vis + sizeof(bsp_vis_t);
+
+	return rows + (offset + cluster) * vis->cluster_bytes;
+}
+
+/**
+ * @brief Resolves the potentially visible set of the specified cluster.
+ * @return The PVS bit vector, with one bit per cluster, or `NULL` if the BSP has no visibility
+ * data or the cluster is invalid. A `NULL` PVS should be interpreted as everything being visible.
+ */
+const byte *Cm_ClusterPVS(const int32_t cluster) {
+	return Cm_ClusterVis(cluster, 0);
+}
+
+/**
+ * @brief Resolves the potentially hearable set of the specified cluster.
+ * @return The PHS bit vector, with one bit per cluster, or `NULL` if the BSP has no visibility
+ * data or the cluster is invalid. A `NULL` PHS should be interpreted as everything being hearable.
+ */
+const byte *Cm_ClusterPHS(const int32_t cluster) {
+	return Cm_ClusterVis(cluster, Cm_NumClusters());
+}
+
+/**
+ * @return True if the specified cluster is set in the visibility vector, false otherwise.
+ */
+_Bool Cm_ClusterVisible(const byte *vis, const int32_t cluster) {
+
+	if (vis == NULL || cluster < 0) {
+		return true;
+	}
+
+	return vis[cluster >> 3] & (1 << (cluster & 7));
+}
+
+/**
+ * @return True if any leaf beneath the specified node is in a cluster set in the visibility
+ * vector, false otherwise.
+ */
+_Bool Cm_HeadnodeVisible(const int32_t node_num, const byte *vis) {
+
+	if (vis == NULL) {
+		return true;
+	}
+
+	if (node_num < 0) {
+		const int32_t cluster = cm_bsp.leafs[-1 - node_num].cluster;
+		if (cluster == -1) {
+			return false;
+		}
+		return Cm_ClusterVisible(vis, cluster);
+	}
+
+	const cm_bsp_node_t *node = &cm_bsp.nodes[node_num];
+
+	if (Cm_HeadnodeVisible(node->children[0], vis)) {
+		return true;
+	}
+
+	return Cm_HeadnodeVisible(node->children[1], vis);
+}
+
 /**
  * @brief
  */
@@ -34,6 +34,12 @@ cm_entity_t *Cm_Worldspawn(void);
 int32_t Cm_LeafContents(const int32_t leaf_num);
 int32_t Cm_LeafCluster(const int32_t leaf_num);
 
+int32_t Cm_NumClusters(void);
+const byte *Cm_ClusterPVS(const int32_t cluster);
+const byte *Cm_ClusterPHS(const int32_t cluster);
+_Bool Cm_ClusterVisible(const byte *vis, const int32_t cluster);
+_Bool Cm_HeadnodeVisible(const int32_t node_num, const byte *vis);
+
 typedef struct {
 	char name[MAX_QPATH];
 	
@@ -175,71 +175,31 @@ int32_t Cm_BoxOnPlaneSide(const box3_t bounds, const cm_bsp_plane_t *p) {
 	return side;
 }
 
-/**
- * @brief Bounding box to BSP tree structure for box positional testing.
- */
-typedef struct {
-	int32_t head_node;
-	cm_bsp_plane_t *planes;
-	cm_bsp_brush_t *brush;
-	cm_bsp_leaf_t *leaf;
-} cm_box_t;
-
-static cm_box_t cm_box;
+__thread cm_box_t cm_box;
 
 /**
- * @brief Appends a brush (6 nodes, 12 planes) opaquely to the primary BSP
- * structure to represent the bounding box used for Cm_BoxLeafnums. This brush
- * is never tested by the rest of the collision detection code, as it resides
- * just beyond the parsed size of the map.
+ * @brief Initializes the calling thread's box hull for the current map. The box hull
+ * is never tested by the rest of the collision detection code, as it resides just
+ * beyond the parsed size of the map.
  */
-void Cm_InitBoxHull(void) {
+static void Cm_InitBoxHull(void) {
 	static cm_bsp_texinfo_t null_texinfo;
 
-	if (cm_bsp.file.num_planes + 12 > MAX_BSP_PLANES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_PLANES\n");
-	}
-
-	if (cm_bsp.file.num_nodes + 6 > MAX_BSP_NODES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_NODES\n");
-	}
-
-	if (cm_bsp.file.num_leafs + 1 > MAX_BSP_LEAFS) {
-		Com_Error(ERROR_DROP, "MAX_BSP_LEAFS\n");
-	}
-
-	if (cm_bsp.file.num_leaf_brushes + 1 > MAX_BSP_LEAF_BRUSHES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_LEAF_BRUSHES\n");
-	}
-
-	if (cm_bsp.file.num_brushes + 1 > MAX_BSP_BRUSHES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_BRUSHES\n");
-	}
-
-	if (cm_bsp.file.num_brush_sides + 6 > MAX_BSP_BRUSH_SIDES) {
-		Com_Error(ERROR_DROP, "MAX_BSP_BRUSH_SIDES\n");
-	}
+	memset(&cm_box, 0, sizeof(cm_box));
 
 	// head node
 	cm_box.head_node = cm_bsp.file.num_nodes;
 
-	// planes
-	cm_box.planes = &cm_bsp.planes[cm_bsp.file.num_planes];
-
 	// leaf
-	cm_box.leaf = &cm_bsp.leafs[cm_bsp.file.num_leafs];
-	cm_box.leaf->contents = CONTENTS_MONSTER;
-	cm_box.leaf->first_leaf_brush = cm_bsp.file.num_leaf_brushes;
-	cm_box.leaf->num_leaf_brushes = 1;
-
-	// leaf brush
-	cm_bsp.leaf_brushes[cm_bsp.file.num_leaf_brushes] = cm_bsp.file.num_brushes;
+	cm_box.leaf_num = cm_bsp.file.num_leafs;
+	cm_box.leaf.contents = CONTENTS_MONSTER;
+	cm_box.leaf.first_leaf_brush = cm_bsp.file.num_leaf_brushes;
+	cm_box.leaf.num_leaf_brushes = 1;
 
 	// brush
-	cm_box.brush = &cm_bsp.brushes[cm_bsp.file.num_brushes];
-	cm_box.brush->num_sides = 6;
-	cm_box.brush->sides = cm_bsp.brush_sides + cm_bsp.file.num_brush_sides;
-	cm_box.brush->contents = CONTENTS_MONSTER;
+	cm_box.brush.num_sides = 6;
+	cm_box.brush.sides = cm_box.sides;
+	cm_box.brush.contents = CONTENTS_MONSTER;
 
 	for (int32_t i = 0; i < 6; i++) {
 
@@ -259,29 +219,36 @@ void Cm_InitBoxHull(void) {
 		const int32_t s = i & 1;
 
 		// fill in nodes, one per side
-		cm_bsp_node_t *node = &cm_bsp.nodes[cm_box.head_node + i];
-		node->plane = cm_bsp.planes + (cm_bsp.file.num_planes + i * 2);
-		node->children[s] = -1 - cm_bsp.file.num_leafs;
+		cm_bsp_node_t *node = &cm_box.nodes[i];
+		node->plane = &cm_box.planes[i * 2];
+		node->children[s] = -1 - cm_box.leaf_num;
 		if (i != 5) {
 			node->children[s ^ 1] = cm_box.head_node + i + 1;
 		} else {
-			node->children[s ^ 1] = -1 - cm_bsp.file.num_leafs;
+			node->children[s ^ 1] = -1 - cm_box.leaf_num;
 		}
 
 		// fill in brush sides, one per side
-		cm_bsp_brush_side_t *side = &cm_bsp.brush_sides[cm_bsp.file.num_brush_sides + i];
-		side->plane = cm_bsp.planes + (cm_bsp.file.num_planes + i * 2 + s);
+		cm_bsp_brush_side_t *side = &cm_box.sides[i];
+		side->plane = &cm_box.planes[i * 2 + s];
 		side->texinfo = &null_texinfo;
 	}
 }
 
 /**
- * @brief Initializes the box hull for the specified bounds, returning the
- * head node for the resulting box hull tree.
+ * @brief Initializes the calling thread's box hull for the specified bounds, returning
+ * the head node for the resulting box hull tree. The box hull remains valid until the
+ * calling thread sets it again.
  */
 int32_t Cm_SetBoxHull(const box3_t bounds, const int32_t contents) {
 
-	cm_box.brush->bounds = bounds;
+	if (cm_box.brush.num_sides == 0 ||
+		cm_box.head_node != cm_bsp.file.num_nodes ||
+		cm_box.leaf_num != cm_bsp.file.num_leafs) {
+		Cm_InitBoxHull();
+	}
+
+	cm_box.brush.bounds = bounds;
 
 	cm_box.planes[0].dist = bounds.maxs.x;
 	cm_box.planes[1].dist = -bounds.maxs.x;
@@ -296,7 +263,7 @@ int32_t Cm_SetBoxHull(const box3_t bounds, const int32_t contents) {
 	cm_box.planes[10].dist = bounds.mins.z;
 	cm_box.planes[11].dist = -bounds.mins.z;
 
-	cm_box.leaf->contents = cm_box.brush->contents = contents;
+	cm_box.leaf.contents = cm_box.brush.contents = contents;
 
 	return cm_box.head_node;
 }
@@ -312,7 +279,7 @@ int32_t Cm_PointLeafnum(const vec3_t p, int32_t head_node) {
 
 	int32_t num = head_node;
 	while (num >= 0) {
-		const cm_bsp_node_t *node = cm_bsp.nodes + num;
+		const cm_bsp_node_t *node = Cm_Node(num);
 		const float dist = Cm_DistanceToPlane(p, node->plane);
 		if (dist < 0.f) {
 			num = node->children[1];
@@ -340,7 +307,7 @@ int32_t Cm_PointContents(const vec3_t p, int32_t head_node) {
 
 	const int32_t leaf_num = Cm_PointLeafnum(p, head_node);
 
-	return cm_bsp.leafs[leaf_num].contents;
+	return Cm_Leaf(leaf_num)->contents;
 }
 
 /**
@@ -368,7 +335,7 @@ static void Cm_BoxLeafnums_r(cm_box_leafnum_data *data, int32_t node_num) {
 			return;
 		}
 
-		const cm_bsp_node_t *node = &cm_bsp.nodes[node_num];
+		const cm_bsp_node_t *node = Cm_Node(node_num);
 		cm_bsp_plane_t plane = *node->plane;
 
 		if (data->matrix) {
@@ -66,5 +66,72 @@ int32_t Cm_TransformedPointContents(const vec3_t p, int32_t head_node, const mat
 size_t Cm_BoxLeafnums(const box3_t bounds, int32_t *list, size_t len, int32_t *top_node, int32_t head_node, const mat4_t *matrix);
 
 #ifdef __CM_LOCAL_H__
-void Cm_InitBoxHull(void);
+
+#include "cm_model.h"
+
+/**
+ * @brief Bounding box to BSP tree structure for box positional testing. The box hull
+ * (6 nodes, 12 planes, 1 leaf and 1 brush) is numbered just beyond the parsed size of
+ * the map, but each thread has its own, so that traces may run concurrently.
+ */
+typedef struct {
+	int32_t head_node;
+	int32_t leaf_num;
+	cm_bsp_plane_t planes[12];
+	cm_bsp_node_t nodes[6];
+	cm_bsp_leaf_t leaf;
+	cm_bsp_brush_side_t sides[6];
+	cm_bsp_brush_t brush;
+} cm_box_t;
+
+extern __thread cm_box_t cm_box;
+
+/**
+ * @return The node by the specified number, which may be the calling thread's box hull.
+ */
+static inline const cm_bsp_node_t *Cm_Node(int32_t node_num) {
+
+	if (node_num < cm_bsp.file.num_nodes) {
+		return &cm_bsp.nodes[node_num];
+	}
+
+	return &cm_box.nodes[node_num - cm_bsp.file.num_nodes];
+}
+
+/**
+ * @return The leaf by the specified number, which may be the calling thread's box hull.
+ */
+static inline const cm_bsp_leaf_t *Cm_Leaf(int32_t leaf_num) {
+
+	if (leaf_num < cm_bsp.file.num_leafs) {
+		return &cm_bsp.leafs[leaf_num];
+	}
+
+	return &cm_box.leaf;
+}
+
+/**
+ * @return The brush number of the specified leaf brush, which may be the box hull brush.
+ */
+static inline int32_t Cm_LeafBrush(int32_t leaf_brush) {
+
+	if (leaf_brush < cm_bsp.file.num_leaf_brushes) {
+		return cm_bsp.leaf_brushes[leaf_brush];
+	}
+
+	return cm_bsp.file.num_brushes;
+}
+
+/**
+ * @return The brush by the specified number, which may be the calling thread's box hull.
+ */
+static inline const cm_bsp_brush_t *Cm_Brush(int32_t brush_num) {
+
+	if (brush_num < cm_bsp.file.num_brushes) {
+		return &cm_bsp.brushes[brush_num];
+	}
+
+	return &cm_box.brush;
+}
+
 #endif /* __CM_LOCAL_H__ */
@@ -205,7 +205,7 @@ static void Cm_TestBoxInBrush(cm_trace_data_t *data, const cm_bsp_brush_t *brush
  */
 static void Cm_TraceToLeaf(cm_trace_data_t *data, int32_t leaf_num) {
 
-	const cm_bsp_leaf_t *leaf = &cm_bsp.leafs[leaf_num];
+	const cm_bsp_leaf_t *leaf = Cm_Leaf(leaf_num);
 
 	if (!(leaf->contents & data->contents)) {
 		return;
@@ -213,13 +213,13 @@ static void Cm_TraceToLeaf(cm_trace_data_t *data, int32_t leaf_num) {
 
 	// trace line against all brushes in the leaf
 	for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
-		const int32_t brush_num = cm_bsp.leaf_brushes[leaf->first_leaf_brush + i];
+		const int32_t brush_num = Cm_LeafBrush(leaf->first_leaf_brush + i);
 
 		if (Cm_BrushAlreadyTested(brush_num)) {
 			continue; // already checked this brush in another leaf
 		}
 
-		const cm_bsp_brush_t *b = &cm_bsp.brushes[brush_num];
+		const cm_bsp_brush_t *b = Cm_Brush(brush_num);
 
 		if (!(b->contents & data->contents)) {
 			continue;
@@ -238,7 +238,7 @@ static void Cm_TraceToLeaf(cm_trace_data_t *data, int32_t leaf_num) {
  */
 static void Cm_TestInLeaf(cm_trace_data_t *data, int32_t leaf_num) {
 
-	const cm_bsp_leaf_t *leaf = &cm_bsp.leafs[leaf_num];
+	const cm_bsp_leaf_t *leaf = Cm_Leaf(leaf_num);
 
 	if (!(leaf->contents & data->contents)) {
 		return;
@@ -246,13 +246,13 @@ static void Cm_TestInLeaf(cm_trace_data_t *data, int32_t leaf_num) {
 
 	// trace line against all brushes in the leaf
 	for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
-		const int32_t brush_num = cm_bsp.leaf_brushes[leaf->first_leaf_brush + i];
+		const int32_t brush_num = Cm_LeafBrush(leaf->first_leaf_brush + i);
 
 		if (Cm_BrushAlreadyTested(brush_num)) {
 			continue; // already checked this brush in another leaf
 		}
 
-		const cm_bsp_brush_t *b = &cm_bsp.brushes[brush_num];
+		const cm_bsp_brush_t *b = Cm_Brush(brush_num);
 
 		if (!(b->contents & data->contents)) {
 			continue;
@@ -284,7 +284,7 @@ static void Cm_TraceToNode(cm_trace_data_t *data, int32_t num, float p1f, float
 
 	// find the point distances to the separating plane
 	// and the offset for the size of the box
-	const cm_bsp_node_t *node = cm_bsp.nodes + num;
+	const cm_bsp_node_t *node = Cm_Node(num);
 	cm_bsp_plane_t plane = *node->plane;
 
 	if (data->matrix) {
@@ -383,6 +383,8 @@ static void Cm_TraceToNode(cm_trace_data_t *data, int32_t num, float p1f, float
 cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const box3_t bounds, const int32_t head_node,
 					   const int32_t contents, const mat4_t *matrix, const mat4_t *inverse_matrix) {
 
+	PROFILE_SCOPE_FINE("Cm_BoxTrace");
+
 	cm_trace_data_t data = {
 		.start = start,
 		.end = end,
@@ -20,6 +20,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 
 #include "atlas.h"
 
@@ -128,30 +129,102 @@ static gint Atlas_NodeComparator(gconstpointer a, gconstpointer b, gpointer data
 }
 
 /**
- * @brief Compiles the layered `atlas` into the given list of equally sized surfaces.
- * @details If all nodes fit in the given surface(s), `0` is returned. If a node overflows,
- * the index of that node is returned. If a node exceeds the bounds of the output surfaces,
- * `-1` is returned.
- * @param atlas The atlas.
- * @param start The node index to start packing from.
- * @param ... The layered surfaces list to blit nodes to, which must be `atlas->layers` in length.
- * @return `0` on success, or the index of the next `start` node. `-1` on error.
+ * @brief A skyline segment: the lowest free row `y` spanning `w` columns from `x`.
  */
-int32_t Atlas_Compile(atlas_t *atlas, int32_t start, ...) {
+typedef struct {
+	int32_t x, y, w;
+} atlas_skyline_t;
 
-	assert(atlas);
+/**
+ * @brief Finds the row at which a node of the given size would rest on the skyline,
+ * starting at segment `index`.
+ * @return The row, or `-1` if the node does not fit there.
+ */
+static int32_t Atlas_SkylineFit(const atlas_skyline_t *skyline, int32_t count, int32_t index,
+								int32_t w, int32_t h, int32_t width, int32_t height) {
 
-	SDL_Surface *surfaces[atlas->layers];
+	const int32_t x = skyline[index].x;
+	if (x + w > width) {
+		return -1;
+	}
 
-	va_list args;
-	va_start(args, start);
+	int32_t y = 0;
+	for (int32_t i = index, remaining = w; remaining > 0; i++) {
+		assert(i < count);
 
-	for (int32_t i = 0; i < atlas->layers; i++) {
-		surfaces[i] = va_arg(args, SDL_Surface *);
+		y = MAX(y, skyline[i].y);
+		if (y + h > height) {
+			return -1;
+		}
+
+		remaining -= skyline[i].w;
 	}
 
-	va_end(args);
-	assert(surfaces[0]);
+	return y;
+}
+
+/**
+ * @brief Raises the skyline beneath a node placed at segment `index`.
+ * @return The new number of segments.
+ */
+static int32_t Atlas_SkylineInsert(atlas_skyline_t *skyline, int32_t count, int32_t index,
+								   int32_t y, int32_t w, int32_t h) {
+
+	const atlas_skyline_t segment = { .x = skyline[index].x, .y = y + h, .w = w };
+
+	memmove(skyline + index + 1, skyline + index, (count - index) * sizeof(*skyline));
+	skyline[index] = segment;
+	count++;
+
+	// trim or remove the segments now covered by the node
+
+	for (int32_t i = index + 1; i < count; ) {
+		const int32_t covered = segment.x + segment.w - skyline[i].x;
+		if (covered <= 0) {
+			break;
+		}
+
+		if (covered < skyline[i].w) {
+			skyline[i].x += covered;
+			skyline[i].w -= covered;
+			break;
+		}
+
+		memmove(skyline + i, skyline + i + 1, (count - i - 1) * sizeof(*skyline));
+		count--;
+	}
+
+	// and merge neighboring segments of equal height
+
+	for (int32_t i = 0; i < count - 1; ) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].w += skyline[i + 1].w;
+			memmove(skyline + i + 1, skyline + i + 2, (count - i - 2) * sizeof(*skyline));
+			count--;
+		} else {
+			i++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief Packs the layered `atlas` into the given dimensions, without blitting.
+ * @details Nodes are sorted by the atlas comparator, and each is then placed at the lowest
+ * position on a skyline of the area packed so far, preferring the leftmost. Node coordinates
+ * and tags are written as nodes are placed, so that `Atlas_Blit` may later copy them to the
+ * output surfaces. Packing is cheap compared to blitting, and so callers searching for the
+ * smallest sufficient dimensions should pack each candidate, and blit only once.
+ * @param atlas The atlas.
+ * @param start The node index to start packing from.
+ * @param width The output width.
+ * @param height The output height.
+ * @return `0` on success, or the index of the next `start` node. `-1` on error.
+ */
+int32_t Atlas_Pack(atlas_t *atlas, int32_t start, int32_t width, int32_t height) {
+
+	assert(atlas);
 
 	atlas->tag++;
 
@@ -159,30 +232,61 @@ int32_t Atlas_Compile(atlas_t *atlas, int32_t start, ...) {
 
 	g_ptr_array_sort_with_data(atlas->nodes, Atlas_NodeComparator, &comparator);
 
-	int32_t x = 0, y = 0, row = 0;
+	// each placement adds at most one segment to the skyline
+
+	atlas_skyline_t *skyline = g_malloc((atlas->nodes->len + 2) * sizeof(*skyline));
+	int32_t count = 0;
+
+	skyline[count++] = (atlas_skyline_t) { .x = 0, .y = 0, .w = width };
+
+	int32_t res = 0;
 
 	for (int32_t i = start; i < (int32_t) atlas->nodes->len; i++) {
 		atlas_node_t *node = g_ptr_array_index(atlas->nodes, i);
 
-		if (node->w > surfaces[0]->w ||
-			node->h > surfaces[0]->h) {
-			return -1;
+		if (node->w > width || node->h > height) {
+			res = -1;
+			break;
 		}
 
-		if (y + node->h > surfaces[0]->h) {
-			return i;
+		int32_t best = -1, best_y = INT32_MAX;
+
+		for (int32_t j = 0; j < count; j++) {
+			const int32_t y = Atlas_SkylineFit(skyline, count, j, node->w, node->h, width, height);
+			if (y != -1 && y < best_y) {
+				best = j;
+				best_y = y;
+			}
 		}
 
-		if (x + node->w > surfaces[0]->w) {
-			x = 0;
-			y += row;
-			row = 0;
+		if (best == -1) {
+			res = i;
+			break;
 		}
 
-		node->x = x;
-		node->y = y;
+		node->x = skyline[best].x;
+		node->y = best_y;
 		node->tag = atlas->tag;
 
+		count = Atlas_SkylineInsert(skyline, count, best, best_y, node->w, node->h);
+	}
+
+	g_free(skyline);
+	return res;
+}
+
+/**
+ * @brief Blits the nodes placed by the most recent `Atlas_Pack` to the given surfaces.
+ */
+static void Atlas_BlitSurfaces(const atlas_t *atlas, SDL_Surface **surfaces) {
+
+	for (guint i = 0; i < atlas->nodes->len; i++) {
+		const atlas_node_t *node = g_ptr_array_index(atlas->nodes, i);
+
+		if (node->tag != atlas->tag) {
+			continue;
+		}
+
 		for (int32_t layer = 0; layer < atlas->layers; layer++) {
 
 			SDL_Surface *src = node->surfaces[layer];
@@ -194,12 +298,64 @@ int32_t Atlas_Compile(atlas_t *atlas, int32_t start, ...) {
 				});
 			}
 		}
+	}
+}
+
+/**
+ * @brief Blits the nodes placed by the most recent `Atlas_Pack` to the given surfaces.
+ * @param atlas The atlas.
+ * @param ... The layered surfaces list to blit nodes to, which must be `atlas->layers` in length.
+ */
+void Atlas_Blit(atlas_t *atlas, ...) {
+
+	assert(atlas);
+
+	SDL_Surface *surfaces[atlas->layers];
+
+	va_list args;
+	va_start(args, atlas);
+
+	for (int32_t i = 0; i < atlas->layers; i++) {
+		surfaces[i] = va_arg(args, SDL_Surface *);
+	}
+
+	va_end(args);
+	assert(surfaces[0]);
+
+	Atlas_BlitSurfaces(atlas, surfaces);
+}
+
+/**
+ * @brief Compiles the layered `atlas` into the given list of equally sized surfaces.
+ * @details If all nodes fit in the given surface(s), `0` is returned. If a node overflows,
+ * the index of that node is returned. If a node exceeds the bounds of the output surfaces,
+ * `-1` is returned. Nodes which were packed are blitted in either case.
+ * @param atlas The atlas.
+ * @param start The node index to start packing from.
+ * @param ... The layered surfaces list to blit nodes to, which must be `atlas->layers` in length.
+ * @return `0` on success, or the index of the next `start` node. `-1` on error.
+ */
+int32_t Atlas_Compile(atlas_t *atlas, int32_t start, ...) {
 
-		x += node->w;
-		row = MAX(row, node->h);
+	assert(atlas);
+
+	SDL_Surface *surfaces[atlas->layers];
+
+	va_list args;
+	va_start(args, start);
+
+	for (int32_t i = 0; i < atlas->layers; i++) {
+		surfaces[i] = va_arg(args, SDL_Surface *);
 	}
 
-	return 0;
+	va_end(args);
+	assert(surfaces[0]);
+
+	const int32_t res = Atlas_Pack(atlas, start, surfaces[0]->w, surfaces[0]->h);
+
+	Atlas_BlitSurfaces(atlas, surfaces);
+
+	return res;
 }
 
 /**
@@ -97,5 +97,7 @@ typedef struct atlas_s {
 atlas_t *Atlas_Create(int32_t layers);
 atlas_node_t *Atlas_Insert(atlas_t *atlas, ...);
 atlas_node_t *Atlas_Find(atlas_t *atlas, int32_t layer, SDL_Surface *surface);
+int32_t Atlas_Pack(atlas_t *atlas, int32_t start, int32_t width, int32_t height);
+void Atlas_Blit(atlas_t *atlas, ...);
 int32_t Atlas_Compile(atlas_t *atlas, int32_t start, ...);
 void Atlas_Destroy(atlas_t *atlas);
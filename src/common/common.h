@@ -32,6 +32,7 @@
 #include "installer.h"
 #include "mem.h"
 #include "mem_buf.h"
+#include "profile.h"
 #include "sys.h"
 #include "thread.h"
 
@@ -52,6 +53,36 @@
  */
 #define PROTOCOL_MAJOR		1025
 
+/**
+ * @brief Optional protocol extensions, advertised by the client when connecting.
+ * The server enables the subset it supports for that client, and returns it in
+ * its client_connect reply. Clients that do not advertise any extensions use the
+ * baseline protocol.
+ */
+#define PROTOCOL_PACKED_FRAMES	(1 << 0)
+#define PROTOCOL_COMPRESSION	(1 << 1)
+#define PROTOCOL_STREAMED_DOWNLOADS	(1 << 2)
+#define PROTOCOL_EXTENSIONS		(PROTOCOL_PACKED_FRAMES | PROTOCOL_COMPRESSION | PROTOCOL_STREAMED_DOWNLOADS)
+
+/**
+ * @brief Streamed downloads (PROTOCOL_STREAMED_DOWNLOADS) deliver a file in fragments
+ * of DOWNLOAD_FRAGMENT_SIZE bytes, sent unreliably within a sliding window of
+ * DOWNLOAD_WINDOW fragments. The client selectively acknowledges the fragments it
+ * has received, and the server retransmits those that go unacknowledged. The stream
+ * is announced over the reliable channel, while each fragment is sent in its own
+ * out-of-band datagram, so that the channel neither sequences nor drops them:
+ *
+ * SV_CMD_DOWNLOAD [short] DOWNLOAD_STREAM [byte] id [long] size [long] offset
+ * -1 [string] download_fragment [byte] id [long] fragment [short] len [len bytes]
+ *
+ * The client acknowledges with `download_ack <id> <base> <mask>`, where all fragments
+ * before `base` have been received, and bit `n` of `mask` is set if fragment
+ * `base + n` has been received. The window may therefore not exceed 64 fragments.
+ */
+#define DOWNLOAD_FRAGMENT_SIZE	1280
+#define DOWNLOAD_WINDOW			64
+#define DOWNLOAD_STREAM			-2
+
 /**
  * @brief The IP address of the master server, where the authoritative list of
  * game servers is maintained.
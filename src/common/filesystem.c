@@ -66,8 +66,44 @@ typedef struct {
 	 * they are freed (Fs_Free) in all code paths.
 	 */
 	GHashTable *loaded_files;
+
+	/**
+	 * @brief Files mapped (Fs_Map) into memory, keyed by their buffer. Mappings are
+	 * reference counted so that subsystems mapping the same file share one buffer.
+	 */
+	GHashTable *mapped_files;
 } fs_state_t;
 
+/**
+ * @brief A file mapped into memory with Fs_Map.
+ */
+typedef struct {
+	/**
+	 * @brief The Quake path of the mapped file.
+	 */
+	char *filename;
+
+	/**
+	 * @brief The mapped file, or NULL if the file resides in an archive and was loaded.
+	 */
+	GMappedFile *mapped_file;
+
+	/**
+	 * @brief The file contents.
+	 */
+	void *buffer;
+
+	/**
+	 * @brief The file length.
+	 */
+	int64_t len;
+
+	/**
+	 * @brief The number of outstanding Fs_Map calls for this file.
+	 */
+	int32_t ref_count;
+} fs_mapped_file_t;
+
 static fs_state_t fs_state;
 
 /**
@@ -395,6 +431,101 @@ void Fs_Free(void *buffer) {
 	}
 }
 
+/**
+ * @brief GHRFunc for finding a mapped file by name.
+ */
+static gboolean Fs_MappedFile(gpointer key, gpointer value, gpointer data) {
+	return !g_strcmp0(((fs_mapped_file_t *) value)->filename, (const char *) data);
+}
+
+/**
+ * @brief Maps the specified file into memory, read-only. Files residing in directories
+ * are mapped by the operating system, and their pages are only read as they are touched.
+ * Files residing in archives are loaded. If the file is already mapped, the existing
+ * buffer is shared. Be sure to release the buffer when finished with Fs_Unmap.
+ *
+ * @return The file length, or -1 on error.
+ */
+int64_t Fs_Map(const char *filename, void **buffer) {
+
+	fs_mapped_file_t *map = g_hash_table_find(fs_state.mapped_files, Fs_MappedFile, (gpointer) filename);
+	if (map) {
+		map->ref_count++;
+		*buffer = map->buffer;
+		return map->len;
+	}
+
+	GMappedFile *mapped_file = NULL;
+
+	const char *dir = Fs_RealDir(filename);
+	if (dir && g_file_test(dir, G_FILE_TEST_IS_DIR)) {
+
+		gchar *path = g_build_filename(dir, filename, NULL);
+		mapped_file = g_mapped_file_new(path, false, NULL);
+		g_free(path);
+	}
+
+	int64_t len;
+
+	if (mapped_file && g_mapped_file_get_length(mapped_file)) {
+		len = (int64_t) g_mapped_file_get_length(mapped_file);
+		*buffer = g_mapped_file_get_contents(mapped_file);
+	} else {
+		if (mapped_file) {
+			g_mapped_file_unref(mapped_file);
+			mapped_file = NULL;
+		}
+
+		len = Fs_Load(filename, buffer);
+		if (*buffer == NULL) {
+			return len;
+		}
+	}
+
+	map = Mem_TagMalloc(sizeof(fs_mapped_file_t), MEM_TAG_FS);
+
+	map->filename = Mem_Link(Mem_CopyString(filename), map);
+	map->mapped_file = mapped_file;
+	map->buffer = *buffer;
+	map->len = len;
+	map->ref_count = 1;
+
+	g_hash_table_insert(fs_state.mapped_files, map->buffer, map);
+
+	Com_Debug(DEBUG_FILESYSTEM, "%s %s (%" PRId64 " bytes)\n", mapped_file ? "Mapped" : "Loaded", filename, len);
+
+	return len;
+}
+
+/**
+ * @brief Releases the specified buffer mapped by Fs_Map. The file is unmapped once all
+ * references to it are released.
+ */
+void Fs_Unmap(void *buffer) {
+
+	if (buffer) {
+		fs_mapped_file_t *map = g_hash_table_lookup(fs_state.mapped_files, buffer);
+		if (!map) {
+			Com_Warn("Invalid buffer\n");
+			return;
+		}
+
+		if (--map->ref_count > 0) {
+			return;
+		}
+
+		g_hash_table_remove(fs_state.mapped_files, buffer);
+
+		if (map->mapped_file) {
+			g_mapped_file_unref(map->mapped_file);
+		} else {
+			Fs_Free(map->buffer);
+		}
+
+		Mem_Free(map);
+	}
+}
+
 /**
  * @brief Renames the specified source to the given destination.
  */
@@ -773,6 +904,7 @@ void Fs_Init(const uint32_t flags) {
 	fs_state.base_search_paths = PHYSFS_getSearchPath();
 
 	fs_state.loaded_files = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, Mem_Free);
+	fs_state.mapped_files = g_hash_table_new(g_direct_hash, g_direct_equal);
 }
 
 /**
@@ -782,6 +914,13 @@ static void Fs_LoadedFiles_(gpointer key, gpointer value, gpointer data) {
 	Com_Print("Fs_PrintLoadedFiles: %s @ %p\n", (char *) value, key);
 }
 
+/**
+ * @brief Prints the names of mapped (i.e. yet-to-be-unmapped) files.
+ */
+static void Fs_MappedFiles_(gpointer key, gpointer value, gpointer data) {
+	Com_Print("Fs_PrintMappedFiles: %s @ %p\n", ((fs_mapped_file_t *) value)->filename, key);
+}
+
 /**
  * @brief Shuts down the filesystem.
  */
@@ -791,6 +930,9 @@ void Fs_Shutdown(void) {
 		return;
 	}
 
+	g_hash_table_foreach(fs_state.mapped_files, Fs_MappedFiles_, NULL);
+	g_hash_table_destroy(fs_state.mapped_files);
+
 	g_hash_table_foreach(fs_state.loaded_files, Fs_LoadedFiles_, NULL);
 	g_hash_table_destroy(fs_state.loaded_files);
 
@@ -46,6 +46,8 @@ int64_t Fs_Tell(file_t *file);
 int64_t Fs_Write(file_t *file, const void *buffer, size_t size, size_t count);
 int64_t Fs_Load(const char *filename, void **buffer);
 int64_t Fs_LastModTime(const char *filename);
+int64_t Fs_Map(const char *filename, void **buffer);
+void Fs_Unmap(void *buffer);
 void Fs_Free(void *buffer);
 _Bool Fs_Rename(const char *source, const char *dest);
 _Bool Fs_Unlink(const char *filename);
@@ -0,0 +1,707 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_cpuinfo.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+
+#include "job.h"
+#include "thread.h"
+
+/*
+ * Each worker owns a fixed size deque of jobs. The owner pushes and pops jobs
+ * at the bottom of its deque without locking, while idle workers steal from
+ * the top of others' deques (Chase and Lev). The main thread owns a deque too,
+ * and threads which are not workers submit their jobs to a shared, locked
+ * queue. When a deque is full, the job is simply run by the submitting thread.
+ *
+ * Waiting on a counter executes pending jobs until the counter reaches zero,
+ * so waiting never idles a thread while there is work to be done. Background
+ * jobs, which may run for a long time, are kept on a separate queue. Workers
+ * take them when they have nothing else to do, but a waiting thread will only
+ * execute the background jobs of the counter it is waiting on, so that waiting
+ * does not stall for longer than the work being waited on.
+ */
+
+#define JOB_QUEUE_SIZE 1024
+#define JOB_QUEUE_MASK (JOB_QUEUE_SIZE - 1)
+
+/**
+ * @brief A parallel for loop, shared by all jobs executing its index ranges.
+ */
+typedef struct {
+	JobRangeFunc func;
+	void *data;
+	int32_t grain;
+} job_range_t;
+
+/**
+ * @brief A job, which is either a function or an index range of a parallel for.
+ */
+typedef struct {
+	JobFunc func;
+	void *data;
+	const job_range_t *range;
+	int32_t begin, end;
+	job_counter_t *counter;
+} job_t;
+
+/**
+ * @brief A work stealing deque.
+ */
+typedef struct {
+	SDL_atomic_t top;
+	SDL_atomic_t bottom;
+	job_t jobs[JOB_QUEUE_SIZE];
+} job_queue_t;
+
+/**
+ * @brief A worker thread and its deque.
+ */
+typedef struct {
+	SDL_Thread *thread;
+	job_queue_t queue;
+} job_worker_t;
+
+typedef struct {
+
+	/**
+	 * @brief The workers. The first is the main thread, which has no thread of its own.
+	 */
+	job_worker_t *workers;
+
+	/**
+	 * @brief The number of worker threads, not including the main thread.
+	 */
+	int32_t num_workers;
+
+	/**
+	 * @brief The shared queue for jobs submitted by threads which are not workers.
+	 */
+	SDL_SpinLock lock;
+	job_t injected[JOB_QUEUE_SIZE];
+	int32_t injected_head;
+	SDL_atomic_t num_injected;
+
+	/**
+	 * @brief The background queue, of long running jobs.
+	 */
+	SDL_SpinLock background_lock;
+	GQueue background;
+	SDL_atomic_t num_background;
+
+	/**
+	 * @brief The number of jobs awaiting execution, across all queues.
+	 */
+	SDL_atomic_t pending;
+
+	/**
+	 * @brief Idle workers sleep on this condition until jobs are submitted.
+	 */
+	SDL_mutex *mutex;
+	SDL_cond *cond;
+	SDL_atomic_t sleeping;
+	SDL_atomic_t running;
+} job_state_t;
+
+static job_state_t job_state;
+
+/**
+ * @brief The index of the calling thread's worker, or -1 if it is not a worker.
+ */
+static _Thread_local int32_t job_worker = -1;
+
+/**
+ * @brief The calling thread's next steal victim, to spread thieves across workers.
+ */
+static _Thread_local uint32_t job_victim;
+
+/**
+ * @return The number of jobs in the specified deque, which may be stale.
+ */
+static inline int32_t Job_QueueSize(job_queue_t *queue) {
+	return (int32_t) ((uint32_t) SDL_AtomicGet(&queue->bottom) - (uint32_t) SDL_AtomicGet(&queue->top));
+}
+
+/**
+ * @brief Pushes a job to the bottom of the calling worker's own deque.
+ * @return False if the deque is full.
+ */
+static _Bool Job_QueuePush(job_queue_t *queue, const job_t *job) {
+
+	const int32_t bottom = SDL_AtomicGet(&queue->bottom);
+
+	if (Job_QueueSize(queue) >= JOB_QUEUE_SIZE) {
+		return false;
+	}
+
+	queue->jobs[bottom & JOB_QUEUE_MASK] = *job;
+
+	// publish the job to thieves, with a full barrier
+	SDL_AtomicAdd(&queue->bottom, 1);
+
+	return true;
+}
+
+/**
+ * @brief Pops a job from the bottom of the calling worker's own deque.
+ * @return True if a job was popped, false if the deque was empty.
+ */
+static _Bool Job_QueuePop(job_queue_t *queue, job_t *job) {
+
+	// claim the bottom job before inspecting the top, with a full barrier
+	const int32_t bottom = (int32_t) ((uint32_t) SDL_AtomicAdd(&queue->bottom, -1) - 1);
+	const int32_t top = SDL_AtomicGet(&queue->top);
+
+	const int32_t size = (int32_t) ((uint32_t) bottom - (uint32_t) top);
+	if (size < 0) {
+		SDL_AtomicSet(&queue->bottom, top);
+		return false;
+	}
+
+	*job = queue->jobs[bottom & JOB_QUEUE_MASK];
+
+	if (size > 0) {
+		return true;
+	}
+
+	// this was the last job, so race any thieves for it
+	const _Bool popped = SDL_AtomicCAS(&queue->top, top, (int32_t) ((uint32_t) top + 1));
+
+	SDL_AtomicSet(&queue->bottom, (int32_t) ((uint32_t) top + 1));
+
+	return popped;
+}
+
+/**
+ * @brief Steals a job from the top of another worker's deque.
+ * @return True if a job was stolen.
+ */
+static _Bool Job_QueueSteal(job_queue_t *queue, job_t *job) {
+
+	const int32_t top = SDL_AtomicGet(&queue->top);
+	SDL_MemoryBarrierAcquire();
+	const int32_t bottom = SDL_AtomicGet(&queue->bottom);
+
+	if ((int32_t) ((uint32_t) bottom - (uint32_t) top) <= 0) {
+		return false;
+	}
+
+	*job = queue->jobs[top & JOB_QUEUE_MASK];
+
+	// if another thief or the owner claimed it first, the copy is discarded
+	return SDL_AtomicCAS(&queue->top, top, (int32_t) ((uint32_t) top + 1));
+}
+
+static void Job_Execute(const job_t *job);
+
+/**
+ * @brief Submits the specified job, waking a sleeping worker to run it.
+ */
+static void Job_Push(const job_t *job) {
+
+	if (job_state.num_workers == 0) {
+		Job_Execute(job);
+		return;
+	}
+
+	if (job_worker >= 0) {
+		if (!Job_QueuePush(&job_state.workers[job_worker].queue, job)) {
+			Job_Execute(job);
+			return;
+		}
+	} else {
+		SDL_AtomicLock(&job_state.lock);
+
+		const int32_t num_injected = SDL_AtomicGet(&job_state.num_injected);
+		if (num_injected == JOB_QUEUE_SIZE) {
+			SDL_AtomicUnlock(&job_state.lock);
+			Job_Execute(job);
+			return;
+		}
+
+		job_state.injected[(job_state.injected_head + num_injected) & JOB_QUEUE_MASK] = *job;
+		SDL_AtomicSet(&job_state.num_injected, num_injected + 1);
+
+		SDL_AtomicUnlock(&job_state.lock);
+	}
+
+	SDL_AtomicIncRef(&job_state.pending);
+
+	if (SDL_AtomicGet(&job_state.sleeping)) {
+		SDL_LockMutex(job_state.mutex);
+		SDL_CondSignal(job_state.cond);
+		SDL_UnlockMutex(job_state.mutex);
+	}
+}
+
+/**
+ * @brief Takes the next job for the calling thread: its own newest job, then an
+ * injected job, then a job stolen from another worker.
+ * @return True if a job was taken.
+ */
+static _Bool Job_Take(job_t *job) {
+
+	if (job_state.num_workers == 0) {
+		return false;
+	}
+
+	if (job_worker >= 0 && Job_QueuePop(&job_state.workers[job_worker].queue, job)) {
+		goto taken;
+	}
+
+	if (SDL_AtomicGet(&job_state.num_injected)) {
+		SDL_AtomicLock(&job_state.lock);
+
+		const int32_t num_injected = SDL_AtomicGet(&job_state.num_injected);
+		if (num_injected) {
+			*job = job_state.injected[job_state.injected_head];
+			job_state.injected_head = (job_state.injected_head + 1) & JOB_QUEUE_MASK;
+			SDL_AtomicSet(&job_state.num_injected, num_injected - 1);
+
+			SDL_AtomicUnlock(&job_state.lock);
+			goto taken;
+		}
+
+		SDL_AtomicUnlock(&job_state.lock);
+	}
+
+	const int32_t num_queues = job_state.num_workers + 1;
+
+	for (int32_t i = 0; i < num_queues; i++) {
+		const int32_t victim = (job_victim++) % num_queues;
+		if (victim == job_worker) {
+			continue;
+		}
+
+		if (Job_QueueSteal(&job_state.workers[victim].queue, job)) {
+			goto taken;
+		}
+	}
+
+	return false;
+
+taken:
+	SDL_AtomicAdd(&job_state.pending, -1);
+	return true;
+}
+
+/**
+ * @brief Takes the oldest background job tracked by the specified counter, or by
+ * any counter if `counter` is NULL.
+ * @return True if a job was taken.
+ */
+static _Bool Job_TakeBackground(const job_counter_t *counter, job_t *job) {
+
+	if (SDL_AtomicGet(&job_state.num_background) == 0) {
+		return false;
+	}
+
+	SDL_AtomicLock(&job_state.background_lock);
+
+	GList *e = job_state.background.head;
+	while (e && counter && ((job_t *) e->data)->counter != counter) {
+		e = e->next;
+	}
+
+	job_t *background = NULL;
+	if (e) {
+		background = (job_t *) e->data;
+		g_queue_delete_link(&job_state.background, e);
+		SDL_AtomicAdd(&job_state.num_background, -1);
+	}
+
+	SDL_AtomicUnlock(&job_state.background_lock);
+
+	if (background == NULL) {
+		return false;
+	}
+
+	*job = *background;
+	Mem_Free(background);
+
+	SDL_AtomicAdd(&job_state.pending, -1);
+	return true;
+}
+
+/**
+ * @return True if the calling thread's jobs have all been taken, and so it should
+ * offer more of its work to other workers.
+ */
+static _Bool Job_Hungry(void) {
+
+	if (job_state.num_workers == 0) {
+		return false;
+	}
+
+	if (job_worker >= 0) {
+		return Job_QueueSize(&job_state.workers[job_worker].queue) <= 0;
+	}
+
+	return SDL_AtomicGet(&job_state.num_injected) == 0;
+}
+
+/**
+ * @brief Decrements the specified counter, submitting its deferred jobs if it
+ * reaches zero. The counter is not touched after its lock is released, so that
+ * waiters may safely release it.
+ */
+static void Job_Decrement(job_counter_t *counter) {
+
+	SDL_AtomicLock(&counter->lock);
+
+	GSList *deferred = NULL;
+	if (SDL_AtomicAdd(&counter->count, -1) == 1) {
+		deferred = counter->deferred;
+		counter->deferred = NULL;
+	}
+
+	SDL_AtomicUnlock(&counter->lock);
+
+	for (GSList *e = deferred; e; e = e->next) {
+		job_t *job = (job_t *) e->data;
+		Job_Push(job);
+		Mem_Free(job);
+	}
+
+	g_slist_free(deferred);
+}
+
+/**
+ * @brief Executes a parallel for index range. While other workers are starved
+ * for work, the upper half of the remaining range is split off for them to
+ * steal. Ranges are therefore only divided as finely as the load requires.
+ */
+static void Job_ExecuteRange(const job_t *job) {
+	const job_range_t *range = job->range;
+
+	int32_t begin = job->begin, end = job->end;
+	while (begin < end) {
+
+		while (end - begin >= range->grain * 2 && Job_Hungry()) {
+			const int32_t mid = begin + (end - begin) / 2;
+
+			SDL_AtomicIncRef(&job->counter->count);
+
+			Job_Push(&(const job_t) {
+				.range = range,
+				.begin = mid,
+				.end = end,
+				.counter = job->counter
+			});
+
+			end = mid;
+		}
+
+		const int32_t n = MIN(range->grain, end - begin);
+
+		range->func(begin, begin + n, range->data);
+		begin += n;
+	}
+}
+
+/**
+ * @brief Executes the specified job, and decrements its counter.
+ */
+static void Job_Execute(const job_t *job) {
+
+	if (job->range) {
+		Job_ExecuteRange(job);
+	} else {
+		job->func(job->data);
+	}
+
+	if (job->counter) {
+		Job_Decrement(job->counter);
+	}
+}
+
+/**
+ * @brief Runs the specified function asynchronously.
+ * @param counter The optional counter to track the job with.
+ */
+void Job_Run(job_counter_t *counter, JobFunc func, void *data) {
+
+	if (counter) {
+		SDL_AtomicIncRef(&counter->count);
+	}
+
+	Job_Push(&(const job_t) {
+		.func = func,
+		.data = data,
+		.counter = counter
+	});
+}
+
+/**
+ * @brief Runs the specified function asynchronously, on a worker thread. Use this
+ * for long running work, which would otherwise stall threads that execute pending
+ * jobs while they wait. Background jobs are only executed by a waiting thread if
+ * they are tracked by the counter it waits on.
+ * @param counter The optional counter to track the job with.
+ */
+void Job_RunBackground(job_counter_t *counter, JobFunc func, void *data) {
+
+	if (counter) {
+		SDL_AtomicIncRef(&counter->count);
+	}
+
+	const job_t job = {
+		.func = func,
+		.data = data,
+		.counter = counter
+	};
+
+	if (job_state.num_workers == 0) {
+		Job_Execute(&job);
+		return;
+	}
+
+	job_t *background = Mem_Malloc(sizeof(*background));
+	*background = job;
+
+	SDL_AtomicLock(&job_state.background_lock);
+
+	g_queue_push_tail(&job_state.background, background);
+	SDL_AtomicIncRef(&job_state.num_background);
+
+	SDL_AtomicUnlock(&job_state.background_lock);
+
+	SDL_AtomicIncRef(&job_state.pending);
+
+	if (SDL_AtomicGet(&job_state.sleeping)) {
+		SDL_LockMutex(job_state.mutex);
+		SDL_CondSignal(job_state.cond);
+		SDL_UnlockMutex(job_state.mutex);
+	}
+}
+
+/**
+ * @brief Runs the specified function asynchronously once all jobs tracked by
+ * `dependency` have completed.
+ * @param counter The optional counter to track the job with.
+ */
+void Job_RunAfter(job_counter_t *dependency, job_counter_t *counter, JobFunc func, void *data) {
+
+	if (counter) {
+		SDL_AtomicIncRef(&counter->count);
+	}
+
+	const job_t job = {
+		.func = func,
+		.data = data,
+		.counter = counter
+	};
+
+	SDL_AtomicLock(&dependency->lock);
+
+	if (SDL_AtomicGet(&dependency->count) == 0) {
+		SDL_AtomicUnlock(&dependency->lock);
+		Job_Push(&job);
+	} else {
+		job_t *deferred = Mem_Malloc(sizeof(*deferred));
+		*deferred = job;
+
+		dependency->deferred = g_slist_prepend(dependency->deferred, deferred);
+		SDL_AtomicUnlock(&dependency->lock);
+	}
+}
+
+/**
+ * @return True if all jobs tracked by the specified counter have completed.
+ */
+_Bool Job_Done(const job_counter_t *counter) {
+	return SDL_AtomicGet((SDL_atomic_t *) &counter->count) == 0;
+}
+
+/**
+ * @brief Waits for all jobs tracked by the specified counter to complete,
+ * executing pending jobs in the meantime. Background jobs are not executed,
+ * unless they are tracked by this counter.
+ */
+void Job_Wait(job_counter_t *counter) {
+	int32_t idle = 0;
+
+	while (!Job_Done(counter)) {
+		job_t job;
+
+		if (Job_Take(&job) || Job_TakeBackground(counter, &job)) {
+			Job_Execute(&job);
+			idle = 0;
+		} else {
+			SDL_Delay(idle++ < 64 ? 0 : 1);
+		}
+	}
+
+	// synchronize with the final decrement, which may still hold the lock
+	SDL_AtomicLock(&counter->lock);
+	SDL_AtomicUnlock(&counter->lock);
+}
+
+/**
+ * @brief Calls `func` for every index in [0, count), in parallel, returning once
+ * all indices have been processed. The calling thread participates.
+ * @param grain The minimum number of indices per call, or 0 to choose one from
+ * the count and the number of workers.
+ */
+void Job_ParallelFor(int32_t count, int32_t grain, JobRangeFunc func, void *data) {
+
+	if (count <= 0) {
+		return;
+	}
+
+	if (grain <= 0) {
+		grain = MAX(1, count / ((job_state.num_workers + 1) * 64));
+	}
+
+	const job_range_t range = {
+		.func = func,
+		.data = data,
+		.grain = grain
+	};
+
+	job_counter_t counter;
+	memset(&counter, 0, sizeof(counter));
+
+	SDL_AtomicIncRef(&counter.count);
+
+	Job_Execute(&(const job_t) {
+		.range = &range,
+		.begin = 0,
+		.end = count,
+		.counter = &counter
+	});
+
+	Job_Wait(&counter);
+}
+
+/**
+ * @return The number of worker threads, not including the main thread.
+ */
+int32_t Job_Workers(void) {
+	return job_state.num_workers;
+}
+
+/**
+ * @brief The worker thread entry point.
+ */
+static int32_t Job_Worker(void *data) {
+
+	job_worker = (int32_t) (intptr_t) data;
+	thread_id = SDL_ThreadID();
+
+	while (SDL_AtomicGet(&job_state.running)) {
+		job_t job;
+
+		if (Job_Take(&job) || Job_TakeBackground(NULL, &job)) {
+			Job_Execute(&job);
+			continue;
+		}
+
+		SDL_LockMutex(job_state.mutex);
+		SDL_AtomicIncRef(&job_state.sleeping);
+
+		while (SDL_AtomicGet(&job_state.pending) <= 0 && SDL_AtomicGet(&job_state.running)) {
+			SDL_CondWait(job_state.cond, job_state.mutex);
+		}
+
+		SDL_AtomicAdd(&job_state.sleeping, -1);
+		SDL_UnlockMutex(job_state.mutex);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Initializes the job system, which must be done from the main thread.
+ * @param num_workers The number of worker threads, 0 for one per CPU, or -1 for
+ * none, in which case all jobs are run immediately by the submitting thread.
+ */
+void Job_Init(ssize_t num_workers) {
+
+	memset(&job_state, 0, sizeof(job_state));
+
+	if (num_workers == 0) {
+		num_workers = SDL_GetCPUCount();
+	} else if (num_workers == -1) {
+		num_workers = 0;
+	} else if (num_workers > MAX_JOB_WORKERS) {
+		num_workers = MAX_JOB_WORKERS;
+	}
+
+	job_state.num_workers = (int32_t) num_workers;
+
+	if (job_state.num_workers) {
+		job_state.workers = Mem_Malloc(sizeof(job_worker_t) * (job_state.num_workers + 1));
+
+		job_state.mutex = SDL_CreateMutex();
+		job_state.cond = SDL_CreateCond();
+
+		SDL_AtomicSet(&job_state.running, 1);
+
+		job_worker = 0;
+
+		for (int32_t i = 1; i <= job_state.num_workers; i++) {
+			job_state.workers[i].thread = SDL_CreateThread(Job_Worker, __func__, (void *) (intptr_t) i);
+		}
+	}
+}
+
+/**
+ * @brief Shuts down the job system, first completing all pending jobs.
+ */
+void Job_Shutdown(void) {
+
+	if (job_state.num_workers) {
+		job_t job;
+
+		while (SDL_AtomicGet(&job_state.pending) > 0) {
+			if (Job_Take(&job) || Job_TakeBackground(NULL, &job)) {
+				Job_Execute(&job);
+			} else {
+				SDL_Delay(0);
+			}
+		}
+
+		SDL_LockMutex(job_state.mutex);
+		SDL_AtomicSet(&job_state.running, 0);
+		SDL_CondBroadcast(job_state.cond);
+		SDL_UnlockMutex(job_state.mutex);
+
+		for (int32_t i = 1; i <= job_state.num_workers; i++) {
+			SDL_WaitThread(job_state.workers[i].thread, NULL);
+		}
+
+		// jobs submitted by the final jobs are run here
+		while (Job_Take(&job) || Job_TakeBackground(NULL, &job)) {
+			Job_Execute(&job);
+		}
+
+		SDL_DestroyCond(job_state.cond);
+		SDL_DestroyMutex(job_state.mutex);
+
+		Mem_Free(job_state.workers);
+	}
+
+	job_worker = -1;
+
+	memset(&job_state, 0, sizeof(job_state));
+}
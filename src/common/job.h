@@ -0,0 +1,60 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include <SDL_atomic.h>
+
+#include "mem.h"
+
+#define MAX_JOB_WORKERS 128
+
+/**
+ * @brief The job function type.
+ */
+typedef void (*JobFunc)(void *data);
+
+/**
+ * @brief The job range function type, called for the indices [begin, end).
+ */
+typedef void (*JobRangeFunc)(int32_t begin, int32_t end, void *data);
+
+/**
+ * @brief Job counters track the completion of a group of jobs. Every job run
+ * against a counter increments it, and decrements it when it completes. Jobs
+ * may also be deferred until a counter reaches zero. Counters must be zeroed
+ * before use, and must outlive the jobs that reference them.
+ */
+typedef struct {
+	SDL_atomic_t count;
+	SDL_SpinLock lock;
+	GSList *deferred;
+} job_counter_t;
+
+void Job_Run(job_counter_t *counter, JobFunc func, void *data);
+void Job_RunBackground(job_counter_t *counter, JobFunc func, void *data);
+void Job_RunAfter(job_counter_t *dependency, job_counter_t *counter, JobFunc func, void *data);
+void Job_Wait(job_counter_t *counter);
+_Bool Job_Done(const job_counter_t *counter);
+void Job_ParallelFor(int32_t count, int32_t grain, JobRangeFunc func, void *data);
+int32_t Job_Workers(void);
+void Job_Init(ssize_t num_workers);
+void Job_Shutdown(void);
@@ -38,15 +38,40 @@
   #endif
 #endif
 
+/*
+ * Header and footer magic validation is enabled for debug builds, or explicitly
+ * with MEMORY_CHECKS.
+ */
+#if (defined(_DEBUG) || defined(SUPER_MEMORY_CHECKS)) && !defined(MEMORY_CHECKS)
+  #define MEMORY_CHECKS
+#endif
+
 #define MEM_MAGIC 0x69696969
 typedef uint32_t mem_magic_t;
 
+/*
+ * Blocks are allocated from per-tag arenas, so that all memory of a tag may be
+ * released in bulk. Small blocks are carved from slabs of a fixed size class,
+ * and are recycled through thread local caches, so that the common allocation
+ * and free paths do not touch the heap or contend on arena locks. Large blocks
+ * are allocated individually.
+ *
+ * Managed memory forms a tree: each block maintains an intrusive, doubly linked
+ * list of its children, and each arena a list of its root blocks.
+ */
+
+struct mem_arena_s;
+
 typedef struct mem_block_s {
 	mem_magic_t magic;
 	mem_tag_t tag; // for group free
+	struct mem_arena_s *arena; // the arena that owns the block's storage
 	struct mem_block_s *parent;
-	GSList *children;
+	struct mem_block_s *prev, *next; // siblings, or arena roots
+	struct mem_block_s *children;
 	size_t size;
+	int32_t size_class; // or MEM_CLASS_LARGE
+	int32_t reserved;
 #if defined(SUPER_MEMORY_CHECKS)
 	void *stack[MAX_MEMORY_STACK];
 #endif
@@ -56,14 +81,95 @@ typedef struct {
 	mem_magic_t magic;
 } mem_footer_t;
 
+#if defined(MEMORY_CHECKS)
+  #define MEM_FOOTER_SIZE sizeof(mem_footer_t)
+#else
+  #define MEM_FOOTER_SIZE 0
+#endif
+
+/**
+ * @brief The block size classes, including the block header.
+ */
+static const size_t mem_classes[] = {
+	96, 128, 160, 192, 256, 320, 384, 512, 640, 768, 1024, 1280, 1536, 2048
+};
+
+#define MEM_NUM_CLASSES lengthof(mem_classes)
+#define MEM_CLASS_LARGE -1
+
+#define MEM_SLAB_SIZE (16 * 1024)
+
+/**
+ * @brief Thread local caches hold at most this many blocks per size class, and
+ * exchange half as many with their arena at a time.
+ */
+#define MEM_CACHE_BLOCKS 32
+
+#define MEM_CACHES 16
+
+/**
+ * @brief Slabs are the backing storage of small blocks.
+ */
+typedef struct mem_slab_s {
+	struct mem_slab_s *next;
+	void *padding;
+} mem_slab_t;
+
+/**
+ * @brief Arenas own the storage of all blocks allocated with their tag, and
+ * of their linked children.
+ */
+typedef struct mem_arena_s {
+	mem_tag_t tag;
+
+	/**
+	 * @brief The lock governing the slabs and free lists.
+	 */
+	SDL_SpinLock lock;
+
+	/**
+	 * @brief Incremented when the slabs are released, invalidating thread caches.
+	 */
+	SDL_atomic_t generation;
+
+	mem_slab_t *slabs;
+	mem_block_t *free[MEM_NUM_CLASSES];
+	byte *slab[MEM_NUM_CLASSES], *slab_end[MEM_NUM_CLASSES];
+
+	/**
+	 * @brief The root blocks with this tag, and the number of small blocks in use.
+	 * These are governed by the global lock.
+	 */
+	mem_block_t *roots;
+	size_t num_small_blocks;
+} mem_arena_t;
+
+/**
+ * @brief A thread local cache of free small blocks of a single arena.
+ */
+typedef struct {
+	uint32_t epoch;
+	mem_arena_t *arena;
+	int32_t generation;
+	mem_block_t *free[MEM_NUM_CLASSES];
+	uint32_t num_free[MEM_NUM_CLASSES];
+} mem_cache_t;
+
 typedef struct {
-	GHashTable *blocks;
+	GHashTable *arenas;
 	size_t size;
 	SDL_SpinLock lock;
+
+	/**
+	 * @brief Incremented on each initialization, invalidating thread caches.
+	 */
+	uint32_t epoch;
 } mem_state_t;
 
 static mem_state_t mem_state;
 
+static _Thread_local mem_cache_t mem_caches[MEM_CACHES];
+
 #if defined(SUPER_MEMORY_CHECKS)
 /**
  * @brief
@@ -96,8 +202,8 @@ static void Mem_Print(const mem_block_t *block, const char *why) {
 #endif
 
 /**
- * @brief Throws a fatal error if the specified memory block is non-NULL but
- * not owned by the memory subsystem.
+ * @brief Resolves the block of the specified managed memory. With MEMORY_CHECKS,
+ * throws a fatal error if the memory is not owned by the memory subsystem.
  */
 static mem_block_t *Mem_CheckMagic(void *p) {
 	mem_block_t *b = NULL;
@@ -105,6 +211,7 @@ static mem_block_t *Mem_CheckMagic(void *p) {
 	if (p) {
 		b = ((mem_block_t *) p) - 1;
 
+#if defined(MEMORY_CHECKS)
 		if (b->magic != MEM_MAGIC) {
 			fprintf(stderr, "Invalid magic (%d) for %p\n", b->magic, p);
 			raise(SIGABRT);
@@ -116,6 +223,7 @@ static mem_block_t *Mem_CheckMagic(void *p) {
 			fprintf(stderr, "Invalid footer magic (%d) for %p\n", b->magic, p);
 			raise(SIGABRT);
 		}
+#endif
 	}
 
 	return b;
@@ -129,23 +237,403 @@ void Mem_Check(void *p) {
 }
 
 /**
- * @brief Recursively frees linked managed memory.
+ * @brief Prepends the block to the specified list.
+ */
+static void Mem_LinkBlock(mem_block_t **list, mem_block_t *b) {
+
+	b->prev = NULL;
+	b->next = *list;
+
+	if (*list) {
+		(*list)->prev = b;
+	}
+
+	*list = b;
+}
+
+/**
+ * @brief Removes the block from the specified list.
+ */
+static void Mem_UnlinkBlock(mem_block_t **list, mem_block_t *b) {
+
+	if (b->prev) {
+		b->prev->next = b->next;
+	} else {
+		*list = b->next;
+	}
+
+	if (b->next) {
+		b->next->prev = b->prev;
+	}
+
+	b->prev = b->next = NULL;
+}
+
+/**
+ * @return The list the specified block is linked in.
+ */
+static mem_block_t **Mem_BlockList(mem_block_t *b) {
+	return b->parent ? &b->parent->children : &b->arena->roots;
+}
+
+/**
+ * @return The arena for the specified tag, which is created if necessary. The
+ * global lock must be held.
+ */
+static mem_arena_t *Mem_Arena_(mem_tag_t tag) {
+
+	mem_arena_t *arena = g_hash_table_lookup(mem_state.arenas, GINT_TO_POINTER(tag));
+	if (arena == NULL) {
+
+		if (!(arena = calloc(1, sizeof(*arena)))) {
+			fprintf(stderr, "Failed to allocate arena for tag %d\n", tag);
+			raise(SIGABRT);
+			return NULL;
+		}
+
+		arena->tag = tag;
+		g_hash_table_insert(mem_state.arenas, GINT_TO_POINTER(tag), arena);
+	}
+
+	return arena;
+}
+
+/**
+ * @return The calling thread's cache slot for the specified tag.
+ */
+static inline mem_cache_t *Mem_CacheSlot(mem_tag_t tag) {
+	return &mem_caches[((uint32_t) tag) & (MEM_CACHES - 1)];
+}
+
+/**
+ * @return The arena for the specified tag, avoiding the global lock if the
+ * calling thread has a cache for it.
+ */
+static mem_arena_t *Mem_Arena(mem_tag_t tag) {
+
+	const mem_cache_t *cache = Mem_CacheSlot(tag);
+	if (cache->epoch == mem_state.epoch && cache->arena && cache->arena->tag == tag) {
+		return cache->arena;
+	}
+
+	SDL_AtomicLock(&mem_state.lock);
+
+	mem_arena_t *arena = Mem_Arena_(tag);
+
+	SDL_AtomicUnlock(&mem_state.lock);
+
+	return arena;
+}
+
+/**
+ * @brief Returns up to `count` cached blocks of the specified class to the arena. If the
+ * arena has released its slabs since the cache was filled, the blocks are dropped instead.
+ */
+static void Mem_FlushCache(mem_cache_t *cache, int32_t c, uint32_t count) {
+	mem_arena_t *arena = cache->arena;
+
+	SDL_AtomicLock(&arena->lock);
+
+	const _Bool released = cache->generation != SDL_AtomicGet(&arena->generation);
+
+	while (count-- && cache->free[c]) {
+		mem_block_t *b = cache->free[c];
+		cache->free[c] = b->next;
+		cache->num_free[c]--;
+
+		if (!released) {
+			b->next = arena->free[c];
+			arena->free[c] = b;
+		}
+	}
+
+	SDL_AtomicUnlock(&arena->lock);
+}
+
+/**
+ * @return The calling thread's cache for the specified arena, which is
+ * (re)assigned to it if necessary. The global lock must be held, so that
+ * the arena's generation can not change meanwhile.
+ */
+static mem_cache_t *Mem_Cache(mem_arena_t *arena) {
+	mem_cache_t *cache = Mem_CacheSlot(arena->tag);
+
+	const int32_t generation = SDL_AtomicGet(&arena->generation);
+
+	if (cache->epoch == mem_state.epoch && cache->arena == arena) {
+		if (cache->generation == generation) {
+			return cache;
+		}
+	} else if (cache->epoch == mem_state.epoch && cache->arena) {
+		for (int32_t c = 0; c < (int32_t) MEM_NUM_CLASSES; c++) {
+			Mem_FlushCache(cache, c, UINT32_MAX);
+		}
+	}
+
+	// the cache is empty, or its blocks were released with their slabs
+	memset(cache, 0, sizeof(*cache));
+
+	cache->epoch = mem_state.epoch;
+	cache->arena = arena;
+	cache->generation = generation;
+
+	return cache;
+}
+
+/**
+ * @brief Fills the cache with blocks of the specified class, recycling free
+ * blocks before carving new ones from the arena's slabs.
+ */
+static void Mem_FillCache(mem_cache_t *cache, int32_t c) {
+	mem_arena_t *arena = cache->arena;
+
+	const size_t size = mem_classes[c];
+
+	SDL_AtomicLock(&arena->lock);
+
+	while (cache->num_free[c] < MEM_CACHE_BLOCKS / 2) {
+		mem_block_t *b = arena->free[c];
+
+		if (b) {
+			arena->free[c] = b->next;
+		} else {
+			if (arena->slab[c] + size > arena->slab_end[c]) {
+				mem_slab_t *slab = malloc(MEM_SLAB_SIZE);
+				if (!slab) {
+					fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) MEM_SLAB_SIZE);
+					raise(SIGABRT);
+					break;
+				}
+
+				slab->next = arena->slabs;
+				arena->slabs = slab;
+
+				arena->slab[c] = (byte *) (slab + 1);
+				arena->slab_end[c] = ((byte *) slab) + MEM_SLAB_SIZE;
+			}
+
+			b = (mem_block_t *) arena->slab[c];
+			arena->slab[c] += size;
+		}
+
+		b->next = cache->free[c];
+		cache->free[c] = b;
+		cache->num_free[c]++;
+	}
+
+	SDL_AtomicUnlock(&arena->lock);
+}
+
+/**
+ * @brief Releases all slabs of the specified arena at once. Any blocks still
+ * allocated from them, and any cached by threads, are invalidated. The global
+ * lock must be held, so that no thread is allocating from the arena meanwhile.
+ */
+static void Mem_ReleaseSlabs(mem_arena_t *arena) {
+
+	SDL_AtomicLock(&arena->lock);
+
+	mem_slab_t *slab = arena->slabs;
+	while (slab) {
+		mem_slab_t *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	arena->slabs = NULL;
+
+	memset(arena->free, 0, sizeof(arena->free));
+	memset(arena->slab, 0, sizeof(arena->slab));
+	memset(arena->slab_end, 0, sizeof(arena->slab_end));
+
+	SDL_AtomicIncRef(&arena->generation);
+
+	SDL_AtomicUnlock(&arena->lock);
+}
+
+/**
+ * @return The size class of a block with the specified user size, or MEM_CLASS_LARGE.
+ */
+static int32_t Mem_SizeClass(size_t size) {
+
+	const size_t s = sizeof(mem_block_t) + size + MEM_FOOTER_SIZE;
+
+	int32_t c = 0;
+	while (c < (int32_t) MEM_NUM_CLASSES && mem_classes[c] < s) {
+		c++;
+	}
+
+	return c == (int32_t) MEM_NUM_CLASSES ? MEM_CLASS_LARGE : c;
+}
+
+/**
+ * @brief Allocates the storage for a large block from the heap. The global lock
+ * need not be held.
+ * @return The zero-filled block, with its storage fields initialized.
+ */
+static mem_block_t *Mem_AllocLargeBlock(mem_arena_t *arena, size_t size) {
+
+	const size_t s = sizeof(mem_block_t) + size + MEM_FOOTER_SIZE;
+
+	mem_block_t *b = calloc(1, s);
+	if (!b) {
+		fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) s);
+		raise(SIGABRT);
+		return NULL;
+	}
+
+	b->arena = arena;
+	b->size_class = MEM_CLASS_LARGE;
+
+	return b;
+}
+
+/**
+ * @brief Allocates the storage for a small block from the calling thread's cache
+ * of the arena. The global lock must be held until the block is linked, so that
+ * Mem_FreeArena can not release its slab meanwhile.
+ * @return The zero-filled block, with its storage fields initialized.
+ */
+static mem_block_t *Mem_AllocSmallBlock(mem_arena_t *arena, int32_t c) {
+
+	mem_cache_t *cache = Mem_Cache(arena);
+
+	if (cache->free[c] == NULL) {
+		Mem_FillCache(cache, c);
+	}
+
+	mem_block_t *b = cache->free[c];
+
+	cache->free[c] = b->next;
+	cache->num_free[c]--;
+
+	memset(b, 0, mem_classes[c]);
+
+	b->arena = arena;
+	b->size_class = c;
+
+	return b;
+}
+
+/**
+ * @brief Returns the storage of the specified small block to the calling thread's
+ * cache. The global lock must be held, so that the arena can not release the
+ * block's slab meanwhile.
  */
-static void Mem_Free_(mem_block_t *b) {
+static void Mem_RecycleBlock(mem_block_t *b) {
+
+	const int32_t c = b->size_class;
+
+	mem_cache_t *cache = Mem_Cache(b->arena);
+
+	b->next = cache->free[c];
+	cache->free[c] = b;
+	cache->num_free[c]++;
+
+	if (cache->num_free[c] > MEM_CACHE_BLOCKS) {
+		Mem_FlushCache(cache, c, MEM_CACHE_BLOCKS / 2);
+	}
+}
+
+/**
+ * @brief Frees the storage of all blocks in the specified list. Small blocks are
+ * recycled, and so the global lock must be held.
+ * @return The large blocks, which the caller must pass to Mem_FreeLargeBlocks once
+ * it has released the global lock.
+ */
+static mem_block_t *Mem_FreeBlocks(mem_block_t *blocks) {
+	mem_block_t *large = NULL;
+
+	while (blocks) {
+		mem_block_t *b = blocks;
+		blocks = b->next;
 
 #if defined(SUPER_MEMORY_CHECKS)
-	Mem_Print(b, "Freeing");
+		Mem_Print(b, "Freeing");
 #endif
 
-	// recurse down the tree, freeing children
-	if (b->children) {
-		g_slist_free_full(b->children, (GDestroyNotify) Mem_Free_);
+#if defined(MEMORY_CHECKS)
+		b->magic = 0;
+#endif
+
+		if (b->size_class == MEM_CLASS_LARGE) {
+			b->next = large;
+			large = b;
+		} else {
+			Mem_RecycleBlock(b);
+		}
+	}
+
+	return large;
+}
+
+/**
+ * @brief Frees the heap storage of the large blocks in the specified list.
+ */
+static void Mem_FreeLargeBlocks(mem_block_t *blocks) {
+
+	while (blocks) {
+		mem_block_t *b = blocks;
+		blocks = b->next;
+
+		free(b);
+	}
+}
+
+/**
+ * @brief Accounts for a block entering or leaving the managed memory structures.
+ * The global lock must be held.
+ */
+static void Mem_AccountBlock(const mem_block_t *b, int32_t sign) {
+
+	if (sign > 0) {
+		mem_state.size += b->size;
+	} else {
+		mem_state.size -= b->size;
+	}
+
+	if (b->size_class != MEM_CLASS_LARGE) {
+		b->arena->num_small_blocks += sign;
 	}
+}
+
+/**
+ * @brief Accounts for the specified blocks and all of their descendants, which
+ * must already be unlinked from their list, and gathers them into a single list
+ * linked through `next`. The global lock must be held.
+ * @param native If not NULL, small blocks owned by this arena are gathered here,
+ * rather than in the returned list.
+ * @param num_native Incremented for every small block gathered in `native`.
+ * @return The gathered blocks.
+ */
+static mem_block_t *Mem_GatherBlocks(mem_block_t *blocks, mem_arena_t *arena, mem_block_t **native,
+                                     size_t *num_native) {
+
+	mem_block_t *gathered = NULL;
+
+	while (blocks) {
+		mem_block_t *b = blocks;
+		blocks = b->next;
+
+		for (mem_block_t *child = b->children, *next; child; child = next) {
+			next = child->next;
+			child->next = blocks;
+			blocks = child;
+		}
 
-	// decrement the pool size and free the memory
-	mem_state.size -= b->size;
+		Mem_AccountBlock(b, -1);
 
-	free(b);
+		if (native && b->arena == arena && b->size_class != MEM_CLASS_LARGE) {
+			b->next = *native;
+			*native = b;
+			(*num_native)++;
+		} else {
+			b->next = gathered;
+			gathered = b;
+		}
+	}
+
+	return gathered;
 }
 
 /**
@@ -158,46 +646,77 @@ void Mem_Free(void *p) {
 
 		SDL_AtomicLock(&mem_state.lock);
 
-		if (b->parent) {
-			b->parent->children = g_slist_remove(b->parent->children, b);
-		} else {
-			g_hash_table_remove(mem_state.blocks, (gconstpointer) b);
-		}
+		Mem_UnlinkBlock(Mem_BlockList(b), b);
+
+		mem_block_t *blocks = Mem_GatherBlocks(b, NULL, NULL, NULL);
 
-		Mem_Free_(b);
+		mem_block_t *large = Mem_FreeBlocks(blocks);
 
 		SDL_AtomicUnlock(&mem_state.lock);
+
+		Mem_FreeLargeBlocks(large);
 	}
 }
 
 /**
- * @brief Free all managed items allocated with the specified tag.
+ * @brief Frees all root blocks of the specified arena, and their descendants.
+ * If this accounts for every small block the arena has in use, its slabs are
+ * released at once, rather than recycling each block individually. The global
+ * lock is held throughout, so that no other thread can allocate from the slabs
+ * as they are released.
  */
-void Mem_FreeTag(mem_tag_t tag) {
-	GHashTableIter it;
-	gpointer key, value;
+static void Mem_FreeArena(mem_arena_t *arena) {
+	mem_block_t *native = NULL;
+	size_t num_native = 0;
 
 	SDL_AtomicLock(&mem_state.lock);
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+	const size_t num_small_blocks = arena->num_small_blocks;
 
-	while (g_hash_table_iter_next(&it, &key, &value)) {
-		mem_block_t *b = (mem_block_t *) key;
+	mem_block_t *roots = arena->roots;
+	arena->roots = NULL;
+
+	mem_block_t *blocks = Mem_GatherBlocks(roots, arena, &native, &num_native);
+
+	mem_block_t *large = Mem_FreeBlocks(blocks);
 
-		if (tag == MEM_TAG_ALL || b->tag == tag) {
-			g_hash_table_iter_remove(&it);
-			Mem_Free_(b);
+	if (num_native == num_small_blocks) {
+#if defined(SUPER_MEMORY_CHECKS)
+		for (const mem_block_t *b = native; b; b = b->next) {
+			Mem_Print(b, "Freeing");
 		}
+#endif
+		Mem_ReleaseSlabs(arena);
+	} else {
+		Mem_FreeBlocks(native); // some of the arena's blocks are linked elsewhere
 	}
 
 	SDL_AtomicUnlock(&mem_state.lock);
+
+	Mem_FreeLargeBlocks(large);
 }
 
 /**
- * @brief Returns the total size of a memory block.
+ * @brief Free all managed items allocated with the specified tag.
  */
-static size_t Mem_BlockSize(const size_t size) {
-	return sizeof(mem_block_t) + size + sizeof(mem_footer_t);
+void Mem_FreeTag(mem_tag_t tag) {
+
+	SDL_AtomicLock(&mem_state.lock);
+
+	GList *arenas;
+	if (tag == MEM_TAG_ALL) {
+		arenas = g_hash_table_get_values(mem_state.arenas);
+	} else {
+		arenas = g_list_prepend(NULL, Mem_Arena_(tag));
+	}
+
+	SDL_AtomicUnlock(&mem_state.lock);
+
+	for (GList *a = arenas; a; a = a->next) {
+		Mem_FreeArena((mem_arena_t *) a->data);
+	}
+
+	g_list_free(arenas);
 }
 
 /**
@@ -212,15 +731,20 @@ static size_t Mem_BlockSize(const size_t size) {
  * @return A block of managed memory initialized to 0x0.
  */
 static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
-	mem_block_t *b, *p = Mem_CheckMagic(parent);
+	mem_block_t *p = Mem_CheckMagic(parent);
 
-	// allocate the block plus the desired size
-	const size_t s = Mem_BlockSize(size);
+	// children share the storage of their parent, so that they are released with it
+	mem_arena_t *arena = p ? p->arena : Mem_Arena(tag);
 
-	if (!(b = calloc(1, s))) {
-		fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) s);
-		raise(SIGABRT);
-		return NULL;
+	const int32_t c = Mem_SizeClass(size);
+
+	mem_block_t *b = c == MEM_CLASS_LARGE ? Mem_AllocLargeBlock(arena, size) : NULL;
+
+	// small blocks are allocated and linked atomically, see Mem_FreeArena
+	SDL_AtomicLock(&mem_state.lock);
+
+	if (b == NULL) {
+		b = Mem_AllocSmallBlock(arena, c);
 	}
 
 	b->magic = MEM_MAGIC;
@@ -230,20 +754,16 @@ static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
 
 	void *data = (void *) (b + 1);
 
+#if defined(MEMORY_CHECKS)
 	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + size);
 	footer->magic = (mem_magic_t) (MEM_MAGIC + b->size);
+#endif
 
 	// insert it into the managed memory structures
-	SDL_AtomicLock(&mem_state.lock);
+	Mem_LinkBlock(Mem_BlockList(b), b);
 
-	if (b->parent) {
-		b->parent->children = g_slist_prepend(b->parent->children, b);
-	} else {
-		g_hash_table_add(mem_state.blocks, b);
-	}
+	Mem_AccountBlock(b, 1);
 
-	mem_state.size += size;
-	
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(b);
 #endif
@@ -303,56 +823,97 @@ void *Mem_Realloc(void *p, size_t size) {
 		return Mem_Malloc(size);
 	}
 
-	mem_block_t *b = Mem_CheckMagic(p), *new_b;
+	mem_block_t *b = Mem_CheckMagic(p);
 
 	// no change to size
 	if (b->size == size) {
 		return (void *) (b + 1);
 	}
 
-	// allocate the block plus the desired size
-	const size_t old_size = b->size;
-	const size_t s = Mem_BlockSize(size);
-
-	b->size = size;
-
 #if defined(SUPER_MEMORY_PRINTS)
 	Mem_Print(b, "Reallocating");
 #endif
 
-	if (!(new_b = realloc(b, s))) {
-		fprintf(stderr, "Failed to re-allocate %u bytes\n", (uint32_t) s);
-		raise(SIGABRT);
-		return NULL;
+	// resize in place if the block's size class accommodates the new size
+	if (b->size_class != MEM_CLASS_LARGE &&
+	        sizeof(mem_block_t) + size + MEM_FOOTER_SIZE <= mem_classes[b->size_class]) {
+
+		if (size > b->size) {
+			memset(((byte *) p) + b->size, 0, size - b->size);
+		}
+
+		SDL_AtomicLock(&mem_state.lock);
+
+		mem_state.size -= b->size;
+		mem_state.size += size;
+
+		SDL_AtomicUnlock(&mem_state.lock);
+
+		b->size = size;
+
+#if defined(MEMORY_CHECKS)
+		mem_footer_t *footer = (mem_footer_t *) (((byte *) p) + size);
+		footer->magic = (mem_magic_t) (MEM_MAGIC + b->size);
+#endif
+
+		return p;
 	}
 
+	const int32_t c = Mem_SizeClass(size);
+
+	mem_block_t *new_b = NULL;
+
+	if (c == MEM_CLASS_LARGE) {
+		new_b = Mem_AllocLargeBlock(b->arena, size);
+		memcpy(new_b + 1, p, MIN(b->size, size));
+	}
+
+	// small blocks are allocated and linked atomically, see Mem_FreeArena
+	SDL_AtomicLock(&mem_state.lock);
+
+	if (new_b == NULL) {
+		new_b = Mem_AllocSmallBlock(b->arena, c);
+		memcpy(new_b + 1, p, MIN(b->size, size));
+	}
+
+	new_b->magic = MEM_MAGIC;
+	new_b->tag = b->tag;
+	new_b->parent = b->parent;
+	new_b->size = size;
+
 	void *data = (void *) (new_b + 1);
 
+#if defined(MEMORY_CHECKS)
 	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + size);
 	footer->magic = (mem_magic_t) (MEM_MAGIC + new_b->size);
+#endif
 
-	SDL_AtomicLock(&mem_state.lock);
+	// re-seat us in our parent or in our arena's roots
+	mem_block_t **list = Mem_BlockList(b);
 
-	// re-seat us in our parent or in global hash list
-	if (new_b->parent) {
-		new_b->parent->children = g_slist_remove(new_b->parent->children, b);
-		new_b->parent->children = g_slist_prepend(new_b->parent->children, new_b);
+	new_b->prev = b->prev;
+	new_b->next = b->next;
+
+	if (b->prev) {
+		b->prev->next = new_b;
 	} else {
-		g_hash_table_remove(mem_state.blocks, b);
-		g_hash_table_add(mem_state.blocks, new_b);
+		*list = new_b;
 	}
 
-	// change our childrens' parent pointers
-	if (new_b->children) {
-		for (GSList *children = new_b->children; children; children = children->next) {
-			mem_block_t *child = (mem_block_t *) children->data;
-			child->parent = new_b;
-		}
+	if (b->next) {
+		b->next->prev = new_b;
 	}
 
-	mem_state.size -= old_size;
-	mem_state.size += size;
-	
+	// and adopt our children
+	new_b->children = b->children;
+
+	for (mem_block_t *child = new_b->children; child; child = child->next) {
+		child->parent = new_b;
+	}
+
+	Mem_AccountBlock(b, -1);
+	Mem_AccountBlock(new_b, 1);
+
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(new_b);
 
@@ -361,8 +922,14 @@ void *Mem_Realloc(void *p, size_t size) {
 #endif
 #endif
 
+	b->next = NULL;
+
+	mem_block_t *large = Mem_FreeBlocks(b);
+
 	SDL_AtomicUnlock(&mem_state.lock);
 
+	Mem_FreeLargeBlocks(large);
+
 	return data;
 }
 
@@ -381,14 +948,10 @@ void *Mem_Link(void *child, void *parent) {
 
 	SDL_AtomicLock(&mem_state.lock);
 
-	if (c->parent) {
-		c->parent->children = g_slist_remove(c->parent->children, c);
-	} else {
-		g_hash_table_remove(mem_state.blocks, c);
-	}
+	Mem_UnlinkBlock(Mem_BlockList(c), c);
 
 	c->parent = p;
-	p->children = g_slist_prepend(p->children, c);
+	Mem_LinkBlock(&p->children, c);
 
 	SDL_AtomicUnlock(&mem_state.lock);
 
@@ -436,8 +999,8 @@ static size_t Mem_CalculateBlockSize(const mem_block_t *b) {
 
 	size_t size = b->size;
 
-	for (GSList *child = b->children; child; child = child->next) {
-		size += Mem_CalculateBlockSize((const mem_block_t *) child->data);
+	for (const mem_block_t *child = b->children; child; child = child->next) {
+		size += Mem_CalculateBlockSize(child);
 	}
 
 	return size;
@@ -461,32 +1024,25 @@ GArray *Mem_Stats(void) {
 		  .count = 0
 	}, 1);
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+	g_hash_table_iter_init(&it, mem_state.arenas);
 
 	while (g_hash_table_iter_next(&it, &key, &value)) {
-		const mem_block_t *b = (const mem_block_t *) key;
-		mem_stat_t *stats = NULL;
+		const mem_arena_t *arena = (const mem_arena_t *) value;
 
-		for (size_t i = 0; i < stat_array->len; i++) {
+		if (arena->roots == NULL) {
+			continue;
+		}
 
-			mem_stat_t *stat_i = &g_array_index(stat_array, mem_stat_t, i);
+		mem_stat_t stats = {
+			.tag = arena->tag
+		};
 
-			if (stat_i->tag == b->tag) {
-				stats = stat_i;
-				break;
-			}
+		for (const mem_block_t *b = arena->roots; b; b = b->next) {
+			stats.size += Mem_CalculateBlockSize(b);
+			stats.count++;
 		}
 
-		if (stats == NULL) {
-			stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
-				.tag = b->tag,
-				 .size = Mem_CalculateBlockSize(b),
-				  .count = 1
-			}, 1);
-		} else {
-			stats->size += Mem_CalculateBlockSize(b);
-			stats->count++;
-		}
+		stat_array = g_array_append_vals(stat_array, &stats, 1);
 	}
 
 	SDL_AtomicUnlock(&mem_state.lock);
@@ -502,9 +1058,12 @@ GArray *Mem_Stats(void) {
  */
 void Mem_Init(void) {
 
+	const uint32_t epoch = mem_state.epoch;
+
 	memset(&mem_state, 0, sizeof(mem_state));
 
-	mem_state.blocks = g_hash_table_new(NULL, NULL);
+	mem_state.arenas = g_hash_table_new(NULL, NULL);
+	mem_state.epoch = epoch + 1;
 }
 
 /**
@@ -515,5 +1074,23 @@ void Mem_Shutdown(void) {
 
 	Mem_FreeTag(MEM_TAG_ALL);
 
-	g_hash_table_destroy(mem_state.blocks);
+	GHashTableIter it;
+	gpointer key, value;
+
+	g_hash_table_iter_init(&it, mem_state.arenas);
+
+	SDL_AtomicLock(&mem_state.lock);
+
+	while (g_hash_table_iter_next(&it, &key, &value)) {
+		mem_arena_t *arena = (mem_arena_t *) value;
+
+		Mem_ReleaseSlabs(arena);
+		free(arena);
+	}
+
+	SDL_AtomicUnlock(&mem_state.lock);
+
+	g_hash_table_destroy(mem_state.arenas);
+
+	mem_state.epoch++;
 }
@@ -41,6 +41,8 @@ void Mem_ClearBuffer(mem_buf_t *buf) {
 
 	buf->size = 0;
 	buf->overflowed = false;
+	buf->bits = 0;
+	buf->read_bits = 0;
 }
 
 /**
@@ -70,6 +72,8 @@ void *Mem_AllocBuffer(mem_buf_t *buf, size_t len) {
 	data = buf->data + buf->size;
 	buf->size += len;
 
+	buf->bits = 0;
+
 	return data;
 }
 
@@ -79,3 +83,68 @@ void *Mem_AllocBuffer(mem_buf_t *buf, size_t len) {
 void Mem_WriteBuffer(mem_buf_t *buf, const void *data, size_t len) {
 	memcpy(Mem_AllocBuffer(buf, len), data, len);
 }
+
+/**
+ * @brief Writes the low `num_bits` of `value` to the buffer, least significant
+ * bit first. Consecutive bit writes are packed together, while byte writes
+ * always begin on a new byte.
+ */
+void Mem_WriteBits(mem_buf_t *buf, uint32_t value, int32_t num_bits) {
+
+	while (num_bits > 0) {
+
+		if (buf->bits == 0) {
+			*(byte *) Mem_AllocBuffer(buf, 1) = 0;
+		}
+
+		const int32_t n = MIN(8 - buf->bits, num_bits);
+
+		buf->data[buf->size - 1] |= (byte) ((value & ((1u << n) - 1)) << buf->bits);
+		buf->bits = (buf->bits + n) & 7;
+
+		value >>= n;
+		num_bits -= n;
+	}
+}
+
+/**
+ * @brief Reads `num_bits` from the buffer, least significant bit first. Reads
+ * past the end of the buffer return 0, and advance the read cursor so that the
+ * caller may detect the underflow.
+ */
+uint32_t Mem_ReadBits(mem_buf_t *buf, int32_t num_bits) {
+	uint32_t value = 0;
+	int32_t shift = 0;
+
+	while (num_bits > 0) {
+
+		const int32_t n = MIN(8 - buf->read_bits, num_bits);
+
+		if (buf->read < buf->size) {
+			value |= ((uint32_t) (buf->data[buf->read] >> buf->read_bits) & ((1u << n) - 1)) << shift;
+		}
+
+		buf->read_bits += n;
+
+		if (buf->read_bits == 8) {
+			buf->read_bits = 0;
+			buf->read++;
+		}
+
+		shift += n;
+		num_bits -= n;
+	}
+
+	return value;
+}
+
+/**
+ * @brief Advances the read cursor to the next whole byte after bit reads.
+ */
+void Mem_AlignBits(mem_buf_t *buf) {
+
+	if (buf->read_bits) {
+		buf->read_bits = 0;
+		buf->read++;
+	}
+}
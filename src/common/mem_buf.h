@@ -33,9 +33,14 @@ typedef struct {
 	size_t max_size; // maximum size before overflow
 	size_t size; // current size
 	size_t read;
+	uint8_t bits; // bits used in the last byte by Mem_WriteBits, 0 if byte aligned
+	uint8_t read_bits; // bits consumed in the current byte by Mem_ReadBits
 } mem_buf_t;
 
 void Mem_InitBuffer(mem_buf_t *buf, byte *data, size_t len);
 void Mem_ClearBuffer(mem_buf_t *buf);
 void *Mem_AllocBuffer(mem_buf_t *buf, size_t len);
 void Mem_WriteBuffer(mem_buf_t *buf, const void *data, size_t len);
+void Mem_WriteBits(mem_buf_t *buf, uint32_t value, int32_t num_bits);
+uint32_t Mem_ReadBits(mem_buf_t *buf, int32_t num_bits);
+void Mem_AlignBits(mem_buf_t *buf);
@@ -0,0 +1,267 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "common.h"
+#include "profile.h"
+
+SDL_atomic_t profile_capturing;
+
+/**
+ * @brief Each thread that records a zone is given a ring of zones.
+ */
+typedef struct {
+	SDL_threadID id;
+	SDL_SpinLock lock; // held while recording, so that the ring may be read safely
+	uint32_t num_zones; // the total zones recorded in this capture
+	profile_zone_t zones[PROFILE_MAX_ZONES];
+} profile_thread_t;
+
+static _Thread_local profile_thread_t *profile_thread;
+
+static struct {
+	/**
+	 * @brief The threads that have recorded zones, and the lock protecting the list.
+	 */
+	GSList *threads;
+	SDL_SpinLock lock;
+
+	/**
+	 * @brief The capture's start time, and the frames remaining in it.
+	 */
+	uint64_t start;
+	int32_t frames;
+
+	/**
+	 * @brief The file the last capture was written to.
+	 */
+	char filename[MAX_QPATH];
+} profile_state;
+
+/**
+ * @return The calling thread's zone ring, allocating it if necessary.
+ */
+static profile_thread_t *Profile_Thread(void) {
+
+	if (profile_thread == NULL) {
+		profile_thread = Mem_Malloc(sizeof(profile_thread_t));
+		profile_thread->id = SDL_ThreadID();
+
+		SDL_AtomicLock(&profile_state.lock);
+		profile_state.threads = g_slist_prepend(profile_state.threads, profile_thread);
+		SDL_AtomicUnlock(&profile_state.lock);
+	}
+
+	return profile_thread;
+}
+
+/**
+ * @brief Records a zone of the specified name, which began at `start`, as returned by
+ * Profile_Begin. Zones which began before the capture are discarded.
+ */
+void Profile_End(const char *name, uint64_t start) {
+
+	if (start == 0 || !SDL_AtomicGet(&profile_capturing)) {
+		return;
+	}
+
+	const uint64_t end = SDL_GetPerformanceCounter();
+
+	profile_thread_t *thread = Profile_Thread();
+
+	SDL_AtomicLock(&thread->lock);
+
+	profile_zone_t *zone = &thread->zones[thread->num_zones++ % PROFILE_MAX_ZONES];
+
+	zone->name = name;
+	zone->start = start;
+	zone->end = end;
+
+	SDL_AtomicUnlock(&thread->lock);
+}
+
+/**
+ * @brief Begins capturing zones of the specified detail on all threads for the specified
+ * number of frames, or until Profile_Stop is called if `frames` is not positive.
+ */
+void Profile_Capture(int32_t frames, profile_detail_t detail) {
+
+	if (SDL_AtomicGet(&profile_capturing)) {
+		Com_Warn("A capture is already in progress\n");
+		return;
+	}
+
+	SDL_AtomicLock(&profile_state.lock);
+
+	for (GSList *list = profile_state.threads; list; list = list->next) {
+		profile_thread_t *thread = list->data;
+
+		SDL_AtomicLock(&thread->lock);
+		thread->num_zones = 0;
+		SDL_AtomicUnlock(&thread->lock);
+	}
+
+	SDL_AtomicUnlock(&profile_state.lock);
+
+	profile_state.start = SDL_GetPerformanceCounter();
+	profile_state.frames = frames;
+
+	SDL_AtomicSet(&profile_capturing, detail);
+}
+
+/**
+ * @brief Counts down the frames of the capture in progress, if any.
+ */
+void Profile_Frame(void) {
+
+	if (!SDL_AtomicGet(&profile_capturing)) {
+		return;
+	}
+
+	if (profile_state.frames > 0 && --profile_state.frames == 0) {
+		Profile_Stop();
+	}
+}
+
+/**
+ * @return The specified time, in microseconds since the capture began.
+ */
+static double Profile_Micros(uint64_t time) {
+	return (time - profile_state.start) * 1000000.0 / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief Ends the capture in progress, writing its zones to the profiles directory in
+ * the Chrome trace event format, for chrome://tracing or Perfetto.
+ * @return The name of the file written, or NULL.
+ */
+const char *Profile_Stop(void) {
+
+	if (!SDL_AtomicGet(&profile_capturing)) {
+		return NULL;
+	}
+
+	SDL_AtomicSet(&profile_capturing, 0);
+
+	Fs_Mkdir("profiles");
+
+	const char *filename = profile_state.filename;
+	g_snprintf(profile_state.filename, sizeof(profile_state.filename), "profiles/cpu_%u.json", SDL_GetTicks());
+
+	file_t *file = Fs_OpenWrite(filename);
+	if (!file) {
+		Com_Warn("Couldn't write to %s\n", Fs_RealPath(filename));
+		return NULL;
+	}
+
+	Fs_Print(file, "{\"traceEvents\":[\n");
+
+	uint32_t num_zones = 0, num_dropped = 0;
+
+	SDL_AtomicLock(&profile_state.lock);
+
+	for (GSList *list = profile_state.threads; list; list = list->next) {
+		profile_thread_t *thread = list->data;
+
+		SDL_AtomicLock(&thread->lock);
+
+		const char *thread_name = thread->id == thread_main ? "main" : "worker";
+
+		Fs_Print(file, "%s{\"pid\":1,\"tid\":%lu,\"ph\":\"M\",\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+				 num_zones ? ",\n" : "", (unsigned long) thread->id, thread_name);
+		num_zones++;
+
+		const uint32_t count = Mini(thread->num_zones, PROFILE_MAX_ZONES);
+		num_dropped += thread->num_zones - count;
+
+		for (uint32_t i = thread->num_zones - count; i < thread->num_zones; i++) {
+			const profile_zone_t *zone = &thread->zones[i % PROFILE_MAX_ZONES];
+
+			const double start = Profile_Micros(zone->start);
+			const double end = Profile_Micros(zone->end);
+
+			Fs_Print(file, ",\n{\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"ph\":\"X\",\"cat\":\"cpu\",\"name\":\"%s\",\"dur\":%.3f}",
+					 (unsigned long) thread->id, start, zone->name, end - start);
+		}
+
+		num_zones += count;
+
+		SDL_AtomicUnlock(&thread->lock);
+	}
+
+	SDL_AtomicUnlock(&profile_state.lock);
+
+	Fs_Print(file, "]}\n");
+	Fs_Close(file);
+
+	if (num_dropped) {
+		Com_Warn("%u zones were overwritten, consider capturing fewer frames\n", num_dropped);
+	}
+
+	Com_Print("Wrote %s\n", Fs_RealPath(filename));
+
+	return filename;
+}
+
+/**
+ * @brief Command callback for capturing a profile.
+ */
+static void Profile_f(void) {
+
+	if (!g_strcmp0(Cmd_Argv(1), "stop")) {
+		Profile_Stop();
+		return;
+	}
+
+	const int32_t frames = Cmd_Argc() > 1 ? (int32_t) strtol(Cmd_Argv(1), NULL, 10) : 0;
+
+	if (frames > 0) {
+		Com_Print("Capturing %d frames\n", frames);
+	} else {
+		Com_Print("Capturing until profile stop\n");
+	}
+
+	Profile_Capture(frames, PROFILE_FINE);
+}
+
+/**
+ * @brief Initializes the profiler.
+ */
+void Profile_Init(void) {
+
+	Cmd_Add("profile", Profile_f, CMD_SYSTEM, "Capture a CPU profile of the next frames, or until stopped.\n usage: profile [frames|stop]");
+}
+
+/**
+ * @brief Shuts down the profiler, writing any capture in progress.
+ */
+void Profile_Shutdown(void) {
+
+	Profile_Stop();
+
+	SDL_AtomicLock(&profile_state.lock);
+
+	g_slist_free_full(profile_state.threads, Mem_Free);
+	profile_state.threads = NULL;
+
+	SDL_AtomicUnlock(&profile_state.lock);
+
+	profile_thread = NULL;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include <SDL_atomic.h>
+#include <SDL_timer.h>
+
+#include "mem.h"
+
+/**
+ * @brief The number of zones each thread retains during a capture. Should a capture
+ * overrun this, each thread's oldest zones are overwritten.
+ */
+#define PROFILE_MAX_ZONES 0x20000
+
+/**
+ * @brief A completed zone. Zone names must outlive the capture, and are typically
+ * string literals.
+ */
+typedef struct {
+	const char *name;
+	uint64_t start, end;
+} profile_zone_t;
+
+/**
+ * @brief A zone that ends when it leaves scope, declared with PROFILE_SCOPE.
+ */
+typedef struct {
+	const char *name;
+	uint64_t start;
+} profile_scope_t;
+
+/**
+ * @brief The detail of a capture. Fine zones are recorded at a high rate (e.g. per
+ * trace), and would overrun the rings of a long capture, so they may be omitted.
+ */
+typedef enum {
+	PROFILE_COARSE = 1,
+	PROFILE_FINE
+} profile_detail_t;
+
+/**
+ * @brief The detail of the capture in progress, or 0.
+ */
+extern SDL_atomic_t profile_capturing;
+
+/**
+ * @return The start time of a zone, or 0 if no capture is in progress.
+ */
+static inline uint64_t Profile_Begin(void) {
+	return SDL_AtomicGet(&profile_capturing) ? SDL_GetPerformanceCounter() : 0;
+}
+
+/**
+ * @return The start time of a fine zone, or 0 if no fine capture is in progress.
+ */
+static inline uint64_t Profile_BeginFine(void) {
+	return SDL_AtomicGet(&profile_capturing) >= PROFILE_FINE ? SDL_GetPerformanceCounter() : 0;
+}
+
+void Profile_End(const char *name, uint64_t start);
+
+/**
+ * @brief Cleanup function for PROFILE_SCOPE.
+ */
+static inline void Profile_EndScope(const profile_scope_t *scope) {
+	if (scope->start) {
+		Profile_End(scope->name, scope->start);
+	}
+}
+
+#define PROFILE_SCOPE_(name, begin, line) \
+	const profile_scope_t profile_scope_##line __attribute__((cleanup(Profile_EndScope))) = { name, begin() }
+#define PROFILE_SCOPE__(name, begin, line) PROFILE_SCOPE_(name, begin, line)
+
+/**
+ * @brief Profiles the remainder of the enclosing scope as a zone of the specified name.
+ */
+#define PROFILE_SCOPE(name) PROFILE_SCOPE__(name, Profile_Begin, __LINE__)
+
+/**
+ * @brief Profiles the remainder of the enclosing scope as a fine zone.
+ */
+#define PROFILE_SCOPE_FINE(name) PROFILE_SCOPE__(name, Profile_BeginFine, __LINE__)
+
+void Profile_Capture(int32_t frames, profile_detail_t detail);
+void Profile_Frame(void);
+const char *Profile_Stop(void);
+void Profile_Init(void);
+void Profile_Shutdown(void);
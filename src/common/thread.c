@@ -19,41 +19,8 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
-#include <SDL_cpuinfo.h>
-#include <SDL_timer.h>
-
 #include "thread.h"
 
-typedef struct {
-
-	/**
-	 * @brief The lock governing global thread pool access.
-	 */
-	SDL_SpinLock lock;
-
-	/**
-	 * @brief The thread dispatch identifier.
-	 */
-	SDL_atomic_t id;
-
-	/**
-	 * @brief The number of threads in the pool.
-	 */
-	size_t num_threads;
-
-	/**
-	 * @brief The threads.
-	 */
-	thread_t *threads;
-} thread_pool_t;
-
-static thread_pool_t thread_pool;
-
-/**
- * @brief A sentinel thread function to indicate thread termination.
- */
-static ThreadRunFunc ThreadTerminate = (ThreadRunFunc) &ThreadTerminate;
-
 /**
  * @brief The main thread ID.
  */
@@ -65,134 +32,52 @@ SDL_threadID thread_main;
 _Thread_local SDL_threadID thread_id;
 
 /**
- * @brief Wrap the user's function in our own for introspection.
+ * @brief JobFunc wrapping the user's function, releasing the thread if it
+ * will not be waited on.
  */
-static int32_t Thread_Run(void *data) {
+static void Thread_Run(void *data) {
 	thread_t *t = (thread_t *) data;
 
-	thread_id = SDL_ThreadID();
-
-	while (t->Run != ThreadTerminate) {
-
-		SDL_LockMutex(t->mutex);
+	t->Run(t->data);
 
-		if (t->status == THREAD_RUNNING) {
-			t->Run(t->data);
-			if (t->options & THREAD_NO_WAIT) {
-				t->status = THREAD_IDLE;
-			} else {
-				t->status = THREAD_WAITING;
-			}
-			SDL_CondBroadcast(t->cond);
-		} else {
-			SDL_CondWait(t->cond, t->mutex);
-		}
-
-		SDL_UnlockMutex(t->mutex);
-	}
-
-	return 0;
-}
-
-/**
- * @brief Initializes the threads backing the thread pool.
- */
-static void Thread_Init_(ssize_t num_threads) {
-
-	if (num_threads == 0) {
-		num_threads = SDL_GetCPUCount();
-	} else if (num_threads == -1) {
-		num_threads = 0;
-	} else if (num_threads > MAX_THREADS) {
-		num_threads = MAX_THREADS;
-	}
-
-	thread_pool.num_threads = num_threads;
-
-	if (thread_pool.num_threads) {
-		thread_pool.threads = Mem_Malloc(sizeof(thread_t) * thread_pool.num_threads);
-
-		thread_t *t = thread_pool.threads;
-
-		for (size_t i = 0; i < thread_pool.num_threads; i++, t++) {
-			t->cond = SDL_CreateCond();
-			t->mutex = SDL_CreateMutex();
-			t->thread = SDL_CreateThread(Thread_Run, __func__, t);
-		}
-	}
-}
-
-/**
- * Thread_Shutdown_
- */
-static void Thread_Shutdown_(void) {
-
-	if (thread_pool.num_threads) {
-		thread_t *t = thread_pool.threads;
-
-		for (size_t i = 0; i < thread_pool.num_threads; i++, t++) {
-			Thread_Wait(t);
-			t->Run = ThreadTerminate;
-			SDL_CondSignal(t->cond);
-			SDL_WaitThread(t->thread, NULL);
-			SDL_DestroyCond(t->cond);
-			SDL_DestroyMutex(t->mutex);
-		}
-
-		Mem_Free(thread_pool.threads);
+	if (t->options & THREAD_NO_WAIT) {
+		Mem_Free(t);
 	}
 }
 
 /**
  * @brief Creates a new thread to run the specified function. Callers must use
  * Thread_Wait on the returned handle to release the thread when finished.
+ * @details Threads are executed as background jobs by the job system's workers.
+ * If there are no workers, the function is run immediately in this thread.
  */
 thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data, thread_options_t options) {
 
-	// if threads are available, find an idle one and dispatch it
-	if (thread_pool.num_threads) {
-		SDL_AtomicLock(&thread_pool.lock);
-
-		thread_t *t = thread_pool.threads;
-		for (size_t i = 0; i < thread_pool.num_threads; i++, t++) {
-
-			// if the thread appears idle, lock it and check again
-			if (t->status == THREAD_IDLE) {
-
-				SDL_LockMutex(t->mutex);
-
-				// if the thread is idle, dispatch it
-				if (t->status == THREAD_IDLE) {
-					t->status = THREAD_RUNNING;
-					t->options = options;
-
-					g_strlcpy(t->name, name, sizeof(t->name));
-
-					t->Run = run;
-					t->data = data;
+	if (Job_Workers() == 0) {
+		run(data);
+		return NULL;
+	}
 
-					SDL_UnlockMutex(t->mutex);
-					SDL_CondSignal(t->cond);
+	thread_t *t = Mem_Malloc(sizeof(thread_t));
 
-					SDL_AtomicUnlock(&thread_pool.lock);
-					return t;
-				}
+	t->options = options;
+	g_strlcpy(t->name, name, sizeof(t->name));
 
-				SDL_UnlockMutex(t->mutex);
-			}
-		}
+	t->Run = run;
+	t->data = data;
 
-		SDL_AtomicUnlock(&thread_pool.lock);
+	if (options & THREAD_NO_WAIT) {
+		Job_RunBackground(NULL, Thread_Run, t);
+		return NULL;
 	}
 
-	// if we failed to allocate a thread, run the function in this thread
-
-	run(data);
-	return NULL;
+	Job_RunBackground(&t->counter, Thread_Run, t);
+	return t;
 }
 
 /**
- * @brief Wait for the specified thread to complete.
+ * @brief Wait for the specified thread to complete, executing other jobs in
+ * the meantime.
  */
 void Thread_Wait(thread_t *t) {
 
@@ -200,23 +85,16 @@ void Thread_Wait(thread_t *t) {
 		return;
 	}
 
-	SDL_LockMutex(t->mutex);
+	Job_Wait(&t->counter);
 
-	if (t->status == THREAD_RUNNING) {
-		SDL_CondWait(t->cond, t->mutex);
-		assert(t->status == THREAD_WAITING);
-	}
-
-	SDL_UnlockMutex(t->mutex);
-
-	t->status = THREAD_IDLE;
+	Mem_Free(t);
 }
 
 /**
  * @brief Returns the number of threads in the pool.
  */
 int32_t Thread_Count(void) {
-	return (int32_t) thread_pool.num_threads;
+	return Job_Workers();
 }
 
 /**
@@ -224,9 +102,7 @@ int32_t Thread_Count(void) {
  */
 void Thread_Init(ssize_t num_threads) {
 
-	memset(&thread_pool, 0, sizeof(thread_pool));
-
-	Thread_Init_(num_threads);
+	Job_Init(num_threads);
 
 	thread_main = SDL_ThreadID();
 }
@@ -236,7 +112,5 @@ void Thread_Init(ssize_t num_threads) {
  */
 void Thread_Shutdown(void) {
 
-	Thread_Shutdown_();
-
-	memset(&thread_pool, 0, sizeof(thread_pool));
+	Job_Shutdown();
 }
@@ -23,15 +23,7 @@
 
 #include <SDL_thread.h>
 
-#include "mem.h"
-
-#define MAX_THREADS 128
-
-typedef enum {
-	THREAD_IDLE,
-	THREAD_RUNNING,
-	THREAD_WAITING,
-} thread_status_t;
+#include "job.h"
 
 typedef enum {
 	THREAD_NONE,
@@ -44,11 +36,11 @@ typedef enum {
 
 typedef void (*ThreadRunFunc)(void *data);
 
+/**
+ * @brief Threads are jobs on the job system, tracked by their own counter.
+ */
 typedef struct {
-	SDL_Thread *thread;
-	SDL_cond *cond;
-	SDL_mutex *mutex;
-	thread_status_t status;
+	job_counter_t counter;
 	thread_options_t options;
 	char name[64];
 	ThreadRunFunc Run;
@@ -320,6 +320,8 @@ void G_Ai_Frame(void) {
 		return;
 	}
 
+	const uint64_t start = gi.ProfileBegin();
+
 	aix->State(g_level.frame_num);
 
 	if (g_ai_max_clients->modified) {
@@ -373,6 +375,8 @@ void G_Ai_Frame(void) {
 	}
 
 	aix->Frame();
+
+	gi.ProfileEnd("G_Ai_Frame", start);
 }
 
 /**
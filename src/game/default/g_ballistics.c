@@ -362,42 +362,42 @@ void G_BlasterProjectile(g_entity_t *ent, const vec3_t start, const vec3_t dir,
 }
 
 /**
- * @brief
+ * @return The end point of a bullet fired from `start` along `dir`, with random spread.
  */
-void G_BulletProjectile(g_entity_t *ent, const vec3_t start, const vec3_t dir, int32_t damage,
-                        int32_t knockback, int32_t hspread, int32_t vspread, int32_t mod) {
-
-	cm_trace_t tr = gi.Trace(ent->s.origin, start, Box3_Zero(), ent, CONTENTS_MASK_CLIP_PROJECTILE);
-	if (tr.fraction == 1.0) {
-		vec3_t angles, forward, right, up, end;
+static vec3_t G_BulletProjectile_End(const vec3_t start, const vec3_t dir, int32_t hspread, int32_t vspread) {
+	vec3_t angles, forward, right, up, end;
 
-		angles = Vec3_Euler(dir);
-		Vec3_Vectors(angles, &forward, &right, &up);
+	angles = Vec3_Euler(dir);
+	Vec3_Vectors(angles, &forward, &right, &up);
 
-		end = Vec3_Fmaf(start, MAX_WORLD_DIST, forward);
-		end = Vec3_Fmaf(end, RandomRangef(-hspread, hspread), right);
-		end = Vec3_Fmaf(end, RandomRangef(-vspread, vspread), up);
+	end = Vec3_Fmaf(start, MAX_WORLD_DIST, forward);
+	end = Vec3_Fmaf(end, RandomRangef(-hspread, hspread), right);
+	end = Vec3_Fmaf(end, RandomRangef(-vspread, vspread), up);
 
-		tr = gi.Trace(start, end, Box3_Zero(), ent, CONTENTS_MASK_CLIP_PROJECTILE);
+	return end;
+}
 
-		G_Tracer(start, tr.end);
-	}
+/**
+ * @brief Deals damage and emits the impact effects for the specified bullet trace.
+ */
+static void G_BulletProjectile_Impact(g_entity_t *ent, const vec3_t start, const vec3_t dir, cm_trace_t *tr,
+                                      int32_t damage, int32_t knockback, int32_t mod) {
 
-	if (tr.fraction < 1.0) {
+	if (tr->fraction < 1.0) {
 
-		G_Damage(tr.ent, ent, ent, dir, tr.end, tr.plane.normal, damage, knockback, DMG_BULLET, mod);
+		G_Damage(tr->ent, ent, ent, dir, tr->end, tr->plane.normal, damage, knockback, DMG_BULLET, mod);
 
-		if (G_IsStructural(tr.ent, tr.texinfo)) {
-			const vec3_t impact = G_ProjectImpactPoint(NULL, tr.ent, &tr.plane, tr.texinfo, 0.0, tr.end);
-			G_BulletImpact(impact, &tr.plane, tr.texinfo);
+		if (G_IsStructural(tr->ent, tr->texinfo)) {
+			const vec3_t impact = G_ProjectImpactPoint(NULL, tr->ent, &tr->plane, tr->texinfo, 0.0, tr->end);
+			G_BulletImpact(impact, &tr->plane, tr->texinfo);
 		}
 
 		if (gi.PointContents(start) & CONTENTS_MASK_LIQUID) {
-			G_Ripple(NULL, tr.end, start, 8.0, false);
-			G_BubbleTrail(start, &tr);
-		} else if (gi.PointContents(tr.end) & CONTENTS_MASK_LIQUID) {
-			G_Ripple(NULL, start, tr.end, 8.0, true);
-			G_BubbleTrail(start, &tr);
+			G_Ripple(NULL, tr->end, start, 8.0, false);
+			G_BubbleTrail(start, tr);
+		} else if (gi.PointContents(tr->end) & CONTENTS_MASK_LIQUID) {
+			G_Ripple(NULL, start, tr->end, 8.0, true);
+			G_BubbleTrail(start, tr);
 		}
 	}
 }
@@ -405,11 +405,64 @@ void G_BulletProjectile(g_entity_t *ent, const vec3_t start, const vec3_t dir, i
 /**
  * @brief
  */
+void G_BulletProjectile(g_entity_t *ent, const vec3_t start, const vec3_t dir, int32_t damage,
+                        int32_t knockback, int32_t hspread, int32_t vspread, int32_t mod) {
+
+	cm_trace_t tr = gi.Trace(ent->s.origin, start, Box3_Zero(), ent, CONTENTS_MASK_CLIP_PROJECTILE);
+	if (tr.fraction == 1.0) {
+		const vec3_t end = G_BulletProjectile_End(start, dir, hspread, vspread);
+
+		tr = gi.Trace(start, end, Box3_Zero(), ent, CONTENTS_MASK_CLIP_PROJECTILE);
+
+		G_Tracer(start, tr.end);
+	}
+
+	G_BulletProjectile_Impact(ent, start, dir, &tr, damage, knockback, mod);
+}
+
+#define MAX_SHOTGUN_PELLETS 32
+
+/**
+ * @brief Fires `count` pellets, which are traced together through gi.TraceBatch. Every
+ * pellet in a batch is therefore traced before any of them deals damage.
+ */
 void G_ShotgunProjectiles(g_entity_t *ent, const vec3_t start, const vec3_t dir, int32_t damage,
 						  int32_t knockback, int32_t hspread, int32_t vspread, int32_t count, int32_t mod) {
 
-	for (int32_t i = 0; i < count; i++) {
-		G_BulletProjectile(ent, start, dir, damage, knockback, hspread, vspread, mod);
+	// if the muzzle is obstructed, every pellet strikes the obstruction
+	const cm_trace_t tr = gi.Trace(ent->s.origin, start, Box3_Zero(), ent, CONTENTS_MASK_CLIP_PROJECTILE);
+	if (tr.fraction < 1.0) {
+		for (int32_t i = 0; i < count; i++) {
+			cm_trace_t pellet = tr;
+			G_BulletProjectile_Impact(ent, start, dir, &pellet, damage, knockback, mod);
+		}
+		return;
+	}
+
+	g_trace_request_t requests[MAX_SHOTGUN_PELLETS];
+	cm_trace_t traces[MAX_SHOTGUN_PELLETS];
+
+	while (count > 0) {
+		const int32_t num_pellets = Mini(count, MAX_SHOTGUN_PELLETS);
+
+		for (int32_t i = 0; i < num_pellets; i++) {
+			requests[i] = (g_trace_request_t) {
+				.start = start,
+				.end = G_BulletProjectile_End(start, dir, hspread, vspread),
+				.bounds = Box3_Zero(),
+				.skip = ent,
+				.contents = CONTENTS_MASK_CLIP_PROJECTILE
+			};
+		}
+
+		gi.TraceBatch(requests, traces, num_pellets);
+
+		for (int32_t i = 0; i < num_pellets; i++) {
+			G_Tracer(start, traces[i].end);
+			G_BulletProjectile_Impact(ent, start, dir, &traces[i], damage, knockback, mod);
+		}
+
+		count -= num_pellets;
 	}
 }
 
@@ -25,7 +25,7 @@
 #include "ai/ai.h"
 #include "collision/cm_types.h"
 
-#define GAME_API_VERSION 13
+#define GAME_API_VERSION 15
 
 /**
  * @brief Server flags for g_entity_t.
@@ -179,6 +179,17 @@ struct g_entity_s {
 
 typedef _Bool (*EntityFilterFunc)(const g_entity_t *ent);
 
+/**
+ * @brief A single trace within a batch, for gi.TraceBatch. The members mirror the
+ * arguments to gi.Trace.
+ */
+typedef struct {
+	vec3_t start, end;
+	box3_t bounds;
+	const g_entity_t *skip;
+	int32_t contents;
+} g_trace_request_t;
+
 /**
  * @brief The game import provides engine functionality and core configuration
  * such as frame intervals to the game module.
@@ -216,6 +227,23 @@ typedef struct g_import_s {
 	 */
 	void (*Error_)(const char *func, const char *fmt, ...) __attribute__((noreturn, format(printf, 2, 3)));
 
+	/**
+	 * @}
+	 * @defgroup profiling Profiling
+	 * @{
+	 */
+
+	/**
+	 * @return The start time of a profiling zone, or 0 if no capture is in progress.
+	 */
+	uint64_t (*ProfileBegin)(void);
+
+	/**
+	 * @brief Ends the profiling zone of the specified name, which began at `start`.
+	 * @remarks The name must outlive the capture, and is typically a string literal.
+	 */
+	void (*ProfileEnd)(const char *name, uint64_t start);
+
 	/**
 	 * @}
 	 * @defgroup memory-management Memory management
@@ -582,6 +610,21 @@ typedef struct g_import_s {
 	cm_trace_t (*Trace)(const vec3_t start, const vec3_t end, const box3_t bounds,
 	                    const g_entity_t *skip, const int32_t contents);
 
+	/**
+	 * @brief Collision detection for many independent traces at once, such as
+	 * shotgun pellets or line of sight checks. Each trace is resolved exactly as
+	 * it would be through Trace, but the entity broadphase is shared by traces
+	 * of similar bounds, and large batches may run on the thread pool.
+	 *
+	 * @param requests The traces to perform.
+	 * @param traces The resulting traces, one for each request.
+	 * @param count The number of requests.
+	 *
+	 * @remarks Entities must not be linked or unlinked while a batch runs, so
+	 * every trace in the batch sees the world as it was when the batch began.
+	 */
+	void (*TraceBatch)(const g_trace_request_t *requests, cm_trace_t *traces, const size_t count);
+
 	/**
 	 * @brief Collision detection. Traces between the two endpoints, impacting
 	 * the specified entity's planes matching the specified contents mask.
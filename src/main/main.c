@@ -322,6 +322,8 @@ static void Init(void) {
 
 	Con_Init();
 
+	Profile_Init();
+
 	Cmd_Add("mem_stats", MemStats_f, CMD_SYSTEM, "Print memory stats");
 	Cmd_Add("debug", Debug_f, CMD_SYSTEM, "Control debugging output");
 	Cmd_Add("quit", Quit_f, CMD_SYSTEM, "Quit Quetoo");
@@ -367,6 +369,8 @@ static void Shutdown(const char *msg) {
 
 	Thread_Shutdown();
 
+	Profile_Shutdown();
+
 	Con_Shutdown();
 
 	Cvar_Shutdown();
@@ -385,6 +389,8 @@ static void Shutdown(const char *msg) {
  */
 static void Frame(const uint32_t msec) {
 
+	PROFILE_SCOPE("Frame");
+
 	Cbuf_Execute();
 
 	if (threads->modified) {
@@ -458,6 +464,8 @@ int32_t main(int32_t argc, char *argv[]) {
 
 		Frame(msec);
 
+		Profile_Frame();
+
 		old_time = quetoo.ticks;
 	}
 }
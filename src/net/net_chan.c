@@ -20,6 +20,7 @@
  */
 
 #include "net_chan.h"
+#include "net_compress.h"
 
 /*
  *
@@ -29,7 +30,8 @@
  * 1	does this message contain a reliable payload
  * 31	acknowledge sequence
  * 1	acknowledge receipt of even/odd message
- * 8	qport
+ * 8	qport (client to server only)
+ * 8	flags (NET_CHAN_COMPRESSED), only if compression was negotiated
  *
  * The remote connection never knows if it missed a reliable message, the
  * local side detects that it has been dropped by seeing a sequence acknowledge
@@ -67,6 +69,12 @@
  * channel matches even if the IP port differs. The IP port should be updated
  * to the new value before sending out any replies.
  *
+ * If compression was negotiated for the channel, both ends know it, and a flags
+ * byte follows the header (and qport). The payload (reliable and unreliable
+ * together) is compressed whenever that makes it smaller, and flagged with
+ * NET_CHAN_COMPRESSED. Each packet is compressed independently, so a lost
+ * packet never affects another.
+ *
  * If there is no information that needs to be transfered on a given frame,
  * such as during the connection stage while waiting for the client to load,
  * then a packet only needs to be delivered if there is something in the
@@ -76,6 +84,11 @@
 static cvar_t *net_show_packets;
 static cvar_t *net_show_drop;
 
+/**
+ * @brief Header flags, written only on channels which negotiated compression.
+ */
+#define NET_CHAN_COMPRESSED (1 << 0)
+
 net_addr_t net_from;
 mem_buf_t net_message;
 static byte net_message_buffer[MAX_MSG_SIZE];
@@ -174,6 +187,31 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 		send_reliable = true;
 	}
 
+	// assemble the payload, the reliable message first
+	mem_buf_t payload;
+	byte payload_buffer[MAX_MSG_SIZE];
+
+	Mem_InitBuffer(&payload, payload_buffer, sizeof(payload_buffer) - 10);
+
+	if (send_reliable) {
+		Mem_WriteBuffer(&payload, chan->reliable_buffer, chan->reliable_size);
+	}
+
+	// add the unreliable part if space is available
+	if (payload.max_size - payload.size >= len) {
+		Mem_WriteBuffer(&payload, data, len);
+	} else {
+		Com_Warn("Netchan_Transmit: dumped unreliable\n");
+	}
+
+	// and compress it, if negotiated and worthwhile
+	byte compressed[MAX_MSG_SIZE];
+	size_t compressed_size = 0;
+
+	if (chan->compress) {
+		compressed_size = Net_Compress(payload.data, payload.size, compressed, sizeof(compressed));
+	}
+
 	// write the packet header
 	Mem_InitBuffer(&send, send_buffer, sizeof(send_buffer));
 
@@ -191,17 +229,20 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 		Net_WriteByte(&send, chan->qport);
 	}
 
-	// copy the reliable message to the packet first
+	// and the flags, if compression was negotiated
+	if (chan->compress) {
+		Net_WriteByte(&send, compressed_size ? NET_CHAN_COMPRESSED : 0);
+	}
+
 	if (send_reliable) {
-		Mem_WriteBuffer(&send, chan->reliable_buffer, chan->reliable_size);
 		chan->reliable_outgoing = chan->outgoing_sequence;
 	}
 
-	// add the unreliable part if space is available
-	if (send.max_size - send.size >= len) {
-		Mem_WriteBuffer(&send, data, len);
+	// copy the payload to the packet
+	if (compressed_size) {
+		Mem_WriteBuffer(&send, compressed, compressed_size);
 	} else {
-		Com_Warn("Netchan_Transmit: dumped unreliable\n");
+		Mem_WriteBuffer(&send, payload.data, payload.size);
 	}
 
 	// send the datagram
@@ -215,6 +256,10 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 		else
 			Com_Print("Send %u bytes : s=%i ack=%i rack=%i\n", (uint32_t) send.size,
 			          chan->outgoing_sequence - 1, chan->incoming_sequence, chan->reliable_incoming);
+
+		if (compressed_size) {
+			Com_Print("Compressed %u bytes to %u\n", (uint32_t) payload.size, (uint32_t) compressed_size);
+		}
 	}
 }
 
@@ -237,6 +282,14 @@ _Bool Netchan_Process(net_chan_t *chan, mem_buf_t *msg) {
 		Net_ReadByte(msg);
 	}
 
+	// and the flags, if compression was negotiated
+	int32_t flags = 0;
+	if (chan->compress) {
+		flags = Net_ReadByte(msg);
+	}
+
+	const _Bool compressed = (flags & NET_CHAN_COMPRESSED) != 0;
+
 	reliable_message = sequence >> 31u;
 	reliable_ack = sequence_ack >> 31u;
 
@@ -260,6 +313,23 @@ _Bool Netchan_Process(net_chan_t *chan, mem_buf_t *msg) {
 		return false;
 	}
 
+	// inflate the payload in place, so that it reads as if it were never compressed
+	if (compressed) {
+		byte payload[MAX_MSG_SIZE];
+
+		const ssize_t len = Net_Decompress(msg->data + msg->read, msg->size - msg->read,
+		                                   payload, msg->max_size - msg->read);
+		if (len == -1) {
+			if (net_show_drop->value)
+				Com_Print("%s:Malformed compressed packet %i\n",
+				          Net_NetaddrToString(&chan->remote_address), sequence);
+			return false;
+		}
+
+		memcpy(msg->data + msg->read, payload, len);
+		msg->size = msg->read + len;
+	}
+
 	// dropped packets don't keep the message from being used
 	chan->dropped = sequence - (chan->incoming_sequence + 1);
 	if (chan->dropped > 0) {
@@ -298,6 +368,8 @@ void Netchan_Init(void) {
 	net_show_packets = Cvar_Add("net_show_packets", "0", 0, NULL);
 	net_show_drop = Cvar_Add("net_show_drop", "0", 0, NULL);
 
+	Net_InitCompression();
+
 	Mem_InitBuffer(&net_message, net_message_buffer, sizeof(net_message_buffer));
 }
 
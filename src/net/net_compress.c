@@ -0,0 +1,297 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "net_compress.h"
+
+/*
+ * compressed stream
+ * -----------------
+ * The stream is a series of sequences, each of which is a token byte, an
+ * optional literal run and an optional back reference:
+ *
+ * 4	literal length (15 indicates that extension bytes follow)
+ * 4	match length - NET_COMPRESS_MIN_MATCH (15 indicates extension bytes)
+ * *	literal length extension bytes, each adding up to 255
+ * *	literals
+ * 16	match offset, little endian, relative to the current output position
+ * *	match length extension bytes, each adding up to 255
+ *
+ * The final sequence contains only literals, and ends the stream. Offsets may
+ * reach back into the static dictionary, which precedes the output.
+ */
+
+#define NET_COMPRESS_HASH_BITS 12
+#define NET_COMPRESS_HASH_SIZE (1 << NET_COMPRESS_HASH_BITS)
+#define NET_COMPRESS_MIN_MATCH 4
+#define NET_COMPRESS_MAX_OFFSET 0xffff
+
+/**
+ * @brief The static dictionary. Its contents are shared history for every
+ * packet, so it should contain the byte sequences most common in game traffic.
+ * Both ends of a connection must agree on it, so it is part of the protocol.
+ * @details This dictionary is written by hand from the protocol's common strings
+ * and byte runs. It is not trained from demo traffic, because no demo corpus ships
+ * with the source. Replacing it with one trained from recorded demos should be
+ * measured with check_net_compress, which replays any demos it finds.
+ */
+static const byte net_dictionary[] =
+	"\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"config_strings precache \n"
+	"models/players/qforcer/ models/players/ models/weapons/ models/objects/ models/powerups/ "
+	"sounds/weapons/ sounds/players/ sounds/world/ sounds/misc/ sounds/chat/ sounds/items/ "
+	"sprites/ pics/ textures/ maps/ players/ #players/ skins/ default "
+	".md3 .obj .wav .ogg .tga .png .jpg .bsp .cfg "
+	"\\name\\\\skin\\\\color\\\\hand\\\\rate\\\\message_level\\\\ip\\\\spectator\\"
+	"^1^2^3^4^5^6^7 ^7: ^2 ^7 killed ^7 was ^7 by ^7 joined the game\n ^7 left the game\n"
+	"blaster shotgun super_shotgun machinegun grenade_launcher rocket_launcher hyperblaster "
+	"lightning railgun bfg10k hand_grenade chaingun armor_shard armor_jacket armor_combat "
+	"armor_body health_small health health_large health_mega quad_damage adrenaline "
+	"red_flag blue_flag team_red team_blue score frags capture ";
+
+static int32_t net_dictionary_hash[NET_COMPRESS_HASH_SIZE];
+
+#define NET_DICTIONARY_SIZE (sizeof(net_dictionary) - 1)
+
+/**
+ * @return The hash of the minimum match at the specified position.
+ */
+static inline uint32_t Net_CompressHash(const byte *p) {
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return (v * 2654435761u) >> (32 - NET_COMPRESS_HASH_BITS);
+}
+
+/**
+ * @brief Hashes the static dictionary, which seeds every compression.
+ */
+void Net_InitCompression(void) {
+
+	for (size_t i = 0; i < lengthof(net_dictionary_hash); i++) {
+		net_dictionary_hash[i] = -1;
+	}
+
+	for (size_t i = 0; i + NET_COMPRESS_MIN_MATCH <= NET_DICTIONARY_SIZE; i++) {
+		net_dictionary_hash[Net_CompressHash(net_dictionary + i)] = (int32_t) i;
+	}
+}
+
+/**
+ * @brief Writes a length extension, returning false if the output is full.
+ */
+static _Bool Net_CompressLength(byte *out, size_t *op, size_t out_max, size_t len) {
+
+	while (true) {
+		if (*op >= out_max) {
+			return false;
+		}
+
+		const byte b = (byte) Mini((int32_t) len, 255);
+		out[(*op)++] = b;
+
+		if (b < 255) {
+			return true;
+		}
+
+		len -= 255;
+	}
+}
+
+/**
+ * @brief Writes a sequence of literals and an optional match, returning false if
+ * the output is full.
+ */
+static _Bool Net_CompressSequence(byte *out, size_t *op, size_t out_max, const byte *literals,
+                                  size_t num_literals, size_t offset, size_t match) {
+
+	if (*op >= out_max) {
+		return false;
+	}
+
+	const size_t m = match ? match - NET_COMPRESS_MIN_MATCH : 0;
+
+	out[(*op)++] = (byte) ((Mini((int32_t) num_literals, 15) << 4) | Mini((int32_t) m, 15));
+
+	if (num_literals >= 15 && !Net_CompressLength(out, op, out_max, num_literals - 15)) {
+		return false;
+	}
+
+	if (*op + num_literals > out_max) {
+		return false;
+	}
+
+	memcpy(out + *op, literals, num_literals);
+	*op += num_literals;
+
+	if (match) {
+		if (*op + 2 > out_max) {
+			return false;
+		}
+
+		out[(*op)++] = offset & 0xff;
+		out[(*op)++] = offset >> 8;
+
+		if (m >= 15 && !Net_CompressLength(out, op, out_max, m - 15)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Compresses `in` to `out`.
+ * @return The compressed size, or 0 if the input could not be made smaller.
+ */
+size_t Net_Compress(const byte *in, size_t in_len, byte *out, size_t out_max) {
+	byte window[NET_DICTIONARY_SIZE + MAX_MSG_SIZE];
+	int32_t table[NET_COMPRESS_HASH_SIZE];
+
+	if (in_len == 0 || in_len > MAX_MSG_SIZE) {
+		return 0;
+	}
+
+	// never produce more than the input, so that compression never costs space
+	out_max = Mini((int32_t) out_max, (int32_t) in_len - 1);
+
+	memcpy(window, net_dictionary, NET_DICTIONARY_SIZE);
+	memcpy(window + NET_DICTIONARY_SIZE, in, in_len);
+
+	memcpy(table, net_dictionary_hash, sizeof(table));
+
+	const size_t end = NET_DICTIONARY_SIZE + in_len;
+	size_t ip = NET_DICTIONARY_SIZE, anchor = ip, op = 0;
+
+	while (ip + NET_COMPRESS_MIN_MATCH <= end) {
+
+		const uint32_t h = Net_CompressHash(window + ip);
+		const int32_t ref = table[h];
+
+		table[h] = (int32_t) ip;
+
+		if (ref < 0 || ip - ref > NET_COMPRESS_MAX_OFFSET ||
+		        memcmp(window + ref, window + ip, NET_COMPRESS_MIN_MATCH)) {
+			ip++;
+			continue;
+		}
+
+		size_t match = NET_COMPRESS_MIN_MATCH;
+		while (ip + match < end && window[ref + match] == window[ip + match]) {
+			match++;
+		}
+
+		if (!Net_CompressSequence(out, &op, out_max, window + anchor, ip - anchor, ip - ref, match)) {
+			return 0;
+		}
+
+		ip += match;
+		anchor = ip;
+	}
+
+	if (!Net_CompressSequence(out, &op, out_max, window + anchor, end - anchor, 0, 0)) {
+		return 0;
+	}
+
+	return op;
+}
+
+/**
+ * @brief Reads a length extension, returning false if the input is exhausted.
+ */
+static _Bool Net_DecompressLength(const byte *in, size_t *ip, size_t in_len, size_t *len) {
+
+	while (true) {
+		if (*ip >= in_len) {
+			return false;
+		}
+
+		const byte b = in[(*ip)++];
+		*len += b;
+
+		if (b < 255) {
+			return true;
+		}
+	}
+}
+
+/**
+ * @brief Decompresses `in` to `out`. Malformed input is rejected, and never
+ * produces more than `out_max` bytes.
+ * @return The decompressed size, or -1 on error.
+ */
+ssize_t Net_Decompress(const byte *in, size_t in_len, byte *out, size_t out_max) {
+	byte window[NET_DICTIONARY_SIZE + MAX_MSG_SIZE];
+
+	memcpy(window, net_dictionary, NET_DICTIONARY_SIZE);
+
+	const size_t limit = NET_DICTIONARY_SIZE + Mini((int32_t) out_max, MAX_MSG_SIZE);
+	size_t ip = 0, op = NET_DICTIONARY_SIZE;
+
+	while (ip < in_len) {
+		const byte token = in[ip++];
+
+		size_t num_literals = token >> 4;
+		if (num_literals == 15 && !Net_DecompressLength(in, &ip, in_len, &num_literals)) {
+			return -1;
+		}
+
+		if (ip + num_literals > in_len || op + num_literals > limit) {
+			return -1;
+		}
+
+		memcpy(window + op, in + ip, num_literals);
+		ip += num_literals;
+		op += num_literals;
+
+		if (ip == in_len) {
+			break;
+		}
+
+		if (ip + 2 > in_len) {
+			return -1;
+		}
+
+		const size_t offset = in[ip] | (in[ip + 1] << 8);
+		ip += 2;
+
+		size_t match = token & 15;
+		if (match == 15 && !Net_DecompressLength(in, &ip, in_len, &match)) {
+			return -1;
+		}
+
+		match += NET_COMPRESS_MIN_MATCH;
+
+		if (offset == 0 || offset > op || op + match > limit) {
+			return -1;
+		}
+
+		// matches may overlap their own output, so copy forward byte by byte
+		for (size_t i = 0; i < match; i++, op++) {
+			window[op] = window[op - offset];
+		}
+	}
+
+	memcpy(out, window + NET_DICTIONARY_SIZE, op - NET_DICTIONARY_SIZE);
+
+	return (ssize_t) (op - NET_DICTIONARY_SIZE);
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "net_types.h"
+
+/**
+ * @brief Packet payloads are compressed with a byte oriented LZ77 variant,
+ * using a static dictionary as the initial history. Each packet is compressed
+ * independently, so that packet loss never corrupts subsequent packets.
+ */
+void Net_InitCompression(void);
+size_t Net_Compress(const byte *in, size_t in_len, byte *out, size_t out_max);
+ssize_t Net_Decompress(const byte *in, size_t in_len, byte *out, size_t out_max);
@@ -0,0 +1,469 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_endian.h>
+
+#include "net_demo.h"
+
+/*
+ * demo container
+ * --------------
+ * All values are little endian.
+ *
+ * 32	DEMO_IDENT
+ * 32	DEMO_VERSION
+ *
+ * Followed by any number of blocks, each of which is a server message:
+ *
+ * 32	message length
+ * 32	time, in milliseconds
+ * 32	DEMO_BLOCK_* flags
+ * *	message
+ *
+ * A message length of -1 terminates the blocks, and is followed by the keyframe
+ * index and then the footer, which is always the last DEMO_FOOTER_SIZE bytes:
+ *
+ * 32	keyframe time, in milliseconds \ repeated for each keyframe
+ * 64	keyframe offset                /
+ * 64	index offset
+ * 32	number of keyframes
+ * 32	end time, in milliseconds
+ * 32	DEMO_IDENT
+ *
+ * Demos which were not properly terminated have no index, and are indexed by
+ * scanning their block headers when opened.
+ */
+
+#define DEMO_HEADER_SIZE (sizeof(int32_t) * 2)
+#define DEMO_BLOCK_HEADER_SIZE (sizeof(int32_t) * 3)
+#define DEMO_FOOTER_SIZE (sizeof(int64_t) + sizeof(int32_t) * 3)
+
+/**
+ * @brief Reads a little endian 32 bit integer, returning false on failure.
+ */
+static _Bool Net_ReadDemoLong(demo_t *demo, int32_t *l) {
+
+	if (Fs_Read(demo->file, l, sizeof(*l), 1) != 1) {
+		return false;
+	}
+
+	*l = LittleLong(*l);
+	return true;
+}
+
+/**
+ * @brief Reads a little endian 64 bit integer, returning false on failure.
+ */
+static _Bool Net_ReadDemoLongLong(demo_t *demo, int64_t *ll) {
+
+	if (Fs_Read(demo->file, ll, sizeof(*ll), 1) != 1) {
+		return false;
+	}
+
+	*ll = (int64_t) SDL_SwapLE64((uint64_t) *ll);
+	return true;
+}
+
+/**
+ * @brief Writes a little endian 32 bit integer.
+ */
+static void Net_WriteDemoLong(demo_t *demo, int32_t l) {
+
+	l = LittleLong(l);
+	Fs_Write(demo->file, &l, sizeof(l), 1);
+}
+
+/**
+ * @brief Writes a little endian 64 bit integer.
+ */
+static void Net_WriteDemoLongLong(demo_t *demo, int64_t ll) {
+
+	ll = (int64_t) SDL_SwapLE64((uint64_t) ll);
+	Fs_Write(demo->file, &ll, sizeof(ll), 1);
+}
+
+/**
+ * @brief Allocates a demo for the specified file.
+ */
+static demo_t *Net_AllocDemo(file_t *file, _Bool write) {
+
+	demo_t *demo = Mem_TagMalloc(sizeof(demo_t), MEM_TAG_FS);
+
+	demo->file = file;
+	demo->write = write;
+	demo->keyframes = g_array_new(false, false, sizeof(demo_keyframe_t));
+	demo->block = Mem_LinkMalloc(sizeof(demo_block_t), demo);
+
+	return demo;
+}
+
+/**
+ * @brief Creates the specified demo file for recording.
+ *
+ * @return The demo, or NULL if the file could not be opened.
+ */
+demo_t *Net_CreateDemo(const char *filename) {
+
+	file_t *file = Fs_OpenWrite(filename);
+	if (!file) {
+		return NULL;
+	}
+
+	demo_t *demo = Net_AllocDemo(file, true);
+
+	Net_WriteDemoLong(demo, DEMO_IDENT);
+	Net_WriteDemoLong(demo, DEMO_VERSION);
+
+	return demo;
+}
+
+/**
+ * @brief Appends the specified server message to the demo.
+ */
+void Net_WriteDemoBlock(demo_t *demo, const void *data, size_t size, int32_t time, int32_t flags) {
+
+	assert(demo->write);
+
+	if (demo->num_blocks == 0) {
+		demo->start_time = time;
+	}
+
+	Net_WriteDemoLong(demo, (int32_t) size);
+	Net_WriteDemoLong(demo, time);
+	Net_WriteDemoLong(demo, flags);
+
+	Fs_Write(demo->file, data, size, 1);
+
+	demo->num_blocks++;
+	demo->time = demo->end_time = time;
+}
+
+/**
+ * @brief Indexes a keyframe at the current position. The keyframe's blocks must follow,
+ * each of them flagged with DEMO_BLOCK_KEYFRAME.
+ */
+void Net_WriteDemoKeyframe(demo_t *demo, int32_t time) {
+
+	assert(demo->write);
+
+	const demo_keyframe_t keyframe = {
+		.time = time,
+		.offset = Fs_Tell(demo->file)
+	};
+
+	g_array_append_val(demo->keyframes, keyframe);
+}
+
+/**
+ * @brief Reads the next block header, returning its length, or -1 at the end of the blocks.
+ */
+static int32_t Net_ReadDemoBlockHeader(demo_t *demo, int32_t *time, int32_t *flags) {
+	int32_t size;
+
+	if (!Net_ReadDemoLong(demo, &size)) {
+		Com_Debug(DEBUG_NET, "Demo not properly terminated\n");
+		return -1;
+	}
+
+	if (size == -1) {
+		return -1;
+	}
+
+	if (size < 0 || size > MAX_MSG_SIZE) {
+		Com_Warn("Invalid demo block length %d\n", size);
+		return -1;
+	}
+
+	if (demo->legacy) {
+		*time = demo->num_blocks * QUETOO_TICK_MILLIS;
+		*flags = DEMO_BLOCK_FRAME;
+		return size;
+	}
+
+	if (!Net_ReadDemoLong(demo, time) || !Net_ReadDemoLong(demo, flags)) {
+		Com_Warn("Incomplete or corrupt demo file\n");
+		return -1;
+	}
+
+	return size;
+}
+
+/**
+ * @brief Loads the keyframe index from the demo footer.
+ *
+ * @return True if the footer was present and valid, false otherwise.
+ */
+static _Bool Net_LoadDemoIndex(demo_t *demo) {
+	int64_t index_offset;
+	int32_t num_keyframes, end_time, ident;
+
+	const int64_t len = Fs_FileLength(demo->file);
+	if (len < (int64_t) (DEMO_HEADER_SIZE + DEMO_FOOTER_SIZE)) {
+		return false;
+	}
+
+	if (!Fs_Seek(demo->file, len - DEMO_FOOTER_SIZE)) {
+		return false;
+	}
+
+	if (!Net_ReadDemoLongLong(demo, &index_offset) ||
+		!Net_ReadDemoLong(demo, &num_keyframes) ||
+		!Net_ReadDemoLong(demo, &end_time) ||
+		!Net_ReadDemoLong(demo, &ident)) {
+		return false;
+	}
+
+	if (ident != DEMO_IDENT || num_keyframes < 0) {
+		return false;
+	}
+
+	const int64_t index_size = num_keyframes * (int64_t) (sizeof(int32_t) + sizeof(int64_t));
+	if (index_offset < (int64_t) DEMO_HEADER_SIZE || index_offset + index_size + DEMO_FOOTER_SIZE != len) {
+		return false;
+	}
+
+	if (!Fs_Seek(demo->file, index_offset)) {
+		return false;
+	}
+
+	g_array_set_size(demo->keyframes, num_keyframes);
+
+	for (int32_t i = 0; i < num_keyframes; i++) {
+		demo_keyframe_t *keyframe = &g_array_index(demo->keyframes, demo_keyframe_t, i);
+
+		if (!Net_ReadDemoLong(demo, &keyframe->time) || !Net_ReadDemoLongLong(demo, &keyframe->offset)) {
+			g_array_set_size(demo->keyframes, 0);
+			return false;
+		}
+	}
+
+	demo->end_time = end_time;
+	return true;
+}
+
+/**
+ * @brief Rebuilds the keyframe index of a demo which was not properly terminated, by
+ * scanning its block headers.
+ */
+static void Net_ScanDemoIndex(demo_t *demo) {
+	int32_t size, time, flags;
+	_Bool keyframe = false;
+
+	Fs_Seek(demo->file, DEMO_HEADER_SIZE);
+
+	while (true) {
+		const int64_t offset = Fs_Tell(demo->file);
+
+		if ((size = Net_ReadDemoBlockHeader(demo, &time, &flags)) == -1) {
+			break;
+		}
+
+		if (!Fs_Seek(demo->file, offset + DEMO_BLOCK_HEADER_SIZE + size)) {
+			break;
+		}
+
+		if ((flags & DEMO_BLOCK_KEYFRAME) && !keyframe) {
+			const demo_keyframe_t kf = { .time = time, .offset = offset };
+			g_array_append_val(demo->keyframes, kf);
+		}
+
+		keyframe = (flags & DEMO_BLOCK_KEYFRAME) && !(flags & DEMO_BLOCK_FRAME);
+		demo->end_time = time;
+	}
+
+	Com_Debug(DEBUG_NET, "Indexed %u keyframes\n", demo->keyframes->len);
+}
+
+/**
+ * @brief Opens the specified demo file for playback. Both the demo container and legacy
+ * demos are supported.
+ *
+ * @return The demo, or NULL if the file could not be opened or is not a demo.
+ */
+demo_t *Net_OpenDemo(const char *filename) {
+	int32_t ident, version;
+
+	file_t *file = Fs_OpenRead(filename);
+	if (!file) {
+		return NULL;
+	}
+
+	demo_t *demo = Net_AllocDemo(file, false);
+
+	if (!Net_ReadDemoLong(demo, &ident)) {
+		Com_Warn("Failed to read %s\n", filename);
+		Net_CloseDemo(demo);
+		return NULL;
+	}
+
+	if (ident == DEMO_IDENT) {
+
+		if (!Net_ReadDemoLong(demo, &version)) {
+			Com_Warn("Failed to read version of %s\n", filename);
+			Net_CloseDemo(demo);
+			return NULL;
+		}
+
+		if (version != DEMO_VERSION) {
+			Com_Warn("%s has unsupported version %d\n", filename, version);
+			Net_CloseDemo(demo);
+			return NULL;
+		}
+
+		if (!Net_LoadDemoIndex(demo)) {
+			Net_ScanDemoIndex(demo);
+		}
+
+		Fs_Seek(demo->file, DEMO_HEADER_SIZE);
+	} else {
+		demo->legacy = true;
+		Fs_Seek(demo->file, 0);
+	}
+
+	const demo_block_t *block = Net_PeekDemoBlock(demo);
+	if (block) {
+		demo->start_time = block->time;
+	}
+
+	return demo;
+}
+
+/**
+ * @brief Reads the next block of the demo, if it has not been consumed already.
+ *
+ * @return The next block, or NULL at the end of the demo.
+ */
+const demo_block_t *Net_PeekDemoBlock(demo_t *demo) {
+
+	assert(!demo->write);
+
+	if (demo->pending) {
+		return demo->block;
+	}
+
+	if (demo->eof) {
+		return NULL;
+	}
+
+	demo_block_t *block = demo->block;
+
+	const int32_t size = Net_ReadDemoBlockHeader(demo, &block->time, &block->flags);
+	if (size == -1) {
+		demo->eof = true;
+		return NULL;
+	}
+
+	if (size && Fs_Read(demo->file, block->data, size, 1) != 1) {
+		Com_Warn("Incomplete or corrupt demo file\n");
+		demo->eof = true;
+		return NULL;
+	}
+
+	block->size = size;
+
+	demo->num_blocks++;
+	demo->time = block->time;
+	demo->pending = true;
+
+	return block;
+}
+
+/**
+ * @brief Consumes the pending block, so that the next block will be read.
+ */
+void Net_ConsumeDemoBlock(demo_t *demo) {
+	demo->pending = false;
+}
+
+/**
+ * @brief Positions the demo at the last keyframe at or before the specified time, with a
+ * binary search of the keyframe index.
+ *
+ * @return The keyframe, or NULL if the demo is not seekable.
+ */
+const demo_keyframe_t *Net_SeekDemo(demo_t *demo, int32_t time) {
+
+	assert(!demo->write);
+
+	if (demo->keyframes->len == 0) {
+		return NULL;
+	}
+
+	guint lo = 0, hi = demo->keyframes->len;
+	while (hi - lo > 1) {
+		const guint mid = (lo + hi) / 2;
+
+		if (g_array_index(demo->keyframes, demo_keyframe_t, mid).time <= time) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	const demo_keyframe_t *keyframe = &g_array_index(demo->keyframes, demo_keyframe_t, lo);
+
+	if (!Fs_Seek(demo->file, keyframe->offset)) {
+		Com_Warn("Failed to seek demo: %s\n", Fs_LastError());
+		return NULL;
+	}
+
+	demo->pending = demo->eof = false;
+	demo->time = keyframe->time;
+
+	return keyframe;
+}
+
+/**
+ * @return The demo duration, in milliseconds.
+ */
+int32_t Net_DemoDuration(const demo_t *demo) {
+	return demo->end_time - demo->start_time;
+}
+
+/**
+ * @brief Closes the demo. Recordings are terminated, and their keyframe index written.
+ */
+void Net_CloseDemo(demo_t *demo) {
+
+	if (demo->write) {
+		Net_WriteDemoLong(demo, -1);
+
+		const int64_t index_offset = Fs_Tell(demo->file);
+
+		for (guint i = 0; i < demo->keyframes->len; i++) {
+			const demo_keyframe_t *keyframe = &g_array_index(demo->keyframes, demo_keyframe_t, i);
+
+			Net_WriteDemoLong(demo, keyframe->time);
+			Net_WriteDemoLongLong(demo, keyframe->offset);
+		}
+
+		Net_WriteDemoLongLong(demo, index_offset);
+		Net_WriteDemoLong(demo, (int32_t) demo->keyframes->len);
+		Net_WriteDemoLong(demo, demo->end_time);
+		Net_WriteDemoLong(demo, DEMO_IDENT);
+	}
+
+	Fs_Close(demo->file);
+
+	g_array_free(demo->keyframes, true);
+
+	Mem_Free(demo);
+}
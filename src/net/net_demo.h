@@ -0,0 +1,146 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "net_types.h"
+
+/**
+ * @brief Demo files begin with this identifier ("QDEM"), followed by the version. Legacy
+ * demos begin with the length of their first message, which never matches it.
+ */
+#define DEMO_IDENT (('M' << 24) + ('E' << 16) + ('D' << 8) + 'Q')
+#define DEMO_VERSION 1
+
+/**
+ * @brief Set on blocks which complete a server frame. Playback delivers at most one
+ * frame per server frame.
+ */
+#define DEMO_BLOCK_FRAME		(1 << 0)
+
+/**
+ * @brief Set on blocks which belong to a keyframe. Keyframes carry the complete client
+ * state at their time, and are only delivered when seeking to them.
+ */
+#define DEMO_BLOCK_KEYFRAME		(1 << 1)
+
+/**
+ * @brief A demo block is a single server message, with its timecode.
+ */
+typedef struct {
+	/**
+	 * @brief The server time of the frame the message belongs to, in milliseconds.
+	 */
+	int32_t time;
+
+	/**
+	 * @brief The DEMO_BLOCK_* flags.
+	 */
+	int32_t flags;
+
+	/**
+	 * @brief The message.
+	 */
+	byte data[MAX_MSG_SIZE];
+	size_t size;
+} demo_block_t;
+
+/**
+ * @brief A keyframe index entry.
+ */
+typedef struct {
+	/**
+	 * @brief The keyframe time, in milliseconds.
+	 */
+	int32_t time;
+
+	/**
+	 * @brief The file offset of the keyframe's first block.
+	 */
+	int64_t offset;
+} demo_keyframe_t;
+
+/**
+ * @brief A demo file, opened for either recording or playback.
+ */
+typedef struct {
+	/**
+	 * @brief The file handle.
+	 */
+	file_t *file;
+
+	/**
+	 * @brief True if the file is writable.
+	 */
+	_Bool write;
+
+	/**
+	 * @brief True if the file predates the demo container, and is a series of length
+	 * prefixed messages. Legacy demos play back one message per frame, and can not seek.
+	 */
+	_Bool legacy;
+
+	/**
+	 * @brief The keyframe index, in ascending time.
+	 */
+	GArray *keyframes;
+
+	/**
+	 * @brief The number of blocks read or written.
+	 */
+	uint32_t num_blocks;
+
+	/**
+	 * @brief The time of the first block, in milliseconds.
+	 */
+	int32_t start_time;
+
+	/**
+	 * @brief The time of the last block read or written, in milliseconds.
+	 */
+	int32_t time;
+
+	/**
+	 * @brief The time of the last block in the file, in milliseconds.
+	 */
+	int32_t end_time;
+
+	/**
+	 * @brief The block most recently read, awaiting consumption if `pending` is set.
+	 */
+	demo_block_t *block;
+	_Bool pending;
+
+	/**
+	 * @brief True when playback has reached the end of the demo.
+	 */
+	_Bool eof;
+} demo_t;
+
+demo_t *Net_CreateDemo(const char *filename);
+void Net_WriteDemoBlock(demo_t *demo, const void *data, size_t size, int32_t time, int32_t flags);
+void Net_WriteDemoKeyframe(demo_t *demo, int32_t time);
+demo_t *Net_OpenDemo(const char *filename);
+const demo_block_t *Net_PeekDemoBlock(demo_t *demo);
+void Net_ConsumeDemoBlock(demo_t *demo);
+const demo_keyframe_t *Net_SeekDemo(demo_t *demo, int32_t time);
+int32_t Net_DemoDuration(const demo_t *demo);
+void Net_CloseDemo(demo_t *demo);
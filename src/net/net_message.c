@@ -110,9 +110,9 @@ void Net_WritePosition(mem_buf_t *msg, const vec3_t pos) {
 }
 
 /**
- * @brief
+ * @return The 16 bit encoding of the specified angle.
  */
-void Net_WriteAngle(mem_buf_t *msg, float angle) {
+static int16_t Net_AngleToShort(float angle) {
 
 	while (angle < 0.f) {
 		angle += 360.f;
@@ -122,7 +122,14 @@ void Net_WriteAngle(mem_buf_t *msg, float angle) {
 		angle -= 360.f;
 	}
 
-	Net_WriteShort(msg, (int16_t) ((angle / 360.0f) * UINT16_MAX));
+	return (int16_t) ((angle / 360.0f) * UINT16_MAX);
+}
+
+/**
+ * @brief
+ */
+void Net_WriteAngle(mem_buf_t *msg, float angle) {
+	Net_WriteShort(msg, Net_AngleToShort(angle));
 }
 
 /**
@@ -231,9 +238,9 @@ void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t
 }
 
 /**
- * @brief
+ * @return The PS_* bits describing the changes from one player state to another.
  */
-void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to) {
+static uint16_t Net_DeltaPlayerStateBits(const player_state_t *from, const player_state_t *to) {
 
 	uint16_t bits = 0;
 
@@ -285,6 +292,32 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		bits |= PS_PM_STEP_OFFSET;
 	}
 
+	return bits;
+}
+
+/**
+ * @return The bits describing which stats differ from one player state to another.
+ */
+static uint32_t Net_DeltaStatBits(const player_state_t *from, const player_state_t *to) {
+
+	uint32_t stat_bits = 0;
+
+	for (int32_t i = 0; i < MAX_STATS; i++) {
+		if (to->stats[i] != from->stats[i]) {
+			stat_bits |= 1u << i;
+		}
+	}
+
+	return stat_bits;
+}
+
+/**
+ * @brief
+ */
+void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to) {
+
+	const uint16_t bits = Net_DeltaPlayerStateBits(from, to);
+
 	Net_WriteShort(msg, bits);
 
 	if (bits & PS_PM_TYPE) {
@@ -335,13 +368,7 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		Net_WriteFloat(msg, to->pm_state.step_offset);
 	}
 
-	uint32_t stat_bits = 0;
-
-	for (int32_t i = 0; i < MAX_STATS; i++) {
-		if (to->stats[i] != from->stats[i]) {
-			stat_bits |= 1 << i;
-		}
-	}
+	const uint32_t stat_bits = Net_DeltaStatBits(from, to);
 
 	Net_WriteLong(msg, stat_bits);
 
@@ -353,22 +380,12 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 }
 
 /**
- * @brief Writes an entity's state changes to a net message. Can delta from
- * either a baseline or a previous packet_entity
+ * @return The U_* bits describing the changes from one entity state to another.
  */
-void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
-                          _Bool force) {
+uint16_t Net_DeltaEntityBits(const entity_state_t *from, const entity_state_t *to) {
 
 	uint16_t bits = 0;
 
-	if (to->number <= 0) {
-		Com_Error(ERROR_FATAL, "Unset entity number\n");
-	}
-
-	if (to->number >= MAX_ENTITIES) {
-		Com_Error(ERROR_FATAL, "Entity number >= MAX_ENTITIES\n");
-	}
-
 	if (to->step_offset != from->step_offset) {
 		bits |= U_STEP_OFFSET;
 	}
@@ -430,6 +447,26 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 		bits |= U_BOUNDS;
 	}
 
+	return bits;
+}
+
+/**
+ * @brief Writes an entity's state changes to a net message. Can delta from
+ * either a baseline or a previous packet_entity
+ */
+void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
+                          _Bool force) {
+
+	if (to->number <= 0) {
+		Com_Error(ERROR_FATAL, "Unset entity number\n");
+	}
+
+	if (to->number >= MAX_ENTITIES) {
+		Com_Error(ERROR_FATAL, "Entity number >= MAX_ENTITIES\n");
+	}
+
+	const uint16_t bits = Net_DeltaEntityBits(from, to);
+
 	if (!bits && !force) {
 		return;    // nothing to send
 	}
@@ -507,11 +544,281 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 	}
 }
 
+/**
+ * @brief Writes the low `bits` of `value` to the message's bit stream.
+ */
+void Net_WriteBits(mem_buf_t *msg, uint32_t value, int32_t bits) {
+	Mem_WriteBits(msg, value, bits);
+}
+
+/**
+ * @brief Writes an unsigned integer to the bit stream as groups of `chunk` bits,
+ * each followed by a continuation bit. Small values thus require few bits.
+ */
+void Net_WriteVarUInt(mem_buf_t *msg, uint32_t value, int32_t chunk) {
+
+	while (true) {
+		Mem_WriteBits(msg, value, chunk);
+
+		value = chunk < 32 ? value >> chunk : 0;
+
+		Mem_WriteBits(msg, value != 0, 1);
+
+		if (value == 0) {
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Writes a signed integer to the bit stream using zig-zag encoding, so
+ * that values of small magnitude require few bits.
+ */
+void Net_WriteVarInt(mem_buf_t *msg, int32_t value, int32_t chunk) {
+	Net_WriteVarUInt(msg, ((uint32_t) value << 1) ^ (uint32_t) (value >> 31), chunk);
+}
+
+/**
+ * @brief The fixed point precision of packed positions and scalars, in steps per unit.
+ * @details Positions are quantized over the fixed world extents, MIN_WORLD_COORD to
+ * MAX_WORLD_COORD, and not over the bounds of the loaded map. Every map therefore gets the
+ * same precision: steps of 1/16 unit, a worst case error of 1/32 unit per component, and 17
+ * bits for an absolute component (8192 units * 16). Coordinates beyond the world extents are
+ * clamped to them.
+ */
+#define NET_PACKED_SCALE 16.f
+
+/**
+ * @brief Packed scalars (velocities, offsets) are clamped to this magnitude.
+ */
+#define NET_PACKED_SCALAR_MAX (4.f * MAX_WORLD_DIST)
+
+/**
+ * @return The fixed point quantization of the world coordinate, relative to
+ * MIN_WORLD_COORD. Dequantized values quantize exactly to themselves, so the
+ * sender and receiver agree on deltas.
+ */
+static int32_t Net_QuantizePosition(float f) {
+	return (int32_t) lroundf((Clampf(f, MIN_WORLD_COORD, MAX_WORLD_COORD) - MIN_WORLD_COORD) * NET_PACKED_SCALE);
+}
+
+/**
+ * @return The world coordinate for the fixed point quantization.
+ */
+static float Net_DequantizePosition(int32_t q) {
+	return q / NET_PACKED_SCALE + MIN_WORLD_COORD;
+}
+
+/**
+ * @return The fixed point quantization of the scalar.
+ */
+static int32_t Net_QuantizeScalar(float f) {
+	return (int32_t) lroundf(Clampf(f, -NET_PACKED_SCALAR_MAX, NET_PACKED_SCALAR_MAX) * NET_PACKED_SCALE);
+}
+
+/**
+ * @return The scalar for the fixed point quantization.
+ */
+static float Net_DequantizeScalar(int32_t q) {
+	return q / NET_PACKED_SCALE;
+}
+
+/**
+ * @brief Writes a world position as a quantized delta against `from`.
+ */
+static void Net_WritePackedPosition(mem_buf_t *msg, const vec3_t from, const vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		Net_WriteVarInt(msg, Net_QuantizePosition(to.xyz[i]) - Net_QuantizePosition(from.xyz[i]), 5);
+	}
+}
+
+/**
+ * @brief Writes a vector of scalars as a quantized delta against `from`.
+ */
+static void Net_WritePackedScalars(mem_buf_t *msg, const vec3_t from, const vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		Net_WriteVarInt(msg, Net_QuantizeScalar(to.xyz[i]) - Net_QuantizeScalar(from.xyz[i]), 5);
+	}
+}
+
+/**
+ * @brief Writes angles with the same precision as Net_WriteAngles, omitting
+ * zero components, which are common for pitch and roll.
+ */
+static void Net_WritePackedAngles(mem_buf_t *msg, const vec3_t angles) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		const uint16_t a = (uint16_t) Net_AngleToShort(angles.xyz[i]);
+
+		Mem_WriteBits(msg, a != 0, 1);
+
+		if (a) {
+			Mem_WriteBits(msg, a, 16);
+		}
+	}
+}
+
+/**
+ * @brief Writes a player state delta to the message's bit stream. This is the
+ * packed equivalent of Net_WriteDeltaPlayerState.
+ */
+void Net_WritePackedDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to) {
+
+	const uint16_t bits = Net_DeltaPlayerStateBits(from, to);
+
+	Net_WriteVarUInt(msg, bits, 4);
+
+	if (bits & PS_PM_TYPE) {
+		Net_WriteVarUInt(msg, to->pm_state.type, 3);
+	}
+
+	if (bits & PS_PM_ORIGIN) {
+		Net_WritePackedPosition(msg, from->pm_state.origin, to->pm_state.origin);
+	}
+
+	if (bits & PS_PM_VELOCITY) {
+		Net_WritePackedScalars(msg, from->pm_state.velocity, to->pm_state.velocity);
+	}
+
+	if (bits & PS_PM_FLAGS) {
+		Net_WriteVarUInt(msg, to->pm_state.flags, 4);
+	}
+
+	if (bits & PS_PM_TIME) {
+		Net_WriteVarUInt(msg, to->pm_state.time, 6);
+	}
+
+	if (bits & PS_PM_GRAVITY) {
+		Net_WriteVarInt(msg, to->pm_state.gravity, 6);
+	}
+
+	if (bits & PS_PM_VIEW_OFFSET) {
+		Net_WritePackedScalars(msg, from->pm_state.view_offset, to->pm_state.view_offset);
+	}
+
+	if (bits & PS_PM_VIEW_ANGLES) {
+		Net_WritePackedAngles(msg, to->pm_state.view_angles);
+	}
+
+	if (bits & PS_PM_DELTA_ANGLES) {
+		Net_WritePackedAngles(msg, to->pm_state.delta_angles);
+	}
+
+	if (bits & PS_PM_HOOK_POSITION) {
+		Net_WritePackedPosition(msg, from->pm_state.hook_position, to->pm_state.hook_position);
+	}
+
+	if (bits & PS_PM_HOOK_LENGTH) {
+		Net_WriteVarUInt(msg, to->pm_state.hook_length, 6);
+	}
+
+	if (bits & PS_PM_STEP_OFFSET) {
+		Net_WriteVarInt(msg, Net_QuantizeScalar(to->pm_state.step_offset), 5);
+	}
+
+	const uint32_t stat_bits = Net_DeltaStatBits(from, to);
+
+	Net_WriteVarUInt(msg, stat_bits, 8);
+
+	for (int32_t i = 0; i < MAX_STATS; i++) {
+		if (stat_bits & (1u << i)) {
+			Net_WriteVarInt(msg, to->stats[i], 6);
+		}
+	}
+}
+
+/**
+ * @brief Writes the U_* bits and the changed fields of an entity to the
+ * message's bit stream. Unlike Net_WriteDeltaEntity, the entity number is not
+ * written, as packed frames encode entity numbers relative to one another.
+ */
+void Net_WritePackedDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
+                                uint16_t bits) {
+
+	Net_WriteVarUInt(msg, bits, 5);
+
+	if (bits & U_STEP_OFFSET) {
+		Mem_WriteBits(msg, (uint8_t) to->step_offset, 8);
+	}
+
+	if (bits & U_SPAWNID) {
+		Mem_WriteBits(msg, to->spawn_id, 8);
+	}
+
+	if (bits & U_ORIGIN) {
+		Net_WritePackedPosition(msg, from->origin, to->origin);
+	}
+
+	if (bits & U_TERMINATION) {
+		Net_WritePackedPosition(msg, from->termination, to->termination);
+	}
+
+	if (bits & U_ANGLES) {
+		Net_WritePackedAngles(msg, to->angles);
+	}
+
+	if (bits & U_ANIMATIONS) {
+		Mem_WriteBits(msg, to->animation1, 8);
+		Mem_WriteBits(msg, to->animation2, 8);
+	}
+
+	if (bits & U_EVENT) {
+		Mem_WriteBits(msg, to->event, 8);
+	}
+
+	if (bits & U_EFFECTS) {
+		Net_WriteVarUInt(msg, to->effects, 4);
+	}
+
+	if (bits & U_TRAIL) {
+		Mem_WriteBits(msg, to->trail, 8);
+	}
+
+	if (bits & U_MODELS) {
+		Mem_WriteBits(msg, to->model1, 8);
+		Mem_WriteBits(msg, to->model2, 8);
+		Mem_WriteBits(msg, to->model3, 8);
+		Mem_WriteBits(msg, to->model4, 8);
+	}
+
+	if (bits & U_COLOR) {
+		Mem_WriteBits(msg, to->color.rgba, 32);
+	}
+
+	if (bits & U_CLIENT) {
+		Mem_WriteBits(msg, to->client, 8);
+	}
+
+	if (bits & U_SOUND) {
+		Mem_WriteBits(msg, to->sound, 8);
+	}
+
+	if (bits & U_SOLID) {
+		Mem_WriteBits(msg, to->solid, 8);
+	}
+
+	if (bits & U_BOUNDS) {
+		const vec3s_t mins = Vec3_CastVec3s(to->bounds.mins);
+		const vec3s_t maxs = Vec3_CastVec3s(to->bounds.maxs);
+
+		for (int32_t i = 0; i < 3; i++) {
+			Net_WriteVarInt(msg, mins.xyz[i], 5);
+		}
+
+		for (int32_t i = 0; i < 3; i++) {
+			Net_WriteVarInt(msg, maxs.xyz[i], 5);
+		}
+	}
+}
+
 /**
  * @brief
  */
 void Net_BeginReading(mem_buf_t *msg) {
 	msg->read = 0;
+	msg->read_bits = 0;
 }
 
 /**
@@ -797,10 +1104,10 @@ void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player
 		to->pm_state.step_offset = Net_ReadFloat(msg);
 	}
 
-	const int32_t stat_bits = Net_ReadLong(msg);
+	const uint32_t stat_bits = (uint32_t) Net_ReadLong(msg);
 
 	for (int32_t i = 0; i < MAX_STATS; i++) {
-		if (stat_bits & (1 << i)) {
+		if (stat_bits & (1u << i)) {
 			to->stats[i] = Net_ReadShort(msg);
 		}
 	}
@@ -885,3 +1192,237 @@ void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_stat
 		to->bounds = Net_ReadBounds(msg);
 	}
 }
+
+/**
+ * @brief Reads `bits` from the message's bit stream.
+ */
+uint32_t Net_ReadBits(mem_buf_t *msg, int32_t bits) {
+	return Mem_ReadBits(msg, bits);
+}
+
+/**
+ * @brief Reads an unsigned integer written with Net_WriteVarUInt.
+ */
+uint32_t Net_ReadVarUInt(mem_buf_t *msg, int32_t chunk) {
+	uint32_t value = 0;
+
+	for (int32_t shift = 0; shift < 32; shift += chunk) {
+		value |= Mem_ReadBits(msg, chunk) << shift;
+
+		if (!Mem_ReadBits(msg, 1)) {
+			break;
+		}
+	}
+
+	return value;
+}
+
+/**
+ * @brief Reads a signed integer written with Net_WriteVarInt.
+ */
+int32_t Net_ReadVarInt(mem_buf_t *msg, int32_t chunk) {
+
+	const uint32_t value = Net_ReadVarUInt(msg, chunk);
+
+	return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+}
+
+/**
+ * @brief Reads a world position written with Net_WritePackedPosition.
+ */
+static vec3_t Net_ReadPackedPosition(mem_buf_t *msg, const vec3_t from) {
+	vec3_t to;
+
+	for (int32_t i = 0; i < 3; i++) {
+		to.xyz[i] = Net_DequantizePosition(Net_QuantizePosition(from.xyz[i]) + Net_ReadVarInt(msg, 5));
+	}
+
+	return to;
+}
+
+/**
+ * @brief Reads a vector of scalars written with Net_WritePackedScalars.
+ */
+static vec3_t Net_ReadPackedScalars(mem_buf_t *msg, const vec3_t from) {
+	vec3_t to;
+
+	for (int32_t i = 0; i < 3; i++) {
+		to.xyz[i] = Net_DequantizeScalar(Net_QuantizeScalar(from.xyz[i]) + Net_ReadVarInt(msg, 5));
+	}
+
+	return to;
+}
+
+/**
+ * @brief Reads angles written with Net_WritePackedAngles.
+ */
+static vec3_t Net_ReadPackedAngles(mem_buf_t *msg) {
+	vec3_t angles;
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (Mem_ReadBits(msg, 1)) {
+			angles.xyz[i] = (int16_t) Mem_ReadBits(msg, 16) * 360.f / UINT16_MAX;
+		} else {
+			angles.xyz[i] = 0.f;
+		}
+	}
+
+	return angles;
+}
+
+/**
+ * @brief Reads a player state delta written with Net_WritePackedDeltaPlayerState.
+ */
+void Net_ReadPackedDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to) {
+
+	*to = *from;
+
+	const uint32_t bits = Net_ReadVarUInt(msg, 4);
+
+	if (bits & PS_PM_TYPE) {
+		to->pm_state.type = Net_ReadVarUInt(msg, 3);
+	}
+
+	if (bits & PS_PM_ORIGIN) {
+		to->pm_state.origin = Net_ReadPackedPosition(msg, from->pm_state.origin);
+	}
+
+	if (bits & PS_PM_VELOCITY) {
+		to->pm_state.velocity = Net_ReadPackedScalars(msg, from->pm_state.velocity);
+	}
+
+	if (bits & PS_PM_FLAGS) {
+		to->pm_state.flags = Net_ReadVarUInt(msg, 4);
+	}
+
+	if (bits & PS_PM_TIME) {
+		to->pm_state.time = Net_ReadVarUInt(msg, 6);
+	}
+
+	if (bits & PS_PM_GRAVITY) {
+		to->pm_state.gravity = Net_ReadVarInt(msg, 6);
+	}
+
+	if (bits & PS_PM_VIEW_OFFSET) {
+		to->pm_state.view_offset = Net_ReadPackedScalars(msg, from->pm_state.view_offset);
+	}
+
+	if (bits & PS_PM_VIEW_ANGLES) {
+		to->pm_state.view_angles = Net_ReadPackedAngles(msg);
+	}
+
+	if (bits & PS_PM_DELTA_ANGLES) {
+		to->pm_state.delta_angles = Net_ReadPackedAngles(msg);
+	}
+
+	if (bits & PS_PM_HOOK_POSITION) {
+		to->pm_state.hook_position = Net_ReadPackedPosition(msg, from->pm_state.hook_position);
+	}
+
+	if (bits & PS_PM_HOOK_LENGTH) {
+		to->pm_state.hook_length = Net_ReadVarUInt(msg, 6);
+	}
+
+	if (bits & PS_PM_STEP_OFFSET) {
+		to->pm_state.step_offset = Net_DequantizeScalar(Net_ReadVarInt(msg, 5));
+	}
+
+	const uint32_t stat_bits = Net_ReadVarUInt(msg, 8);
+
+	for (int32_t i = 0; i < MAX_STATS; i++) {
+		if (stat_bits & (1u << i)) {
+			to->stats[i] = Net_ReadVarInt(msg, 6);
+		}
+	}
+}
+
+/**
+ * @brief Reads the U_* bits of a packed entity delta.
+ */
+uint16_t Net_ReadPackedEntityBits(mem_buf_t *msg) {
+	return (uint16_t) Net_ReadVarUInt(msg, 5);
+}
+
+/**
+ * @brief Reads the fields of an entity delta written with Net_WritePackedDeltaEntity,
+ * after its bits have been read with Net_ReadPackedEntityBits.
+ */
+void Net_ReadPackedDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
+                               uint16_t number, uint16_t bits) {
+
+	*to = *from;
+
+	to->number = number;
+
+	if (bits & U_STEP_OFFSET) {
+		to->step_offset = (int8_t) Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_SPAWNID) {
+		to->spawn_id = Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_ORIGIN) {
+		to->origin = Net_ReadPackedPosition(msg, from->origin);
+	}
+
+	if (bits & U_TERMINATION) {
+		to->termination = Net_ReadPackedPosition(msg, from->termination);
+	}
+
+	if (bits & U_ANGLES) {
+		to->angles = Net_ReadPackedAngles(msg);
+	}
+
+	if (bits & U_ANIMATIONS) {
+		to->animation1 = Mem_ReadBits(msg, 8);
+		to->animation2 = Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_EVENT) {
+		to->event = Mem_ReadBits(msg, 8);
+	} else {
+		to->event = 0;
+	}
+
+	if (bits & U_EFFECTS) {
+		to->effects = Net_ReadVarUInt(msg, 4);
+	}
+
+	if (bits & U_TRAIL) {
+		to->trail = Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_MODELS) {
+		to->model1 = Mem_ReadBits(msg, 8);
+		to->model2 = Mem_ReadBits(msg, 8);
+		to->model3 = Mem_ReadBits(msg, 8);
+		to->model4 = Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_COLOR) {
+		to->color.rgba = Mem_ReadBits(msg, 32);
+	}
+
+	if (bits & U_CLIENT) {
+		to->client = Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_SOUND) {
+		to->sound = Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_SOLID) {
+		to->solid = Mem_ReadBits(msg, 8);
+	}
+
+	if (bits & U_BOUNDS) {
+		for (int32_t i = 0; i < 3; i++) {
+			to->bounds.mins.xyz[i] = (int16_t) Net_ReadVarInt(msg, 5);
+		}
+
+		for (int32_t i = 0; i < 3; i++) {
+			to->bounds.maxs.xyz[i] = (int16_t) Net_ReadVarInt(msg, 5);
+		}
+	}
+}
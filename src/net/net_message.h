@@ -79,6 +79,13 @@
 #define S_ENTITY				(1 << 2)
 #define S_PITCH					(1 << 3)
 
+/**
+ * @brief Set in the suppress count byte of SV_CMD_FRAME when the player state
+ * and entities of the frame are bit packed. Packed frames are only sent to
+ * clients that advertise PROTOCOL_PACKED_FRAMES when connecting.
+ */
+#define FRAME_PACKED			(1 << 7)
+
 /**
  * @brief Message writing and reading facilities.
  */
@@ -96,8 +103,16 @@ void Net_WriteDir(mem_buf_t *msg, const vec3_t dir);
 void Net_WriteBounds(mem_buf_t *msg, const box3_t bounds);
 void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t *to);
 void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to);
+uint16_t Net_DeltaEntityBits(const entity_state_t *from, const entity_state_t *to);
 void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to, _Bool force);
 
+void Net_WriteBits(mem_buf_t *msg, uint32_t value, int32_t bits);
+void Net_WriteVarUInt(mem_buf_t *msg, uint32_t value, int32_t chunk);
+void Net_WriteVarInt(mem_buf_t *msg, int32_t value, int32_t chunk);
+void Net_WritePackedDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to);
+void Net_WritePackedDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
+                                uint16_t bits);
+
 void Net_BeginReading(mem_buf_t *msg);
 void Net_ReadData(mem_buf_t *msg, void *data, size_t len);
 int32_t Net_ReadChar(mem_buf_t *msg);
@@ -116,3 +131,11 @@ void Net_ReadDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, pm_cmd_t *to);
 void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to);
 void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
                          uint16_t number, uint16_t bits);
+
+uint32_t Net_ReadBits(mem_buf_t *msg, int32_t bits);
+uint32_t Net_ReadVarUInt(mem_buf_t *msg, int32_t chunk);
+int32_t Net_ReadVarInt(mem_buf_t *msg, int32_t chunk);
+void Net_ReadPackedDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to);
+uint16_t Net_ReadPackedEntityBits(mem_buf_t *msg);
+void Net_ReadPackedDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
+                               uint16_t number, uint16_t bits);
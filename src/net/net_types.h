@@ -94,6 +94,8 @@ typedef struct {
 
 	uint8_t qport; // to differentiate multiple clients behind NAT
 
+	_Bool compress; // compression was negotiated, so packets carry a flags byte
+
 	// sequencing variables
 	uint32_t incoming_sequence;
 	uint32_t incoming_acknowledged;
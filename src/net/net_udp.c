@@ -19,6 +19,10 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE 1 // recvmmsg, sendmmsg
+#endif
+
 #if defined(_WIN32)
 	#include <winsock2.h>
 	#include <ws2tcpip.h>
@@ -26,10 +30,21 @@
 	#include <sys/time.h>
 #endif
 
+#if defined(__linux__)
+	#include <poll.h>
+	#include <sys/socket.h>
+#endif
+
 #include "net_udp.h"
 
 #define MAX_NET_UDP_LOOPS 64
 
+/**
+ * @brief The number of datagrams received or sent per system call, where the platform
+ * provides recvmmsg and sendmmsg.
+ */
+#define MAX_NET_UDP_BATCH 32
+
 typedef struct {
 	byte data[MAX_MSG_SIZE];
 	size_t size;
@@ -41,9 +56,45 @@ typedef struct {
 	int32_t send, recv;
 } net_udp_loop_t;
 
+#if defined(__linux__)
+
+/**
+ * @brief A batch of datagrams, received or sent with a single system call.
+ */
+typedef struct {
+	struct mmsghdr headers[MAX_NET_UDP_BATCH];
+	struct iovec iovecs[MAX_NET_UDP_BATCH];
+	net_sockaddr addrs[MAX_NET_UDP_BATCH];
+	byte data[MAX_NET_UDP_BATCH][MAX_MSG_SIZE];
+
+	/**
+	 * @brief The number of datagrams in the batch, and the next datagram to read.
+	 */
+	int32_t count, index;
+} net_udp_batch_t;
+
+#endif
+
 typedef struct {
 	net_udp_loop_t loops[2];
 	int32_t sockets[2];
+
+#if defined(__linux__)
+	/**
+	 * @brief Datagrams received, but not yet read.
+	 */
+	net_udp_batch_t *recv[2];
+
+	/**
+	 * @brief Datagrams queued between Net_BeginDatagrams and Net_FlushDatagrams.
+	 */
+	net_udp_batch_t *send[2];
+#endif
+
+	/**
+	 * @brief True while datagrams are being queued for the given source.
+	 */
+	_Bool batching[2];
 } net_udp_state_t;
 
 static net_udp_state_t net_udp_state;
@@ -95,6 +146,80 @@ static _Bool Net_ReceiveDatagram_Loop(net_src_t source, net_addr_t *from, mem_bu
 	return true;
 }
 
+#if defined(__linux__)
+
+/**
+ * @brief Fills the receive batch for the given source with as many pending datagrams
+ * as a single call to recvmmsg will yield.
+ * @return The number of datagrams received.
+ */
+static int32_t Net_FillReceiveBatch(net_src_t source) {
+	net_udp_batch_t *batch = net_udp_state.recv[source];
+
+	for (int32_t i = 0; i < MAX_NET_UDP_BATCH; i++) {
+		batch->iovecs[i].iov_base = batch->data[i];
+		batch->iovecs[i].iov_len = sizeof(batch->data[i]);
+
+		batch->headers[i].msg_hdr = (struct msghdr) {
+			.msg_name = &batch->addrs[i],
+			.msg_namelen = sizeof(batch->addrs[i]),
+			.msg_iov = &batch->iovecs[i],
+			.msg_iovlen = 1
+		};
+	}
+
+	batch->index = 0;
+	batch->count = recvmmsg(net_udp_state.sockets[source], batch->headers, MAX_NET_UDP_BATCH, MSG_DONTWAIT, NULL);
+
+	if (batch->count == -1) {
+		batch->count = 0;
+
+		const int32_t err = Net_GetError();
+
+		if (err != EWOULDBLOCK && err != ECONNREFUSED) { // not terribly abnormal
+			Com_Warn("%s\n", Net_GetErrorString());
+		}
+	}
+
+	return batch->count;
+}
+
+/**
+ * @brief Reads the next datagram from the receive batch, refilling it as necessary.
+ * @return True if a datagram was read, false otherwise.
+ */
+static _Bool Net_ReceiveDatagram_Batch(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
+	net_udp_batch_t *batch = net_udp_state.recv[source];
+
+	while (true) {
+
+		if (batch->index == batch->count) {
+			if (!Net_FillReceiveBatch(source)) {
+				return false;
+			}
+		}
+
+		const int32_t i = batch->index++;
+
+		from->addr = batch->addrs[i].sin_addr.s_addr;
+		from->port = batch->addrs[i].sin_port;
+
+		const size_t received = batch->headers[i].msg_len;
+
+		if (received >= buf->max_size || (batch->headers[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+			Com_Warn("Oversized packet from %s\n", Net_NetaddrToString(from));
+			continue;
+		}
+
+		memcpy(buf->data, batch->data[i], received);
+		buf->size = received;
+
+		return true;
+	}
+}
+
+#endif
+
 /**
  * @brief Receive a datagram on the specified socket, populating the from
  * address with the sender.
@@ -116,6 +241,10 @@ _Bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
 		return false;
 	}
 
+#if defined(__linux__)
+	return Net_ReceiveDatagram_Batch(source, from, buf);
+#else
+
 	net_sockaddr addr;
 	socklen_t addr_len = sizeof(addr);
 
@@ -147,6 +276,7 @@ _Bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
 	buf->size = received;
 
 	return true;
+#endif
 }
 
 /**
@@ -165,6 +295,67 @@ static _Bool Net_SendDatagram_Loop(net_src_t source, const void *data, size_t le
 	return true;
 }
 
+#if defined(__linux__)
+
+/**
+ * @brief Sends all queued datagrams for the given source with sendmmsg.
+ */
+static void Net_FlushSendBatch(net_src_t source) {
+	net_udp_batch_t *batch = net_udp_state.send[source];
+
+	while (batch->index < batch->count) {
+
+		const int32_t sent = sendmmsg(net_udp_state.sockets[source],
+		                              batch->headers + batch->index,
+		                              batch->count - batch->index, 0);
+
+		if (sent == -1) {
+			net_addr_t to = {
+				.type = NA_DATAGRAM,
+				.addr = batch->addrs[batch->index].sin_addr.s_addr,
+				.port = batch->addrs[batch->index].sin_port
+			};
+
+			Com_Warn("%s to %s\n", Net_GetErrorString(), Net_NetaddrToString(&to));
+			batch->index++; // skip the offending datagram
+		} else {
+			batch->index += sent;
+		}
+	}
+
+	batch->count = batch->index = 0;
+}
+
+/**
+ * @brief Queues a datagram to the specified address, sending the batch when it is full.
+ */
+static _Bool Net_SendDatagram_Batch(net_src_t source, const net_addr_t *to, const void *data, size_t len) {
+	net_udp_batch_t *batch = net_udp_state.send[source];
+
+	if (batch->count == MAX_NET_UDP_BATCH) {
+		Net_FlushSendBatch(source);
+	}
+
+	const int32_t i = batch->count++;
+
+	Net_NetAddrToSockaddr(to, &batch->addrs[i]);
+	memcpy(batch->data[i], data, len);
+
+	batch->iovecs[i].iov_base = batch->data[i];
+	batch->iovecs[i].iov_len = len;
+
+	batch->headers[i].msg_hdr = (struct msghdr) {
+		.msg_name = &batch->addrs[i],
+		.msg_namelen = sizeof(batch->addrs[i]),
+		.msg_iov = &batch->iovecs[i],
+		.msg_iovlen = 1
+	};
+
+	return true;
+}
+
+#endif
+
 /**
  * @brief Send a datagram to the specified address.
  */
@@ -183,6 +374,12 @@ _Bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data,
 		Com_Error(ERROR_DROP, "Bad address type\n");
 	}
 
+#if defined(__linux__)
+	if (net_udp_state.batching[source]) {
+		return Net_SendDatagram_Batch(source, to, data, len);
+	}
+#endif
+
 	net_sockaddr to_addr;
 	Net_NetAddrToSockaddr(to, &to_addr);
 
@@ -197,22 +394,80 @@ _Bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data,
 }
 
 /**
- * @brief Sleeps for msec or until the server socket is ready.
+ * @brief Begins queueing datagrams sent to remote addresses for the given source, so
+ * that a frame's worth of datagrams may be sent with a single system call. Loopback
+ * datagrams are delivered immediately. On platforms without sendmmsg, datagrams are
+ * sent as they are written.
  */
-void Net_Sleep(uint32_t msec) {
-	struct timeval timeout;
-	fd_set fdset;
+void Net_BeginDatagrams(net_src_t source) {
+
+	assert(!net_udp_state.batching[source]);
+
+	net_udp_state.batching[source] = net_udp_state.sockets[source] != 0;
+}
+
+/**
+ * @brief Sends all datagrams queued since Net_BeginDatagrams.
+ */
+void Net_FlushDatagrams(net_src_t source) {
+
+	if (!net_udp_state.batching[source]) {
+		return;
+	}
 
-	const uint32_t sock = net_udp_state.sockets[NS_UDP_SERVER];
+#if defined(__linux__)
+	Net_FlushSendBatch(source);
+#endif
+
+	net_udp_state.batching[source] = false;
+}
+
+/**
+ * @brief Waits for up to usec microseconds for a datagram to arrive on the socket for
+ * the given source.
+ * @return True if a datagram is ready to be received, false if the timeout elapsed.
+ */
+_Bool Net_WaitDatagram(net_src_t source, uint32_t usec) {
+
+	const int32_t sock = net_udp_state.sockets[source];
 	assert(sock);
 
+#if defined(__linux__)
+	const net_udp_batch_t *batch = net_udp_state.recv[source];
+	if (batch->index < batch->count) {
+		return true;
+	}
+
+	struct pollfd fd = {
+		.fd = sock,
+		.events = POLLIN
+	};
+
+	const struct timespec timeout = {
+		.tv_sec = usec / 1000000,
+		.tv_nsec = (usec % 1000000) * 1000
+	};
+
+	return ppoll(&fd, 1, &timeout, NULL) > 0;
+#else
+	struct timeval timeout;
+	fd_set fdset;
+
 	FD_ZERO(&fdset);
-	FD_SET(sock, &fdset); // server socket
+	FD_SET(sock, &fdset);
+
+	timeout.tv_sec = usec / 1000000;
+	timeout.tv_usec = usec % 1000000;
 
-	timeout.tv_sec = msec / 1000;
-	timeout.tv_usec = (msec % 1000) * 1000;
+	return select(sock + 1, &fdset, NULL, NULL, &timeout) > 0;
+#endif
+}
 
-	select(sock + 1, &fdset, NULL, NULL, &timeout);
+/**
+ * @brief Sleeps for msec or until the server socket is ready.
+ */
+void Net_Sleep(uint32_t msec) {
+	Net_WaitDatagram(NS_UDP_SERVER, msec * 1000);
 }
 
 /**
@@ -242,11 +497,26 @@ void Net_Config(net_src_t source, _Bool up) {
 			const in_port_t port = source == NS_UDP_SERVER ? net_port->integer : 0;
 
 			*sock = Net_Socket(NA_DATAGRAM, iface, port);
+
+#if defined(__linux__)
+			net_udp_state.recv[source] = Mem_Malloc(sizeof(net_udp_batch_t));
+			net_udp_state.send[source] = Mem_Malloc(sizeof(net_udp_batch_t));
+#endif
 		}
 	} else {
 		if (*sock != 0) {
+			Net_FlushDatagrams(source);
+
 			Net_CloseSocket(*sock);
 			*sock = 0;
+
+#if defined(__linux__)
+			Mem_Free(net_udp_state.recv[source]);
+			net_udp_state.recv[source] = NULL;
+
+			Mem_Free(net_udp_state.send[source]);
+			net_udp_state.send[source] = NULL;
+#endif
 		}
 	}
 }
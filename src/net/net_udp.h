@@ -26,5 +26,9 @@
 _Bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf);
 _Bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data, size_t len);
 
+void Net_BeginDatagrams(net_src_t source);
+void Net_FlushDatagrams(net_src_t source);
+
 void Net_Config(net_src_t source, _Bool up);
+_Bool Net_WaitDatagram(net_src_t source, uint32_t usec);
 void Net_Sleep(uint32_t msec);
@@ -27,6 +27,7 @@
 #include "net/net_chan.h"
 
 #include "sv_admin.h"
+#include "sv_bench.h"
 #include "sv_console.h"
 #include "sv_client.h"
 #include "sv_entity.h"
@@ -148,6 +148,54 @@ static void Sv_Demo_f(void) {
 	Sv_InitServer(Cmd_Argv(1), SV_ACTIVE_DEMO);
 }
 
+/**
+ * @brief Seeks demo playback to the specified time, in seconds or minutes:seconds. Times
+ * prefixed with + or - are relative to the current playback time.
+ */
+static void Sv_DemoSeek_f(void) {
+
+	if (Cmd_Argc() != 2) {
+		Com_Print("Usage: %s <[+|-]seconds|minutes:seconds>\n", Cmd_Argv(0));
+		return;
+	}
+
+	if (sv.state != SV_ACTIVE_DEMO) {
+		Com_Print("Not playing a demo\n");
+		return;
+	}
+
+	const char *arg = Cmd_Argv(1);
+
+	int32_t sign = 0;
+	if (*arg == '+' || *arg == '-') {
+		sign = *arg++ == '+' ? 1 : -1;
+	}
+
+	const char *colon = strchr(arg, ':');
+	const float seconds = colon ? atoi(arg) * 60.f + atof(colon + 1) : atof(arg);
+
+	int32_t time;
+	if (sign) {
+		time = sv.demo_time + sign * (int32_t) (seconds * 1000.f);
+	} else {
+		time = sv.demo->start_time + (int32_t) (seconds * 1000.f);
+	}
+
+	const demo_keyframe_t *keyframe = Net_SeekDemo(sv.demo, time);
+	if (keyframe == NULL) {
+		Com_Print("%s is not seekable\n", sv.name);
+		return;
+	}
+
+	sv.demo_time = keyframe->time;
+	sv.demo_seek = true;
+
+	const int32_t position = (keyframe->time - sv.demo->start_time) / 1000;
+	const int32_t duration = Net_DemoDuration(sv.demo) / 1000;
+
+	Com_Print("Seeked to %d:%02d of %d:%02d\n", position / 60, position % 60, duration / 60, duration % 60);
+}
+
 /**
  * @brief Map command autocompletion.
  */
@@ -192,6 +240,47 @@ static void Sv_Kick_f(void) {
 	Sv_KickClient(sv_client, NULL);
 }
 
+/**
+ * @brief qsort comparator for tick jitter samples.
+ */
+static int32_t Sv_TickSampleCmp(const void *a, const void *b) {
+
+	const uint32_t ua = *(const uint32_t *) a;
+	const uint32_t ub = *(const uint32_t *) b;
+
+	return ua < ub ? -1 : ua > ub ? 1 : 0;
+}
+
+/**
+ * @brief Prints the jitter of recent dedicated server ticks.
+ */
+static void Sv_TickStatus(void) {
+
+	const uint32_t count = Mini(svs.tick.num_ticks, SV_TICK_SAMPLES);
+
+	if (count == 0) {
+		return;
+	}
+
+	uint32_t samples[SV_TICK_SAMPLES];
+	memcpy(samples, svs.tick.samples, count * sizeof(uint32_t));
+
+	qsort(samples, count, sizeof(uint32_t), Sv_TickSampleCmp);
+
+	double total = 0.0;
+	for (uint32_t i = 0; i < count; i++) {
+		total += samples[i];
+	}
+
+	Com_Print("tick jitter: mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms over %u ticks, %u resets\n",
+	          total / count / 1000.0,
+	          samples[count / 2] / 1000.0,
+	          samples[count * 99 / 100] / 1000.0,
+	          samples[count - 1] / 1000.0,
+	          count,
+	          svs.tick.num_resets);
+}
+
 /**
  * @brief
  */
@@ -226,6 +315,18 @@ static void Sv_Status_f(void) {
 
 		Com_Print("%s\n", status);
 	}
+
+	const uint64_t hits = atomic_load(&sv.delta_cache_hits);
+	const uint64_t misses = atomic_load(&sv.delta_cache_misses);
+
+	if (hits + misses) {
+		Com_Print("delta cache: %" PRIu64 " hits, %" PRIu64 " misses (%.1f%%)\n",
+		          hits, misses, 100.0 * hits / (hits + misses));
+	}
+
+	if (dedicated->value) {
+		Sv_TickStatus();
+	}
 }
 
 /**
@@ -403,6 +504,8 @@ void Sv_InitAdmin(void) {
 	cmd_t *demo_cmd = Cmd_Add("demo", Sv_Demo_f, CMD_SERVER, "Start playback of the specified demo file");
 	Cmd_SetAutocomplete(demo_cmd, Sv_Demo_Autocomplete_f);
 
+	Cmd_Add("demo_seek", Sv_DemoSeek_f, CMD_SERVER, "Seek demo playback to the specified time");
+
 	cmd_t *map_cmd = Cmd_Add("map", Sv_Map_f, CMD_SERVER, "Start a server for the specified map");
 	Cmd_SetAutocomplete(map_cmd, Sv_Map_Autocomplete_f);
 
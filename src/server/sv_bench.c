@@ -0,0 +1,365 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <stdatomic.h>
+#include <SDL_timer.h>
+
+#include "sv_local.h"
+
+/**
+ * @brief The maximum number of ticks to wait for the bots to spawn before measuring.
+ */
+#define SV_BENCH_WARMUP (QUETOO_TICK_RATE * 10)
+
+/**
+ * @brief The counter names, as reported.
+ */
+static const char *sv_bench_counter_names[SV_BENCH_TOTAL] = {
+	"G_Frame",
+	"Sv_BuildClientFrame",
+	"Sv_WriteClientFrame",
+	"Sv_Trace",
+	"Sv_TraceBatch",
+	"Sv_LinkEntity",
+	"Sv_Frame"
+};
+
+/**
+ * @brief The benchmark state.
+ */
+static struct {
+	/**
+	 * @brief True while the benchmark is running, and subsystems should be timed.
+	 */
+	_Bool active;
+
+	/**
+	 * @brief True once the bots have spawned, and ticks are being sampled.
+	 */
+	_Bool measuring;
+
+	/**
+	 * @brief The number of bots requested.
+	 */
+	int32_t bots;
+
+	/**
+	 * @brief The number of warmup and measured ticks run so far.
+	 */
+	int32_t warmup_ticks, ticks;
+
+	/**
+	 * @brief The nanoseconds spent, and the number of calls made, in the current tick.
+	 * Time spent across threads may well exceed what 32 bits of nanoseconds can hold.
+	 */
+	atomic_uint_fast64_t time[SV_BENCH_TOTAL];
+	SDL_atomic_t calls[SV_BENCH_TOTAL];
+
+	/**
+	 * @brief The microseconds spent in each measured tick, and the total calls made.
+	 */
+	GArray *samples[SV_BENCH_TOTAL];
+	uint64_t total_calls[SV_BENCH_TOTAL];
+
+	/**
+	 * @brief The performance counter frequency, and the value at which measuring began.
+	 */
+	uint64_t frequency, start;
+} sv_bench_state;
+
+/**
+ * @return The current performance counter, or 0 if the benchmark is not running.
+ */
+uint64_t Sv_BenchTime(void) {
+	return sv_bench_state.active ? SDL_GetPerformanceCounter() : 0;
+}
+
+/**
+ * @brief Accumulates the time elapsed since `start`, which was returned by Sv_BenchTime,
+ * to the specified counter. This is safe to call from worker threads.
+ */
+void Sv_BenchCount(sv_bench_counter_t counter, uint64_t start) {
+
+	if (start == 0) {
+		return;
+	}
+
+	const uint64_t nanos = (SDL_GetPerformanceCounter() - start) * 1000000000 / sv_bench_state.frequency;
+
+	atomic_fetch_add_explicit(&sv_bench_state.time[counter], nanos, memory_order_relaxed);
+	SDL_AtomicIncRef(&sv_bench_state.calls[counter]);
+}
+
+/**
+ * @return True if the client is a loopback client that the benchmark attached to a bot.
+ */
+static _Bool Sv_IsBenchClient(const sv_client_t *cl) {
+	return cl->state == SV_CLIENT_ACTIVE &&
+	       cl->net_chan.remote_address.type == NA_LOOP &&
+	       cl->entity->client->ai;
+}
+
+/**
+ * @brief Attaches a loopback client to the bot occupying the specified client slot, so
+ * that frames are built, encoded and transmitted for it as for a connected player.
+ */
+static void Sv_AttachBenchClient(sv_client_t *cl) {
+
+	net_addr_t addr = { .type = NA_LOOP };
+
+	Netchan_Setup(NS_UDP_SERVER, &cl->net_chan, &addr, (byte) (cl - svs.clients));
+
+	Mem_InitBuffer(&cl->datagram.buffer, cl->datagram.data, sizeof(cl->datagram.data));
+	cl->datagram.buffer.allow_overflow = true;
+
+	cl->extensions = PROTOCOL_EXTENSIONS;
+	cl->net_chan.compress = true;
+
+	g_snprintf(cl->name, sizeof(cl->name), "bench%d", (int32_t) (cl - svs.clients));
+
+	cl->last_frame = -1;
+	cl->last_message = quetoo.ticks;
+
+	cl->state = SV_CLIENT_ACTIVE;
+}
+
+/**
+ * @brief Releases the loopback client, leaving its bot in the game.
+ */
+static void Sv_DetachBenchClient(sv_client_t *cl) {
+
+	Mem_ClearBuffer(&cl->net_chan.message);
+	Mem_ClearBuffer(&cl->datagram.buffer);
+
+	if (cl->datagram.messages) {
+		g_list_free_full(cl->datagram.messages, g_free);
+		cl->datagram.messages = NULL;
+	}
+
+	cl->state = SV_CLIENT_FREE;
+}
+
+/**
+ * @brief Begins the benchmark on the loaded map, spawning the requested bots. The AI
+ * and game modules draw on generators seeded with `sv_bench_seed`, so that runs are
+ * comparable.
+ */
+void Sv_InitBench(void) {
+
+	memset(&sv_bench_state, 0, sizeof(sv_bench_state));
+
+	for (int32_t i = 0; i < SV_BENCH_TOTAL; i++) {
+		sv_bench_state.samples[i] = g_array_sized_new(false, false, sizeof(double), sv_bench->integer);
+	}
+
+	sv_bench_state.bots = Clampf(sv_bench_bots->integer, 0, sv_max_clients->integer);
+
+	if (sv_bench_state.bots) {
+		Cmd_ExecuteString(va("g_ai_add %d", sv_bench_state.bots));
+	}
+
+	sv_bench_state.frequency = SDL_GetPerformanceFrequency();
+	sv_bench_state.active = true;
+
+	Com_Print("Benchmarking %d ticks of %s with %d bots, seed %d\n",
+	          sv_bench->integer, sv.name, sv_bench_state.bots, sv_bench_seed->integer);
+}
+
+/**
+ * @brief Samples the previous tick, and prepares the loopback clients for the next one.
+ * @return False when the requested number of ticks have been measured.
+ */
+_Bool Sv_BenchFrame(void) {
+
+	if (sv_bench_state.measuring) {
+
+		for (int32_t i = 0; i < SV_BENCH_TOTAL; i++) {
+			const double micros = atomic_load(&sv_bench_state.time[i]) / 1000.0;
+			g_array_append_val(sv_bench_state.samples[i], micros);
+
+			sv_bench_state.total_calls[i] += SDL_AtomicGet(&sv_bench_state.calls[i]);
+		}
+
+		sv_bench_state.ticks++;
+	} else {
+		sv_bench_state.warmup_ticks++;
+	}
+
+	for (int32_t i = 0; i < SV_BENCH_TOTAL; i++) {
+		atomic_store(&sv_bench_state.time[i], 0);
+		SDL_AtomicSet(&sv_bench_state.calls[i], 0);
+	}
+
+	if (sv_bench_state.ticks == sv_bench->integer) {
+		return false;
+	}
+
+	// attach spawned bots to loopback clients, which acknowledge every frame they are sent
+	int32_t num_clients = 0;
+
+	sv_client_t *cl = svs.clients;
+	for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
+
+		const g_client_t *client = cl->entity->client;
+
+		if (cl->state == SV_CLIENT_FREE) {
+			if (client->ai && client->connected) {
+				Sv_AttachBenchClient(cl);
+				num_clients++;
+			}
+			continue;
+		}
+
+		if (!Sv_IsBenchClient(cl)) {
+			continue;
+		}
+
+		if (!client->connected) {
+			Sv_DetachBenchClient(cl);
+			continue;
+		}
+
+		cl->last_frame = sv.frame_num;
+		cl->last_message = quetoo.ticks;
+
+		num_clients++;
+	}
+
+	if (!sv_bench_state.measuring) {
+
+		if (num_clients < sv_bench_state.bots && sv_bench_state.warmup_ticks < SV_BENCH_WARMUP) {
+			return true;
+		}
+
+		if (num_clients < sv_bench_state.bots) {
+			Com_Warn("Only %d of %d bots spawned\n", num_clients, sv_bench_state.bots);
+		}
+
+		sv_bench_state.measuring = true;
+		sv_bench_state.start = SDL_GetPerformanceCounter();
+	}
+
+	return true;
+}
+
+/**
+ * @brief GCompareFunc for sorting samples.
+ */
+static gint Sv_BenchSampleCmp(gconstpointer a, gconstpointer b) {
+
+	const double da = *(const double *) a;
+	const double db = *(const double *) b;
+
+	return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/**
+ * @return The specified percentile of the sorted samples.
+ */
+static double Sv_BenchPercentile(const GArray *samples, double percentile) {
+
+	if (samples->len == 0) {
+		return 0.0;
+	}
+
+	const guint i = Minf(samples->len * percentile / 100.0, samples->len - 1);
+	return g_array_index(samples, double, i);
+}
+
+/**
+ * @brief Writes the report for the specified counter.
+ */
+static void Sv_BenchWriteCounter(file_t *file, sv_bench_counter_t counter) {
+
+	GArray *samples = sv_bench_state.samples[counter];
+	g_array_sort(samples, Sv_BenchSampleCmp);
+
+	double total = 0.0;
+	for (guint i = 0; i < samples->len; i++) {
+		total += g_array_index(samples, double, i);
+	}
+
+	const double ticks = Maxf(samples->len, 1);
+
+	Fs_Print(file, "\t\t\"%s\": {\n", sv_bench_counter_names[counter]);
+	Fs_Print(file, "\t\t\t\"calls\": %.2f,\n", sv_bench_state.total_calls[counter] / ticks);
+	Fs_Print(file, "\t\t\t\"mean\": %.3f,\n", total / ticks);
+	Fs_Print(file, "\t\t\t\"p50\": %.3f,\n", Sv_BenchPercentile(samples, 50.0));
+	Fs_Print(file, "\t\t\t\"p90\": %.3f,\n", Sv_BenchPercentile(samples, 90.0));
+	Fs_Print(file, "\t\t\t\"p99\": %.3f,\n", Sv_BenchPercentile(samples, 99.0));
+	Fs_Print(file, "\t\t\t\"max\": %.3f\n", Sv_BenchPercentile(samples, 100.0));
+	Fs_Print(file, "\t\t}%s\n", counter < SV_BENCH_TOTAL - 1 ? "," : "");
+}
+
+/**
+ * @brief Ends the benchmark, writing the per tick timings of each counter, in
+ * microseconds, to `sv_bench.json`.
+ */
+void Sv_ShutdownBench(void) {
+
+	if (!sv_bench_state.active) {
+		return;
+	}
+
+	const double elapsed = (SDL_GetPerformanceCounter() - sv_bench_state.start) * 1000.0 / sv_bench_state.frequency;
+
+	int32_t num_clients = 0;
+
+	sv_client_t *cl = svs.clients;
+	for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
+		if (Sv_IsBenchClient(cl)) {
+			Sv_DetachBenchClient(cl);
+			num_clients++;
+		}
+	}
+
+	file_t *file = Fs_OpenWrite("sv_bench.json");
+	if (file) {
+		Fs_Print(file, "{\n");
+		Fs_Print(file, "\t\"map\": \"%s\",\n", sv.name);
+		Fs_Print(file, "\t\"revision\": \"%s\",\n", REVISION);
+		Fs_Print(file, "\t\"seed\": %d,\n", sv_bench_seed->integer);
+		Fs_Print(file, "\t\"threads\": %d,\n", Thread_Count());
+		Fs_Print(file, "\t\"bots\": %d,\n", num_clients);
+		Fs_Print(file, "\t\"ticks\": %d,\n", sv_bench_state.ticks);
+		Fs_Print(file, "\t\"elapsed\": %.3f,\n", elapsed);
+		Fs_Print(file, "\t\"counters\": {\n");
+
+		for (int32_t i = 0; i < SV_BENCH_TOTAL; i++) {
+			Sv_BenchWriteCounter(file, i);
+		}
+
+		Fs_Print(file, "\t}\n");
+		Fs_Print(file, "}\n");
+		Fs_Close(file);
+
+		Com_Print("Benchmarked %d ticks in %.2f ms, wrote %s\n",
+		          sv_bench_state.ticks, elapsed, Fs_RealPath("sv_bench.json"));
+	} else {
+		Com_Warn("Failed to write sv_bench.json\n");
+	}
+
+	for (int32_t i = 0; i < SV_BENCH_TOTAL; i++) {
+		g_array_free(sv_bench_state.samples[i], true);
+	}
+
+	memset(&sv_bench_state, 0, sizeof(sv_bench_state));
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "sv_types.h"
+
+#ifdef __SV_LOCAL_H__
+
+/**
+ * @brief The subsystems timed by the benchmark. Counters accumulate across all threads,
+ * so for work which runs in parallel, they report CPU time rather than wall time.
+ */
+typedef enum {
+	SV_BENCH_GAME,
+	SV_BENCH_BUILD,
+	SV_BENCH_WRITE,
+	SV_BENCH_TRACE,
+	SV_BENCH_TRACE_BATCH,
+	SV_BENCH_LINK,
+	SV_BENCH_FRAME,
+	SV_BENCH_TOTAL
+} sv_bench_counter_t;
+
+uint64_t Sv_BenchTime(void);
+void Sv_BenchCount(sv_bench_counter_t counter, uint64_t start);
+void Sv_InitBench(void);
+_Bool Sv_BenchFrame(void);
+void Sv_ShutdownBench(void);
+
+#endif /* __SV_LOCAL_H__ */
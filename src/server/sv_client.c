@@ -192,6 +192,24 @@ static void Sv_Begin_f(void) {
 	Cbuf_InsertFromDefer();
 }
 
+/**
+ * @brief Closes the specified client's download, if any.
+ */
+void Sv_CloseDownload(sv_client_t *cl) {
+
+	sv_client_download_t *download = &cl->download;
+
+	if (download->file) {
+		Fs_Close(download->file);
+	}
+
+	const uint8_t id = download->id;
+
+	memset(download, 0, sizeof(*download));
+
+	download->id = id;
+}
+
 /**
  * @brief
  */
@@ -201,7 +219,7 @@ static void Sv_NextDownload_f(void) {
 
 	sv_client_download_t *download = &sv_client->download;
 
-	if (!download->buffer) {
+	if (!download->file || download->stream) {
 		return;
 	}
 
@@ -212,10 +230,17 @@ static void Sv_NextDownload_f(void) {
 	Net_WriteByte(&msg, SV_CMD_DOWNLOAD);
 	Net_WriteShort(&msg, len);
 
-	int32_t percent = download->count * 100 / (Clampf(download->size, 1, download->size));
+	int32_t percent = (download->count + len) * 100 / (Clampf(download->size, 1, download->size));
 	Net_WriteByte(&msg, percent);
 
-	Mem_WriteBuffer(&msg, download->buffer + download->count, len);
+	if (Fs_Read(download->file, msg.data + msg.size, 1, len) != len) {
+		Com_Warn("Failed to read download for %s\n", Sv_NetaddrToString(sv_client));
+		Sv_CloseDownload(sv_client);
+		return;
+	}
+
+	msg.size += len;
+
 	Mem_WriteBuffer(&sv_client->net_chan.message, msg.data, msg.size);
 
 	download->count += len;
@@ -223,8 +248,64 @@ static void Sv_NextDownload_f(void) {
 	if (download->count == download->size) {
 		Com_Debug(DEBUG_SERVER, "Finished download to %s\n", Sv_NetaddrToString(sv_client));
 
-		Fs_Free(download->buffer);
-		download->buffer = NULL;
+		Sv_CloseDownload(sv_client);
+	}
+}
+
+/**
+ * @brief Merges an acknowledgement of streamed download fragments into the window. All
+ * fragments before `base` have been received, as have those whose bits are set in `mask`.
+ * Acknowledgements may arrive out of order, or acknowledge fragments that were never sent.
+ */
+void Sv_AckDownload(sv_client_download_t *download, int32_t base, uint64_t mask) {
+
+	base = Maxi(0, Mini(base, download->next));
+
+	// only fragments that have been sent may be acknowledged
+	const int32_t sent = download->next - base;
+	if (sent < 64) {
+		mask &= (1ull << sent) - 1;
+	}
+
+	if (base > download->base) {
+		const int32_t shift = base - download->base;
+		download->acked = shift < 64 ? download->acked >> shift : 0;
+		download->base = base;
+	} else {
+		const int32_t shift = download->base - base;
+		mask = shift < 64 ? mask >> shift : 0;
+	}
+
+	download->acked |= mask;
+
+	// advance past any leading fragments that were acknowledged selectively
+	while (download->acked & 1) {
+		download->acked >>= 1;
+		download->base++;
+	}
+}
+
+/**
+ * @brief Acknowledges receipt of streamed download fragments.
+ */
+static void Sv_DownloadAck_f(void) {
+
+	sv_client_download_t *download = &sv_client->download;
+
+	if (!download->file || !download->stream) {
+		return;
+	}
+
+	if (strtoul(Cmd_Argv(1), NULL, 0) != download->id) {
+		return; // a late acknowledgement of a previous download
+	}
+
+	Sv_AckDownload(download, (int32_t) strtol(Cmd_Argv(2), NULL, 0), g_ascii_strtoull(Cmd_Argv(3), NULL, 0));
+
+	if (download->base >= download->num_fragments) {
+		Com_Debug(DEBUG_SERVER, "Finished download to %s\n", Sv_NetaddrToString(sv_client));
+
+		Sv_CloseDownload(sv_client);
 	}
 }
 
@@ -274,16 +355,12 @@ static void Sv_Download_f(void) {
 
 	sv_client_download_t *download = &sv_client->download;
 
-	if (download->buffer) { // free last download
-		Fs_Free(download->buffer);
-	}
-
-	memset(download, 0, sizeof(*download));
+	Sv_CloseDownload(sv_client); // close last download
 
-	// try to load the file
-	download->size = (int32_t) Fs_Load(filename, (void *) &download->buffer);
+	// try to open the file
+	download->file = Fs_OpenRead(filename);
 
-	if (download->size == -1) {
+	if (!download->file) {
 		Com_Warn("Couldn't download %s to %s\n", filename, Sv_NetaddrToString(sv_client));
 		Net_WriteByte(&sv_client->net_chan.message, SV_CMD_DOWNLOAD);
 		Net_WriteShort(&sv_client->net_chan.message, -1);
@@ -291,6 +368,8 @@ static void Sv_Download_f(void) {
 		return;
 	}
 
+	download->size = (int32_t) Fs_FileLength(download->file);
+
 	if (Cmd_Argc() > 2) {
 		download->count = (int32_t) strtol(Cmd_Argv(2), NULL, 0);
 		if (download->count < 0 || download->count > download->size) {
@@ -300,8 +379,33 @@ static void Sv_Download_f(void) {
 		}
 	}
 
-	Sv_NextDownload_f();
 	Com_Debug(DEBUG_SERVER, "Downloading %s to %s\n", filename, sv_client->name);
+
+	if (sv_client->extensions & PROTOCOL_STREAMED_DOWNLOADS) {
+
+		download->stream = true;
+		download->id++;
+		download->offset = download->count;
+		download->num_fragments = (download->size - download->offset + DOWNLOAD_FRAGMENT_SIZE - 1) / DOWNLOAD_FRAGMENT_SIZE;
+
+		Net_WriteByte(&sv_client->net_chan.message, SV_CMD_DOWNLOAD);
+		Net_WriteShort(&sv_client->net_chan.message, DOWNLOAD_STREAM);
+		Net_WriteByte(&sv_client->net_chan.message, download->id);
+		Net_WriteLong(&sv_client->net_chan.message, download->size);
+		Net_WriteLong(&sv_client->net_chan.message, download->offset);
+
+		// the fragments are sent as bandwidth allows, see Sv_SendClientDownload
+		if (download->num_fragments == 0) {
+			Sv_CloseDownload(sv_client);
+		}
+	} else {
+
+		if (!Fs_Seek(download->file, download->count)) {
+			Com_Warn("Couldn't seek %s for %s\n", filename, Sv_NetaddrToString(sv_client));
+		}
+
+		Sv_NextDownload_f();
+	}
 }
 
 /**
@@ -348,6 +452,7 @@ static sv_user_string_cmd_t sv_user_string_cmds[] = { // mapping command names t
 	{ "disconnect", Sv_Disconnect_f },
 	{ "info", Sv_Info_f },
 	{ "download", Sv_Download_f },
+	{ "download_ack", Sv_DownloadAck_f },
 	{ "next_download", Sv_NextDownload_f },
 	{ NULL, NULL }
 };
@@ -24,5 +24,7 @@
 #include "sv_types.h"
 
 #ifdef __SV_LOCAL_H__
+void Sv_AckDownload(sv_client_download_t *download, int32_t base, uint64_t mask);
+void Sv_CloseDownload(sv_client_t *cl);
 void Sv_ParseClientMessage(sv_client_t *cl);
 #endif /* __SV_LOCAL_H__ */
@@ -21,15 +21,213 @@
 
 #include "sv_local.h"
 
+/**
+ * @return The client's reservation of SV_CLIENT_ENTITY_STATES in svs.entity_states.
+ */
+static entity_state_t *Sv_ClientEntityStates(const sv_client_t *client) {
+	return svs.entity_states + (ptrdiff_t) (client - svs.clients) * SV_CLIENT_ENTITY_STATES;
+}
+
+/**
+ * @brief Entity delta writing state for a single client frame.
+ */
+typedef struct {
+	mem_buf_t *msg;
+	_Bool packed; // the client has negotiated PROTOCOL_PACKED_FRAMES
+	uint16_t number; // the last entity number written to a packed frame
+	int32_t from_frame_num; // the frame being deltaed from, or -1
+	uint64_t hits, misses; // delta cache accounting
+} sv_entity_writer_t;
+
+/**
+ * @brief Writes the entity number, which packed frames encode relative to the
+ * previously written number.
+ */
+static void Sv_WriteEntityNumber(sv_entity_writer_t *writer, uint16_t number) {
+
+	if (writer->packed) {
+		Net_WriteVarUInt(writer->msg, number - writer->number, 4);
+		writer->number = number;
+	} else {
+		Net_WriteShort(writer->msg, number);
+	}
+}
+
+/**
+ * @brief The phases of a delta cache entry's tag.
+ */
+#define SV_DELTA_CLAIMED 1
+#define SV_DELTA_READY 2
+
+/**
+ * @return The delta cache entry tag for the specified phase of the current frame.
+ */
+static int32_t Sv_DeltaTag(int32_t phase) {
+	return (int32_t) ((sv.frame_num << 2) | phase);
+}
+
+/**
+ * @brief Writes a cached delta of the specified entity to the message.
+ */
+static void Sv_WriteCachedDelta(sv_entity_writer_t *writer, uint16_t number, const sv_delta_entity_t *delta) {
+
+	if (delta->size == 0) {
+		return;
+	}
+
+	// packed entity numbers are relative, so they are written apart from the delta
+	if (writer->packed) {
+		Sv_WriteEntityNumber(writer, number);
+
+		size_t i;
+		for (i = 0; i < delta->size / 8u; i++) {
+			Net_WriteBits(writer->msg, delta->data[i], 8);
+		}
+		if (delta->size & 7) {
+			Net_WriteBits(writer->msg, delta->data[i], delta->size & 7);
+		}
+	} else {
+		Mem_WriteBuffer(writer->msg, delta->data, delta->size);
+	}
+}
+
+/**
+ * @return The cached delta matching the specified key in the current frame, or NULL.
+ */
+static const sv_delta_entity_t *Sv_FindCachedDelta(sv_delta_cache_t *cache, const sv_delta_entity_t *key) {
+
+	const int32_t ready = Sv_DeltaTag(SV_DELTA_READY);
+
+	sv_delta_entity_t *entry = cache->entries;
+	for (size_t i = 0; i < lengthof(cache->entries); i++, entry++) {
+
+		if (SDL_AtomicGet(&entry->tag) != ready) {
+			continue;
+		}
+
+		if (entry->from_frame_num == key->from_frame_num &&
+			entry->packed == key->packed &&
+			entry->from_solid == key->from_solid &&
+			entry->to_solid == key->to_solid) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Publishes the delta to the cache, if an entry is yet unused in the current frame.
+ * Should two clients race to publish the same delta, each simply takes its own entry.
+ */
+static void Sv_CacheDelta(sv_delta_cache_t *cache, const sv_delta_entity_t *delta) {
+
+	const int32_t claimed = Sv_DeltaTag(SV_DELTA_CLAIMED);
+
+	sv_delta_entity_t *entry = cache->entries;
+	for (size_t i = 0; i < lengthof(cache->entries); i++, entry++) {
+
+		const int32_t tag = SDL_AtomicGet(&entry->tag);
+
+		if ((tag & ~3) == (claimed & ~3)) {
+			continue;
+		}
+
+		if (!SDL_AtomicCAS(&entry->tag, tag, claimed)) {
+			continue;
+		}
+
+		entry->from_frame_num = delta->from_frame_num;
+		entry->packed = delta->packed;
+		entry->from_solid = delta->from_solid;
+		entry->to_solid = delta->to_solid;
+		entry->size = delta->size;
+
+		memcpy(entry->data, delta->data, sizeof(entry->data));
+
+		// the exchange is a full barrier, so the entry is complete before it is ready
+		SDL_AtomicCAS(&entry->tag, claimed, Sv_DeltaTag(SV_DELTA_READY));
+		return;
+	}
+}
+
+/**
+ * @brief Writes the delta of an entity to the message, through the shared delta cache.
+ * Clients acknowledging the same frame share the same transition for nearly every entity,
+ * and so each transition need only be encoded once per server frame.
+ */
+static void Sv_WriteDeltaEntity(sv_entity_writer_t *writer, const entity_state_t *from,
+                                const entity_state_t *to, _Bool force) {
+
+	sv_delta_cache_t *cache = &svs.delta_cache[to->number];
+
+	// the baseline is only ever forced, and deltas from frames never are
+	sv_delta_entity_t delta = {
+		.from_frame_num = force ? -1 : writer->from_frame_num,
+		.packed = writer->packed,
+		.from_solid = from->solid,
+		.to_solid = to->solid
+	};
+
+	const sv_delta_entity_t *entry = Sv_FindCachedDelta(cache, &delta);
+	if (entry) {
+		Sv_WriteCachedDelta(writer, to->number, entry);
+		writer->hits++;
+		return;
+	}
+
+	writer->misses++;
+
+	mem_buf_t buf;
+	Mem_InitBuffer(&buf, delta.data, sizeof(delta.data));
+	buf.allow_overflow = true;
+
+	uint16_t bits = 0;
+
+	if (writer->packed) {
+		bits = Net_DeltaEntityBits(from, to);
+		if (bits || force) {
+			Net_WritePackedDeltaEntity(&buf, from, to, bits);
+		}
+	} else {
+		Net_WriteDeltaEntity(&buf, from, to, force);
+	}
+
+	// deltas too large to cache are simply written
+	if (buf.overflowed) {
+		if (writer->packed) {
+			Sv_WriteEntityNumber(writer, to->number);
+			Net_WritePackedDeltaEntity(writer->msg, from, to, bits);
+		} else {
+			Net_WriteDeltaEntity(writer->msg, from, to, force);
+		}
+		return;
+	}
+
+	delta.size = (uint16_t) (writer->packed ? buf.size * 8 - (buf.bits ? 8 - buf.bits : 0) : buf.size);
+
+	Sv_WriteCachedDelta(writer, to->number, &delta);
+
+	Sv_CacheDelta(cache, &delta);
+}
+
 /**
  * @brief Writes a delta update of an entity_state_t list to the message.
  */
-static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
+static void Sv_WriteEntities(const sv_client_t *client, int32_t from_frame_num, sv_frame_t *from,
+                             sv_frame_t *to, mem_buf_t *msg) {
+	entity_state_t *entity_states = Sv_ClientEntityStates(client);
 	entity_state_t *old_state = NULL, *new_state = NULL;
 	uint32_t old_index, new_index;
 	uint16_t old_num, new_num;
 	uint16_t from_num_entities;
 
+	sv_entity_writer_t writer = {
+		.msg = msg,
+		.packed = (client->extensions & PROTOCOL_PACKED_FRAMES) != 0,
+		.from_frame_num = from_frame_num
+	};
+
 	if (!from) {
 		from_num_entities = 0;
 	} else {
@@ -42,27 +240,26 @@ static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 		if (new_index >= to->num_entities) {
 			new_num = 0xffff;
 		} else {
-			new_state = &svs.entity_states[(to->entity_state + new_index) % svs.num_entity_states];
+			new_state = &entity_states[(to->entity_state + new_index) % SV_CLIENT_ENTITY_STATES];
 			new_num = new_state->number;
 		}
 
 		if (old_index >= from_num_entities) {
 			old_num = 0xffff;
 		} else {
-			old_state
-			    = &svs.entity_states[(from->entity_state + old_index) % svs.num_entity_states];
+			old_state = &entity_states[(from->entity_state + old_index) % SV_CLIENT_ENTITY_STATES];
 			old_num = old_state->number;
 		}
 
 		if (new_num == old_num) { // delta update from old position
-			Net_WriteDeltaEntity(msg, old_state, new_state, false);
+			Sv_WriteDeltaEntity(&writer, old_state, new_state, false);
 			old_index++;
 			new_index++;
 			continue;
 		}
 
 		if (new_num < old_num) { // this is a new entity, send it from the baseline
-			Net_WriteDeltaEntity(msg, &sv.baselines[new_num], new_state, true);
+			Sv_WriteDeltaEntity(&writer, &sv.baselines[new_num], new_state, true);
 			new_index++;
 			continue;
 		}
@@ -70,32 +267,47 @@ static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 		if (new_num > old_num) { // the old entity isn't present in the new message
 			const int16_t bits = U_REMOVE;
 
-			Net_WriteShort(msg, old_num);
-			Net_WriteShort(msg, bits);
+			Sv_WriteEntityNumber(&writer, old_num);
+
+			if (writer.packed) {
+				Net_WriteVarUInt(msg, bits, 5);
+			} else {
+				Net_WriteShort(msg, bits);
+			}
 
 			old_index++;
 			continue;
 		}
 	}
 
-	Net_WriteShort(msg, 0); // end of entities
+	if (writer.packed) {
+		Net_WriteVarUInt(msg, 0, 4); // end of entities
+	} else {
+		Net_WriteShort(msg, 0); // end of entities
+	}
+
+	atomic_fetch_add_explicit(&sv.delta_cache_hits, writer.hits, memory_order_relaxed);
+	atomic_fetch_add_explicit(&sv.delta_cache_misses, writer.misses, memory_order_relaxed);
 }
 
 /**
  * @brief
  */
-static void Sv_WritePlayerState(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
+static void Sv_WritePlayerState(const sv_client_t *client, sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 	static player_state_t null_state;
 
-	if (from) {
-		Net_WriteDeltaPlayerState(msg, &from->ps, &to->ps);
+	const player_state_t *from_ps = from ? &from->ps : &null_state;
+
+	if (client->extensions & PROTOCOL_PACKED_FRAMES) {
+		Net_WritePackedDeltaPlayerState(msg, from_ps, &to->ps);
 	} else {
-		Net_WriteDeltaPlayerState(msg, &null_state, &to->ps);
+		Net_WriteDeltaPlayerState(msg, from_ps, &to->ps);
 	}
 }
 
 /**
- * @brief
+ * @brief Writes the current frame for the specified client to the message. This
+ * touches only the client's own state, and may be called from a worker thread.
  */
 void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
 	sv_frame_t *frame, *delta_frame;
@@ -112,6 +324,10 @@ void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
 		// client hasn't gotten a good message through in a long time
 		delta_frame = NULL;
 		delta_frame_num = -1;
+	} else if (client->next_entity_state - client->frames[client->last_frame & PACKET_MASK].entity_state > SV_CLIENT_ENTITY_STATES) {
+		// the delta frame's entities have been overwritten in our reservation
+		delta_frame = NULL;
+		delta_frame_num = -1;
 	} else {
 		// we have a valid message to delta from
 		delta_frame = &client->frames[client->last_frame & PACKET_MASK];
@@ -121,19 +337,73 @@ void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
 	Net_WriteByte(msg, SV_CMD_FRAME);
 	Net_WriteLong(msg, sv.frame_num);
 	Net_WriteLong(msg, delta_frame_num); // what we are delta'ing from
-	Net_WriteByte(msg, client->suppress_count); // rate dropped packets
+	if (client->extensions & PROTOCOL_PACKED_FRAMES) {
+		Net_WriteByte(msg, Mini(client->suppress_count, FRAME_PACKED - 1) | FRAME_PACKED);
+	} else {
+		Net_WriteByte(msg, client->suppress_count); // rate dropped packets
+	}
 	client->suppress_count = 0;
 
 	// delta encode the player state
-	Sv_WritePlayerState(delta_frame, frame, msg);
+	Sv_WritePlayerState(client, delta_frame, frame, msg);
 
 	// delta encode the entities
-	Sv_WriteEntities(delta_frame, frame, msg);
+	Sv_WriteEntities(client, delta_frame_num, delta_frame, frame, msg);
+}
+
+/**
+ * @return The visibility cluster of the client's view origin, or -1.
+ */
+int32_t Sv_ClientCluster(const sv_client_t *client) {
+
+	const g_entity_t *cent = client->entity;
+	if (!cent || !cent->client) {
+		return -1;
+	}
+
+	const pm_state_t *pm = &cent->client->ps.pm_state;
+	const vec3_t view = Vec3_Add(pm->origin, pm->view_offset);
+
+	return Cm_LeafCluster(Cm_PointLeafnum(view, 0));
+}
+
+/**
+ * @return True if the entity occupies at least one cluster set in the visibility
+ * vector, false otherwise. A `NULL` vector is considered to see everything.
+ */
+_Bool Sv_EntityVisible(const g_entity_t *ent, const byte *vis) {
+
+	if (vis == NULL) {
+		return true;
+	}
+
+	const sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
+
+	if (sent->num_clusters == -1) {
+		return Cm_HeadnodeVisible(sent->top_node, vis);
+	}
+
+	for (int32_t i = 0; i < sent->num_clusters; i++) {
+		if (Cm_ClusterVisible(vis, sent->clusters[i])) {
+			return true;
+		}
+	}
+
+	// beams are visible if either end point is
+	if (!Vec3_Equal(ent->s.termination, Vec3_Zero())) {
+		const int32_t cluster = Cm_LeafCluster(Cm_PointLeafnum(ent->s.termination, 0));
+		if (cluster != -1 && Cm_ClusterVisible(vis, cluster)) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
 /**
  * @brief Decides which entities are going to be visible to the client, and
- * copies off the player state.
+ * copies off the player state. Entity states are copied into the client's own
+ * reservation, so frames for different clients may be built concurrently.
  */
 void Sv_BuildClientFrame(sv_client_t *client) {
 
@@ -149,9 +419,21 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 	// grab the current player_state_t
 	frame->ps = cent->client->ps;
 
+	// resolve the potentially visible and hearable sets for the client's view
+	const byte *pvs = NULL, *phs = NULL;
+
+	if (!sv_no_vis->integer) {
+		const int32_t cluster = Sv_ClientCluster(client);
+
+		pvs = Cm_ClusterPVS(cluster);
+		phs = Cm_ClusterPHS(cluster);
+	}
+
 	// build up the list of relevant entities
 	frame->num_entities = 0;
-	frame->entity_state = svs.next_entity_state;
+	frame->entity_state = client->next_entity_state;
+
+	entity_state_t *entity_states = Sv_ClientEntityStates(client);
 
 	for (int32_t e = 1; e < svs.game->num_entities; e++) {
 		g_entity_t *ent = ENTITY_FOR_NUM(e);
@@ -166,8 +448,16 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 			continue;
 		}
 
-		// copy it to the circular entity_state_t array
-		entity_state_t *s = &svs.entity_states[svs.next_entity_state % svs.num_entity_states];
+		// ignore entities the client can neither see nor hear, but always send our own
+		if (ent != cent) {
+			const byte *vis = (ent->s.sound || ent->s.event) ? phs : pvs;
+			if (!Sv_EntityVisible(ent, vis)) {
+				continue;
+			}
+		}
+
+		// copy it to the client's circular entity_state_t array
+		entity_state_t *s = &entity_states[client->next_entity_state % SV_CLIENT_ENTITY_STATES];
 		if (ent->s.number != e) {
 			Com_Warn("Fixing entity number: %d -> %d\n", ent->s.number, e);
 			ent->s.number = e;
@@ -179,7 +469,7 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 			s->solid = SOLID_NOT;
 		}
 
-		svs.next_entity_state++;
+		client->next_entity_state++;
 		frame->num_entities++;
 	}
 }
@@ -24,6 +24,8 @@
 #include "sv_types.h"
 
 #ifdef __SV_LOCAL_H__
+int32_t Sv_ClientCluster(const sv_client_t *client);
+_Bool Sv_EntityVisible(const g_entity_t *ent, const byte *vis);
 void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg);
 void Sv_BuildClientFrame(sv_client_t *client);
 #endif /* __SV_LOCAL_H__ */
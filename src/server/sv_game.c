@@ -56,6 +56,13 @@ static void Sv_GameError(const char *func, const char *fmt, ...) {
 	va_end(args);
 }
 
+/**
+ * @brief Profile_Begin is inline, and so must be wrapped for the game module.
+ */
+static uint64_t Sv_ProfileBegin(void) {
+	return Profile_Begin();
+}
+
 /**
  * @brief Also sets mins and maxs for inline bsp models.
  */
@@ -170,23 +177,34 @@ static void Sv_WriteAngles(const vec3_t angles) {
 }
 
 /**
- * @brief
+ * @return The visibility cluster at the specified point, or -1.
+ */
+static int32_t Sv_PointCluster(const vec3_t p) {
+	return Cm_LeafCluster(Cm_PointLeafnum(p, 0));
+}
+
+/**
+ * @return True if the two points are in potentially visible clusters.
  */
 static _Bool Sv_InPVS(const vec3_t p1, const vec3_t p2) {
 
-	// TODO: Traces?
+	if (sv_no_vis->integer) {
+		return true;
+	}
 
-	return true;
+	return Cm_ClusterVisible(Cm_ClusterPVS(Sv_PointCluster(p1)), Sv_PointCluster(p2));
 }
 
 /**
- * @brief
+ * @return True if the two points are in potentially hearable clusters.
  */
 static _Bool Sv_InPHS(const vec3_t p1, const vec3_t p2) {
 
-	// TODO: Distance threshold?
+	if (sv_no_vis->integer) {
+		return true;
+	}
 
-	return true;
+	return Cm_ClusterVisible(Cm_ClusterPHS(Sv_PointCluster(p1)), Sv_PointCluster(p2));
 }
 
 /**
@@ -285,6 +303,9 @@ void Sv_InitGame(void) {
 	import.Warn_ = Com_Warn_;
 	import.Error_ = Sv_GameError;
 
+	import.ProfileBegin = Sv_ProfileBegin;
+	import.ProfileEnd = Profile_End;
+
 	import.Malloc = Mem_TagMalloc;
 	import.LinkMalloc = Mem_LinkMalloc;
 	import.Free = Mem_Free;
@@ -334,6 +355,7 @@ void Sv_InitGame(void) {
 	import.PointContents = Sv_PointContents;
 	import.PointInsideBrush = Cm_PointInsideBrush;
 	import.Trace = Sv_Trace;
+	import.TraceBatch = Sv_TraceBatch;
 	import.Clip = Sv_Clip;
 	import.inPVS = Sv_InPVS;
 	import.inPHS = Sv_InPHS;
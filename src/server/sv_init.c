@@ -138,8 +138,8 @@ static void Sv_ClearState() {
 
 	if (svs.initialized) { // if we were intialized, cleanup
 
-		if (sv.demo_file) {
-			Fs_Close(sv.demo_file);
+		if (sv.demo) {
+			Net_CloseDemo(sv.demo);
 		}
 	}
 
@@ -172,16 +172,20 @@ static void Sv_ShutdownClients(void) {
 
 	for (i = 0, cl = svs.clients; i < sv_max_clients->integer; i++, cl++) {
 
-		if (cl->download.buffer) {
-			Fs_Free(cl->download.buffer);
-		}
+		Sv_CloseDownload(cl);
 	}
 
 	Mem_Free(svs.clients);
 	svs.clients = NULL;
 
+	g_hash_table_destroy(svs.client_addresses);
+	svs.client_addresses = NULL;
+
 	Mem_Free(svs.entity_states);
 	svs.entity_states = NULL;
+
+	Mem_Free(svs.delta_cache);
+	svs.delta_cache = NULL;
 }
 
 /**
@@ -201,13 +205,20 @@ static void Sv_InitEntities(sv_state_t state) {
 
 		// initialize the clients array
 		svs.clients = Mem_TagMalloc(sizeof(sv_client_t) * sv_max_clients->integer, MEM_TAG_SERVER);
+		svs.client_addresses = g_hash_table_new(g_int64_hash, g_int64_equal);
 
 		// and the entity states array
-		svs.num_entity_states = sv_max_clients->integer * PACKET_BACKUP * MAX_PACKET_ENTITIES;
+		svs.num_entity_states = sv_max_clients->integer * SV_CLIENT_ENTITY_STATES;
 		svs.entity_states = Mem_TagMalloc(sizeof(entity_state_t) * svs.num_entity_states, MEM_TAG_SERVER);
 
+		// and the shared entity delta cache
+		svs.delta_cache = Mem_TagMalloc(sizeof(sv_delta_cache_t) * MAX_ENTITIES, MEM_TAG_SERVER);
+
 		Sv_InitGame();
 	}
+
+	// frame numbers restart with each level, and so must the cached deltas
+	memset(svs.delta_cache, 0, sizeof(sv_delta_cache_t) * MAX_ENTITIES);
 	
 	svs.spawn_count++;
 }
@@ -250,10 +261,15 @@ static void Sv_LoadMedia(const char *server, sv_state_t state) {
 
 	if (state == SV_ACTIVE_DEMO) { // loading a demo
 
-		sv.demo_file = Fs_OpenRead(va("demos/%s.demo", sv.name));
+		sv.demo = Net_OpenDemo(va("demos/%s.demo", sv.name));
+		if (!sv.demo) {
+			Com_Error(ERROR_DROP, "Failed to open demo %s\n", sv.name);
+		}
+
+		sv.demo_time = sv.demo->start_time;
 		svs.spawn_count = 0;
 
-		Com_Print("  Loaded demo %s.\n", sv.name);
+		Com_Print("  Loaded demo %s%s.\n", sv.name, sv.demo->legacy ? " (legacy, not seekable)" : "");
 	} else { // loading a map
 		g_snprintf(sv.config_strings[CS_MODELS], MAX_STRING_CHARS, "maps/%s.bsp", sv.name);
 
@@ -28,15 +28,72 @@ sv_server_t sv; // per-level server info
 
 sv_client_t *sv_client; // current client
 
+cvar_t *sv_bench;
+cvar_t *sv_bench_bots;
+cvar_t *sv_bench_seed;
+cvar_t *sv_compression;
 cvar_t *sv_demo_list;
 cvar_t *sv_download_url;
 cvar_t *sv_enforce_time;
 cvar_t *sv_hostname;
 cvar_t *sv_max_clients;
+cvar_t *sv_no_vis;
+cvar_t *sv_packed_frames;
 cvar_t *sv_public;
 cvar_t *sv_rcon_password; // password for remote server commands
+cvar_t *sv_threaded_frames;
+cvar_t *sv_threaded_traces;
 cvar_t *sv_timeout;
 cvar_t *sv_udp_download;
+cvar_t *sv_world_tree;
+
+/**
+ * @return The key of the specified address and qport in svs.client_addresses. The port
+ * is excluded, so that clients behind address translating routers are still found.
+ */
+static uint64_t Sv_ClientAddressKey(const net_addr_t *addr, byte qport) {
+	return ((uint64_t) addr->type << 40) | ((uint64_t) addr->addr << 8) | qport;
+}
+
+/**
+ * @brief Adds the client to svs.client_addresses, so that its packets are dispatched to it.
+ * Any other client with the same key is displaced, and the key is replaced with this
+ * client's own, so that it does not reference the displaced client.
+ */
+static void Sv_LinkClientAddress(sv_client_t *cl) {
+
+	cl->address_key = Sv_ClientAddressKey(&cl->net_chan.remote_address, cl->net_chan.qport);
+
+	g_hash_table_replace(svs.client_addresses, &cl->address_key, cl);
+}
+
+/**
+ * @brief Removes the client from svs.client_addresses, if it is present.
+ */
+static void Sv_UnlinkClientAddress(sv_client_t *cl) {
+
+	if (g_hash_table_lookup(svs.client_addresses, &cl->address_key) == cl) {
+		g_hash_table_remove(svs.client_addresses, &cl->address_key);
+	}
+
+	cl->address_key = 0;
+}
+
+/**
+ * @return The connected client for the specified address and qport, or NULL.
+ */
+static sv_client_t *Sv_ClientForAddress(const net_addr_t *addr, byte qport) {
+
+	const uint64_t key = Sv_ClientAddressKey(addr, qport);
+
+	sv_client_t *cl = g_hash_table_lookup(svs.client_addresses, &key);
+
+	if (cl && cl->state != SV_CLIENT_FREE) {
+		return cl;
+	}
+
+	return NULL;
+}
 
 /**
  * @brief Called when the player is totally leaving the server, either willingly
@@ -63,9 +120,9 @@ void Sv_DropClient(sv_client_t *cl) {
 		Netchan_Transmit(&cl->net_chan, cl->net_chan.message.data, cl->net_chan.message.size);
 	}
 
-	if (cl->download.buffer) {
-		Fs_Free(cl->download.buffer);
-	}
+	Sv_CloseDownload(cl);
+
+	Sv_UnlinkClientAddress(cl);
 
 	ent = cl->entity;
 
@@ -128,7 +185,7 @@ static void Sv_Ack_f(void) {
 static void Sv_Info_f(void) {
 	char string[MAX_MSG_SIZE];
 
-	if (sv.demo_file) {
+	if (sv.demo) {
 		Com_Debug(DEBUG_SERVER, "Demo server ignoring server info request\n");
 		return;
 	}
@@ -224,6 +281,17 @@ static void Sv_Connect_f(void) {
 	// copy user_info, leave room for ip stuffing
 	g_strlcpy(user_info, Cmd_Argv(4), sizeof(user_info) - 25);
 
+	// resolve the protocol extensions the client supports, and that we allow
+	uint32_t extensions = (uint32_t) strtoul(Cmd_Argv(5), NULL, 0) & PROTOCOL_EXTENSIONS;
+
+	if (!sv_packed_frames->integer) {
+		extensions &= ~PROTOCOL_PACKED_FRAMES;
+	}
+
+	if (!sv_compression->integer) {
+		extensions &= ~PROTOCOL_COMPRESSION;
+	}
+
 	if (*user_info == '\0') { // catch empty user_info
 		Com_Print("Empty user_info from %s\n", Net_NetaddrToString(addr));
 		Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "print\nConnection refused\n");
@@ -336,14 +404,25 @@ static void Sv_Connect_f(void) {
 	g_strlcpy(client->user_info, user_info, sizeof(client->user_info));
 	Sv_UserInfoChanged(client);
 
-	// send the connect packet to the client
-	Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "client_connect %s", sv_download_url->string);
+	// send the connect packet to the client, with the extensions enabled for it
+	if (extensions) {
+		Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "client_connect \"%s\" %u", sv_download_url->string, extensions);
+	} else {
+		Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "client_connect %s", sv_download_url->string);
+	}
+
+	Sv_UnlinkClientAddress(client);
 
 	Netchan_Setup(NS_UDP_SERVER, &client->net_chan, addr, qport);
 
+	Sv_LinkClientAddress(client);
+
 	Mem_InitBuffer(&client->datagram.buffer, client->datagram.data, sizeof(client->datagram.data));
 	client->datagram.buffer.allow_overflow = true;
 
+	client->extensions = extensions;
+	client->net_chan.compress = (extensions & PROTOCOL_COMPRESSION) != 0;
+
 	client->last_message = quetoo.ticks;
 
 	client->state = SV_CLIENT_CONNECTED;
@@ -558,34 +637,20 @@ static void Sv_ReadPackets(void) {
 		const byte qport = Net_ReadByte(&net_message) & 0xff;
 
 		// check for packets from connected clients
-		sv_client_t *cl = svs.clients;
-		for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
-
-			if (cl->state == SV_CLIENT_FREE) {
-				continue;
-			}
-
-			if (!Net_CompareClientNetaddr(&net_from, &cl->net_chan.remote_address)) {
-				continue;
-			}
-
-			if (cl->net_chan.qport != qport) {
-				continue;
-			}
-
-			if (cl->net_chan.remote_address.port != net_from.port) {
-				cl->net_chan.remote_address.port = net_from.port;
-				Com_Warn("Fixed translated port for %s\n", Net_NetaddrToString(&net_from));
-			}
+		sv_client_t *cl = Sv_ClientForAddress(&net_from, qport);
+		if (cl == NULL) {
+			continue;
+		}
 
-			// this is a valid, sequenced packet, so process it
-			if (Netchan_Process(&cl->net_chan, &net_message)) {
-				cl->last_message = quetoo.ticks; // nudge timeout
-				Sv_ParseClientMessage(cl);
-			}
+		if (cl->net_chan.remote_address.port != net_from.port) {
+			cl->net_chan.remote_address.port = net_from.port;
+			Com_Warn("Fixed translated port for %s\n", Net_NetaddrToString(&net_from));
+		}
 
-			// we've processed the packet for the correct client, so break
-			break;
+		// this is a valid, sequenced packet, so process it
+		if (Netchan_Process(&cl->net_chan, &net_message)) {
+			cl->last_message = quetoo.ticks; // nudge timeout
+			Sv_ParseClientMessage(cl);
 		}
 	}
 }
@@ -643,7 +708,13 @@ static void Sv_RunGameFrame(void) {
 	sv.time = sv.frame_num * QUETOO_TICK_MILLIS;
 
 	if (sv.state == SV_ACTIVE_GAME) {
+		PROFILE_SCOPE("G_Frame");
+
+		const uint64_t time = Sv_BenchTime();
+
 		svs.game->Frame();
+
+		Sv_BenchCount(SV_BENCH_GAME, time);
 	}
 }
 
@@ -739,33 +810,12 @@ void Sv_UserInfoChanged(sv_client_t *cl) {
 }
 
 /**
- * @brief
+ * @brief Reads and services pending packets, and then runs and sends as many game
+ * frames as fit in the specified interval, leaving the remainder in it.
  */
-void Sv_Frame(const uint32_t msec) {
-	static uint32_t frame_delta;
+static void Sv_RunFrames(uint32_t *frame_delta) {
 
-	// if server is not active, do nothing
-	if (!svs.initialized) {
-		return;
-	}
-
-	if (time_demo->value) { // always run a frame
-		frame_delta = QUETOO_TICK_MILLIS;
-	} else { // keep simulation time in sync with reality
-
-		frame_delta += msec;
-
-		if (frame_delta < QUETOO_TICK_MILLIS) {
-			if (dedicated->value) {
-				SDL_Delay(QUETOO_TICK_MILLIS - frame_delta);
-			}
-
-			return;
-		}
-	}
-
-	// clamp the frame interval to 1 second of simulation
-	frame_delta = Minf(frame_delta, (uint32_t) (QUETOO_TICK_MILLIS * QUETOO_TICK_RATE));
+	PROFILE_SCOPE("Sv_Frame");
 
 	// read any pending packets from clients
 	Sv_ReadPackets();
@@ -783,16 +833,20 @@ void Sv_Frame(const uint32_t msec) {
 	Sv_HeartbeatMasters();
 
 	// let everything in the world think and move
-	while (frame_delta >= QUETOO_TICK_MILLIS) {
+	while (*frame_delta >= QUETOO_TICK_MILLIS) {
 
 		// run the simulation
 		Sv_RunGameFrame();
 
-		// send the resulting frame to connected clients
+		// send the resulting frame to connected clients, in as few system calls as possible
+		Net_BeginDatagrams(NS_UDP_SERVER);
+
 		Sv_SendClientPackets();
 
+		Net_FlushDatagrams(NS_UDP_SERVER);
+
 		// decrement the simulation time
-		frame_delta -= QUETOO_TICK_MILLIS;
+		*frame_delta -= QUETOO_TICK_MILLIS;
 	}
 
 	// clear entity flags, etc for next frame
@@ -802,11 +856,135 @@ void Sv_Frame(const uint32_t msec) {
 	Sv_DrawConsole();
 }
 
+/**
+ * @brief Runs `sv_bench` frames back to back, as with `time_demo`, timing each of them,
+ * and then quits.
+ */
+static void Sv_RunBench(void) {
+
+	Sv_InitBench();
+
+	while (Sv_BenchFrame()) {
+		uint32_t frame_delta = QUETOO_TICK_MILLIS;
+
+		quetoo.ticks = SDL_GetTicks();
+
+		const uint64_t time = Sv_BenchTime();
+
+		Sv_RunFrames(&frame_delta);
+
+		Sv_BenchCount(SV_BENCH_FRAME, time);
+	}
+
+	Sv_ShutdownBench();
+
+	Cvar_SetInteger(sv_bench->name, 0);
+
+	Cbuf_AddText("quit\n");
+}
+
+/**
+ * @brief Dedicated servers wait on the server socket until this close to the tick
+ * deadline, and then spin, as the operating system may oversleep by about as much.
+ */
+#define SV_TICK_SPIN_USEC 250
+
+/**
+ * @brief Waits for the next tick deadline, reading client packets as they arrive.
+ * @return The number of ticks due, which is more than one if the server has fallen behind.
+ */
+static uint32_t Sv_WaitForTick(void) {
+
+	const uint64_t frequency = SDL_GetPerformanceFrequency();
+	const uint64_t interval = frequency * QUETOO_TICK_MILLIS / (1000.0 * time_scale->value);
+
+	uint64_t now = SDL_GetPerformanceCounter();
+
+	if (svs.tick.deadline == 0) {
+		svs.tick.deadline = now + interval;
+	}
+
+	while (now < svs.tick.deadline) {
+
+		const uint64_t usec = (svs.tick.deadline - now) * 1000000 / frequency;
+
+		if (usec > SV_TICK_SPIN_USEC) {
+			if (Net_WaitDatagram(NS_UDP_SERVER, (uint32_t) (usec - SV_TICK_SPIN_USEC))) {
+				quetoo.ticks = SDL_GetTicks();
+				Sv_ReadPackets();
+			}
+		}
+
+		now = SDL_GetPerformanceCounter();
+	}
+
+	quetoo.ticks = SDL_GetTicks();
+
+	const uint64_t lateness = now - svs.tick.deadline;
+
+	svs.tick.samples[svs.tick.num_ticks % SV_TICK_SAMPLES] = (uint32_t) MIN(lateness * 1000000 / frequency, UINT32_MAX);
+	svs.tick.num_ticks++;
+
+	uint32_t ticks = 1 + (uint32_t) (lateness / interval);
+
+	if (ticks > QUETOO_TICK_RATE) { // a second or more behind, so reset the schedule
+		svs.tick.deadline = now + interval;
+		svs.tick.num_resets++;
+	} else {
+		svs.tick.deadline += ticks * interval;
+	}
+
+	return ticks;
+}
+
+/**
+ * @brief
+ */
+void Sv_Frame(const uint32_t msec) {
+	static uint32_t frame_delta;
+
+	// if server is not active, do nothing
+	if (!svs.initialized) {
+		return;
+	}
+
+	if (sv_bench->integer && sv.state == SV_ACTIVE_GAME) {
+		Sv_RunBench();
+		return;
+	}
+
+	if (time_demo->value) { // always run a frame
+		frame_delta = QUETOO_TICK_MILLIS;
+	} else if (dedicated->value) { // sleep until the next tick is due
+		frame_delta += Sv_WaitForTick() * QUETOO_TICK_MILLIS;
+	} else { // keep simulation time in sync with reality
+
+		frame_delta += msec;
+
+		if (frame_delta < QUETOO_TICK_MILLIS) {
+			return;
+		}
+	}
+
+	// clamp the frame interval to 1 second of simulation
+	frame_delta = Minf(frame_delta, (uint32_t) (QUETOO_TICK_MILLIS * QUETOO_TICK_RATE));
+
+	Sv_RunFrames(&frame_delta);
+}
+
 /**
  * @brief
  */
 static void Sv_InitLocal(void) {
 
+	sv_bench = Cvar_Add("sv_bench", "0", CVAR_DEVELOPER,
+	                    "Benchmark this many server frames of the loaded map as fast as possible, and then quit");
+	sv_bench_bots = Cvar_Add("sv_bench_bots", "8", CVAR_DEVELOPER,
+	                         "The number of bots to spawn for sv_bench");
+	sv_bench_seed = Cvar_Add("sv_bench_seed", "1", CVAR_DEVELOPER,
+	                         "The random seed for sv_bench, so that runs are comparable");
+	sv_compression = Cvar_Add("sv_compression", "1", 0,
+	                          "Compress packets to clients that support it");
 	sv_demo_list = Cvar_Add("sv_demo_list", "", CVAR_SERVER_INFO,
 	                        "A list of demo names to cycle through");
 	sv_download_url = Cvar_Add("sv_download_url", "", CVAR_SERVER_INFO,
@@ -817,15 +995,27 @@ static void Sv_InitLocal(void) {
 	                       "The server hostname, visible in the server browser");
 	sv_max_clients = Cvar_Add("sv_max_clients", "8", CVAR_SERVER_INFO | CVAR_LATCH,
 	                          "The maximum number of clients the server will allow");
+	sv_no_vis = Cvar_Add("sv_no_vis", "0", 0,
+	                     "Disable potentially visible set culling, sending all entities and events to all clients");
+	sv_packed_frames = Cvar_Add("sv_packed_frames", "1", 0,
+	                            "Send bit packed, quantized frames to clients that support them");
 	sv_public = Cvar_Add("sv_public", "0", CVAR_SERVER_INFO,
 	                     "Set to 1 to to advertise this server via the master server");
 	sv_rcon_password = Cvar_Add("rcon_password", "", 0,
 	                            "The remote console password. If set, only give this to trusted clients");
+	sv_threaded_frames = Cvar_Add("sv_threaded_frames", "1", 0,
+	                              "Build and encode client frames in parallel on the thread pool");
+	sv_threaded_traces = Cvar_Add("sv_threaded_traces", "1", 0,
+	                              "Run large batches of game traces in parallel on the thread pool");
 	sv_timeout = Cvar_Add("sv_timeout", va("%d", SV_TIMEOUT), 0, NULL);
 	sv_udp_download = Cvar_Add("sv_udp_download", "1", CVAR_ARCHIVE,
 	                           "If set, in-game UDP downloads will be allowed when HTTP downloads fail");
+	sv_world_tree = Cvar_Add("sv_world_tree", "1", CVAR_LATCH,
+	                         "Link entities into a dynamic bounding volume tree, rather than fixed sectors");
 
-	if (dedicated->value) {
+	if (sv_bench->integer) { // seed the game and ai modules before they are loaded
+		g_setenv("QUETOO_RANDOM_SEED", sv_bench_seed->string, true);
+	} else if (dedicated->value) {
 		Cvar_SetInteger(sv_public->name, 1);
 	}
 
@@ -838,7 +1028,7 @@ static void Sv_InitLocal(void) {
  */
 static void Sv_CheckForUpdates(void) {
 
-	if (!dedicated->value) {
+	if (!dedicated->value || sv_bench->integer) {
 		return;
 	}
 
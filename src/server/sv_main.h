@@ -29,15 +29,24 @@ void Sv_Frame(const uint32_t msec);
 
 #ifdef __SV_LOCAL_H__
 // cvars
+extern cvar_t *sv_bench;
+extern cvar_t *sv_bench_bots;
+extern cvar_t *sv_bench_seed;
+extern cvar_t *sv_compression;
 extern cvar_t *sv_demo_list;
 extern cvar_t *sv_download_url;
 extern cvar_t *sv_enforce_time;
 extern cvar_t *sv_hostname;
 extern cvar_t *sv_max_clients;
+extern cvar_t *sv_no_vis;
+extern cvar_t *sv_packed_frames;
 extern cvar_t *sv_public;
 extern cvar_t *sv_rcon_password;
+extern cvar_t *sv_threaded_frames;
+extern cvar_t *sv_threaded_traces;
 extern cvar_t *sv_timeout;
 extern cvar_t *sv_udp_download;
+extern cvar_t *sv_world_tree;
 
 // per-level and static server structures
 extern sv_server_t sv;
@@ -185,6 +185,7 @@ void Sv_Unicast(const g_entity_t *ent, const _Bool reliable) {
 void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter) {
 
 	_Bool reliable = false;
+	const byte *vis = NULL;
 
 	switch (to) {
 		case MULTICAST_ALL_R:
@@ -197,12 +198,14 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 			reliable = true;
 			__attribute__((fallthrough));
 		case MULTICAST_PHS:
+			vis = Cm_ClusterPHS(Cm_LeafCluster(Cm_PointLeafnum(origin, 0)));
 			break;
 
 		case MULTICAST_PVS_R:
 			reliable = true;
 			__attribute__((fallthrough));
 		case MULTICAST_PVS:
+			vis = Cm_ClusterPVS(Cm_LeafCluster(Cm_PointLeafnum(origin, 0)));
 			break;
 
 		default:
@@ -227,8 +230,10 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 			continue;
 		}
 
-		if (to != MULTICAST_ALL && to != MULTICAST_ALL_R) {
-			// TODO: Some basic tracing or just distance attenuation?
+		if (vis && !sv_no_vis->integer) {
+			if (!Cm_ClusterVisible(vis, Sv_ClientCluster(cl))) {
+				continue;
+			}
 		}
 
 		if (filter) { // allow the game module to filter the recipients
@@ -297,51 +302,102 @@ void Sv_PositionedSound(const vec3_t origin, const g_entity_t *ent, uint16_t ind
 }
 
 /**
- * @brief
+ * @brief Builds and delta compresses the current frame for the specified client
+ * into its frame message buffer. This touches only the client's own state, and
+ * so may run on a worker thread.
  */
-static void Sv_SendClientDatagram(sv_client_t *cl) {
-	byte buffer[MAX_MSG_SIZE];
-	mem_buf_t buf;
+static void Sv_EncodeClientFrame(sv_client_t *cl) {
+
+	uint64_t time = Sv_BenchTime();
 
 	Sv_BuildClientFrame(cl);
 
-	Mem_InitBuffer(&buf, buffer, sizeof(buffer));
-	buf.allow_overflow = true;
+	Sv_BenchCount(SV_BENCH_BUILD, time);
 
-	// accumulate the total size for rate throttling
-	size_t frame_size = 0;
+	Mem_InitBuffer(&cl->frame_message, cl->frame_message_data, sizeof(cl->frame_message_data));
+	cl->frame_message.allow_overflow = true;
 
-	// send over all the relevant entity_state_t and the player_state_t
-	Sv_WriteClientFrame(cl, &buf);
+	time = Sv_BenchTime();
+
+	// write all the relevant entity_state_t and the player_state_t
+	Sv_WriteClientFrame(cl, &cl->frame_message);
+
+	Sv_BenchCount(SV_BENCH_WRITE, time);
+}
+
+/**
+ * @brief The clients whose frames are to be encoded this server frame.
+ */
+typedef struct {
+	sv_client_t *clients[MAX_CLIENTS];
+	int32_t num_clients;
+} sv_encode_t;
+
+/**
+ * @brief JobRangeFunc for encoding client frames.
+ */
+static void Sv_EncodeClientFrames_(int32_t begin, int32_t end, void *data) {
+	sv_encode_t *encode = (sv_encode_t *) data;
+
+	for (int32_t i = begin; i < end; i++) {
+		Sv_EncodeClientFrame(encode->clients[i]);
+	}
+}
+
+/**
+ * @brief Encodes the frames for all pending clients, fanning the work out
+ * across the job system when sv_threaded_frames is set.
+ */
+static void Sv_EncodeClientFrames(sv_encode_t *encode) {
+
+	if (sv_threaded_frames->integer) {
+		Job_ParallelFor(encode->num_clients, 1, Sv_EncodeClientFrames_, encode);
+	} else {
+		Sv_EncodeClientFrames_(0, encode->num_clients, encode);
+	}
+}
+
+/**
+ * @brief Transmits the encoded frame and all pending datagram messages for the
+ * specified client. This must be called from the main thread.
+ */
+static void Sv_SendClientDatagram(sv_client_t *cl) {
+
+	mem_buf_t *buf = &cl->frame_message;
 
 	// the frame itself (player state and delta entities) must fit into a single message,
 	// since it is parsed as a single command by the client
-	if (buf.overflowed || buf.size > MAX_MSG_SIZE - 16) {
-		Com_Error(ERROR_DROP, "Frame exceeds MAX_MSG_SIZE (%u)\n", (uint32_t) buf.size);
+	if (buf->overflowed || buf->size > MAX_MSG_SIZE - 16) {
+		Com_Error(ERROR_DROP, "Frame exceeds MAX_MSG_SIZE (%u)\n", (uint32_t) buf->size);
 	}
 
+	// accumulate the total size for rate throttling
+	size_t frame_size = 0;
+
 	// but we can packetize the remaining datagram messages, which are parsed individually
 	const GList *e = cl->datagram.messages;
 	while (e) {
 		const sv_client_message_t *msg = (sv_client_message_t *) e->data;
 
 		// if we would overflow the packet, flush it first
-		if (buf.size + msg->len > (MAX_MSG_SIZE - 16)) {
-			Com_Debug(DEBUG_SERVER, "Fragmenting datagram @ %u bytes\n", (uint32_t) buf.size);
+		if (buf->size + msg->len > (MAX_MSG_SIZE - 16)) {
+			Com_Debug(DEBUG_SERVER, "Fragmenting datagram @ %u bytes\n", (uint32_t) buf->size);
 
-			Netchan_Transmit(&cl->net_chan, buf.data, buf.size);
-			frame_size += buf.size;
+			Netchan_Transmit(&cl->net_chan, buf->data, buf->size);
+			frame_size += buf->size;
 
-			Mem_ClearBuffer(&buf);
+			Mem_ClearBuffer(buf);
 		}
 
-		Mem_WriteBuffer(&buf, cl->datagram.buffer.data + msg->offset, msg->len);
+		Mem_WriteBuffer(buf, cl->datagram.buffer.data + msg->offset, msg->len);
 		e = e->next;
 	}
 
 	// send the pending packet, which may include reliable messages
-	Netchan_Transmit(&cl->net_chan, buf.data, buf.size);
-	frame_size += buf.size;
+	Netchan_Transmit(&cl->net_chan, buf->data, buf->size);
+	frame_size += buf->size;
+
+	Mem_ClearBuffer(buf);
 
 	// record the total size for rate estimation
 	cl->frame_size[sv.frame_num % QUETOO_TICK_RATE] = frame_size;
@@ -389,10 +445,9 @@ static void Sv_DemoCompleted(void) {
 }
 
 /**
- * @brief Returns true if the client is over its current bandwidth estimation
- * and should not be sent another packet.
+ * @brief Returns true if the client is over its current bandwidth estimation.
  */
-static _Bool Sv_RateDrop(sv_client_t *cl) {
+static _Bool Sv_RateExceeded(const sv_client_t *cl) {
 
 	if (sv.frame_num < lengthof(cl->frame_size)) {
 		return false;
@@ -411,7 +466,6 @@ static _Bool Sv_RateDrop(sv_client_t *cl) {
 	for (size_t i = 0; i < lengthof(cl->frame_size); i++) {
 		total += cl->frame_size[(sv.frame_num - i) % lengthof(cl->frame_size)];
 		if (total > cl->rate) {
-			cl->suppress_count++;
 			return true;
 		}
 	}
@@ -420,53 +474,157 @@ static _Bool Sv_RateDrop(sv_client_t *cl) {
 }
 
 /**
- * @brief Reads the next frame from the current demo file into the specified buffer,
- * returning the size of the frame in bytes.
- *
- * FIXME This doesn't work with the new packetized overflow avoidance. Multiple
- * messages can constitute a frame. We need a mechanism to indicate frame
- * completion, or we need a timecode in our demos.
+ * @brief Returns true if the client is over its current bandwidth estimation
+ * and should not be sent another packet.
+ */
+static _Bool Sv_RateDrop(sv_client_t *cl) {
+
+	if (Sv_RateExceeded(cl)) {
+		cl->suppress_count++;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Unacknowledged download fragments are retransmitted after this many milliseconds.
+ */
+#define SV_DOWNLOAD_RETRANSMIT 250
+
+/**
+ * @return The next fragment of the client's streamed download to send, or -1 if the
+ * window is full and no fragment is due for retransmission.
+ */
+int32_t Sv_NextDownloadFragment(sv_client_download_t *download) {
+
+	for (int32_t i = download->base; i < download->next; i++) {
+		if (download->acked & (1ull << (i - download->base))) {
+			continue;
+		}
+
+		if (quetoo.ticks - download->sent_time[i % DOWNLOAD_WINDOW] >= SV_DOWNLOAD_RETRANSMIT) {
+			return i;
+		}
+	}
+
+	if (download->next < download->num_fragments && download->next < download->base + DOWNLOAD_WINDOW) {
+		return download->next++;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Sends as many fragments of the client's streamed download as its window and
+ * bandwidth allow. Each fragment is read from the file as it is sent, and is sent in
+ * its own out-of-band datagram, so that the channel neither sequences nor drops it.
  */
-static size_t Sv_GetDemoMessage(byte *buffer) {
-	int32_t size;
-	int64_t r;
+static void Sv_SendClientDownload(sv_client_t *cl) {
 
-	r = Fs_Read(sv.demo_file, &size, sizeof(size), 1);
+	sv_client_download_t *download = &cl->download;
 
-	if (r != 1) { // improperly terminated demo file
-		Com_Warn("Failed to read demo file\n");
-		Sv_DemoCompleted();
-		return 0;
+	if (!download->file || !download->stream) {
+		return;
 	}
 
-	size = LittleLong(size);
+	while (!Sv_RateExceeded(cl)) {
+
+		const int32_t fragment = Sv_NextDownloadFragment(download);
+		if (fragment == -1) {
+			break;
+		}
+
+		const int32_t offset = download->offset + fragment * DOWNLOAD_FRAGMENT_SIZE;
+		const int32_t len = Mini(download->size - offset, DOWNLOAD_FRAGMENT_SIZE);
+
+		byte data[DOWNLOAD_FRAGMENT_SIZE + 32];
+		mem_buf_t buf;
+
+		Mem_InitBuffer(&buf, data, sizeof(data));
+
+		Net_WriteString(&buf, "download_fragment");
+		Net_WriteByte(&buf, download->id);
+		Net_WriteLong(&buf, fragment);
+		Net_WriteShort(&buf, len);
 
-	if (size == -1) { // properly terminated demo file
-		Sv_DemoCompleted();
-		return 0;
+		if (!Fs_Seek(download->file, offset) || Fs_Read(download->file, buf.data + buf.size, 1, len) != len) {
+			Com_Warn("Failed to read download for %s\n", Sv_NetaddrToString(cl));
+			Sv_CloseDownload(cl);
+			return;
+		}
+
+		buf.size += len;
+
+		Netchan_OutOfBand(NS_UDP_SERVER, &cl->net_chan.remote_address, buf.data, buf.size);
+
+		download->sent_time[fragment % DOWNLOAD_WINDOW] = quetoo.ticks;
+
+		cl->frame_size[sv.frame_num % lengthof(cl->frame_size)] += buf.size;
 	}
+}
 
-	if (size > MAX_MSG_SIZE) { // corrupt demo file
-		Com_Warn("%d > MAX_MSG_SIZE\n", size);
-		Sv_DemoCompleted();
-		return 0;
+/**
+ * @brief Delivers the demo blocks whose time has been reached to all clients, at most one
+ * frame per server frame. Keyframes are skipped, unless playback has seeked to one.
+ */
+static void Sv_SendDemoPackets(void) {
+	int32_t i;
+
+	// wait for a client to connect before starting playback
+	for (i = 0; i < sv_max_clients->integer; i++) {
+		if (svs.clients[i].state != SV_CLIENT_FREE) {
+			break;
+		}
+	}
+
+	if (i == sv_max_clients->integer) {
+		return;
 	}
 
-	r = Fs_Read(sv.demo_file, buffer, size, 1);
+	while (true) {
+		const demo_block_t *block = Net_PeekDemoBlock(sv.demo);
+		if (!block) {
+			Sv_DemoCompleted();
+			return;
+		}
+
+		if ((block->flags & DEMO_BLOCK_KEYFRAME) && !sv.demo_seek) {
+			Net_ConsumeDemoBlock(sv.demo);
+			continue;
+		}
+
+		if (block->time > sv.demo_time) {
+			break;
+		}
 
-	if (r != 1) {
-		Com_Warn("Incomplete or corrupt demo file\n");
-		Sv_DemoCompleted();
-		return 0;
+		sv_client_t *cl = svs.clients;
+		for (i = 0; i < sv_max_clients->integer; i++, cl++) {
+			if (cl->state != SV_CLIENT_FREE) {
+				Netchan_Transmit(&cl->net_chan, (byte *) block->data, block->size);
+			}
+		}
+
+		Net_ConsumeDemoBlock(sv.demo);
+
+		if (block->flags & DEMO_BLOCK_FRAME) {
+			if (block->flags & DEMO_BLOCK_KEYFRAME) {
+				sv.demo_seek = false;
+			}
+			break;
+		}
 	}
 
-	return size;
+	sv.demo_time += QUETOO_TICK_MILLIS;
 }
 
 /**
  * @brief Send the frame and all pending datagram messages since the last frame.
+ * Client frames are built and encoded first, possibly in parallel, and then
+ * transmitted serially.
  */
 void Sv_SendClientPackets(void) {
+	sv_encode_t encode;
 	sv_client_t *cl;
 	int32_t i;
 
@@ -474,7 +632,11 @@ void Sv_SendClientPackets(void) {
 		return;
 	}
 
-	// send a message to each connected client
+	PROFILE_SCOPE("Sv_SendClientPackets");
+
+	encode.num_clients = 0;
+
+	// drop overflowed clients, apply rate throttling and service non-active clients
 	for (i = 0, cl = svs.clients; i < sv_max_clients->integer; i++, cl++) {
 
 		if (cl->state == SV_CLIENT_FREE) { // don't bother
@@ -488,36 +650,57 @@ void Sv_SendClientPackets(void) {
 			continue;
 		}
 
-		if (sv.state == SV_ACTIVE_DEMO) { // send the demo packet
-			byte buffer[MAX_MSG_SIZE];
-			size_t size;
-
-			if ((size = Sv_GetDemoMessage(buffer))) {
-				Netchan_Transmit(&cl->net_chan, buffer, size);
-			} else {
-				break;    // recording is done, so we're done
-			}
-		} else if (cl->state == SV_CLIENT_ACTIVE) { // send the game packet
+		if (sv.state == SV_ACTIVE_DEMO) { // demo packets are sent to all clients below
+			continue;
+		} else if (cl->state == SV_CLIENT_ACTIVE) { // queue the game packet
 
 			if (Sv_RateDrop(cl)) { // enforce rate throttle
 				cl->frame_size[sv.frame_num % lengthof(cl->frame_size)] = 0;
 			} else {
-				Sv_SendClientDatagram(cl);
+				encode.clients[encode.num_clients++] = cl;
 			}
+		} else {
 
-			// clean up for the next frame
-			Mem_ClearBuffer(&cl->datagram.buffer);
+			if (cl->download.stream) { // stream the download, which also carries the reliable
+				cl->frame_size[sv.frame_num % lengthof(cl->frame_size)] = 0;
+				Sv_SendClientDownload(cl);
+			}
 
-			if (cl->datagram.messages) {
-				g_list_free_full(cl->datagram.messages, g_free);
+			if (cl->net_chan.message.size) { // update reliable
+				Netchan_Transmit(&cl->net_chan, NULL, 0);
+			} else if (quetoo.ticks - cl->net_chan.last_sent > 1000) { // or just don't timeout
+				Netchan_Transmit(&cl->net_chan, NULL, 0);
 			}
+		}
+	}
+
+	if (sv.state == SV_ACTIVE_DEMO) {
+		Sv_SendDemoPackets();
+		return;
+	}
+
+	// build and encode the game packets
+	Sv_EncodeClientFrames(&encode);
+
+	// and send them, along with any download fragments that bandwidth allows
+	for (i = 0; i < encode.num_clients; i++) {
+		Sv_SendClientDatagram(encode.clients[i]);
+		Sv_SendClientDownload(encode.clients[i]);
+	}
 
-			cl->datagram.messages = NULL;
+	// clean up for the next frame
+	for (i = 0, cl = svs.clients; i < sv_max_clients->integer; i++, cl++) {
+
+		if (cl->state != SV_CLIENT_ACTIVE) {
+			continue;
+		}
+
+		Mem_ClearBuffer(&cl->datagram.buffer);
 
-		} else if (cl->net_chan.message.size) { // update reliable
-			Netchan_Transmit(&cl->net_chan, NULL, 0);
-		} else if (quetoo.ticks - cl->net_chan.last_sent > 1000) { // or just don't timeout
-			Netchan_Transmit(&cl->net_chan, NULL, 0);
+		if (cl->datagram.messages) {
+			g_list_free_full(cl->datagram.messages, g_free);
 		}
+
+		cl->datagram.messages = NULL;
 	}
 }
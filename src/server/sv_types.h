@@ -21,7 +21,10 @@
 
 #pragma once
 
+#include <stdatomic.h>
+
 #include "common/common.h"
+#include "net/net_demo.h"
 
 #include "ai/ai.h"
 #include "game/game.h"
@@ -54,6 +57,7 @@ typedef struct {
 	int32_t num_clusters; // if -1, use top_node
 
 	struct sv_sector_s *sector;
+	int32_t tree_node; // the world tree leaf, if sv_world_tree is set
 
 	mat4_t matrix;
 	mat4_t inverse_matrix;
@@ -87,22 +91,81 @@ typedef struct {
 	sv_entity_t entities[MAX_ENTITIES]; // the server-local entity structures
 	entity_state_t baselines[MAX_ENTITIES]; // g_entity_t baselines
 
+	// delta cache accounting, see Sv_WriteEntities
+	atomic_uint_fast64_t delta_cache_hits;
+	atomic_uint_fast64_t delta_cache_misses;
+
 	// the multicast buffer is used to send a message to a set of clients
 	// it is flushed each time Sv_Multicast is called
 	mem_buf_t multicast;
 	byte multicast_buffer[MAX_MSG_SIZE];
 
 	// demo server information
-	file_t *demo_file;
+	demo_t *demo;
+
+	/**
+	 * @brief The demo playback time, in milliseconds. Blocks are delivered as their
+	 * time is reached.
+	 */
+	int32_t demo_time;
+
+	/**
+	 * @brief True while delivering the keyframe that playback has seeked to.
+	 */
+	_Bool demo_seek;
 } sv_server_t;
 
 typedef struct {
 	player_state_t ps;
 	uint16_t num_entities;
-	uint32_t entity_state; // index into svs.entity_states array
+	uint32_t entity_state; // index into the client's entity_states reservation
 	uint32_t sent_time; // for ping calculations
 } sv_frame_t;
 
+/**
+ * @brief Each client reserves a private slice of svs.entity_states, so that
+ * client frames may be built and delta compressed concurrently.
+ */
+#define SV_CLIENT_ENTITY_STATES (PACKET_BACKUP * MAX_PACKET_ENTITIES)
+
+/**
+ * @brief The maximum number of distinct transitions cached per entity per frame.
+ */
+#define SV_DELTA_CACHE_ENTRIES 4
+
+/**
+ * @brief The maximum size of a cached entity delta. Larger deltas are not cached.
+ */
+#define SV_DELTA_CACHE_SIZE 128
+
+/**
+ * @brief A delta encoded entity transition in the current server frame, keyed by the
+ * frame it is deltaed from, and shared by all clients deltaing from that frame. Clients'
+ * entity states differ only in `solid`, which is cleared for their own missiles, so that
+ * alone is keyed besides the frame.
+ */
+typedef struct {
+	/**
+	 * @brief The server frame the entry was encoded in, shifted left by 2, and or'ed with
+	 * SV_DELTA_CLAIMED or SV_DELTA_READY. Entries are claimed and published atomically, and
+	 * are immutable once ready, so that they may be shared within the frame without locking.
+	 */
+	SDL_atomic_t tag;
+
+	int32_t from_frame_num; // the frame deltaed from, or -1 for the baseline
+	_Bool packed; // bit packed, see PROTOCOL_PACKED_FRAMES
+	uint8_t from_solid, to_solid;
+	uint16_t size; // in bytes, or in bits if packed, and 0 if nothing is written
+	byte data[SV_DELTA_CACHE_SIZE];
+} sv_delta_entity_t;
+
+/**
+ * @brief The delta cache for a single entity number.
+ */
+typedef struct {
+	sv_delta_entity_t entries[SV_DELTA_CACHE_ENTRIES];
+} sv_delta_cache_t;
+
 /**
  * @brief Clients are dropped after 20 seconds without receiving a packet.
  */
@@ -159,12 +222,26 @@ typedef struct {
 /**
  * @brief Each client my download a single file at a time via the game's UDP
  * protocol. This only serves as a fallback for when HTTP downloading is not
- * configured or unavailable.
+ * configured or unavailable. The file is read as it is sent, rather than loaded.
  */
 typedef struct {
-	byte *buffer;
+	file_t *file;
 	int32_t size;
 	int32_t count;
+
+	/**
+	 * @brief Streamed downloads (PROTOCOL_STREAMED_DOWNLOADS) send a sliding window of
+	 * fragments, starting at the resume offset, and retransmit those which are not
+	 * acknowledged in time.
+	 */
+	_Bool stream;
+	uint8_t id; // identifies the stream in fragments and acknowledgements
+	int32_t offset; // the resume offset, where fragment 0 begins
+	int32_t num_fragments;
+	int32_t base; // the first unacknowledged fragment
+	int32_t next; // the next fragment that has never been sent
+	uint64_t acked; // bit n is set if fragment base + n is acknowledged
+	uint32_t sent_time[DOWNLOAD_WINDOW]; // quetoo.ticks when each fragment was last sent, by fragment % DOWNLOAD_WINDOW
 } sv_client_download_t;
 
 /**
@@ -188,6 +265,8 @@ typedef struct {
 	uint32_t rate;
 	uint32_t suppress_count; // number of messages rate suppressed
 
+	uint32_t extensions; // negotiated PROTOCOL_* extensions
+
 	g_entity_t *entity; // the g_entity_t for this client
 	char name[32]; // extracted from user_info, high bits masked
 	int32_t message_level; // for filtering printed messages
@@ -198,11 +277,19 @@ typedef struct {
 	sv_client_datagram_t datagram;
 
 	sv_frame_t frames[PACKET_BACKUP]; // updates can be delta'd from here
+	uint32_t next_entity_state; // next entity_state to use in this client's reservation
+
+	// the frame (player state and delta entities) is encoded here, possibly
+	// on a worker thread, before being transmitted on the main thread
+	mem_buf_t frame_message;
+	byte frame_message_data[MAX_MSG_SIZE];
 
 	sv_client_download_t download; // UDP file downloads
 
 	uint32_t last_message; // quetoo.ticks when packet was last received
 	net_chan_t net_chan;
+
+	uint64_t address_key; // the key of this client in svs.client_addresses
 } sv_client_t;
 
 /**
@@ -228,6 +315,33 @@ typedef struct {
  */
 #define MAX_CHALLENGES 1024
 
+/**
+ * @brief The number of recent ticks for which the dedicated server keeps jitter samples.
+ */
+#define SV_TICK_SAMPLES 1024
+
+/**
+ * @brief The dedicated server schedules ticks against a high resolution deadline, reading
+ * packets as they arrive in between.
+ */
+typedef struct {
+	/**
+	 * @brief The performance counter value at which the next tick is due.
+	 */
+	uint64_t deadline;
+
+	/**
+	 * @brief The lateness of recent ticks relative to their deadlines, in microseconds.
+	 */
+	uint32_t samples[SV_TICK_SAMPLES];
+
+	/**
+	 * @brief The number of ticks scheduled, and the number of those which were so late
+	 * that the schedule was reset.
+	 */
+	uint32_t num_ticks, num_resets;
+} sv_tick_t;
+
 /**
  * @brief The sv_static_t structure is persistent for the execution of the
  * game. It is only cleared when Sv_Init is called. It is not exposed to the
@@ -240,21 +354,27 @@ typedef struct {
 
 	sv_client_t *clients; // server-side client structures
 
+	GHashTable *client_addresses; // connected clients, by address and qport
+
 	// the server maintains an array of entity states it uses to calculate
 	// delta compression from frame to frame
 
 	// the size of this array is based on the number of clients we might be
 	// asked to support at any point in time during the current game
 
-	uint32_t num_entity_states; // sv_max_clients->integer * UPDATE_BACKUP * MAX_PACKET_ENTITIES
-	uint32_t next_entity_state; // next entity_state to use for newly spawned entities
+	uint32_t num_entity_states; // sv_max_clients->integer * SV_CLIENT_ENTITY_STATES
 	entity_state_t *entity_states; // entity states array used for delta compression
 
+	// entity deltas are encoded once per frame and shared among clients
+	sv_delta_cache_t *delta_cache; // MAX_ENTITIES
+
 	net_addr_t masters[MAX_MASTERS];
 	uint32_t next_heartbeat;
 
 	sv_challenge_t challenges[MAX_CHALLENGES]; // to prevent invalid IPs from connecting
 
+	sv_tick_t tick; // the dedicated server tick scheduler
+
 	/**
 	 * @brief The exported game module API.
 	 */
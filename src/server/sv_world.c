@@ -37,21 +37,55 @@ typedef struct sv_sector_s {
 #define SECTOR_NODES	32
 
 /**
- * @brief The world structure contains all sectors and also the current query
- * context issued to Sv_BoxEntities.
+ * @brief Alternatively, entities are linked into a dynamic bounding volume tree.
+ * Leafs are fattened so that moving entities can be relinked without updating the
+ * tree, and the tree is kept balanced by rotations as leafs are inserted and removed.
+ * Node 0 is reserved, so that zero indicates no node.
+ */
+typedef struct {
+	box3_t bounds;
+	int32_t parent; // the next free node for free nodes
+	int32_t children[2];
+	int32_t height; // 0 for leafs
+	g_entity_t *ent;
+} sv_tree_node_t;
+
+#define TREE_NODES		(MAX_ENTITIES * 2)
+#define TREE_MARGIN		8.f
+#define TREE_STACK		64
+
+/**
+ * @brief The world structure contains all sectors or tree nodes. Queries do not modify
+ * it, so that they may run concurrently, provided no entities are linked meanwhile.
  */
 typedef struct {
 	sv_sector_t sectors[SECTOR_NODES];
 	uint16_t num_sectors;
 
-	box3_t box;
+	_Bool tree; // true if entities are linked into the tree, rather than sectors
 
-	g_entity_t **box_entities;
-	size_t num_box_entities, max_box_entities;
-
-	uint32_t box_type; // BOX_SOLID, BOX_TRIGGER, ..
+	sv_tree_node_t nodes[TREE_NODES];
+	int32_t num_nodes;
+	int32_t free_node;
+	int32_t root;
 } sv_world_t;
 
+/**
+ * @brief A callback for each entity a box query yields.
+ * @return True to continue the query, false to stop it.
+ */
+typedef _Bool (*Sv_BoxEntitiesFunc)(g_entity_t *ent, void *data);
+
+/**
+ * @brief The query context for Sv_BoxEntities_, supplied by the caller.
+ */
+typedef struct {
+	box3_t box;
+	uint32_t type; // BOX_COLLIDE, BOX_OCCUPY, ..
+	Sv_BoxEntitiesFunc func;
+	void *data;
+} sv_box_query_t;
+
 static sv_world_t sv_world;
 
 /**
@@ -100,6 +134,296 @@ void Sv_InitWorld(void) {
 	memset(&sv_world, 0, sizeof(sv_world));
 
 	Sv_CreateSector(0, sv.cm_models[0]->bounds);
+
+	sv_world.tree = sv_world_tree->integer;
+	sv_world.num_nodes = 1;
+}
+
+/**
+ * @return The surface area of the specified bounds, which approximates the cost of
+ * visiting a tree node with those bounds.
+ */
+static float Sv_TreeCost(const box3_t bounds) {
+
+	const vec3_t size = Box3_Size(bounds);
+
+	return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+/**
+ * @return A free tree node.
+ */
+static int32_t Sv_AllocTreeNode(void) {
+
+	int32_t node;
+
+	if (sv_world.free_node) {
+		node = sv_world.free_node;
+		sv_world.free_node = sv_world.nodes[node].parent;
+	} else {
+		if (sv_world.num_nodes == TREE_NODES) {
+			Com_Error(ERROR_DROP, "TREE_NODES\n");
+		}
+		node = sv_world.num_nodes++;
+	}
+
+	memset(&sv_world.nodes[node], 0, sizeof(sv_tree_node_t));
+	return node;
+}
+
+/**
+ * @brief Returns the specified node to the free list.
+ */
+static void Sv_FreeTreeNode(int32_t node) {
+
+	sv_world.nodes[node].parent = sv_world.free_node;
+	sv_world.nodes[node].height = -1;
+	sv_world.nodes[node].ent = NULL;
+
+	sv_world.free_node = node;
+}
+
+/**
+ * @brief Replaces the child of the specified parent, or the root if the parent is 0.
+ */
+static void Sv_ReplaceTreeChild(int32_t parent, int32_t child, int32_t replacement) {
+
+	if (parent) {
+		sv_tree_node_t *p = &sv_world.nodes[parent];
+		if (p->children[0] == child) {
+			p->children[0] = replacement;
+		} else {
+			p->children[1] = replacement;
+		}
+	} else {
+		sv_world.root = replacement;
+	}
+}
+
+/**
+ * @brief Performs a left or right rotation if the specified node is imbalanced.
+ * @return The node that has replaced the specified node in the tree.
+ */
+static int32_t Sv_BalanceTreeNode(int32_t a) {
+
+	sv_tree_node_t *nodes = sv_world.nodes;
+	sv_tree_node_t *A = &nodes[a];
+
+	if (A->height < 2) {
+		return a;
+	}
+
+	const int32_t b = A->children[0];
+	const int32_t c = A->children[1];
+
+	sv_tree_node_t *B = &nodes[b];
+	sv_tree_node_t *C = &nodes[c];
+
+	const int32_t balance = C->height - B->height;
+
+	if (balance > 1) { // rotate C up
+		const int32_t f = C->children[0];
+		const int32_t g = C->children[1];
+
+		sv_tree_node_t *F = &nodes[f];
+		sv_tree_node_t *G = &nodes[g];
+
+		C->children[0] = a;
+		C->parent = A->parent;
+		A->parent = c;
+
+		Sv_ReplaceTreeChild(C->parent, a, c);
+
+		if (F->height > G->height) {
+			C->children[1] = f;
+			A->children[1] = g;
+			G->parent = a;
+			A->bounds = Box3_Union(B->bounds, G->bounds);
+			C->bounds = Box3_Union(A->bounds, F->bounds);
+			A->height = 1 + Maxi(B->height, G->height);
+			C->height = 1 + Maxi(A->height, F->height);
+		} else {
+			C->children[1] = g;
+			A->children[1] = f;
+			F->parent = a;
+			A->bounds = Box3_Union(B->bounds, F->bounds);
+			C->bounds = Box3_Union(A->bounds, G->bounds);
+			A->height = 1 + Maxi(B->height, F->height);
+			C->height = 1 + Maxi(A->height, G->height);
+		}
+
+		return c;
+	}
+
+	if (balance < -1) { // rotate B up
+		const int32_t d = B->children[0];
+		const int32_t e = B->children[1];
+
+		sv_tree_node_t *D = &nodes[d];
+		sv_tree_node_t *E = &nodes[e];
+
+		B->children[0] = a;
+		B->parent = A->parent;
+		A->parent = b;
+
+		Sv_ReplaceTreeChild(B->parent, a, b);
+
+		if (D->height > E->height) {
+			B->children[1] = d;
+			A->children[0] = e;
+			E->parent = a;
+			A->bounds = Box3_Union(C->bounds, E->bounds);
+			B->bounds = Box3_Union(A->bounds, D->bounds);
+			A->height = 1 + Maxi(C->height, E->height);
+			B->height = 1 + Maxi(A->height, D->height);
+		} else {
+			B->children[1] = e;
+			A->children[0] = d;
+			D->parent = a;
+			A->bounds = Box3_Union(C->bounds, D->bounds);
+			B->bounds = Box3_Union(A->bounds, E->bounds);
+			A->height = 1 + Maxi(C->height, D->height);
+			B->height = 1 + Maxi(A->height, E->height);
+		}
+
+		return b;
+	}
+
+	return a;
+}
+
+/**
+ * @brief Balances and refits the ancestors of the specified node.
+ */
+static void Sv_RefitTree(int32_t node) {
+
+	while (node) {
+		node = Sv_BalanceTreeNode(node);
+
+		sv_tree_node_t *n = &sv_world.nodes[node];
+
+		const sv_tree_node_t *c0 = &sv_world.nodes[n->children[0]];
+		const sv_tree_node_t *c1 = &sv_world.nodes[n->children[1]];
+
+		n->height = 1 + Maxi(c0->height, c1->height);
+		n->bounds = Box3_Union(c0->bounds, c1->bounds);
+
+		node = n->parent;
+	}
+}
+
+/**
+ * @brief Inserts the specified leaf, pairing it with the sibling that least increases
+ * the surface area of the tree.
+ */
+static void Sv_InsertTreeLeaf(int32_t leaf) {
+
+	sv_tree_node_t *nodes = sv_world.nodes;
+
+	if (sv_world.root == 0) {
+		sv_world.root = leaf;
+		nodes[leaf].parent = 0;
+		return;
+	}
+
+	const box3_t bounds = nodes[leaf].bounds;
+
+	int32_t sibling = sv_world.root;
+	while (nodes[sibling].height > 0) {
+		const sv_tree_node_t *node = &nodes[sibling];
+
+		const float area = Sv_TreeCost(node->bounds);
+		const float combined = Sv_TreeCost(Box3_Union(node->bounds, bounds));
+
+		// the cost of pairing the leaf with this node
+		const float cost = 2.f * combined;
+
+		// the cost of pushing the leaf further down the tree
+		const float inheritance = 2.f * (combined - area);
+
+		float child_cost[2];
+		for (int32_t i = 0; i < 2; i++) {
+			const sv_tree_node_t *child = &nodes[node->children[i]];
+
+			child_cost[i] = Sv_TreeCost(Box3_Union(child->bounds, bounds)) + inheritance;
+			if (child->height > 0) {
+				child_cost[i] -= Sv_TreeCost(child->bounds);
+			}
+		}
+
+		if (cost < child_cost[0] && cost < child_cost[1]) {
+			break;
+		}
+
+		sibling = child_cost[0] < child_cost[1] ? node->children[0] : node->children[1];
+	}
+
+	const int32_t old_parent = nodes[sibling].parent;
+	const int32_t parent = Sv_AllocTreeNode();
+
+	nodes[parent].parent = old_parent;
+	nodes[parent].bounds = Box3_Union(nodes[sibling].bounds, bounds);
+	nodes[parent].height = nodes[sibling].height + 1;
+	nodes[parent].children[0] = sibling;
+	nodes[parent].children[1] = leaf;
+
+	Sv_ReplaceTreeChild(old_parent, sibling, parent);
+
+	nodes[sibling].parent = parent;
+	nodes[leaf].parent = parent;
+
+	Sv_RefitTree(parent);
+}
+
+/**
+ * @brief Removes the specified leaf from the tree, freeing it.
+ */
+static void Sv_RemoveTreeLeaf(int32_t leaf) {
+
+	sv_tree_node_t *nodes = sv_world.nodes;
+
+	if (leaf == sv_world.root) {
+		sv_world.root = 0;
+	} else {
+		const int32_t parent = nodes[leaf].parent;
+		const int32_t grandparent = nodes[parent].parent;
+
+		const int32_t sibling = nodes[parent].children[0] == leaf ?
+		                        nodes[parent].children[1] : nodes[parent].children[0];
+
+		Sv_ReplaceTreeChild(grandparent, parent, sibling);
+		nodes[sibling].parent = grandparent;
+
+		Sv_FreeTreeNode(parent);
+
+		Sv_RefitTree(grandparent);
+	}
+
+	Sv_FreeTreeNode(leaf);
+}
+
+/**
+ * @brief Links the specified entity into the tree. If the entity remains within its
+ * fattened bounds, the tree is not modified.
+ */
+static void Sv_LinkTreeEntity(g_entity_t *ent, sv_entity_t *sent) {
+
+	if (sent->tree_node) {
+		if (Box3_Contains(sv_world.nodes[sent->tree_node].bounds, ent->abs_bounds)) {
+			return;
+		}
+
+		Sv_RemoveTreeLeaf(sent->tree_node);
+	}
+
+	sent->tree_node = Sv_AllocTreeNode();
+
+	sv_tree_node_t *leaf = &sv_world.nodes[sent->tree_node];
+
+	leaf->bounds = Box3_Expand(ent->abs_bounds, TREE_MARGIN);
+	leaf->ent = ent;
+
+	Sv_InsertTreeLeaf(sent->tree_node);
 }
 
 /**
@@ -114,24 +438,34 @@ void Sv_UnlinkEntity(g_entity_t *ent) {
 		sv_sector_t *sector = (sv_sector_t *) sent->sector;
 		sector->entities = g_list_remove(sector->entities, ent);
 
+		memset(sent, 0, sizeof(*sent));
+	} else if (sent->tree_node) {
+		Sv_RemoveTreeLeaf(sent->tree_node);
+
 		memset(sent, 0, sizeof(*sent));
 	}
 }
 
 /**
- * @brief Called whenever an entity changes origin, mins, maxs, or solid to add it to
- * the clipping hull.
+ * @brief Links the entity into the world, resolving its clusters and clipping matrices.
  */
-void Sv_LinkEntity(g_entity_t *ent) {
+static void Sv_LinkEntity_(g_entity_t *ent) {
 	int32_t leafs[MAX_ENT_LEAFS];
 	int32_t top_node;
 
-	if (ent == svs.game->entities) { // never bother with the world
-		return;
-	}
+	// remove it from its current sector, while the tree refits entities in place
+	if (!sv_world.tree || !ent->in_use) {
+		Sv_UnlinkEntity(ent);
+	} else {
+		sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
 
-	// remove it from its current sector
-	Sv_UnlinkEntity(ent);
+		// but is otherwise reset as the sector does, so that nothing stale survives
+		const int32_t tree_node = sent->tree_node;
+
+		memset(sent, 0, sizeof(*sent));
+
+		sent->tree_node = tree_node;
+	}
 
 	if (!ent->in_use) { // and if its free, we're done
 		return;
@@ -167,7 +501,7 @@ void Sv_LinkEntity(g_entity_t *ent) {
 	sent->num_clusters = 0;
 
 	// get all leafs, including solids
-	const size_t len = Cm_BoxLeafnums(ent->abs_bounds, leafs, lengthof(leafs), &top_node, 0, &matrix);
+	const size_t len = Cm_BoxLeafnums(ent->abs_bounds, leafs, lengthof(leafs), &top_node, 0, NULL);
 
 	if (len == MAX_ENT_LEAFS) { // use top_node
 		sent->num_clusters = -1;
@@ -201,29 +535,37 @@ void Sv_LinkEntity(g_entity_t *ent) {
 	}
 
 	if (ent->solid == SOLID_NOT) {
+		if (sent->tree_node) {
+			Sv_RemoveTreeLeaf(sent->tree_node);
+			sent->tree_node = 0;
+		}
 		return;
 	}
 
-	// find the first sector that the ent's box crosses
-	sv_sector_t *sector = sv_world.sectors;
-	while (true) {
+	if (sv_world.tree) {
+		Sv_LinkTreeEntity(ent, sent);
+	} else {
+		// find the first sector that the ent's box crosses
+		sv_sector_t *sector = sv_world.sectors;
+		while (true) {
 
-		if (sector->axis == -1) {
-			break;
-		}
+			if (sector->axis == -1) {
+				break;
+			}
 
-		if (ent->abs_bounds.mins.xyz[sector->axis] > sector->dist) {
-			sector = sector->children[0];
-		} else if (ent->abs_bounds.maxs.xyz[sector->axis] < sector->dist) {
-			sector = sector->children[1];
-		} else {
-			break;    // crosses the node
+			if (ent->abs_bounds.mins.xyz[sector->axis] > sector->dist) {
+				sector = sector->children[0];
+			} else if (ent->abs_bounds.maxs.xyz[sector->axis] < sector->dist) {
+				sector = sector->children[1];
+			} else {
+				break;    // crosses the node
+			}
 		}
-	}
 
-	// add it to the sector
-	sent->sector = sector;
-	sector->entities = g_list_prepend(sector->entities, ent);
+		// add it to the sector
+		sent->sector = sector;
+		sector->entities = g_list_prepend(sector->entities, ent);
+	}
 
 	// and update its clipping matrices
 	sent->matrix = matrix;
@@ -231,14 +573,31 @@ void Sv_LinkEntity(g_entity_t *ent) {
 }
 
 /**
- * @return True if the entity matches the current world filter, false otherwise.
+ * @brief Called whenever an entity changes origin, mins, maxs, or solid to add it to
+ * the clipping hull.
  */
-static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
+void Sv_LinkEntity(g_entity_t *ent) {
+
+	if (ent == svs.game->entities) { // never bother with the world
+		return;
+	}
+
+	const uint64_t time = Sv_BenchTime();
+
+	Sv_LinkEntity_(ent);
+
+	Sv_BenchCount(SV_BENCH_LINK, time);
+}
+
+/**
+ * @return True if the entity matches the query filter, false otherwise.
+ */
+static _Bool Sv_BoxEntities_Filter(const sv_box_query_t *query, const g_entity_t *ent) {
 
 	switch (ent->solid) {
 		case SOLID_TRIGGER:
 		case SOLID_PROJECTILE:
-			if (sv_world.box_type & BOX_OCCUPY) {
+			if (query->type & BOX_OCCUPY) {
 				return true;
 			}
 			break;
@@ -246,7 +605,7 @@ static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 		case SOLID_DEAD:
 		case SOLID_BOX:
 		case SOLID_BSP:
-			if (sv_world.box_type & BOX_COLLIDE) {
+			if (query->type & BOX_COLLIDE) {
 				return true;
 			}
 			break;
@@ -259,45 +618,128 @@ static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 }
 
 /**
- * @brief
+ * @brief Yields the specified entity to the query, if it matches.
+ * @return True to continue the query, false to stop it.
  */
-static void Sv_BoxEntities_r(sv_sector_t *sector) {
+static _Bool Sv_BoxEntities_Yield(const sv_box_query_t *query, g_entity_t *ent) {
 
-	GList *e = sector->entities;
-	while (e) {
-		g_entity_t *ent = (g_entity_t *) e->data;
+	if (Sv_BoxEntities_Filter(query, ent)) {
 
-		if (Sv_BoxEntities_Filter(ent)) {
+		if (Box3_Intersects(ent->abs_bounds, query->box)) {
+			return query->func(ent, query->data);
+		}
+	}
 
-			if (Box3_Intersects(ent->abs_bounds, sv_world.box)) {
+	return true;
+}
 
-				sv_world.box_entities[sv_world.num_box_entities] = ent;
-				sv_world.num_box_entities++;
+/**
+ * @brief
+ */
+static _Bool Sv_BoxEntities_r(const sv_box_query_t *query, const sv_sector_t *sector) {
 
-				if (sv_world.num_box_entities == sv_world.max_box_entities) {
-					Com_Warn("sv_world.max_box_entities\n");
-					return;
-				}
-			}
+	for (const GList *e = sector->entities; e; e = e->next) {
+		if (!Sv_BoxEntities_Yield(query, (g_entity_t *) e->data)) {
+			return false;
 		}
-
-		e = e->next;
 	}
 
 	if (sector->axis == -1) {
-		return;    // terminal node
+		return true;    // terminal node
 	}
 
 	// recurse down both sides
-	if (sv_world.box.maxs.xyz[sector->axis] > sector->dist) {
-		Sv_BoxEntities_r(sector->children[0]);
+	if (query->box.maxs.xyz[sector->axis] > sector->dist) {
+		if (!Sv_BoxEntities_r(query, sector->children[0])) {
+			return false;
+		}
+	}
+
+	if (query->box.mins.xyz[sector->axis] < sector->dist) {
+		if (!Sv_BoxEntities_r(query, sector->children[1])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Yields the entities of all tree leafs intersecting the query box.
+ */
+static void Sv_BoxEntities_Tree(const sv_box_query_t *query) {
+	int32_t stack[TREE_STACK];
+	int32_t depth = 0;
+
+	if (sv_world.root) {
+		stack[depth++] = sv_world.root;
 	}
 
-	if (sv_world.box.mins.xyz[sector->axis] < sector->dist) {
-		Sv_BoxEntities_r(sector->children[1]);
+	while (depth) {
+		const sv_tree_node_t *node = &sv_world.nodes[stack[--depth]];
+
+		if (!Box3_Intersects(node->bounds, query->box)) {
+			continue;
+		}
+
+		if (node->height) {
+			stack[depth++] = node->children[1];
+			stack[depth++] = node->children[0];
+			continue;
+		}
+
+		if (!Sv_BoxEntities_Yield(query, node->ent)) {
+			return;
+		}
 	}
 }
 
+/**
+ * @brief Yields all entities of the specified type whose bounding boxes intersect the
+ * specified box to the specified callback. This is reentrant, and thread safe provided
+ * that no entities are linked or unlinked while it runs.
+ */
+static void Sv_BoxEntities_(const box3_t bounds, uint32_t type, Sv_BoxEntitiesFunc func, void *data) {
+
+	const sv_box_query_t query = {
+		.box = bounds,
+		.type = type,
+		.func = func,
+		.data = data
+	};
+
+	if (sv_world.tree) {
+		Sv_BoxEntities_Tree(&query);
+	} else {
+		Sv_BoxEntities_r(&query, sv_world.sectors);
+	}
+}
+
+/**
+ * @brief The output list of Sv_BoxEntities.
+ */
+typedef struct {
+	g_entity_t **list;
+	size_t len, max_len;
+} sv_box_entities_t;
+
+/**
+ * @brief Sv_BoxEntitiesFunc for Sv_BoxEntities.
+ */
+static _Bool Sv_BoxEntities_List(g_entity_t *ent, void *data) {
+
+	sv_box_entities_t *out = data;
+
+	out->list[out->len++] = ent;
+
+	if (out->len == out->max_len) {
+		Com_Warn("max_len reached\n");
+		return false;
+	}
+
+	return true;
+}
+
 /**
  * @brief Populates an array of entities with those which have bounding boxes
  * that intersect the given box. It is possible for a non-axial BSP model to
@@ -308,18 +750,16 @@ static void Sv_BoxEntities_r(sv_sector_t *sector) {
 size_t Sv_BoxEntities(const box3_t bounds, g_entity_t **list, const size_t len,
                       const uint32_t type) {
 
-	sv_world.box = bounds;
-	sv_world.box_entities = list;
-	sv_world.num_box_entities = 0;
-	sv_world.max_box_entities = len;
-	sv_world.box_type = type;
-
-	Sv_BoxEntities_r(sv_world.sectors);
+	sv_box_entities_t out = {
+		.list = list,
+		.max_len = len
+	};
 
-	sv_world.box = Box3_Zero();
-	sv_world.box_entities = NULL;
+	if (len) {
+		Sv_BoxEntities_(bounds, type, Sv_BoxEntities_List, &out);
+	}
 
-	return sv_world.num_box_entities;
+	return out.len;
 }
 
 /**
@@ -354,32 +794,47 @@ static int32_t Sv_HullForEntity(const g_entity_t *ent) {
 	return -1;
 }
 
+/**
+ * @brief The point contents query context.
+ */
+typedef struct {
+	vec3_t point;
+	int32_t contents;
+} sv_point_contents_t;
+
+/**
+ * @brief Sv_BoxEntitiesFunc for Sv_PointContents.
+ */
+static _Bool Sv_PointContents_Entity(g_entity_t *ent, void *data) {
+
+	sv_point_contents_t *pc = data;
+
+	const int32_t head_node = Sv_HullForEntity(ent);
+	if (head_node != -1) {
+
+		const sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
+		pc->contents |= Cm_TransformedPointContents(pc->point, head_node, sent->inverse_matrix);
+	}
+
+	return true;
+}
+
 /**
  * @brief Returns the contents mask for the specified point. This includes world
  * contents as well as contents for any solid entities this point intersects.
  */
 int32_t Sv_PointContents(const vec3_t point) {
-	g_entity_t *entities[MAX_ENTITIES];
 
 	// get base contents from world
-	int32_t contents = Cm_PointContents(point, 0);
+	sv_point_contents_t pc = {
+		.point = point,
+		.contents = Cm_PointContents(point, 0)
+	};
 
 	// as well as contents from all intersected entities
-	const size_t len = Sv_BoxEntities(Box3_FromCenter(point), entities, lengthof(entities), BOX_COLLIDE);
+	Sv_BoxEntities_(Box3_FromCenter(point), BOX_COLLIDE, Sv_PointContents_Entity, &pc);
 
-	// iterate the box entities, checking each one for an intersection
-	for (size_t i = 0; i < len; i++) {
-		const g_entity_t *ent = entities[i];
-
-		const int32_t head_node = Sv_HullForEntity(ent);
-		if (head_node != -1) {
-
-			const sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
-			contents |= Cm_TransformedPointContents(point, head_node, sent->inverse_matrix);
-		}
-	}
-
-	return contents;
+	return pc.contents;
 }
 
 // an entity's movement, with allowed exceptions and other info
@@ -451,19 +906,45 @@ static void Sv_ClipTraceToEntity(sv_trace_t *trace, const g_entity_t *ent) {
 	}
 }
 
+/**
+ * @brief Sv_BoxEntitiesFunc for Sv_ClipTraceToEntities.
+ */
+static _Bool Sv_ClipTraceToEntities_Entity(g_entity_t *ent, void *data) {
+
+	Sv_ClipTraceToEntity((sv_trace_t *) data, ent);
+
+	return true;
+}
+
 /**
  * @brief Clips the specified trace to other entities in its bounds. This is the basis of all
  * collision and interaction for the server. Tread carefully.
  */
 static void Sv_ClipTraceToEntities(sv_trace_t *trace) {
-	g_entity_t *e[MAX_ENTITIES];
 
-	const size_t len = Sv_BoxEntities(trace->box, e, lengthof(e), BOX_COLLIDE);
+	Sv_BoxEntities_(trace->box, BOX_COLLIDE, Sv_ClipTraceToEntities_Entity, trace);
+}
 
-	for (size_t i = 0; i < len; i++) {
+/**
+ * @brief Clips the specified trace to the world, and resolves the bounding box of the
+ * entire move for entity clipping.
+ * @return True if the trace should be clipped to entities, false if it was blocked entirely.
+ */
+static _Bool Sv_ClipTraceToWorld(sv_trace_t *trace) {
 
-		Sv_ClipTraceToEntity(trace, e[i]);
+	trace->trace = Cm_BoxTrace(trace->start, trace->end, trace->bounds, 0, trace->contents, NULL, NULL);
+	if (trace->trace.fraction < 1.0f) {
+		trace->trace.ent = svs.game->entities;
+
+		if (trace->trace.start_solid) { // blocked entirely
+			return false;
+		}
 	}
+
+	// create the bounding box of the entire move
+	trace->box = Cm_TraceBounds(trace->start, trace->end, trace->bounds);
+
+	return true;
 }
 
 /**
@@ -475,33 +956,147 @@ static void Sv_ClipTraceToEntities(sv_trace_t *trace) {
 cm_trace_t Sv_Trace(const vec3_t start, const vec3_t end, const box3_t bounds,
                     const g_entity_t *skip, const int32_t contents) {
 
-	sv_trace_t trace = { };
+	const uint64_t time = Sv_BenchTime();
 
-	// clip to world
-	trace.trace = Cm_BoxTrace(start, end, bounds, 0, contents, NULL, NULL);
-	if (trace.trace.fraction < 1.0f) {
-		trace.trace.ent = svs.game->entities;
+	sv_trace_t trace = {
+		.start = start,
+		.end = end,
+		.bounds = bounds,
+		.skip = skip,
+		.contents = contents
+	};
 
-		if (trace.trace.start_solid) { // blocked entirely
-			return trace.trace;
-		}
+	// clip to world, and then to other solid entities
+	if (Sv_ClipTraceToWorld(&trace)) {
+		Sv_ClipTraceToEntities(&trace);
 	}
 
-	trace.start = start;
-	trace.end = end;
-	trace.bounds = bounds;
-	trace.skip = skip;
-	trace.contents = contents;
+	Sv_BenchCount(SV_BENCH_TRACE, time);
 
-	// create the bounding box of the entire move
-	trace.box = Cm_TraceBounds(start, end, bounds);
+	return trace.trace;
+}
+
+/**
+ * @brief Batches whose combined bounds are within this factor of the sum of their
+ * individual bounds share a single entity broadphase.
+ */
+#define SV_TRACE_BATCH_SHARE 4.f
 
-	// clip to other solid entities
-	Sv_ClipTraceToEntities(&trace);
+/**
+ * @brief Batches of at least this many traces are run on the thread pool.
+ */
+#define SV_TRACE_BATCH_JOBS 16
 
-	return trace.trace;
+/**
+ * @brief A batch of traces, and their shared entity broadphase.
+ */
+typedef struct {
+	const g_trace_request_t *requests;
+	cm_trace_t *traces;
+
+	/**
+	 * @brief The entities intersecting the combined bounds of the batch, or NULL if
+	 * each trace should query the world for its own.
+	 */
+	g_entity_t **entities;
+	size_t num_entities;
+} sv_trace_batch_t;
+
+/**
+ * @brief JobRangeFunc for Sv_TraceBatch.
+ */
+static void Sv_TraceBatch_(int32_t begin, int32_t end, void *data) {
+
+	const sv_trace_batch_t *batch = (sv_trace_batch_t *) data;
+
+	for (int32_t i = begin; i < end; i++) {
+		const g_trace_request_t *req = &batch->requests[i];
+
+		sv_trace_t trace = {
+			.start = req->start,
+			.end = req->end,
+			.bounds = req->bounds,
+			.skip = req->skip,
+			.contents = req->contents
+		};
+
+		if (Sv_ClipTraceToWorld(&trace)) {
+
+			if (batch->entities) {
+				for (size_t j = 0; j < batch->num_entities; j++) {
+					const g_entity_t *ent = batch->entities[j];
+
+					if (Box3_Intersects(ent->abs_bounds, trace.box)) {
+						Sv_ClipTraceToEntity(&trace, ent);
+					}
+				}
+			} else {
+				Sv_ClipTraceToEntities(&trace);
+			}
+		}
+
+		batch->traces[i] = trace.trace;
+	}
+}
+
+/**
+ * @return The volume of the specified box, padded so that line traces along an axis
+ * are not considered empty.
+ */
+static float Sv_TraceBatch_Volume(const box3_t box) {
+
+	const vec3_t size = Vec3_Add(Box3_Size(box), Vec3_One());
+
+	return size.x * size.y * size.z;
 }
 
+/**
+ * @brief Performs the specified traces, each of which yields exactly the result that
+ * Sv_Trace would. Traces of similar bounds share a single entity broadphase, which the
+ * world is queried for once, and large batches are spread across the thread pool.
+ */
+void Sv_TraceBatch(const g_trace_request_t *requests, cm_trace_t *traces, const size_t count) {
+
+	if (count == 0) {
+		return;
+	}
+
+	const uint64_t time = Sv_BenchTime();
+
+	sv_trace_batch_t batch = {
+		.requests = requests,
+		.traces = traces
+	};
+
+	// batches are not reentrant, so each thread's broadphase is kept off of its stack
+	static __thread g_entity_t *entities[MAX_ENTITIES];
+
+	if (count > 1) {
+
+		box3_t box = Box3_Null();
+		float volume = 0.f;
+
+		for (size_t i = 0; i < count; i++) {
+			const box3_t b = Cm_TraceBounds(requests[i].start, requests[i].end, requests[i].bounds);
+
+			box = Box3_Union(box, b);
+			volume += Sv_TraceBatch_Volume(b);
+		}
+
+		if (Sv_TraceBatch_Volume(box) <= volume * SV_TRACE_BATCH_SHARE) {
+			batch.entities = entities;
+			batch.num_entities = Sv_BoxEntities(box, entities, lengthof(entities), BOX_COLLIDE);
+		}
+	}
+
+	if (sv_threaded_traces->integer && count >= SV_TRACE_BATCH_JOBS) {
+		Job_ParallelFor((int32_t) count, 4, Sv_TraceBatch_, &batch);
+	} else {
+		Sv_TraceBatch_(0, (int32_t) count, &batch);
+	}
+
+	Sv_BenchCount(SV_BENCH_TRACE_BATCH, time);
+}
 
 /**
  * @brief Tests a clip of the specified translation against the specified entity.
@@ -336,13 +336,19 @@ static inline float __attribute__ ((warn_unused_result)) Radians(float degrees)
 }
 
 /**
- * @return A random number generator.
+ * @return A random number generator. If the `QUETOO_RANDOM_SEED` environment variable
+ * is set, it seeds every generator, so that simulations may be reproduced exactly.
  */
 static inline GRand *InitRandom(void) {
 	static _Thread_local GRand *rand;
 
 	if (rand == NULL) {
-		rand = g_rand_new_with_seed((guint32) time(NULL));
+		const gchar *seed = g_getenv("QUETOO_RANDOM_SEED");
+		if (seed) {
+			rand = g_rand_new_with_seed((guint32) g_ascii_strtoull(seed, NULL, 10));
+		} else {
+			rand = g_rand_new_with_seed((guint32) time(NULL));
+		}
 	}
 
 	return rand;
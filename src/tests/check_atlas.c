@@ -35,6 +35,17 @@ static SDL_Surface *CreateSurface(int32_t w, int32_t h, int32_t color) {
 	return surface;
 }
 
+static atlas_node_t *InsertSurface(atlas_t *atlas, SDL_Surface *surface) {
+
+	atlas_node_t *node = Atlas_Insert(atlas, surface);
+	if (node) {
+		node->w = surface->w;
+		node->h = surface->h;
+	}
+
+	return node;
+}
+
 START_TEST(check_atlas) {
 
 	SDL_Surface *red = CreateSurface(128, 128, 0xff0000);
@@ -44,13 +55,13 @@ START_TEST(check_atlas) {
 
 	atlas_t *atlas = Atlas_Create(1);
 
-	atlas_node_t *a = Atlas_Insert(atlas, red);
+	atlas_node_t *a = InsertSurface(atlas, red);
 	ck_assert_ptr_ne(NULL, a);
 
-	atlas_node_t *b = Atlas_Insert(atlas, green);
+	atlas_node_t *b = InsertSurface(atlas, green);
 	ck_assert_ptr_ne(NULL, b);
 
-	atlas_node_t *c = Atlas_Insert(atlas, blue);
+	atlas_node_t *c = InsertSurface(atlas, blue);
 	ck_assert_ptr_ne(NULL, c);
 
 	SDL_Surface *surface = CreateSurface(1024, 1024, 0x000000);
@@ -67,7 +78,7 @@ START_TEST(check_atlas) {
 	ck_assert_int_eq(768, a->x);
 	ck_assert_int_eq(0, a->y);
 
-	atlas_node_t *d = Atlas_Insert(atlas, purple);
+	atlas_node_t *d = InsertSurface(atlas, purple);
 	ck_assert_ptr_ne(NULL, d);
 
 	res = Atlas_Compile(atlas, 0, surface);
@@ -114,7 +125,7 @@ START_TEST(check_atlas_random) {
 		
 		surfaces[i] = CreateSurface(w, h, color);
 
-		Atlas_Insert(atlas, surfaces[i]);
+		InsertSurface(atlas, surfaces[i]);
 	}
 
 	SDL_Surface *surface = CreateSurface(1024, 1024, 0);
@@ -134,6 +145,46 @@ START_TEST(check_atlas_random) {
 
 } END_TEST
 
+START_TEST(check_atlas_pack) {
+
+	srand(getpid());
+
+	atlas_t *atlas = Atlas_Create(1);
+
+	SDL_Surface *surfaces[1000];
+
+	for (size_t i = 0; i < lengthof(surfaces); i++) {
+		surfaces[i] = CreateSurface(rand() % 96 + 1, rand() % 96 + 1, 0);
+		InsertSurface(atlas, surfaces[i]);
+	}
+
+	ck_assert_int_eq(-1, Atlas_Pack(atlas, 0, 64, 64));
+	ck_assert(Atlas_Pack(atlas, 0, 512, 512) > 0);
+	ck_assert_int_eq(0, Atlas_Pack(atlas, 0, 2048, 2048));
+
+	for (guint i = 0; i < atlas->nodes->len; i++) {
+		const atlas_node_t *a = g_ptr_array_index(atlas->nodes, i);
+
+		ck_assert_int_eq(atlas->tag, a->tag);
+		ck_assert(a->x >= 0 && a->x + a->w <= 2048);
+		ck_assert(a->y >= 0 && a->y + a->h <= 2048);
+
+		for (guint j = 0; j < i; j++) {
+			const atlas_node_t *b = g_ptr_array_index(atlas->nodes, j);
+
+			ck_assert(a->x >= b->x + b->w || b->x >= a->x + a->w ||
+					  a->y >= b->y + b->h || b->y >= a->y + a->h);
+		}
+	}
+
+	Atlas_Destroy(atlas);
+
+	for (size_t i = 0; i < lengthof(surfaces); i++) {
+		SDL_FreeSurface(surfaces[i]);
+	}
+
+} END_TEST
+
 /**
  * @brief This custom comparator should actually produce the worst possible packing.
  */
@@ -158,7 +209,7 @@ START_TEST(check_atlas_custom_comparator) {
 
 		surfaces[i] = CreateSurface(w, h, color);
 
-		Atlas_Insert(atlas, surfaces[i]);
+		InsertSurface(atlas, surfaces[i]);
 	}
 
 	SDL_Surface *surface = CreateSurface(1024, 1024, 0);
@@ -186,6 +237,7 @@ int32_t main(int32_t argc, char **argv) {
 
 	tcase_add_test(tcase, check_atlas);
 	tcase_add_test(tcase, check_atlas_random);
+	tcase_add_test(tcase, check_atlas_pack);
 	tcase_add_test(tcase, check_atlas_custom_comparator);
 
 	Suite *suite = suite_create("check_atlas");
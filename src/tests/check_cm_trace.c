@@ -0,0 +1,168 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "collision/collision.h"
+
+quetoo_t quetoo;
+
+/**
+ * @brief The map is a single empty leaf, so that only box hulls are traced.
+ */
+static cm_bsp_node_t node;
+static cm_bsp_leaf_t leaf;
+
+#define NUM_TRACES 200000
+
+static SDL_atomic_t failures;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Thread_Init(0);
+
+	cm_bsp_t *bsp = Cm_Bsp();
+
+	bsp->nodes = &node;
+	bsp->file.num_nodes = 1;
+
+	bsp->leafs = &leaf;
+	bsp->file.num_leafs = 1;
+
+	SDL_AtomicSet(&failures, 0);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	memset(Cm_Bsp(), 0, sizeof(cm_bsp_t));
+
+	Thread_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @return A box hull, unique to the specified trace number.
+ */
+static box3_t check_Cm_BoxHull(int32_t i) {
+
+	const float size = 8.f + (i % 61);
+	const vec3_t center = Vec3((i % 97) * 16.f, (i % 89) * -16.f, (i % 83) * 8.f);
+
+	return Box3_Translate(Box3f(size, size, size), center);
+}
+
+/**
+ * @brief Counts a failure, asserting from the main thread once all work is done.
+ */
+static void check_Cm_Fail(void) {
+	SDL_AtomicAdd(&failures, 1);
+}
+
+/**
+ * @brief JobRangeFunc that traces a range of box hulls, each of which differs from those
+ * that other threads are concurrently tracing.
+ */
+static void check_Cm_BoxTrace_range(int32_t begin, int32_t end, void *data) {
+
+	for (int32_t i = begin; i < end; i++) {
+
+		const box3_t bounds = check_Cm_BoxHull(i);
+		const vec3_t center = Box3_Center(bounds);
+
+		const int32_t head_node = Cm_SetBoxHull(bounds, CONTENTS_SOLID);
+
+		// a line trace along the x axis, through the box
+		const vec3_t start = Vec3(bounds.mins.x - 64.f, center.y, center.z);
+		const vec3_t stop = Vec3(bounds.maxs.x + 64.f, center.y, center.z);
+
+		const cm_trace_t tr = Cm_BoxTrace(start, stop, Box3_Zero(), head_node, CONTENTS_SOLID, NULL, NULL);
+
+		if (tr.fraction == 1.f || fabsf(tr.end.x - bounds.mins.x) > 1.f || tr.contents != CONTENTS_SOLID) {
+			check_Cm_Fail();
+		}
+
+		// a box trace along the z axis, from above the box
+		const box3_t box = Box3f(4.f, 4.f, 4.f);
+		const vec3_t above = Vec3(center.x, center.y, bounds.maxs.z + 64.f);
+
+		const cm_trace_t down = Cm_BoxTrace(above, center, box, head_node, CONTENTS_SOLID, NULL, NULL);
+
+		if (fabsf(down.end.z - (bounds.maxs.z + 2.f)) > 1.f) {
+			check_Cm_Fail();
+		}
+
+		// a position test within the box
+		const cm_trace_t pos = Cm_BoxTrace(center, center, box, head_node, CONTENTS_SOLID, NULL, NULL);
+
+		if (!pos.all_solid) {
+			check_Cm_Fail();
+		}
+
+		// and point contents, which resolve to the box leaf
+		if (Cm_PointContents(center, head_node) != CONTENTS_SOLID) {
+			check_Cm_Fail();
+		}
+	}
+}
+
+START_TEST(check_Cm_BoxTrace_threads) {
+
+	const uint64_t start = SDL_GetPerformanceCounter();
+
+	Job_ParallelFor(NUM_TRACES, 64, check_Cm_BoxTrace_range, NULL);
+
+	const uint64_t end = SDL_GetPerformanceCounter();
+
+	Com_Print("%d box hulls traced by %d threads in %.2f ms\n", NUM_TRACES, Thread_Count() + 1,
+	          (end - start) * 1000.0 / SDL_GetPerformanceFrequency());
+
+	ck_assert_int_eq(0, SDL_AtomicGet(&failures));
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_cm_trace");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Cm_BoxTrace_threads);
+
+	Suite *suite = suite_create("check_cm_trace");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -99,6 +99,173 @@ START_TEST(check_Mem_CopyString) {
 	ck_assert(Mem_Size() == 0);
 } END_TEST
 
+START_TEST(check_Mem_Realloc) {
+	byte *parent = Mem_Malloc(8);
+	byte *child = Mem_LinkMalloc(8, parent);
+
+	memset(parent, 0xff, 8);
+
+	parent = Mem_Realloc(parent, 4096);
+
+	ck_assert(Mem_Size() == 4096 + 8);
+
+	for (size_t i = 0; i < 4096; i++) {
+		ck_assert_int_eq(i < 8 ? 0xff : 0, parent[i]);
+	}
+
+	child = Mem_Realloc(child, 16);
+
+	ck_assert(Mem_Size() == 4096 + 16);
+
+	Mem_Free(parent);
+
+	ck_assert(Mem_Size() == 0);
+
+} END_TEST
+
+START_TEST(check_Mem_FreeTag) {
+	byte *parent = Mem_Malloc(1);
+
+	// blocks linked elsewhere are no longer freed with their tag
+	byte *linked = Mem_TagMalloc(64, TAG);
+	Mem_Link(linked, parent);
+
+	for (int32_t i = 0; i < 1024; i++) {
+		Mem_LinkMalloc(i, Mem_TagMalloc(i, TAG));
+	}
+
+	Mem_FreeTag(TAG);
+
+	ck_assert(Mem_Size() == 65);
+
+	memset(linked, 0xff, 64);
+
+	// while the tag may be reused after its arena was released in bulk
+	for (int32_t i = 0; i < 1024; i++) {
+		Mem_TagMalloc(i, TAG + 1);
+	}
+
+	Mem_FreeTag(TAG + 1);
+
+	for (int32_t i = 0; i < 1024; i++) {
+		ck_assert(Mem_TagMalloc(32, TAG + 1) != NULL);
+	}
+
+	Mem_FreeTag(TAG + 1);
+
+	ck_assert(Mem_Size() == 65);
+
+	Mem_Free(parent);
+
+	ck_assert(Mem_Size() == 0);
+
+} END_TEST
+
+#define ALLOCATIONS (1 << 16)
+
+/**
+ * @brief ThreadRunFunc allocating and freeing small blocks of varied sizes.
+ */
+static void allocate(void *data) {
+	void **blocks = (void **) data;
+
+	for (int32_t round = 0; round < 16; round++) {
+		for (int32_t i = 0; i < ALLOCATIONS; i++) {
+			blocks[i] = Mem_TagMalloc(8 + (i * 7) % 500, TAG + (i & 3));
+		}
+
+		for (int32_t i = 0; i < ALLOCATIONS; i++) {
+			Mem_Free(blocks[(i * 31) & (ALLOCATIONS - 1)]);
+		}
+	}
+}
+
+START_TEST(check_Mem_Throughput) {
+	const int32_t num_threads[] = { 1, 4 };
+
+	for (size_t i = 0; i < lengthof(num_threads); i++) {
+		Thread_Init(num_threads[i]);
+
+		void **blocks = Mem_Malloc(sizeof(void *) * ALLOCATIONS * num_threads[i]);
+		thread_t *threads[num_threads[i]];
+
+		const uint64_t start = SDL_GetPerformanceCounter();
+
+		for (int32_t j = 0; j < num_threads[i]; j++) {
+			threads[j] = Thread_Create(allocate, blocks + j * ALLOCATIONS, 0);
+		}
+
+		for (int32_t j = 0; j < num_threads[i]; j++) {
+			Thread_Wait(threads[j]);
+		}
+
+		const uint64_t end = SDL_GetPerformanceCounter();
+
+		const double seconds = (end - start) / (double) SDL_GetPerformanceFrequency();
+		const double ops = 2.0 * 16 * ALLOCATIONS * num_threads[i];
+
+		Com_Print("%d threads: %.1f M allocations and frees per second\n", num_threads[i], ops / seconds / 1e6);
+
+		Mem_Free(blocks);
+
+		Thread_Shutdown();
+	}
+
+	for (int32_t i = 0; i < ALLOCATIONS * 16; i++) {
+		Mem_TagMalloc(8 + (i * 7) % 500, TAG);
+	}
+
+	const uint64_t start = SDL_GetPerformanceCounter();
+
+	Mem_FreeTag(TAG);
+
+	const uint64_t end = SDL_GetPerformanceCounter();
+
+	Com_Print("Freed %d blocks by tag in %.2f ms\n", ALLOCATIONS * 16,
+	          1000.0 * (end - start) / SDL_GetPerformanceFrequency());
+
+	ck_assert(Mem_Size() == 0);
+
+} END_TEST
+
+/**
+ * @brief ThreadRunFunc allocating small blocks in a tag that is concurrently freed.
+ */
+static void allocate_freed(void *data) {
+
+	for (int32_t i = 0; i < ALLOCATIONS; i++) {
+		Mem_TagMalloc(8 + (i * 7) % 500, TAG);
+	}
+}
+
+START_TEST(check_Mem_FreeTagConcurrent) {
+	const int32_t num_threads = 4;
+
+	Thread_Init(num_threads);
+
+	thread_t *threads[num_threads];
+
+	for (int32_t i = 0; i < num_threads; i++) {
+		threads[i] = Thread_Create(allocate_freed, NULL, 0);
+	}
+
+	// the arena's slabs may be released while the threads are allocating from them
+	for (int32_t i = 0; i < 256; i++) {
+		Mem_FreeTag(TAG);
+	}
+
+	for (int32_t i = 0; i < num_threads; i++) {
+		Thread_Wait(threads[i]);
+	}
+
+	Mem_FreeTag(TAG);
+
+	Thread_Shutdown();
+
+	ck_assert(Mem_Size() == 0);
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -112,6 +279,10 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_test(tcase, check_Mem_TagMalloc);
 	tcase_add_test(tcase, check_Mem_LinkMalloc);
 	tcase_add_test(tcase, check_Mem_CopyString);
+	tcase_add_test(tcase, check_Mem_Realloc);
+	tcase_add_test(tcase, check_Mem_FreeTag);
+	tcase_add_test(tcase, check_Mem_FreeTagConcurrent);
+	tcase_add_test(tcase, check_Mem_Throughput);
 
 	Suite *suite = suite_create("check_mem");
 	suite_add_tcase(suite, tcase);
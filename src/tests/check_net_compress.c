@@ -0,0 +1,248 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "net/net_compress.h"
+
+quetoo_t quetoo;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+
+	Net_InitCompression();
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief Compresses and decompresses `in`, asserting that the round trip is lossless.
+ * @return The compressed size, or `len` if the input was not compressible.
+ */
+static size_t check_RoundTrip(const byte *in, size_t len) {
+	byte compressed[MAX_MSG_SIZE], decompressed[MAX_MSG_SIZE];
+
+	const size_t size = Net_Compress(in, len, compressed, sizeof(compressed));
+	if (size == 0) {
+		return len;
+	}
+
+	ck_assert_msg(size < len, "Compressed %zu bytes to %zu", len, size);
+
+	const ssize_t out = Net_Decompress(compressed, size, decompressed, sizeof(decompressed));
+
+	ck_assert_int_eq((int32_t) len, (int32_t) out);
+	ck_assert(memcmp(in, decompressed, len) == 0);
+
+	return size;
+}
+
+START_TEST(check_Net_Compress) {
+	byte in[MAX_MSG_SIZE];
+
+	// runs compress well
+	memset(in, 0, sizeof(in));
+	ck_assert(check_RoundTrip(in, sizeof(in)) < sizeof(in) / 64);
+
+	// as do strings found in the dictionary
+	const char *string = "models/players/qforcer/ ^7 joined the game\n";
+	ck_assert(check_RoundTrip((const byte *) string, strlen(string)) < strlen(string) / 2);
+
+	// as do short repetitive sequences, which overlap their own matches
+	for (size_t i = 0; i < sizeof(in); i++) {
+		in[i] = "abc"[i % 3];
+	}
+	ck_assert(check_RoundTrip(in, sizeof(in)) < sizeof(in) / 64);
+
+	// random data is never expanded
+	GRand *rand = g_rand_new_with_seed(1);
+
+	for (size_t i = 0; i < sizeof(in); i++) {
+		in[i] = (byte) g_rand_int(rand);
+	}
+
+	byte out[MAX_MSG_SIZE];
+	ck_assert_int_eq(0, (int32_t) Net_Compress(in, sizeof(in), out, sizeof(out)));
+
+	// and mixtures of the two round trip at every length
+	for (size_t i = 0; i < sizeof(in); i++) {
+		in[i] = (i & 64) ? (byte) g_rand_int(rand) : (byte) (i >> 8);
+	}
+
+	for (size_t len = 1; len < sizeof(in); len += 97) {
+		check_RoundTrip(in, len);
+	}
+
+	g_rand_free(rand);
+
+} END_TEST
+
+START_TEST(check_Net_Decompress) {
+	byte in[512], compressed[MAX_MSG_SIZE], out[MAX_MSG_SIZE];
+
+	for (size_t i = 0; i < sizeof(in); i++) {
+		in[i] = (byte) (i / 7);
+	}
+
+	const size_t size = Net_Compress(in, sizeof(in), compressed, sizeof(compressed));
+	ck_assert(size > 0);
+
+	// output limits are respected
+	ck_assert_int_eq(-1, (int32_t) Net_Decompress(compressed, size, out, sizeof(in) - 1));
+
+	// truncated input is rejected, or yields a prefix of the original
+	for (size_t len = 0; len < size; len++) {
+		const ssize_t n = Net_Decompress(compressed, len, out, sizeof(out));
+		if (n != -1) {
+			ck_assert(memcmp(in, out, n) == 0);
+		}
+	}
+
+	// and corrupted input never escapes the output buffer
+	GRand *rand = g_rand_new_with_seed(2);
+
+	for (int32_t i = 0; i < 10000; i++) {
+		byte corrupt[MAX_MSG_SIZE];
+		memcpy(corrupt, compressed, size);
+
+		corrupt[g_rand_int_range(rand, 0, (int32_t) size)] = (byte) g_rand_int(rand);
+
+		const ssize_t n = Net_Decompress(corrupt, size, out, sizeof(in));
+		ck_assert(n >= -1 && n <= (ssize_t) sizeof(in));
+	}
+
+	g_rand_free(rand);
+
+} END_TEST
+
+typedef struct {
+	size_t messages;
+	size_t in, out;
+	uint64_t compress, decompress;
+} check_benchmark_t;
+
+/**
+ * @brief Replays the messages of the specified demo through the codec. Demos
+ * are a series of little endian message lengths and messages, terminated by -1.
+ */
+static void check_Net_CompressDemos_enumerate(const char *path, void *data) {
+	check_benchmark_t *bench = (check_benchmark_t *) data;
+	void *buffer;
+
+	const int64_t len = Fs_Load(path, &buffer);
+	if (len == -1) {
+		return;
+	}
+
+	const byte *demo = buffer, *end = demo + len;
+
+	while (demo + sizeof(int32_t) <= end) {
+		int32_t size;
+
+		memcpy(&size, demo, sizeof(size));
+		size = LittleLong(size);
+		demo += sizeof(size);
+
+		if (size <= 0 || size > MAX_MSG_SIZE || demo + size > end) {
+			break;
+		}
+
+		byte compressed[MAX_MSG_SIZE], decompressed[MAX_MSG_SIZE];
+
+		const uint64_t start = SDL_GetPerformanceCounter();
+		size_t out = Net_Compress(demo, size, compressed, sizeof(compressed));
+		const uint64_t mid = SDL_GetPerformanceCounter();
+
+		if (out) {
+			ck_assert_int_eq(size, (int32_t) Net_Decompress(compressed, out, decompressed, sizeof(decompressed)));
+			bench->decompress += SDL_GetPerformanceCounter() - mid;
+
+			ck_assert(memcmp(demo, decompressed, size) == 0);
+		} else {
+			out = size;
+		}
+
+		bench->compress += mid - start;
+
+		bench->messages++;
+		bench->in += size;
+		bench->out += out;
+
+		demo += size;
+	}
+
+	Fs_Free(buffer);
+}
+
+START_TEST(check_Net_CompressDemos) {
+	check_benchmark_t bench = { 0 };
+
+	Fs_Enumerate("demos/*.demo", check_Net_CompressDemos_enumerate, &bench);
+
+	if (bench.messages == 0) {
+		Com_Print("No demos found, skipping benchmark\n");
+		return;
+	}
+
+	const double ns = 1e9 / SDL_GetPerformanceFrequency();
+
+	Com_Print("%zu messages, %zu bytes compressed to %zu (%.1f%%)\n",
+	          bench.messages, bench.in, bench.out, 100.0 * bench.out / bench.in);
+	Com_Print("compress %.2f ns/byte, decompress %.2f ns/byte\n",
+	          bench.compress * ns / bench.in, bench.decompress * ns / bench.in);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_net_compress");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Net_Compress);
+	tcase_add_test(tcase, check_Net_Decompress);
+	tcase_add_test(tcase, check_Net_CompressDemos);
+
+	Suite *suite = suite_create("check_net_compress");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
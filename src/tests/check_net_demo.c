@@ -0,0 +1,242 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "net/net_demo.h"
+
+quetoo_t quetoo;
+
+#define NUM_FRAMES 2000
+#define KEYFRAME_INTERVAL 50
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @return The time of the specified frame.
+ */
+static int32_t check_Net_FrameTime(int32_t frame) {
+	return 100000 + frame * QUETOO_TICK_MILLIS;
+}
+
+/**
+ * @brief Records a demo of NUM_FRAMES frames, each of which is preceded by a message, and
+ * with a keyframe every KEYFRAME_INTERVAL frames. Each message carries its frame number.
+ */
+static void check_Net_RecordDemo(const char *filename) {
+
+	demo_t *demo = Net_CreateDemo(filename);
+	ck_assert(demo != NULL);
+
+	for (int32_t i = 0; i < NUM_FRAMES; i++) {
+		const int32_t time = check_Net_FrameTime(i);
+
+		Net_WriteDemoBlock(demo, &i, sizeof(i), time, 0);
+		Net_WriteDemoBlock(demo, &i, sizeof(i), time, DEMO_BLOCK_FRAME);
+
+		if (i % KEYFRAME_INTERVAL == 0) {
+			Net_WriteDemoKeyframe(demo, time);
+
+			Net_WriteDemoBlock(demo, &i, sizeof(i), time, DEMO_BLOCK_KEYFRAME);
+			Net_WriteDemoBlock(demo, &i, sizeof(i), time, DEMO_BLOCK_KEYFRAME | DEMO_BLOCK_FRAME);
+		}
+	}
+
+	Net_CloseDemo(demo);
+}
+
+/**
+ * @brief Asserts that the demo is indexed, and that seeking lands on the expected keyframes.
+ */
+static void check_Net_SeekDemo(demo_t *demo) {
+
+	ck_assert(!demo->legacy);
+	ck_assert_int_eq(NUM_FRAMES / KEYFRAME_INTERVAL, demo->keyframes->len);
+	ck_assert_int_eq(check_Net_FrameTime(0), demo->start_time);
+	ck_assert_int_eq(check_Net_FrameTime(NUM_FRAMES - 1), demo->start_time + Net_DemoDuration(demo));
+
+	const int32_t targets[] = { 0, 1, 49, 50, 51, 777, 1234, NUM_FRAMES - 1, NUM_FRAMES * 2 };
+
+	for (size_t i = 0; i < lengthof(targets); i++) {
+
+		const demo_keyframe_t *keyframe = Net_SeekDemo(demo, check_Net_FrameTime(targets[i]));
+		ck_assert(keyframe != NULL);
+
+		const int32_t frame = Mini(targets[i], NUM_FRAMES - 1) / KEYFRAME_INTERVAL * KEYFRAME_INTERVAL;
+		ck_assert_int_eq(check_Net_FrameTime(frame), keyframe->time);
+
+		// the keyframe's blocks must follow, and then the next frame
+		const demo_block_t *block = Net_PeekDemoBlock(demo);
+		ck_assert(block != NULL);
+		ck_assert_int_eq(DEMO_BLOCK_KEYFRAME, block->flags);
+		ck_assert_int_eq(frame, *(int32_t *) block->data);
+		Net_ConsumeDemoBlock(demo);
+
+		block = Net_PeekDemoBlock(demo);
+		ck_assert(block != NULL);
+		ck_assert_int_eq(DEMO_BLOCK_KEYFRAME | DEMO_BLOCK_FRAME, block->flags);
+		Net_ConsumeDemoBlock(demo);
+
+		block = Net_PeekDemoBlock(demo);
+		if (frame < NUM_FRAMES - KEYFRAME_INTERVAL) {
+			ck_assert(block != NULL);
+			ck_assert_int_eq(0, block->flags);
+			ck_assert_int_eq(frame + 1, *(int32_t *) block->data);
+		}
+	}
+}
+
+START_TEST(check_Net_OpenDemo) {
+
+	check_Net_RecordDemo(__func__);
+
+	demo_t *demo = Net_OpenDemo(__func__);
+	ck_assert(demo != NULL);
+
+	// play the whole demo, skipping keyframes
+	int32_t frames = 0;
+
+	const demo_block_t *block;
+	while ((block = Net_PeekDemoBlock(demo))) {
+
+		if (!(block->flags & DEMO_BLOCK_KEYFRAME)) {
+			ck_assert_int_eq(frames, *(int32_t *) block->data);
+			ck_assert_int_eq(check_Net_FrameTime(frames), block->time);
+
+			if (block->flags & DEMO_BLOCK_FRAME) {
+				frames++;
+			}
+		}
+
+		Net_ConsumeDemoBlock(demo);
+	}
+
+	ck_assert_int_eq(NUM_FRAMES, frames);
+
+	check_Net_SeekDemo(demo);
+
+	Net_CloseDemo(demo);
+
+} END_TEST
+
+START_TEST(check_Net_OpenDemo_unterminated) {
+
+	check_Net_RecordDemo(__func__);
+
+	// truncate the index and footer, as if recording had been interrupted
+	void *buffer;
+	const int64_t len = Fs_Load(__func__, &buffer);
+	ck_assert(len > 0);
+
+	const int32_t index_size = (NUM_FRAMES / KEYFRAME_INTERVAL) * (sizeof(int32_t) + sizeof(int64_t));
+	const int32_t footer_size = sizeof(int64_t) + sizeof(int32_t) * 3;
+
+	file_t *file = Fs_OpenWrite(__func__);
+	Fs_Write(file, buffer, len - index_size - footer_size - sizeof(int32_t), 1);
+	Fs_Close(file);
+
+	Fs_Free(buffer);
+
+	demo_t *demo = Net_OpenDemo(__func__);
+	ck_assert(demo != NULL);
+
+	check_Net_SeekDemo(demo);
+
+	Net_CloseDemo(demo);
+
+} END_TEST
+
+START_TEST(check_Net_OpenDemo_legacy) {
+
+	file_t *file = Fs_OpenWrite(__func__);
+
+	for (int32_t i = 0; i < 10; i++) {
+		const int32_t len = LittleLong(sizeof(i));
+		Fs_Write(file, &len, sizeof(len), 1);
+		Fs_Write(file, &i, sizeof(i), 1);
+	}
+
+	const int32_t end = -1;
+	Fs_Write(file, &end, sizeof(end), 1);
+	Fs_Close(file);
+
+	demo_t *demo = Net_OpenDemo(__func__);
+	ck_assert(demo != NULL);
+	ck_assert(demo->legacy);
+
+	// legacy demos play one message per frame, and can not seek
+	for (int32_t i = 0; i < 10; i++) {
+		const demo_block_t *block = Net_PeekDemoBlock(demo);
+
+		ck_assert(block != NULL);
+		ck_assert_int_eq(i, *(int32_t *) block->data);
+		ck_assert_int_eq(i * QUETOO_TICK_MILLIS, block->time);
+		ck_assert_int_eq(DEMO_BLOCK_FRAME, block->flags);
+
+		Net_ConsumeDemoBlock(demo);
+	}
+
+	ck_assert(Net_PeekDemoBlock(demo) == NULL);
+	ck_assert(Net_SeekDemo(demo, 0) == NULL);
+
+	Net_CloseDemo(demo);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_net_demo");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Net_OpenDemo);
+	tcase_add_test(tcase, check_Net_OpenDemo_unterminated);
+	tcase_add_test(tcase, check_Net_OpenDemo_legacy);
+
+	Suite *suite = suite_create("check_net_demo");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "net/net_message.h"
+
+quetoo_t quetoo;
+
+static byte buffer[MAX_MSG_SIZE];
+static mem_buf_t msg;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+	Mem_Init();
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+	Mem_Shutdown();
+}
+
+START_TEST(check_Mem_WriteBits) {
+
+	Net_WriteByte(&msg, 0xab);
+	Mem_WriteBits(&msg, 0x5, 3);
+	Mem_WriteBits(&msg, 0x1ff, 9);
+	Net_WriteByte(&msg, 0xcd);
+
+	ck_assert_int_eq(4, msg.size);
+
+	Net_BeginReading(&msg);
+
+	ck_assert_int_eq(0xab, Net_ReadByte(&msg));
+	ck_assert_int_eq(0x5, Mem_ReadBits(&msg, 3));
+	ck_assert_int_eq(0x1ff, Mem_ReadBits(&msg, 9));
+
+	Mem_AlignBits(&msg);
+
+	ck_assert_int_eq(0xcd, Net_ReadByte(&msg));
+
+} END_TEST
+
+START_TEST(check_Net_WriteVarInt) {
+
+	const int32_t values[] = { 0, 1, -1, 15, -16, 1024, -65536, INT32_MAX, INT32_MIN };
+
+	for (size_t i = 0; i < lengthof(values); i++) {
+		Net_WriteVarInt(&msg, values[i], 5);
+	}
+
+	Net_WriteVarUInt(&msg, UINT32_MAX, 8);
+
+	Net_BeginReading(&msg);
+
+	for (size_t i = 0; i < lengthof(values); i++) {
+		ck_assert_int_eq(values[i], Net_ReadVarInt(&msg, 5));
+	}
+
+	ck_assert_uint_eq(UINT32_MAX, Net_ReadVarUInt(&msg, 8));
+
+} END_TEST
+
+START_TEST(check_Net_WritePackedDeltaEntity) {
+
+	const entity_state_t from = {
+		.number = 42,
+		.origin = Vec3(1024.f, -512.f, 64.f),
+		.angles = Vec3(0.f, 90.f, 0.f),
+		.model1 = 1,
+	};
+
+	entity_state_t to = from;
+	to.origin = Vec3(1031.3f, -509.1f, 64.f);
+	to.angles = Vec3(10.f, 180.f, 0.f);
+	to.event = 3;
+	to.effects = 0x101;
+	to.bounds = Box3(Vec3(-16.f, -16.f, -24.f), Vec3(16.f, 16.f, 32.f));
+
+	const uint16_t bits = Net_DeltaEntityBits(&from, &to);
+
+	Net_WritePackedDeltaEntity(&msg, &from, &to, bits);
+
+	const size_t packed_size = msg.size;
+
+	Net_BeginReading(&msg);
+
+	entity_state_t packed;
+	ck_assert_uint_eq(bits, Net_ReadPackedEntityBits(&msg));
+	Net_ReadPackedDeltaEntity(&msg, &from, &packed, to.number, bits);
+
+	Mem_ClearBuffer(&msg);
+
+	Net_WriteDeltaEntity(&msg, &from, &to, false);
+
+	ck_assert(packed_size < msg.size);
+
+	Net_BeginReading(&msg);
+
+	entity_state_t plain;
+	const uint16_t number = Net_ReadShort(&msg);
+	Net_ReadDeltaEntity(&msg, &from, &plain, number, Net_ReadShort(&msg));
+
+	// positions are quantized, everything else must match the plain delta exactly
+	for (int32_t i = 0; i < 3; i++) {
+		ck_assert(fabsf(packed.origin.xyz[i] - to.origin.xyz[i]) <= 1.f / 32.f);
+	}
+
+	packed.origin = plain.origin;
+	ck_assert(memcmp(&packed, &plain, sizeof(packed)) == 0);
+
+} END_TEST
+
+START_TEST(check_Net_WritePackedDeltaPlayerState) {
+
+	player_state_t from, to, packed;
+
+	memset(&from, 0, sizeof(from));
+
+	to = from;
+	to.pm_state.origin = Vec3(-3000.f, 2000.5f, 100.25f);
+	to.pm_state.velocity = Vec3(320.f, -15.f, 0.f);
+	to.pm_state.view_angles = Vec3(-20.f, 270.f, 0.f);
+	to.pm_state.gravity = 800;
+	to.stats[3] = -100;
+	to.stats[31] = 32000;
+
+	Net_WritePackedDeltaPlayerState(&msg, &from, &to);
+
+	Net_BeginReading(&msg);
+	Net_ReadPackedDeltaPlayerState(&msg, &from, &packed);
+
+	ck_assert(Vec3_Equal(to.pm_state.origin, packed.pm_state.origin));
+	ck_assert(Vec3_Equal(to.pm_state.velocity, packed.pm_state.velocity));
+	ck_assert_int_eq(to.pm_state.gravity, packed.pm_state.gravity);
+	ck_assert(memcmp(to.stats, packed.stats, sizeof(to.stats)) == 0);
+
+	// deltas against a dequantized state must reproduce the quantized value exactly
+	from = packed;
+	to = packed;
+	to.pm_state.origin.x += 7.5f;
+
+	Mem_ClearBuffer(&msg);
+	Net_WritePackedDeltaPlayerState(&msg, &from, &to);
+
+	Net_BeginReading(&msg);
+	Net_ReadPackedDeltaPlayerState(&msg, &from, &packed);
+
+	ck_assert(Vec3_Equal(to.pm_state.origin, packed.pm_state.origin));
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_net_message");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Mem_WriteBits);
+	tcase_add_test(tcase, check_Net_WriteVarInt);
+	tcase_add_test(tcase, check_Net_WritePackedDeltaEntity);
+	tcase_add_test(tcase, check_Net_WritePackedDeltaPlayerState);
+
+	Suite *suite = suite_create("check_net_message");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
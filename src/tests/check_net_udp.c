@@ -0,0 +1,297 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "net/net_chan.h"
+#include "net/net_demo.h"
+
+quetoo_t quetoo;
+
+/**
+ * @brief More datagrams than fit in a single batch.
+ */
+#define NUM_DATAGRAMS 100
+
+#define CHECK_NET_PORT 27911
+
+static byte buffer[MAX_MSG_SIZE];
+static mem_buf_t msg;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+
+	Cvar_Init();
+
+	Cvar_Add("net_port", va("%d", CHECK_NET_PORT), CVAR_NO_SET, NULL);
+
+	Netchan_Init();
+
+	Net_Config(NS_UDP_SERVER, true);
+	Net_Config(NS_UDP_CLIENT, true);
+
+	Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Net_Config(NS_UDP_CLIENT, false);
+	Net_Config(NS_UDP_SERVER, false);
+
+	Net_Shutdown();
+
+	Cvar_Shutdown();
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief Writes the specified datagram, whose size and contents are unique to it.
+ */
+static void check_Net_WriteDatagram(int32_t i) {
+
+	Mem_ClearBuffer(&msg);
+
+	Net_WriteLong(&msg, i);
+
+	for (int32_t j = 0; j < i * 7; j++) {
+		Net_WriteByte(&msg, (i + j) & 0xff);
+	}
+}
+
+/**
+ * @brief Asserts that the datagram in msg is the specified one.
+ */
+static void check_Net_ReadDatagram(int32_t i) {
+
+	ck_assert_int_eq(sizeof(int32_t) + i * 7, msg.size);
+
+	Net_BeginReading(&msg);
+	ck_assert_int_eq(i, Net_ReadLong(&msg));
+
+	for (int32_t j = 0; j < i * 7; j++) {
+		ck_assert_int_eq((i + j) & 0xff, Net_ReadByte(&msg));
+	}
+}
+
+START_TEST(check_Net_FlushDatagrams) {
+
+	net_addr_t to;
+	ck_assert(Net_StringToNetaddr(va("127.0.0.1:%d", CHECK_NET_PORT), &to));
+
+	Net_BeginDatagrams(NS_UDP_CLIENT);
+
+	for (int32_t i = 0; i < NUM_DATAGRAMS; i++) {
+		check_Net_WriteDatagram(i);
+		ck_assert(Net_SendDatagram(NS_UDP_CLIENT, &to, msg.data, msg.size));
+	}
+
+	Net_FlushDatagrams(NS_UDP_CLIENT);
+
+	int32_t received = 0;
+
+	for (int32_t attempts = 0; received < NUM_DATAGRAMS && attempts < 100; attempts++) {
+
+		net_addr_t from;
+		while (Net_ReceiveDatagram(NS_UDP_SERVER, &from, &msg)) {
+
+			ck_assert_int_eq(NA_DATAGRAM, from.type);
+			ck_assert_int_eq(net_lo, from.addr);
+
+			check_Net_ReadDatagram(received++);
+		}
+
+		Net_Sleep(10);
+	}
+
+	ck_assert_int_eq(NUM_DATAGRAMS, received);
+
+} END_TEST
+
+START_TEST(check_Net_WaitDatagram) {
+
+	ck_assert(!Net_WaitDatagram(NS_UDP_SERVER, 1000));
+
+	net_addr_t to;
+	ck_assert(Net_StringToNetaddr(va("127.0.0.1:%d", CHECK_NET_PORT), &to));
+
+	check_Net_WriteDatagram(1);
+	ck_assert(Net_SendDatagram(NS_UDP_CLIENT, &to, msg.data, msg.size));
+
+	ck_assert(Net_WaitDatagram(NS_UDP_SERVER, 1000000));
+
+	net_addr_t from;
+	ck_assert(Net_ReceiveDatagram(NS_UDP_SERVER, &from, &msg));
+	check_Net_ReadDatagram(1);
+
+} END_TEST
+
+/**
+ * @brief Receives the next datagram into net_message, and processes it through the channel.
+ */
+static _Bool check_Netchan_Receive(net_src_t source, net_chan_t *chan) {
+
+	for (int32_t attempts = 0; attempts < 100; attempts++) {
+		if (Net_ReceiveDatagram(source, &net_from, &net_message)) {
+			return Netchan_Process(chan, &net_message);
+		}
+		Net_Sleep(10);
+	}
+
+	return false;
+}
+
+START_TEST(check_Netchan_Compress) {
+
+	net_addr_t to;
+	ck_assert(Net_StringToNetaddr(va("127.0.0.1:%d", CHECK_NET_PORT), &to));
+
+	net_chan_t server, client;
+
+	Netchan_Setup(NS_UDP_CLIENT, &client, &to, 0);
+	Netchan_Setup(NS_UDP_SERVER, &server, &to, 0);
+
+	server.compress = client.compress = true;
+
+	// the client speaks first, so that the server learns its address
+	Netchan_Transmit(&client, NULL, 0);
+
+	ck_assert(check_Netchan_Receive(NS_UDP_SERVER, &server));
+	server.remote_address = net_from;
+
+	// sequence numbers must keep their full range, and not lose a bit to the flags
+	server.outgoing_sequence = (1u << 30) + 5;
+	client.incoming_sequence = (1u << 30) + 4;
+
+	for (int32_t i = 0; i < 2; i++) {
+
+		// a compressible message, and then an incompressible one
+		Mem_ClearBuffer(&msg);
+		for (int32_t j = 0; j < 256; j++) {
+			Net_WriteByte(&msg, i ? (j * 131 + 7) & 0xff : 'q');
+		}
+
+		Netchan_Transmit(&server, msg.data, msg.size);
+
+		ck_assert(check_Netchan_Receive(NS_UDP_CLIENT, &client));
+		ck_assert_int_eq((1u << 30) + 5 + i, client.incoming_sequence);
+
+		ck_assert_int_eq(msg.size, net_message.size - net_message.read);
+		ck_assert(memcmp(msg.data, net_message.data + net_message.read, msg.size) == 0);
+	}
+
+	// and the acknowledgement must make it back intact
+	Netchan_Transmit(&client, NULL, 0);
+
+	ck_assert(check_Netchan_Receive(NS_UDP_SERVER, &server));
+	ck_assert_int_eq((1u << 30) + 6, server.incoming_acknowledged);
+
+} END_TEST
+
+START_TEST(check_Netchan_RecordDemo) {
+
+	net_addr_t to;
+	ck_assert(Net_StringToNetaddr(va("127.0.0.1:%d", CHECK_NET_PORT), &to));
+
+	net_chan_t server, client;
+
+	Netchan_Setup(NS_UDP_CLIENT, &client, &to, 0);
+	Netchan_Setup(NS_UDP_SERVER, &server, &to, 0);
+
+	server.compress = client.compress = true;
+
+	Netchan_Transmit(&client, NULL, 0);
+
+	ck_assert(check_Netchan_Receive(NS_UDP_SERVER, &server));
+	server.remote_address = net_from;
+
+	demo_t *demo = Net_CreateDemo(__func__);
+	ck_assert(demo != NULL);
+
+	// record messages as the client does, from where the header (and its flags) ends
+	for (int32_t i = 0; i < NUM_DATAGRAMS; i++) {
+
+		check_Net_WriteDatagram(i);
+
+		Netchan_Transmit(&server, msg.data, msg.size);
+		ck_assert(check_Netchan_Receive(NS_UDP_CLIENT, &client));
+
+		Net_WriteDemoBlock(demo, net_message.data + net_message.read,
+						   net_message.size - net_message.read, i, 0);
+	}
+
+	Net_CloseDemo(demo);
+
+	demo = Net_OpenDemo(__func__);
+	ck_assert(demo != NULL);
+
+	for (int32_t i = 0; i < NUM_DATAGRAMS; i++) {
+
+		const demo_block_t *block = Net_PeekDemoBlock(demo);
+		ck_assert(block != NULL);
+
+		Mem_ClearBuffer(&msg);
+		Mem_WriteBuffer(&msg, block->data, block->size);
+
+		check_Net_ReadDatagram(i);
+
+		Net_ConsumeDemoBlock(demo);
+	}
+
+	ck_assert(Net_PeekDemoBlock(demo) == NULL);
+
+	Net_CloseDemo(demo);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_net_udp");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Net_FlushDatagrams);
+	tcase_add_test(tcase, check_Net_WaitDatagram);
+	tcase_add_test(tcase, check_Netchan_Compress);
+	tcase_add_test(tcase, check_Netchan_RecordDemo);
+
+	Suite *suite = suite_create("check_net_udp");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+
+quetoo_t quetoo;
+
+#define NUM_ZONES 1000
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+
+	Thread_Init(2);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Thread_Shutdown();
+
+	Profile_Shutdown();
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief JobRangeFunc that profiles a zone for each index.
+ */
+static void check_Profile_zones(int32_t begin, int32_t end, void *data) {
+
+	for (int32_t i = begin; i < end; i++) {
+		PROFILE_SCOPE("check_Profile_zone");
+	}
+}
+
+/**
+ * @return The number of occurrences of the quoted name in the profile.
+ */
+static int32_t check_Profile_count(const char *profile, const char *name) {
+
+	const char *quoted = va("\"%s\"", name);
+	int32_t count = 0;
+
+	for (const char *s = strstr(profile, quoted); s; s = strstr(s + 1, quoted)) {
+		count++;
+	}
+
+	return count;
+}
+
+START_TEST(check_Profile_Capture) {
+
+	// zones outside of a capture are not recorded
+	{
+		PROFILE_SCOPE("check_Profile_outside");
+	}
+
+	Profile_Capture(0, PROFILE_FINE);
+
+	{
+		PROFILE_SCOPE("check_Profile_parallel");
+
+		Job_ParallelFor(NUM_ZONES, 1, check_Profile_zones, NULL);
+	}
+
+	const char *filename = Profile_Stop();
+	ck_assert(filename != NULL);
+
+	// and zones after it are neither
+	{
+		PROFILE_SCOPE("check_Profile_outside");
+	}
+
+	void *buffer;
+	const int64_t len = Fs_Load(filename, &buffer);
+	ck_assert(len > 0);
+
+	gchar *profile = g_strndup(buffer, len);
+	Fs_Free(buffer);
+
+	ck_assert(g_str_has_prefix(profile, "{\"traceEvents\":["));
+	ck_assert(g_str_has_suffix(profile, "]}\n"));
+
+	ck_assert_int_eq(NUM_ZONES, check_Profile_count(profile, "check_Profile_zone"));
+	ck_assert_int_eq(1, check_Profile_count(profile, "check_Profile_parallel"));
+	ck_assert_int_eq(0, check_Profile_count(profile, "check_Profile_outside"));
+	ck_assert_int_eq(1, check_Profile_count(profile, "main"));
+
+	g_free(profile);
+
+} END_TEST
+
+START_TEST(check_Profile_Detail) {
+
+	Profile_Capture(0, PROFILE_COARSE);
+
+	{
+		PROFILE_SCOPE("check_Profile_coarse");
+		PROFILE_SCOPE_FINE("check_Profile_fine");
+	}
+
+	const char *filename = Profile_Stop();
+	ck_assert(filename != NULL);
+
+	void *buffer;
+	const int64_t len = Fs_Load(filename, &buffer);
+	ck_assert(len > 0);
+
+	gchar *profile = g_strndup(buffer, len);
+	Fs_Free(buffer);
+
+	// fine zones are omitted from coarse captures
+	ck_assert_int_eq(1, check_Profile_count(profile, "check_Profile_coarse"));
+	ck_assert_int_eq(0, check_Profile_count(profile, "check_Profile_fine"));
+
+	g_free(profile);
+
+} END_TEST
+
+START_TEST(check_Profile_Frame) {
+
+	Profile_Capture(2, PROFILE_FINE);
+
+	Profile_Frame();
+	ck_assert(SDL_AtomicGet(&profile_capturing));
+
+	Profile_Frame();
+	ck_assert(!SDL_AtomicGet(&profile_capturing));
+
+	ck_assert(Profile_Stop() == NULL);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_profile");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Profile_Capture);
+	tcase_add_test(tcase, check_Profile_Detail);
+	tcase_add_test(tcase, check_Profile_Frame);
+
+	Suite *suite = suite_create("check_profile");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "raytrace.h"
+
+quetoo_t quetoo;
+
+/**
+ * @brief The map is a single solid leaf of beveled boxes, so that every brush is
+ * clipped by both tracers.
+ */
+#define NUM_BRUSHES 64
+#define NUM_SIDES 7
+
+static cm_bsp_node_t node;
+static cm_bsp_leaf_t leaf;
+static cm_bsp_model_t model;
+static int32_t leaf_brushes[NUM_BRUSHES];
+static cm_bsp_brush_t brushes[NUM_BRUSHES];
+static cm_bsp_brush_side_t brush_sides[NUM_BRUSHES * NUM_SIDES];
+static cm_bsp_plane_t planes[NUM_BRUSHES * NUM_SIDES + 1];
+static cm_bsp_texinfo_t texinfos[NUM_BRUSHES * NUM_SIDES];
+
+#define NUM_TRACES 100000
+
+static box3_t world;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	cm_bsp_t *bsp = Cm_Bsp();
+
+	world = Box3f(1024.f, 1024.f, 1024.f);
+
+	// the node's plane is outside of the world, so that every trace reaches the leaf
+	planes[NUM_BRUSHES * NUM_SIDES] = Cm_Plane(Vec3(1.f, 0.f, 0.f), 4096.f);
+
+	node.plane = &planes[NUM_BRUSHES * NUM_SIDES];
+	node.children[0] = node.children[1] = -1;
+
+	leaf.contents = CONTENTS_SOLID;
+	leaf.num_leaf_brushes = NUM_BRUSHES;
+
+	for (int32_t i = 0; i < NUM_BRUSHES; i++) {
+		cm_bsp_brush_t *brush = &brushes[i];
+
+		const vec3_t center = Box3_RandomPoint(world);
+		const vec3_t size = Vec3(RandomRangef(8.f, 128.f), RandomRangef(8.f, 128.f), RandomRangef(8.f, 128.f));
+
+		brush->contents = CONTENTS_SOLID;
+		brush->sides = &brush_sides[i * NUM_SIDES];
+		brush->num_sides = NUM_SIDES;
+		brush->bounds = Box3_FromCenterSize(center, size);
+
+		cm_bsp_plane_t *p = &planes[i * NUM_SIDES];
+
+		for (int32_t j = 0; j < 3; j++) {
+			vec3_t normal = Vec3_Zero();
+
+			normal.xyz[j] = 1.f;
+			*p++ = Cm_Plane(normal, brush->bounds.maxs.xyz[j]);
+
+			normal.xyz[j] = -1.f;
+			*p++ = Cm_Plane(normal, -brush->bounds.mins.xyz[j]);
+		}
+
+		// and bevel one corner, so that not every plane is axial
+		const vec3_t bevel = Vec3_Normalize(Vec3(1.f, 1.f, 1.f));
+		*p++ = Cm_Plane(bevel, Vec3_Dot(bevel, center) + Vec3_Length(size) * .25f);
+
+		for (int32_t j = 0; j < NUM_SIDES; j++) {
+			brush->sides[j].plane = &planes[i * NUM_SIDES + j];
+			brush->sides[j].texinfo = &texinfos[i * NUM_SIDES + j];
+		}
+
+		leaf_brushes[i] = i;
+	}
+
+	model.head_node = 0;
+	model.bounds = world;
+
+	bsp->nodes = &node;
+	bsp->file.num_nodes = 1;
+
+	bsp->leafs = &leaf;
+	bsp->file.num_leafs = 1;
+
+	bsp->leaf_brushes = leaf_brushes;
+	bsp->file.num_leaf_brushes = NUM_BRUSHES;
+
+	bsp->brushes = brushes;
+	bsp->file.num_brushes = NUM_BRUSHES;
+
+	bsp->brush_sides = brush_sides;
+	bsp->file.num_brush_sides = NUM_BRUSHES * NUM_SIDES;
+
+	bsp->planes = planes;
+	bsp->file.num_planes = NUM_BRUSHES * NUM_SIDES + 1;
+
+	bsp->models = &model;
+	bsp->file.num_models = 1;
+
+	BuildRayTracer();
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	FreeRayTracer();
+
+	memset(Cm_Bsp(), 0, sizeof(cm_bsp_t));
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief Asserts that a ray traced trace matches the collision model trace.
+ */
+static void check_RayTrace_Matches(const cm_trace_t *cm, const cm_trace_t *rt) {
+
+	ck_assert(fabsf(cm->fraction - rt->fraction) <= 1e-6f);
+	ck_assert_int_eq(cm->start_solid, rt->start_solid);
+	ck_assert_int_eq(cm->all_solid, rt->all_solid);
+
+	if (cm->fraction < 1.f && !cm->all_solid) {
+		ck_assert(cm->texinfo == rt->texinfo);
+		ck_assert(Vec3_Equal(cm->plane.normal, rt->plane.normal));
+	}
+}
+
+START_TEST(check_RayTracePacket_nearest) {
+	int32_t hits = 0;
+
+	for (int32_t i = 0; i < NUM_TRACES; i += RAY_PACKET_SIZE) {
+
+		const vec3_t start = Box3_RandomPoint(world);
+
+		vec3_t ends[RAY_PACKET_SIZE];
+		for (int32_t j = 0; j < RAY_PACKET_SIZE; j++) {
+			ends[j] = Box3_RandomPoint(world);
+		}
+
+		cm_trace_t traces[RAY_PACKET_SIZE];
+		RayTracePacket(start, ends, RAY_PACKET_SIZE, 0, CONTENTS_SOLID, RAY_NEAREST, traces);
+
+		for (int32_t j = 0; j < RAY_PACKET_SIZE; j++) {
+			const cm_trace_t tr = Cm_BoxTrace(start, ends[j], Box3_Zero(), 0, CONTENTS_SOLID, NULL, NULL);
+
+			check_RayTrace_Matches(&tr, &traces[j]);
+
+			hits += tr.fraction < 1.f;
+		}
+	}
+
+	// the test is meaningless unless many, but not all, rays are obstructed
+	ck_assert(hits > NUM_TRACES / 10);
+	ck_assert(hits < NUM_TRACES - NUM_TRACES / 10);
+
+} END_TEST
+
+START_TEST(check_RayTracePacket_occlusion) {
+
+	for (int32_t i = 0; i < NUM_TRACES; i += RAY_PACKET_SIZE) {
+
+		const vec3_t start = Box3_RandomPoint(world);
+
+		vec3_t ends[RAY_PACKET_SIZE];
+		for (int32_t j = 0; j < RAY_PACKET_SIZE; j++) {
+			ends[j] = Box3_RandomPoint(world);
+		}
+
+		cm_trace_t traces[RAY_PACKET_SIZE];
+		RayTracePacket(start, ends, RAY_PACKET_SIZE, 0, CONTENTS_SOLID, RAY_OCCLUSION, traces);
+
+		for (int32_t j = 0; j < RAY_PACKET_SIZE; j++) {
+			const cm_trace_t tr = Cm_BoxTrace(start, ends[j], Box3_Zero(), 0, CONTENTS_SOLID, NULL, NULL);
+
+			ck_assert_int_eq(tr.fraction < 1.f, traces[j].fraction < 1.f);
+		}
+	}
+
+} END_TEST
+
+START_TEST(check_RayTrace_partial) {
+
+	// packets need not be full, and idle rays must not disturb the active ones
+	for (int32_t i = 0; i < NUM_TRACES / 10; i++) {
+
+		const vec3_t start = Box3_RandomPoint(world);
+		const vec3_t end = Box3_RandomPoint(world);
+
+		const cm_trace_t rt = RayTrace(start, end, 0, CONTENTS_SOLID);
+		const cm_trace_t tr = Cm_BoxTrace(start, end, Box3_Zero(), 0, CONTENTS_SOLID, NULL, NULL);
+
+		check_RayTrace_Matches(&tr, &rt);
+	}
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_raytrace");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_RayTracePacket_nearest);
+	tcase_add_test(tcase, check_RayTracePacket_occlusion);
+	tcase_add_test(tcase, check_RayTrace_partial);
+
+	Suite *suite = suite_create("check_raytrace");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
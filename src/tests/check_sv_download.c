@@ -0,0 +1,205 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "server/sv_local.h"
+
+quetoo_t quetoo;
+cvar_t *dedicated;
+
+/**
+ * @brief The server references the client to disconnect it from local games.
+ */
+void Cl_Disconnect(void) {}
+
+#define NUM_FRAGMENTS (DOWNLOAD_WINDOW * 3 + 7)
+
+static sv_client_download_t download;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	memset(&download, 0, sizeof(download));
+
+	download.stream = true;
+	download.num_fragments = NUM_FRAGMENTS;
+
+	quetoo.ticks = 1000;
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {}
+
+/**
+ * @brief Sends every fragment that the window allows, returning how many were sent.
+ */
+static int32_t fill_window(void) {
+
+	int32_t count = 0, fragment;
+	while ((fragment = Sv_NextDownloadFragment(&download)) != -1) {
+		download.sent_time[fragment % DOWNLOAD_WINDOW] = quetoo.ticks;
+		count++;
+	}
+
+	return count;
+}
+
+START_TEST(check_Sv_NextDownloadFragment_window) {
+
+	for (int32_t i = 0; i < DOWNLOAD_WINDOW; i++) {
+		const int32_t fragment = Sv_NextDownloadFragment(&download);
+		ck_assert_int_eq(fragment, i);
+		download.sent_time[fragment % DOWNLOAD_WINDOW] = quetoo.ticks;
+	}
+
+	// the window is full, and nothing is due for retransmission
+	ck_assert_int_eq(Sv_NextDownloadFragment(&download), -1);
+	ck_assert_int_eq(download.next, DOWNLOAD_WINDOW);
+
+	// acknowledging the head of the window admits exactly that many new fragments
+	Sv_AckDownload(&download, 3, 0);
+	ck_assert_int_eq(download.base, 3);
+	ck_assert_int_eq(fill_window(), 3);
+	ck_assert_int_eq(download.next, DOWNLOAD_WINDOW + 3);
+
+	// the last window is bounded by the file
+	while (download.next - download.base == DOWNLOAD_WINDOW) {
+		Sv_AckDownload(&download, download.next, 0);
+		fill_window();
+	}
+
+	ck_assert_int_eq(download.next, NUM_FRAGMENTS);
+	ck_assert(download.next - download.base < DOWNLOAD_WINDOW);
+
+	Sv_AckDownload(&download, NUM_FRAGMENTS, 0);
+	ck_assert_int_eq(download.base, NUM_FRAGMENTS);
+	ck_assert_int_eq(Sv_NextDownloadFragment(&download), -1);
+
+} END_TEST
+
+START_TEST(check_Sv_AckDownload_selective) {
+
+	fill_window();
+
+	// fragments 0 and 1 were lost, but 2, 3 and 5 arrived
+	Sv_AckDownload(&download, 0, (1ull << 2) | (1ull << 3) | (1ull << 5));
+	ck_assert_int_eq(download.base, 0);
+	ck_assert(download.acked == ((1ull << 2) | (1ull << 3) | (1ull << 5)));
+
+	// fragment 0 arrives, but the base may not pass the hole at 1
+	Sv_AckDownload(&download, 1, (1ull << 1) | (1ull << 2) | (1ull << 4));
+	ck_assert_int_eq(download.base, 1);
+	ck_assert(download.acked == ((1ull << 1) | (1ull << 2) | (1ull << 4)));
+
+	// a late acknowledgement of an older base is merged, and does not rewind
+	Sv_AckDownload(&download, 0, (1ull << 7));
+	ck_assert_int_eq(download.base, 1);
+	ck_assert(download.acked & (1ull << 6));
+
+	// filling the hole advances the base past every contiguous fragment
+	Sv_AckDownload(&download, 2, 0);
+	ck_assert_int_eq(download.base, 4);
+	ck_assert(download.acked == ((1ull << 1) | (1ull << 3)));
+
+	Sv_AckDownload(&download, 5, 0);
+	ck_assert_int_eq(download.base, 6);
+	ck_assert(download.acked == (1ull << 1));
+
+} END_TEST
+
+START_TEST(check_Sv_AckDownload_unsent) {
+
+	for (int32_t i = 0; i < 4; i++) {
+		download.sent_time[Sv_NextDownloadFragment(&download) % DOWNLOAD_WINDOW] = quetoo.ticks;
+	}
+
+	// fragments that were never sent may not be acknowledged
+	Sv_AckDownload(&download, 2, ~0ull);
+	ck_assert_int_eq(download.base, 4);
+	ck_assert(download.acked == 0);
+
+	Sv_AckDownload(&download, NUM_FRAGMENTS, 0);
+	ck_assert_int_eq(download.base, 4);
+
+	Sv_AckDownload(&download, -1, 0);
+	ck_assert_int_eq(download.base, 4);
+
+	ck_assert_int_eq(Sv_NextDownloadFragment(&download), 4);
+
+} END_TEST
+
+START_TEST(check_Sv_NextDownloadFragment_retransmit) {
+
+	fill_window();
+
+	Sv_AckDownload(&download, 0, (1ull << 1) | (1ull << 3));
+
+	// nothing is retransmitted before the timeout
+	quetoo.ticks += 100;
+	ck_assert_int_eq(Sv_NextDownloadFragment(&download), -1);
+
+	// after which only the unacknowledged fragments are, oldest first
+	quetoo.ticks += 200;
+
+	int32_t fragment;
+	int32_t count = 0;
+	int32_t last = -1;
+
+	while ((fragment = Sv_NextDownloadFragment(&download)) != -1) {
+		ck_assert(fragment > last);
+		ck_assert(fragment != 1 && fragment != 3);
+		download.sent_time[fragment % DOWNLOAD_WINDOW] = quetoo.ticks;
+		last = fragment;
+		count++;
+	}
+
+	ck_assert_int_eq(count, DOWNLOAD_WINDOW - 2);
+	ck_assert_int_eq(download.next, DOWNLOAD_WINDOW);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_sv_download");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Sv_NextDownloadFragment_window);
+	tcase_add_test(tcase, check_Sv_AckDownload_selective);
+	tcase_add_test(tcase, check_Sv_AckDownload_unsent);
+	tcase_add_test(tcase, check_Sv_NextDownloadFragment_retransmit);
+
+	Suite *suite = suite_create("check_sv_download");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
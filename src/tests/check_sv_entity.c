@@ -0,0 +1,236 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "server/sv_local.h"
+
+quetoo_t quetoo;
+cvar_t *dedicated;
+
+/**
+ * @brief The server references the client to disconnect it from local games.
+ */
+void Cl_Disconnect(void) {}
+
+#define NUM_CLIENTS 3
+#define NUM_ENTITIES 64
+
+/**
+ * @brief The frame every client has acknowledged, and is deltaed from.
+ */
+#define FROM_FRAME 100
+
+static sv_client_t clients[NUM_CLIENTS];
+static entity_state_t entity_states[NUM_CLIENTS * SV_CLIENT_ENTITY_STATES];
+static sv_delta_cache_t delta_cache[MAX_ENTITIES];
+
+static entity_state_t from_states[NUM_ENTITIES], to_states[NUM_ENTITIES];
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	memset(&sv, 0, sizeof(sv));
+	memset(clients, 0, sizeof(clients));
+	memset(delta_cache, 0, sizeof(delta_cache));
+
+	svs.clients = clients;
+	svs.entity_states = entity_states;
+	svs.delta_cache = delta_cache;
+
+	sv.frame_num = FROM_FRAME + 1;
+
+	GRand *rand = g_rand_new_with_seed(1);
+
+	for (int32_t i = 0; i < NUM_ENTITIES; i++) {
+		entity_state_t *s = &from_states[i];
+
+		s->number = i + 1;
+		s->origin = Vec3(g_rand_double_range(rand, -1024.0, 1024.0), 0.f, 0.f);
+		s->model1 = 1;
+		s->solid = SOLID_BOX;
+
+		to_states[i] = *s;
+
+		// a third of the entities move, and entities are born and die
+		if (i % 3 == 0) {
+			to_states[i].origin.y = g_rand_double_range(rand, -1024.0, 1024.0);
+		}
+
+		sv.baselines[s->number] = from_states[i];
+		sv.baselines[s->number].origin = Vec3_Zero();
+	}
+
+	g_rand_free(rand);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	svs.clients = NULL;
+	svs.entity_states = NULL;
+	svs.delta_cache = NULL;
+}
+
+/**
+ * @brief Prepares the client's frames. Entity 1 is the client's own missile, which the
+ * client receives as SOLID_NOT, as Sv_BuildClientFrame would send it.
+ */
+static void check_Sv_PrepareClient(sv_client_t *cl, _Bool packed, _Bool owner) {
+
+	entity_state_t *states = svs.entity_states + (cl - svs.clients) * SV_CLIENT_ENTITY_STATES;
+
+	sv_frame_t *from = &cl->frames[FROM_FRAME & PACKET_MASK];
+	sv_frame_t *to = &cl->frames[sv.frame_num & PACKET_MASK];
+
+	memset(from, 0, sizeof(*from));
+	memset(to, 0, sizeof(*to));
+
+	from->entity_state = 0;
+	to->entity_state = NUM_ENTITIES;
+
+	// the first entity is born, and the last dies
+	for (int32_t i = 1; i < NUM_ENTITIES; i++) {
+		states[from->num_entities++] = from_states[i];
+	}
+
+	for (int32_t i = 0; i < NUM_ENTITIES - 1; i++) {
+		states[to->entity_state + to->num_entities++] = to_states[i];
+	}
+
+	if (owner) {
+		states[to->entity_state].solid = SOLID_NOT;
+	}
+
+	cl->extensions = packed ? PROTOCOL_PACKED_FRAMES : 0;
+	cl->last_frame = FROM_FRAME;
+	cl->next_entity_state = 2 * NUM_ENTITIES;
+}
+
+/**
+ * @brief Writes the client's frame to the specified buffer.
+ */
+static void check_Sv_WriteClientFrame(sv_client_t *cl, mem_buf_t *msg, byte *data, size_t len) {
+
+	Mem_InitBuffer(msg, data, len);
+
+	Sv_WriteClientFrame(cl, msg);
+}
+
+START_TEST(check_Sv_WriteClientFrame_cached) {
+
+	for (int32_t packed = 0; packed < 2; packed++) {
+
+		for (int32_t i = 0; i < NUM_CLIENTS; i++) {
+			check_Sv_PrepareClient(&clients[i], packed, i == NUM_CLIENTS - 1);
+		}
+
+		// encode each client alone, without any help from the cache
+		byte expected[NUM_CLIENTS][MAX_MSG_SIZE];
+		mem_buf_t expected_msg[NUM_CLIENTS];
+
+		for (int32_t i = 0; i < NUM_CLIENTS; i++) {
+			memset(delta_cache, 0, sizeof(delta_cache));
+			check_Sv_WriteClientFrame(&clients[i], &expected_msg[i], expected[i], sizeof(expected[i]));
+		}
+
+		ck_assert(expected_msg[0].size == expected_msg[1].size);
+		ck_assert(!memcmp(expected[0], expected[1], expected_msg[0].size));
+
+		// the owner receives its missile as SOLID_NOT
+		ck_assert(expected_msg[0].size != expected_msg[NUM_CLIENTS - 1].size ||
+				  memcmp(expected[0], expected[NUM_CLIENTS - 1], expected_msg[0].size));
+
+		// then encode them together, so that they share the cache
+		memset(delta_cache, 0, sizeof(delta_cache));
+		atomic_store(&sv.delta_cache_hits, 0);
+		atomic_store(&sv.delta_cache_misses, 0);
+
+		for (int32_t i = 0; i < NUM_CLIENTS; i++) {
+			byte data[MAX_MSG_SIZE];
+			mem_buf_t msg;
+
+			check_Sv_WriteClientFrame(&clients[i], &msg, data, sizeof(data));
+
+			ck_assert_int_eq(expected_msg[i].size, msg.size);
+			ck_assert(!memcmp(expected[i], data, msg.size));
+		}
+
+		// the first client misses every delta, the second hits every delta, and the third
+		// hits every delta but its own missile's
+		ck_assert_int_eq((NUM_CLIENTS - 1) * (NUM_ENTITIES - 1) - 1, atomic_load(&sv.delta_cache_hits));
+		ck_assert_int_eq(NUM_ENTITIES, atomic_load(&sv.delta_cache_misses));
+	}
+
+} END_TEST
+
+START_TEST(check_Sv_WriteClientFrame_stale) {
+
+	byte data[MAX_MSG_SIZE], cached[MAX_MSG_SIZE];
+	mem_buf_t msg, cached_msg;
+
+	check_Sv_PrepareClient(&clients[0], false, false);
+	check_Sv_WriteClientFrame(&clients[0], &msg, data, sizeof(data));
+
+	// in the next frame, an entity moves again, and the deltas cached before are stale
+	sv.frame_num++;
+	to_states[9].origin.z += 64.f;
+
+	check_Sv_PrepareClient(&clients[1], false, false);
+
+	atomic_store(&sv.delta_cache_hits, 0);
+
+	check_Sv_WriteClientFrame(&clients[1], &cached_msg, cached, sizeof(cached));
+	ck_assert_int_eq(0, atomic_load(&sv.delta_cache_hits));
+
+	memset(delta_cache, 0, sizeof(delta_cache));
+
+	check_Sv_WriteClientFrame(&clients[1], &msg, data, sizeof(data));
+
+	ck_assert_int_eq(msg.size, cached_msg.size);
+	ck_assert(!memcmp(data, cached, msg.size));
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_sv_entity");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Sv_WriteClientFrame_cached);
+	tcase_add_test(tcase, check_Sv_WriteClientFrame_stale);
+
+	Suite *suite = suite_create("check_sv_entity");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
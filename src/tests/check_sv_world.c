@@ -0,0 +1,425 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_timer.h>
+
+#include "tests.h"
+#include "server/sv_local.h"
+
+quetoo_t quetoo;
+cvar_t *dedicated;
+
+/**
+ * @brief The server references the client to disconnect it from local games.
+ */
+void Cl_Disconnect(void) {}
+
+/**
+ * @brief The world is a single node, with a single leaf, spanning the entire map.
+ */
+static cm_bsp_plane_t plane;
+static cm_bsp_node_t node;
+static cm_bsp_leaf_t leafs[2];
+static cm_bsp_model_t world;
+
+static g_entity_t entities[MAX_ENTITIES];
+static g_export_t ge;
+
+#define WORLD_SIZE 4096.f
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Cmd_Init();
+
+	Cvar_Init();
+
+	Thread_Init(0);
+
+	sv_threaded_traces = Cvar_Add("sv_threaded_traces", "1", 0, NULL);
+	sv_world_tree = Cvar_Add("sv_world_tree", "1", 0, NULL);
+
+	plane = Cm_Plane(Vec3_Up(), -WORLD_SIZE * 2.f);
+
+	node.plane = &plane;
+	node.children[0] = node.children[1] = -2;
+
+	leafs[1].cluster = -1;
+
+	cm_bsp_t *bsp = Cm_Bsp();
+
+	bsp->nodes = &node;
+	bsp->file.num_nodes = 1;
+
+	bsp->leafs = leafs;
+	bsp->file.num_leafs = lengthof(leafs);
+
+	world.bounds = Box3f(WORLD_SIZE * 2.f, WORLD_SIZE * 2.f, WORLD_SIZE * 2.f);
+
+	memset(entities, 0, sizeof(entities));
+
+	ge.entities = entities;
+	ge.entity_size = sizeof(g_entity_t);
+
+	svs.game = &ge;
+
+	memset(&sv, 0, sizeof(sv));
+	sv.cm_models[0] = &world;
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	svs.game = NULL;
+
+	memset(Cm_Bsp(), 0, sizeof(cm_bsp_t));
+
+	Thread_Shutdown();
+
+	Cvar_Shutdown();
+
+	Cmd_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief Positions the specified entity randomly within the world.
+ */
+static void check_Sv_World_PlaceEntity(GRand *rand, g_entity_t *ent, float extent) {
+
+	const float size = g_rand_double_range(rand, 1.0, 48.0);
+
+	ent->bounds = Box3f(size, size, size);
+	ent->s.origin = Vec3(g_rand_double_range(rand, -extent, extent),
+	                     g_rand_double_range(rand, -extent, extent),
+	                     g_rand_double_range(rand, -extent, extent));
+}
+
+/**
+ * @brief Spawns the specified number of projectiles and corpses.
+ */
+static void check_Sv_World_SpawnEntities(GRand *rand, int32_t count, float extent) {
+
+	Sv_InitWorld();
+
+	for (int32_t i = 1; i < count; i++) {
+		g_entity_t *ent = &entities[i];
+
+		ent->in_use = true;
+		ent->solid = i & 1 ? SOLID_PROJECTILE : SOLID_DEAD;
+
+		check_Sv_World_PlaceEntity(rand, ent, extent);
+
+		Sv_LinkEntity(ent);
+	}
+}
+
+/**
+ * @return The number of entities of the specified type intersecting the specified bounds.
+ */
+static size_t check_Sv_World_BruteForce(const box3_t bounds, int32_t count, uint32_t type) {
+
+	size_t len = 0;
+
+	for (int32_t i = 1; i < count; i++) {
+		const g_entity_t *ent = &entities[i];
+
+		if (!ent->in_use || ent->solid == SOLID_NOT) {
+			continue;
+		}
+
+		if (ent->solid == SOLID_PROJECTILE) {
+			if (!(type & BOX_OCCUPY)) {
+				continue;
+			}
+		} else if (!(type & BOX_COLLIDE)) {
+			continue;
+		}
+
+		if (Box3_Intersects(ent->abs_bounds, bounds)) {
+			len++;
+		}
+	}
+
+	return len;
+}
+
+/**
+ * @brief Asserts that Sv_BoxEntities agrees with a brute force search.
+ */
+static void check_Sv_World_Queries(GRand *rand, int32_t count, float extent) {
+	g_entity_t *list[MAX_ENTITIES];
+
+	for (int32_t i = 0; i < 1000; i++) {
+
+		const float size = g_rand_double_range(rand, 1.0, 512.0);
+		const vec3_t origin = Vec3(g_rand_double_range(rand, -extent, extent),
+		                           g_rand_double_range(rand, -extent, extent),
+		                           g_rand_double_range(rand, -extent, extent));
+
+		const box3_t bounds = Box3_Translate(Box3f(size, size, size), origin);
+
+		const uint32_t type = (i % 3) + 1;
+
+		const size_t len = Sv_BoxEntities(bounds, list, lengthof(list), type);
+		ck_assert_uint_eq(len, check_Sv_World_BruteForce(bounds, count, type));
+
+		for (size_t j = 0; j < len; j++) {
+			ck_assert(Box3_Intersects(list[j]->abs_bounds, bounds));
+		}
+	}
+}
+
+START_TEST(check_Sv_BoxEntities) {
+
+	for (int32_t tree = 0; tree < 2; tree++) {
+
+		Cvar_ForceSetInteger(sv_world_tree->name, tree);
+
+		GRand *rand = g_rand_new_with_seed(1);
+
+		check_Sv_World_SpawnEntities(rand, MAX_ENTITIES, WORLD_SIZE);
+		check_Sv_World_Queries(rand, MAX_ENTITIES, WORLD_SIZE);
+
+		// move some entities, free some others, and make some others non-solid
+		for (int32_t i = 1; i < MAX_ENTITIES; i++) {
+			g_entity_t *ent = &entities[i];
+
+			switch (i % 4) {
+				case 0:
+					ent->s.origin = Vec3_Add(ent->s.origin, Vec3(4.f, -4.f, 4.f));
+					break;
+				case 1:
+					check_Sv_World_PlaceEntity(rand, ent, WORLD_SIZE);
+					break;
+				case 2:
+					ent->in_use = false;
+					break;
+				case 3:
+					ent->solid = SOLID_NOT;
+					break;
+			}
+
+			Sv_LinkEntity(ent);
+		}
+
+		check_Sv_World_Queries(rand, MAX_ENTITIES, WORLD_SIZE);
+
+		// non-solid entities are reset by both partitions, leaving no stale matrices
+		for (int32_t i = 3; i < MAX_ENTITIES; i += 4) {
+			const sv_entity_t *sent = &sv.entities[i];
+			const mat4_t zero = { };
+
+			ck_assert(sent->sector == NULL);
+			ck_assert(sent->tree_node == 0);
+			ck_assert(memcmp(&sent->matrix, &zero, sizeof(zero)) == 0);
+			ck_assert(memcmp(&sent->inverse_matrix, &zero, sizeof(zero)) == 0);
+		}
+
+		// and unlink the rest
+		for (int32_t i = 1; i < MAX_ENTITIES; i++) {
+			Sv_UnlinkEntity(&entities[i]);
+		}
+
+		g_entity_t *list[MAX_ENTITIES];
+		ck_assert_uint_eq(0, Sv_BoxEntities(world.bounds, list, lengthof(list), BOX_ALL));
+
+		memset(entities, 0, sizeof(entities));
+		memset(sv.entities, 0, sizeof(sv.entities));
+
+		g_rand_free(rand);
+	}
+
+} END_TEST
+
+/**
+ * @brief Asserts that the specified batched trace matches its equivalent single trace.
+ */
+static void check_Sv_TraceBatch_Request(const g_trace_request_t *req, const cm_trace_t *trace) {
+
+	const cm_trace_t tr = Sv_Trace(req->start, req->end, req->bounds, req->skip, req->contents);
+
+	ck_assert(tr.fraction == trace->fraction);
+	ck_assert(tr.ent == trace->ent);
+	ck_assert(Vec3_Equal(tr.end, trace->end));
+	ck_assert(tr.start_solid == trace->start_solid);
+	ck_assert(tr.all_solid == trace->all_solid);
+}
+
+START_TEST(check_Sv_TraceBatch) {
+
+	for (int32_t tree = 0; tree < 2; tree++) {
+
+		Cvar_ForceSetInteger(sv_world_tree->name, tree);
+
+		GRand *rand = g_rand_new_with_seed(1);
+
+		const float extent = 1024.f;
+
+		check_Sv_World_SpawnEntities(rand, MAX_ENTITIES, extent);
+
+		g_trace_request_t requests[64];
+		cm_trace_t traces[lengthof(requests)];
+
+		for (int32_t i = 0; i < 100; i++) {
+
+			const g_entity_t *skip = &entities[g_rand_int_range(rand, 1, MAX_ENTITIES)];
+
+			// pellets, fanning out from a common origin, share a broadphase
+			const vec3_t start = skip->s.origin;
+			const vec3_t dir = Vec3_Normalize(Vec3(g_rand_double_range(rand, -1.0, 1.0),
+			                                       g_rand_double_range(rand, -1.0, 1.0),
+			                                       g_rand_double_range(rand, -1.0, 1.0)));
+
+			for (size_t j = 0; j < lengthof(requests); j++) {
+				const vec3_t spread = Vec3(g_rand_double_range(rand, -.1, .1),
+				                           g_rand_double_range(rand, -.1, .1),
+				                           g_rand_double_range(rand, -.1, .1));
+
+				requests[j] = (g_trace_request_t) {
+					.start = start,
+					.end = Vec3_Fmaf(start, extent, Vec3_Add(dir, spread)),
+					.bounds = j & 1 ? Box3_Zero() : Box3f(4.f, 4.f, 4.f),
+					.skip = skip,
+					.contents = CONTENTS_MASK_CLIP_PROJECTILE
+				};
+			}
+
+			Sv_TraceBatch(requests, traces, lengthof(requests));
+
+			for (size_t j = 0; j < lengthof(requests); j++) {
+				check_Sv_TraceBatch_Request(&requests[j], &traces[j]);
+			}
+
+			// while unrelated traces are clipped individually
+			for (size_t j = 0; j < lengthof(requests); j++) {
+				requests[j].start = Vec3(g_rand_double_range(rand, -extent, extent),
+				                         g_rand_double_range(rand, -extent, extent),
+				                         g_rand_double_range(rand, -extent, extent));
+				requests[j].end = Vec3(g_rand_double_range(rand, -extent, extent),
+				                       g_rand_double_range(rand, -extent, extent),
+				                       g_rand_double_range(rand, -extent, extent));
+				requests[j].skip = NULL;
+			}
+
+			Sv_TraceBatch(requests, traces, lengthof(requests));
+
+			for (size_t j = 0; j < lengthof(requests); j++) {
+				check_Sv_TraceBatch_Request(&requests[j], &traces[j]);
+			}
+		}
+
+		memset(entities, 0, sizeof(entities));
+		memset(sv.entities, 0, sizeof(sv.entities));
+
+		g_rand_free(rand);
+	}
+
+} END_TEST
+
+START_TEST(check_Sv_BoxEntities_benchmark) {
+
+	const double ms = 1000.0 / SDL_GetPerformanceFrequency();
+
+	for (int32_t tree = 0; tree < 2; tree++) {
+
+		Cvar_ForceSetInteger(sv_world_tree->name, tree);
+
+		GRand *rand = g_rand_new_with_seed(1);
+
+		// a large room, straddling the sector divisions at its center
+		const float extent = 1024.f;
+
+		check_Sv_World_SpawnEntities(rand, MAX_ENTITIES, extent);
+
+		uint64_t link = 0, query = 0;
+		size_t num_box_entities = 0;
+
+		for (int32_t frame = 0; frame < 100; frame++) {
+
+			uint64_t start = SDL_GetPerformanceCounter();
+
+			for (int32_t i = 1; i < MAX_ENTITIES; i++) {
+				g_entity_t *ent = &entities[i];
+
+				if (ent->solid == SOLID_PROJECTILE) {
+					ent->s.origin = Vec3_Add(ent->s.origin, Vec3(g_rand_double_range(rand, -24.0, 24.0),
+					                                             g_rand_double_range(rand, -24.0, 24.0),
+					                                             g_rand_double_range(rand, -24.0, 24.0)));
+				}
+
+				Sv_LinkEntity(ent);
+			}
+
+			link += SDL_GetPerformanceCounter() - start;
+
+			start = SDL_GetPerformanceCounter();
+
+			for (int32_t i = 1; i < MAX_ENTITIES; i++) {
+				g_entity_t *list[MAX_ENTITIES];
+
+				const box3_t bounds = Box3_Expand(entities[i].abs_bounds, 32.f);
+				num_box_entities += Sv_BoxEntities(bounds, list, lengthof(list), BOX_ALL);
+			}
+
+			query += SDL_GetPerformanceCounter() - start;
+		}
+
+		Com_Print("%s: link %.2f ms, query %.2f ms per frame of %d entities (%zu results)\n",
+		          tree ? "tree" : "sectors", link * ms / 100.0, query * ms / 100.0, MAX_ENTITIES - 1, num_box_entities);
+
+		memset(entities, 0, sizeof(entities));
+		memset(sv.entities, 0, sizeof(sv.entities));
+
+		g_rand_free(rand);
+	}
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_sv_world");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Sv_BoxEntities);
+	tcase_add_test(tcase, check_Sv_TraceBatch);
+	tcase_add_test(tcase, check_Sv_BoxEntities_benchmark);
+
+	Suite *suite = suite_create("check_sv_world");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -81,6 +81,141 @@ START_TEST(check_Thread_Wait) {
 
 } END_TEST
 
+/**
+ * @brief JobRangeFunc accumulating the sum of its indices.
+ */
+static void sum(int32_t begin, int32_t end, void *data) {
+
+	for (int32_t i = begin; i < end; i++) {
+		SDL_AtomicAdd((SDL_atomic_t *) data, i);
+	}
+}
+
+START_TEST(check_Job_ParallelFor) {
+	SDL_atomic_t total;
+
+	for (int32_t count = 0; count < 10000; count = count * 2 + 1) {
+		for (int32_t grain = 0; grain < 4; grain++) {
+			SDL_AtomicSet(&total, 0);
+
+			Job_ParallelFor(count, grain, sum, &total);
+
+			ck_assert_int_eq(count * (count - 1) / 2, SDL_AtomicGet(&total));
+		}
+	}
+
+} END_TEST
+
+/**
+ * @brief JobFunc appending the next step number, asserting the dependency order.
+ */
+static void step(void *data) {
+	SDL_atomic_t *steps = (SDL_atomic_t *) data;
+
+	ck_assert(SDL_AtomicGet(steps) < 8);
+
+	SDL_AtomicIncRef(steps);
+}
+
+/**
+ * @brief JobFunc asserting that all of its dependencies have run.
+ */
+static void final(void *data) {
+	ck_assert_int_eq(8, SDL_AtomicGet((SDL_atomic_t *) data));
+}
+
+START_TEST(check_Job_RunAfter) {
+	job_counter_t first, second;
+	SDL_atomic_t steps;
+
+	memset(&first, 0, sizeof(first));
+	memset(&second, 0, sizeof(second));
+
+	SDL_AtomicSet(&steps, 0);
+
+	for (int32_t i = 0; i < 8; i++) {
+		Job_Run(&first, step, &steps);
+	}
+
+	Job_RunAfter(&first, &second, final, &steps);
+
+	Job_Wait(&second);
+
+	ck_assert(Job_Done(&first));
+	ck_assert_int_eq(8, SDL_AtomicGet(&steps));
+
+} END_TEST
+
+static SDL_atomic_t released, stalled;
+
+/**
+ * @brief ThreadRunFunc occupying a worker until released. If the main thread runs it
+ * while waiting on other work, it is flagged and returns immediately instead.
+ */
+static void background(void *data) {
+
+	if (SDL_ThreadID() == thread_main) {
+		SDL_AtomicIncRef(&stalled);
+		return;
+	}
+
+	while (!SDL_AtomicGet(&released)) {
+		SDL_Delay(1);
+	}
+}
+
+/**
+ * @brief ThreadRunFunc taking a while to complete, which is also flagged if it is run
+ * by the main thread.
+ */
+static void timer(void *data) {
+
+	if (SDL_ThreadID() == thread_main) {
+		SDL_AtomicIncRef(&stalled);
+	}
+
+	SDL_Delay(100);
+}
+
+/**
+ * @brief JobFunc doing nothing.
+ */
+static void noop(void *data) {
+}
+
+START_TEST(check_Job_RunBackground) {
+	thread_t *threads[4];
+
+	SDL_AtomicSet(&released, 0);
+	SDL_AtomicSet(&stalled, 0);
+
+	// the timer occupies one worker, and the rest of the threads the other, or the queue
+	thread_t *t = Thread_Create(timer, NULL, 0);
+
+	for (size_t i = 0; i < lengthof(threads); i++) {
+		threads[i] = Thread_Create(background, NULL, 0);
+	}
+
+	// waiting on work which follows the timer must not pick up the queued threads
+	job_counter_t counter;
+	memset(&counter, 0, sizeof(counter));
+
+	Job_RunAfter(&t->counter, &counter, noop, NULL);
+
+	Job_Wait(&counter);
+
+	ck_assert_int_eq(0, SDL_AtomicGet(&stalled));
+
+	SDL_AtomicSet(&released, 1);
+
+	Thread_Wait(t);
+
+	for (size_t i = 0; i < lengthof(threads); i++) {
+		Thread_Wait(threads[i]);
+	}
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -92,6 +227,9 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_checked_fixture(tcase, setup, teardown);
 
 	tcase_add_test(tcase, check_Thread_Wait);
+	tcase_add_test(tcase, check_Job_ParallelFor);
+	tcase_add_test(tcase, check_Job_RunAfter);
+	tcase_add_test(tcase, check_Job_RunBackground);
 
 	Suite *suite = suite_create("check_threads");
 	suite_add_tcase(suite, tcase);
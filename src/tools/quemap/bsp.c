@@ -72,6 +72,7 @@ static void PrintBSPFileSizes(void) {
 
 	Com_Verbose("      lightmap    %7i bytes\n", bsp_file.lightmap_size);
 	Com_Verbose("      lightgrid   %7i bytes\n", bsp_file.lightgrid_size);
+	Com_Verbose("      vis         %7i bytes\n", bsp_file.vis_size);
 }
 
 /**
@@ -145,87 +145,314 @@ csg_brush_t *MakeBrushes(int32_t index, int32_t count) {
 		Progress("Creating brushes", i * 100.f / count);
 	}
 
-	Com_Print("\r%-24s [100%%] %d ms\n", "Creating brushes", SDL_GetTicks() - start);
+	WorkReport("Creating brushes", SDL_GetTicks() - start);
 
 	return list;
 }
 
 /**
- * @brief
+ * @brief Returns true if b1 is allowed to bite b2
  */
-static csg_brush_t *AddBrushToBrushes(csg_brush_t *list, csg_brush_t *tail) {
-	csg_brush_t *walk, *next;
-
-	for (walk = list; walk; walk = next) { // add to end of list
-		next = walk->next;
-		walk->next = NULL;
-		tail->next = walk;
-		tail = walk;
+static inline _Bool BrushGE(const csg_brush_t *b1, const csg_brush_t *b2) {
+	// detail brushes never bite structural brushes
+	if ((b1->original->contents & CONTENTS_DETAIL) && !(b2->original->contents & CONTENTS_DETAIL)) {
+		return false;
 	}
+	if (b1->original->contents & CONTENTS_SOLID) {
+		return true;
+	}
+	return false;
+}
 
-	return tail;
+/**
+ * @brief The size of the grid cells by which brushes are indexed for subtraction.
+ */
+#define CSG_CELL_SIZE 128.f
+
+/**
+ * @brief Brushes spanning more grid cells than this are tested against every brush.
+ */
+#define CSG_MAX_CELLS 64
+
+/**
+ * @brief A brush awaiting subtraction. Brushes are processed from the front of a list
+ * which is reversed each time a brush is subtracted, and to which fragments are appended.
+ * The list is doubly linked with an orientation, so that these operations are constant
+ * time, and each brush carries an ordinal so that candidates may be sorted into list order.
+ */
+typedef struct csg_node_s {
+	csg_brush_t *brush;
+	struct csg_node_s *prev, *next;
+	int64_t ordinal;
+
+	/**
+	 * @brief The range of grid cells the brush is indexed in, unless it is too large to
+	 * be indexed in cells.
+	 */
+	int32_t cells[3][2];
+	_Bool large;
+
+	/**
+	 * @brief The query that most recently visited this brush.
+	 */
+	uint32_t query;
+} csg_node_t;
+
+/**
+ * @brief The brushes awaiting subtraction, and the grid by which they are indexed.
+ */
+typedef struct {
+	csg_node_t *head, *tail;
+	_Bool reversed;
+	int64_t min_ordinal, max_ordinal;
+
+	GHashTable *cells;
+	GPtrArray *large;
+	uint32_t query;
+} csg_list_t;
+
+/**
+ * @return The grid cell containing the specified coordinate.
+ */
+static int32_t CsgCell(float f) {
+	return (int32_t) floorf(Clampf(f, -MAX_WORLD_COORD, MAX_WORLD_COORD) / CSG_CELL_SIZE);
 }
 
 /**
- * @brief Builds a new list that doesn't hold the given brush.
+ * @return The hash table key for the specified grid cell.
  */
-static csg_brush_t *RemoveBrushFromBrushes(csg_brush_t *list, const csg_brush_t *skip) {
-	csg_brush_t *next;
-	csg_brush_t *new_list = NULL;
+static gpointer CsgCellKey(int32_t x, int32_t y, int32_t z) {
+	const int32_t offset = MAX_WORLD_COORD / CSG_CELL_SIZE + 1;
+	return GINT_TO_POINTER((x + offset) | ((y + offset) << 10) | ((z + offset) << 20));
+}
 
-	for (; list; list = next) {
-		next = list->next;
-		if (list == skip) {
-			FreeBrush(list);
-			continue;
+/**
+ * @brief Adds the node to or removes it from the grid cells its brush occupies.
+ */
+static void CsgIndexNode(csg_list_t *list, csg_node_t *node, _Bool add) {
+
+	if (node->large) {
+		if (add) {
+			g_ptr_array_add(list->large, node);
+		} else {
+			g_ptr_array_remove_fast(list->large, node);
+		}
+		return;
+	}
+
+	for (int32_t z = node->cells[2][0]; z <= node->cells[2][1]; z++) {
+		for (int32_t y = node->cells[1][0]; y <= node->cells[1][1]; y++) {
+			for (int32_t x = node->cells[0][0]; x <= node->cells[0][1]; x++) {
+
+				gpointer key = CsgCellKey(x, y, z);
+				GPtrArray *cell = g_hash_table_lookup(list->cells, key);
+
+				if (add) {
+					if (!cell) {
+						cell = g_ptr_array_new();
+						g_hash_table_insert(list->cells, key, cell);
+					}
+					g_ptr_array_add(cell, node);
+				} else {
+					g_ptr_array_remove_fast(cell, node);
+				}
+			}
 		}
-		list->next = new_list;
-		new_list = list;
 	}
-	return new_list;
 }
 
 /**
- * @brief Returns true if b1 is allowed to bite b2
+ * @brief Appends the brush to the end of the list, and indexes it.
  */
-static inline _Bool BrushGE(const csg_brush_t *b1, const csg_brush_t *b2) {
-	// detail brushes never bite structural brushes
-	if ((b1->original->contents & CONTENTS_DETAIL) && !(b2->original->contents & CONTENTS_DETAIL)) {
-		return false;
+static void CsgAppendBrush(csg_list_t *list, csg_brush_t *brush) {
+
+	csg_node_t *node = Mem_Malloc(sizeof(*node));
+	node->brush = brush;
+
+	if (list->reversed) {
+		node->ordinal = --list->min_ordinal;
+		node->next = list->head;
+		if (list->head) {
+			list->head->prev = node;
+		} else {
+			list->tail = node;
+		}
+		list->head = node;
+	} else {
+		node->ordinal = ++list->max_ordinal;
+		node->prev = list->tail;
+		if (list->tail) {
+			list->tail->next = node;
+		} else {
+			list->head = node;
+		}
+		list->tail = node;
 	}
-	if (b1->original->contents & CONTENTS_SOLID) {
-		return true;
+
+	int32_t num_cells = 1;
+	for (int32_t i = 0; i < 3; i++) {
+		node->cells[i][0] = CsgCell(brush->bounds.mins.xyz[i]);
+		node->cells[i][1] = CsgCell(brush->bounds.maxs.xyz[i]);
+		num_cells *= node->cells[i][1] - node->cells[i][0] + 1;
+	}
+
+	node->large = num_cells > CSG_MAX_CELLS;
+
+	CsgIndexNode(list, node, true);
+}
+
+/**
+ * @brief Removes the node from the list and the index, returning its brush.
+ */
+static csg_brush_t *CsgRemoveNode(csg_list_t *list, csg_node_t *node) {
+
+	CsgIndexNode(list, node, false);
+
+	if (node->prev) {
+		node->prev->next = node->next;
+	} else {
+		list->head = node->next;
+	}
+
+	if (node->next) {
+		node->next->prev = node->prev;
+	} else {
+		list->tail = node->prev;
+	}
+
+	csg_brush_t *brush = node->brush;
+	Mem_Free(node);
+
+	return brush;
+}
+
+/**
+ * @return The node at the front of the list.
+ */
+static csg_node_t *CsgFront(const csg_list_t *list) {
+	return list->reversed ? list->tail : list->head;
+}
+
+/**
+ * @brief GCompareDataFunc sorting nodes into list order.
+ */
+static gint CsgNodeCmp(gconstpointer a, gconstpointer b, gpointer data) {
+
+	const int64_t oa = (*(const csg_node_t **) a)->ordinal;
+	const int64_t ob = (*(const csg_node_t **) b)->ordinal;
+
+	const gint cmp = oa < ob ? -1 : oa > ob ? 1 : 0;
+	return ((const csg_list_t *) data)->reversed ? -cmp : cmp;
+}
+
+/**
+ * @brief Populates candidates with the nodes whose brushes' bounds intersect those of
+ * the specified node, in list order.
+ */
+static void CsgCandidates(csg_list_t *list, const csg_node_t *node, GPtrArray *candidates) {
+
+	g_ptr_array_set_size(candidates, 0);
+
+	const uint32_t query = ++list->query;
+	const box3_t bounds = node->brush->bounds;
+
+	if (node->large) {
+		for (csg_node_t *n = list->head; n; n = n->next) {
+			if (n != node && Box3_Intersects(bounds, n->brush->bounds)) {
+				g_ptr_array_add(candidates, n);
+			}
+		}
+	} else {
+		for (int32_t z = node->cells[2][0]; z <= node->cells[2][1]; z++) {
+			for (int32_t y = node->cells[1][0]; y <= node->cells[1][1]; y++) {
+				for (int32_t x = node->cells[0][0]; x <= node->cells[0][1]; x++) {
+
+					const GPtrArray *cell = g_hash_table_lookup(list->cells, CsgCellKey(x, y, z));
+					if (!cell) {
+						continue;
+					}
+
+					for (guint i = 0; i < cell->len; i++) {
+						csg_node_t *n = g_ptr_array_index(cell, i);
+
+						if (n == node || n->query == query) {
+							continue;
+						}
+
+						n->query = query;
+
+						if (Box3_Intersects(bounds, n->brush->bounds)) {
+							g_ptr_array_add(candidates, n);
+						}
+					}
+				}
+			}
+		}
+
+		for (guint i = 0; i < list->large->len; i++) {
+			csg_node_t *n = g_ptr_array_index(list->large, i);
+
+			if (Box3_Intersects(bounds, n->brush->bounds)) {
+				g_ptr_array_add(candidates, n);
+			}
+		}
+	}
+
+	g_ptr_array_sort_with_data(candidates, CsgNodeCmp, list);
+}
+
+/**
+ * @brief Appends the brushes to the end of the list.
+ */
+static void CsgAppendBrushes(csg_list_t *list, csg_brush_t *brushes) {
+
+	csg_brush_t *next;
+	for (csg_brush_t *b = brushes; b; b = next) {
+		next = b->next;
+		b->next = NULL;
+
+		CsgAppendBrush(list, b);
 	}
-	return false;
 }
 
 /**
  * @brief Carves any intersecting solid brushes into the minimum number
  * of non-intersecting brushes.
+ * @details Brushes are taken from the front of the list, and subtracted from the brushes
+ * that follow them. When a brush is subtracted, its fragments are appended to the list,
+ * the list is reversed, and the search begins anew. Only brushes whose bounds intersect
+ * are tested, by way of a grid, but in the order of an exhaustive search.
  */
 csg_brush_t *SubtractBrushes(csg_brush_t *head) {
 
 	const uint32_t start = SDL_GetTicks();
-	
-	size_t head_count = CountBrushes(head);
+
+	const size_t head_count = CountBrushes(head);
+
+	csg_list_t list = {
+		.cells = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_ptr_array_unref),
+		.large = g_ptr_array_new()
+	};
+
+	CsgAppendBrushes(&list, head);
+
+	GPtrArray *candidates = g_ptr_array_new();
 
 	csg_brush_t *keep = NULL;
 
-newlist:
-	if (!head) {
-		return NULL;
-	}
+	csg_node_t *n1;
+	while ((n1 = CsgFront(&list))) {
 
-	csg_brush_t *tail = head;
-	for (; tail->next; tail = tail->next) {
-		// find tail
-	}
+		csg_brush_t *b1 = n1->brush;
+
+		CsgCandidates(&list, n1, candidates);
+
+		_Bool intersects = false;
+
+		for (guint i = 0; i < candidates->len && !intersects; i++) {
+			csg_node_t *n2 = g_ptr_array_index(candidates, i);
+			csg_brush_t *b2 = n2->brush;
 
-	csg_brush_t *next;
-	for (csg_brush_t *b1 = head; b1; b1 = next) {
-		next = b1->next;
-		csg_brush_t *b2 = next;
-		for (; b2; b2 = b2->next) {
 			if (BrushesDisjoint(b1, b2)) {
 				continue;
 			}
@@ -242,8 +469,9 @@ newlist:
 					continue; // didn't really intersect
 				}
 				if (!sub1) { // b1 is swallowed by b2
-					head = RemoveBrushFromBrushes(b1, b1);
-					goto newlist;
+					FreeBrush(CsgRemoveNode(&list, n1));
+					intersects = true;
+					break;
 				}
 				c1 = CountBrushes(sub1);
 			}
@@ -251,12 +479,14 @@ newlist:
 			if (BrushGE(b1, b2)) {
 				sub2 = SubtractBrush(b2, b1);
 				if (sub2 == b2) {
+					FreeBrushes(sub1);
 					continue; // didn't really intersect
 				}
 				if (!sub2) { // b2 is swallowed by b1
 					FreeBrushes(sub1);
-					head = RemoveBrushFromBrushes(b1, b2);
-					goto newlist;
+					FreeBrush(CsgRemoveNode(&list, n2));
+					intersects = true;
+					break;
 				}
 				c2 = CountBrushes(sub2);
 			}
@@ -281,20 +511,24 @@ newlist:
 				if (sub2) {
 					FreeBrushes(sub2);
 				}
-				tail = AddBrushToBrushes(sub1, tail);
-				head = RemoveBrushFromBrushes(b1, b1);
-				goto newlist;
+				CsgAppendBrushes(&list, sub1);
+				FreeBrush(CsgRemoveNode(&list, n1));
 			} else {
 				if (sub1) {
 					FreeBrushes(sub1);
 				}
-				tail = AddBrushToBrushes(sub2, tail);
-				head = RemoveBrushFromBrushes(b1, b2);
-				goto newlist;
+				CsgAppendBrushes(&list, sub2);
+				FreeBrush(CsgRemoveNode(&list, n2));
 			}
+
+			intersects = true;
 		}
 
-		if (!b2) { // b1 is no longer intersecting anything, so keep it
+		if (intersects) {
+			list.reversed = !list.reversed;
+		} else { // b1 is no longer intersecting anything, so keep it
+			CsgRemoveNode(&list, n1);
+
 			b1->next = keep;
 			keep = b1;
 		}
@@ -302,9 +536,13 @@ newlist:
 		Progress("Subtracting brushes", -1);
 	}
 
+	g_ptr_array_free(candidates, true);
+	g_ptr_array_free(list.large, true);
+	g_hash_table_destroy(list.cells);
+
 	Com_Verbose("SubtractBrushes: %zi / %zi\n", head_count, CountBrushes(keep));
 
-	Com_Print("\r%-24s [100%%] %d ms\n", "Subtracting brushes", SDL_GetTicks() - start);
+	WorkReport("Subtracting brushes", SDL_GetTicks() - start);
 
 	return keep;
 }
@@ -391,12 +391,70 @@ int32_t EmitFace(const face_t *face) {
 #define MAX_PHONG_FACES 256
 
 /**
- * @brief Populate phong_faces with pointers to all Phong shaded faces referencing the vertex.
- * @return The number of Phong shaded bsp_face_t's referencing the vertex.
+ * @brief Phong shaded face vertexes are hashed by quantized position and texinfo value,
+ * so that the faces sharing a vertex are found without visiting every face.
  */
-static size_t PhongFacesForVertex(const bsp_vertex_t *vertex, int32_t value, const bsp_face_t **phong_faces) {
+typedef struct {
+	vec3i_t cell;
+	int32_t value;
+} phong_key_t;
 
-	size_t count = 0;
+/**
+ * @brief A Phong shaded face vertex.
+ */
+typedef struct {
+	int32_t face_num;
+	int32_t vertex_num;
+} phong_vertex_t;
+
+static GHashTable *phong_spatial_hash;
+
+/**
+ * @brief
+ */
+static phong_key_t GetPhongKey(const vec3_t p, int32_t value) {
+
+	return (phong_key_t) {
+		.cell = Vec3i(floorf(p.x / VERTEX_EPSILON), floorf(p.y / VERTEX_EPSILON), floorf(p.z / VERTEX_EPSILON)),
+		.value = value
+	};
+}
+
+/**
+ * @brief
+ */
+static guint PhongSpatialHashFunc(const phong_key_t *key) {
+
+	return ((guint) key->cell.x * 73856093u) ^
+	       ((guint) key->cell.y * 19349663u) ^
+	       ((guint) key->cell.z * 83492791u) ^ (guint) key->value;
+}
+
+/**
+ * @brief
+ */
+static gboolean PhongSpatialHashEqualFunc(const phong_key_t *a, const phong_key_t *b) {
+
+	return a->cell.x == b->cell.x && a->cell.y == b->cell.y && a->cell.z == b->cell.z && a->value == b->value;
+}
+
+/**
+ * @brief
+ */
+static void PhongSpatialHashValueDestroyFunc(GArray *array) {
+
+	g_array_free(array, true);
+}
+
+/**
+ * @brief Hashes the vertexes of all Phong shaded faces, for PhongVertex.
+ */
+void BuildPhongSpatialHash(void) {
+
+	phong_spatial_hash = g_hash_table_new_full((GHashFunc) PhongSpatialHashFunc,
+											   (GEqualFunc) PhongSpatialHashEqualFunc,
+											   Mem_Free,
+											   (GDestroyNotify) PhongSpatialHashValueDestroyFunc);
 
 	const bsp_face_t *face = bsp_file.faces;
 	for (int32_t i = 0; i < bsp_file.num_faces; i++, face++) {
@@ -406,23 +464,106 @@ static size_t PhongFacesForVertex(const bsp_vertex_t *vertex, int32_t value, con
 			continue;
 		}
 
-		if (texinfo->value != value) {
+		for (int32_t j = 0; j < face->num_vertexes; j++) {
+
+			const phong_vertex_t vertex = {
+				.face_num = i,
+				.vertex_num = face->first_vertex + j
+			};
+
+			const phong_key_t key = GetPhongKey(bsp_file.vertexes[vertex.vertex_num].position, texinfo->value);
+			GArray *array = g_hash_table_lookup(phong_spatial_hash, &key);
+
+			if (!array) {
+				array = g_array_new(false, false, sizeof(phong_vertex_t));
+
+				phong_key_t *key_copy = Mem_Malloc(sizeof(key));
+				*key_copy = key;
+
+				g_hash_table_insert(phong_spatial_hash, key_copy, array);
+			}
+
+			g_array_append_val(array, vertex);
+		}
+	}
+}
+
+/**
+ * @brief Frees the Phong vertex hash.
+ */
+void FreePhongSpatialHash(void) {
+
+	if (phong_spatial_hash) {
+		g_hash_table_destroy(phong_spatial_hash);
+		phong_spatial_hash = NULL;
+	}
+}
+
+/**
+ * @brief GCompareFunc for sorting face numbers.
+ */
+static gint PhongFaceNumCmp(gconstpointer a, gconstpointer b) {
+	return *(const int32_t *) a - *(const int32_t *) b;
+}
+
+/**
+ * @brief Populate phong_faces with pointers to all Phong shaded faces referencing the vertex.
+ * @details The faces are resolved from the Phong vertex hash, and then visited in the order
+ * of the BSP file, so that the vertex normal is accumulated identically to an exhaustive search.
+ * @return The number of Phong shaded bsp_face_t's referencing the vertex.
+ */
+static size_t PhongFacesForVertex(const bsp_vertex_t *vertex, int32_t value, const bsp_face_t **phong_faces) {
+
+	GArray *face_nums = g_array_new(false, false, sizeof(int32_t));
+
+	// any vertex within VERTEX_EPSILON must be in this cell, or in one adjacent to it
+	const phong_key_t key = GetPhongKey(vertex->position, value);
+
+	for (int32_t z = -1; z <= 1; z++) {
+		for (int32_t y = -1; y <= 1; y++) {
+			for (int32_t x = -1; x <= 1; x++) {
+
+				const phong_key_t k = {
+					.cell = Vec3i(key.cell.x + x, key.cell.y + y, key.cell.z + z),
+					.value = value
+				};
+
+				const GArray *array = g_hash_table_lookup(phong_spatial_hash, &k);
+				if (!array) {
+					continue;
+				}
+
+				for (guint i = 0; i < array->len; i++) {
+					const phong_vertex_t *v = &g_array_index(array, phong_vertex_t, i);
+
+					if (Vec3_Distance(vertex->position, bsp_file.vertexes[v->vertex_num].position) < VERTEX_EPSILON) {
+						g_array_append_val(face_nums, v->face_num);
+					}
+				}
+			}
+		}
+	}
+
+	g_array_sort(face_nums, PhongFaceNumCmp);
+
+	size_t count = 0;
+
+	for (guint i = 0; i < face_nums->len; i++) {
+
+		const int32_t face_num = g_array_index(face_nums, int32_t, i);
+
+		if (i && face_num == g_array_index(face_nums, int32_t, i - 1)) {
 			continue;
 		}
 
+		const bsp_face_t *face = &bsp_file.faces[face_num];
+
 		const bsp_plane_t *plane = &bsp_file.planes[face->plane_num];
 		if (Vec3_Dot(vertex->normal, plane->normal) < 0.f) {
 			continue;
 		}
 
-		const bsp_vertex_t *v = &bsp_file.vertexes[face->first_vertex];
-		for (int32_t j = 0; j < face->num_vertexes; j++, v++) {
-
-			if (Vec3_Distance(vertex->position, v->position) < VERTEX_EPSILON) {
-				phong_faces[count++] = face;
-				break;
-			}
-		}
+		phong_faces[count++] = face;
 
 		if (count == MAX_PHONG_FACES) {
 			Mon_SendPoint(MON_ERROR, vertex->position, "MAX_PHONG_FACES");
@@ -430,6 +571,8 @@ static size_t PhongFacesForVertex(const bsp_vertex_t *vertex, int32_t value, con
 		}
 	}
 
+	g_array_free(face_nums, true);
+
 	return count;
 }
 
@@ -281,55 +281,257 @@ void FreeLights(void) {
 }
 
 /**
- * @return A GPtrArray of all light sources that intersect the specified bounds.
+ * @brief The light index is a bounding volume hierarchy over the bounds of all attenuated
+ * light sources, so that the light sources reaching a node or leaf are resolved without
+ * testing every light source.
  */
-static GPtrArray *BoxLights(const box3_t bounds) {
+typedef struct {
+	/**
+	 * @brief The bounds of all light sources beneath this node.
+	 */
+	box3_t bounds;
+
+	/**
+	 * @brief The second child of internal nodes. The first child immediately follows its parent.
+	 */
+	int32_t child;
+
+	/**
+	 * @brief The light sources of leaf nodes, as a range of the sorted light indexes.
+	 */
+	int32_t first_light;
+	int32_t num_lights;
+} light_node_t;
+
+#define LIGHT_NODE_LIGHTS 4
+#define LIGHT_NODE_STACK 64
+
+static struct {
+	/**
+	 * @brief The bounds of each light source.
+	 */
+	box3_t *bounds;
+
+	/**
+	 * @brief The indexes of the attenuated light sources, sorted by node.
+	 */
+	int32_t *lights;
+	int32_t num_lights;
+
+	light_node_t *nodes;
+	int32_t num_nodes;
+} light_index;
+
+/**
+ * @brief Sorts light indexes by the center of their bounds along the specified axis.
+ */
+static gint LightIndexCmp(gconstpointer a, gconstpointer b, gpointer data) {
+
+	const int32_t axis = GPOINTER_TO_INT(data);
+
+	const float a_center = Box3_Center(light_index.bounds[*(const int32_t *) a]).xyz[axis];
+	const float b_center = Box3_Center(light_index.bounds[*(const int32_t *) b]).xyz[axis];
+
+	return a_center < b_center ? -1 : a_center > b_center ? 1 : 0;
+}
+
+/**
+ * @brief Recursively builds the light index over the specified range of light indexes,
+ * splitting at the median of the longest axis of their centers.
+ * @return The node number.
+ */
+static int32_t BuildLightNode(int32_t first_light, int32_t num_lights, int32_t depth) {
+
+	const int32_t node_num = light_index.num_nodes++;
+	light_node_t *node = &light_index.nodes[node_num];
+
+	node->bounds = Box3_Null();
+
+	box3_t centers = Box3_Null();
+
+	for (int32_t i = first_light; i < first_light + num_lights; i++) {
+		const box3_t bounds = light_index.bounds[light_index.lights[i]];
+
+		node->bounds = Box3_Union(node->bounds, bounds);
+		centers = Box3_Append(centers, Box3_Center(bounds));
+	}
+
+	if (num_lights <= LIGHT_NODE_LIGHTS || depth == LIGHT_NODE_STACK - 1) {
+		node->first_light = first_light;
+		node->num_lights = num_lights;
+		return node_num;
+	}
+
+	const vec3_t size = Box3_Size(centers);
+
+	int32_t axis = 0;
+	if (size.y > size.xyz[axis]) {
+		axis = 1;
+	}
+	if (size.z > size.xyz[axis]) {
+		axis = 2;
+	}
+
+	g_qsort_with_data(light_index.lights + first_light, num_lights, sizeof(int32_t),
+					  LightIndexCmp, GINT_TO_POINTER(axis));
+
+	const int32_t half = num_lights / 2;
 
-	GPtrArray *box_lights = g_ptr_array_new();
+	BuildLightNode(first_light, half, depth + 1);
+
+	const int32_t child = BuildLightNode(first_light + half, num_lights - half, depth + 1);
+
+	light_index.nodes[node_num].child = child;
+	return node_num;
+}
+
+/**
+ * @brief Builds the light index over all attenuated light sources.
+ */
+static void BuildLightIndex(void) {
+
+	memset(&light_index, 0, sizeof(light_index));
+
+	if (lights->len == 0) {
+		return;
+	}
+
+	light_index.bounds = Mem_TagMalloc(lights->len * sizeof(box3_t), MEM_TAG_LIGHT);
+	light_index.lights = Mem_TagMalloc(lights->len * sizeof(int32_t), MEM_TAG_LIGHT);
 
 	const light_t *light = (light_t *) lights->data;
 	for (guint i = 0; i < lights->len; i++, light++) {
 
-		if (light->atten != LIGHT_ATTEN_NONE) {
-			const float radius = light->radius + light->size * .5f;
-			const box3_t light_bounds = Box3_FromCenterRadius(light->origin, radius);
-			if (!Box3_Intersects(bounds, light_bounds)) {
+		if (light->atten == LIGHT_ATTEN_NONE) {
+			continue;
+		}
+
+		const float radius = light->radius + light->size * .5f;
+
+		light_index.bounds[i] = Box3_FromCenterRadius(light->origin, radius);
+		light_index.lights[light_index.num_lights++] = (int32_t) i;
+	}
+
+	if (light_index.num_lights) {
+		light_index.nodes = Mem_TagMalloc(light_index.num_lights * 2 * sizeof(light_node_t), MEM_TAG_LIGHT);
+		BuildLightNode(0, light_index.num_lights, 0);
+	}
+}
+
+/**
+ * @brief Frees the light index.
+ */
+static void FreeLightIndex(void) {
+
+	if (light_index.bounds) {
+		Mem_Free(light_index.bounds);
+	}
+
+	if (light_index.lights) {
+		Mem_Free(light_index.lights);
+	}
+
+	if (light_index.nodes) {
+		Mem_Free(light_index.nodes);
+	}
+
+	memset(&light_index, 0, sizeof(light_index));
+}
+
+/**
+ * @brief Sorts light indexes ascending.
+ */
+static gint BoxLightsCmp(gconstpointer a, gconstpointer b) {
+	return *(const int32_t *) a - *(const int32_t *) b;
+}
+
+/**
+ * @return A GPtrArray of all light sources that intersect the specified bounds, in the
+ * order in which they were created, so that lighting does not depend on the light index.
+ */
+static GPtrArray *BoxLights(const box3_t bounds) {
+
+	GArray *indexes = g_array_new(false, false, sizeof(int32_t));
+
+	if (light_index.num_nodes) {
+		int32_t stack[LIGHT_NODE_STACK];
+		int32_t depth = 0;
+
+		stack[depth++] = 0;
+
+		while (depth) {
+			const light_node_t *node = &light_index.nodes[stack[--depth]];
+
+			if (!Box3_Intersects(bounds, node->bounds)) {
 				continue;
 			}
+
+			if (node->num_lights) {
+				for (int32_t i = node->first_light; i < node->first_light + node->num_lights; i++) {
+					const int32_t light_num = light_index.lights[i];
+					if (Box3_Intersects(bounds, light_index.bounds[light_num])) {
+						g_array_append_val(indexes, light_num);
+					}
+				}
+			} else {
+				stack[depth++] = node->child;
+				stack[depth++] = (int32_t) (node - light_index.nodes) + 1;
+			}
 		}
+	}
 
-		g_ptr_array_add(box_lights, (gpointer) light);
+	const light_t *light_data = (light_t *) lights->data;
+
+	for (guint i = 0; i < unattenuated_lights->len; i++) {
+		const light_t *light = g_ptr_array_index(unattenuated_lights, i);
+		const int32_t light_num = (int32_t) (light - light_data);
+		g_array_append_val(indexes, light_num);
 	}
 
+	g_array_sort(indexes, BoxLightsCmp);
+
+	GPtrArray *box_lights = g_ptr_array_sized_new(indexes->len);
+
+	for (guint i = 0; i < indexes->len; i++) {
+		g_ptr_array_add(box_lights, (gpointer) &light_data[g_array_index(indexes, int32_t, i)]);
+	}
+
+	g_array_free(indexes, true);
 	return box_lights;
 }
 
 /**
- * @brief Hashes all light sources into bins by node and leaf.
+ * @brief WorkFunc for binning light sources to nodes, and then to leafs.
  */
-static void HashLights(void) {
+static void BinLights(int32_t num) {
 
-	assert(lights);
-
-	const bsp_node_t *node = bsp_file.nodes;
-	for (int32_t i = 0; i < bsp_file.num_nodes; i++, node++) {
+	if (num < bsp_file.num_nodes) {
+		const bsp_node_t *node = &bsp_file.nodes[num];
 
 		if (node->num_faces == 0) {
-			continue;
+			return;
 		}
 
-		node_lights[i] = BoxLights(node->bounds);
-	}
+		node_lights[num] = BoxLights(node->bounds);
+	} else {
+		num -= bsp_file.num_nodes;
 
-	const bsp_leaf_t *leaf = bsp_file.leafs;
-	for (int32_t i = 0; i < bsp_file.num_leafs; i++, leaf++) {
+		const bsp_leaf_t *leaf = &bsp_file.leafs[num];
 
 		if (leaf->cluster == 0) {
-			continue;
+			return;
 		}
 
-		leaf_lights[i] = BoxLights(leaf->bounds);
+		leaf_lights[num] = BoxLights(leaf->bounds);
 	}
+}
+
+/**
+ * @brief Hashes all light sources into bins by node and leaf.
+ */
+static void HashLights(void) {
+
+	assert(lights);
 
 	unattenuated_lights = g_ptr_array_new();
 
@@ -340,6 +542,16 @@ static void HashLights(void) {
 			g_ptr_array_add(unattenuated_lights, light);
 		}
 	}
+
+	const uint32_t start = SDL_GetTicks();
+
+	BuildLightIndex();
+
+	WorkReport("Indexing lights", SDL_GetTicks() - start);
+
+	Work("Binning lights", BinLights, bsp_file.num_nodes + bsp_file.num_leafs);
+
+	FreeLightIndex();
 }
 
 /**
@@ -0,0 +1,815 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "light.h"
+#include "lightcache.h"
+#include "lightgrid.h"
+#include "qlight.h"
+
+/*
+ * The light cache persists the direct and indirect lighting terms of every lightmap and
+ * lightgrid luxel alongside the .bsp, so that relighting a map only re-evaluates what has
+ * changed. Each lightmap and lightgrid luxel is keyed by a hash of its own geometry, the
+ * light sources that may reach it, and the brushes within the region those light sources'
+ * traces may touch. Brushes are hashed into a coarse grid with a summed (XOR) table, so
+ * that the geometry within any region is hashed in constant time.
+ *
+ * Indirect lighting depends on the direct lighting of the entire map, so it is restored
+ * only when nothing at all has changed. Otherwise, the bounces are re-run from the
+ * (partially) cached direct terms.
+ */
+
+#define LIGHT_CACHE_IDENT (('C' << 24) + ('L' << 16) + ('Q' << 8) + 'Q') // "QQLC"
+#define LIGHT_CACHE_VERSION 1
+
+#define LIGHT_CACHE_CELL_SIZE 256.f
+#define LIGHT_CACHE_MAX_CELLS 128
+
+#define LIGHT_CACHE_SEED 14695981039346656037ull
+
+typedef struct {
+	int32_t ident;
+	int32_t version;
+	uint64_t params;
+	uint64_t indirect;
+	int32_t num_lightmaps;
+	int32_t num_lightgrid;
+} light_cache_header_t;
+
+typedef struct {
+	uint64_t key;
+	int32_t face_num;
+	int32_t num_luxels;
+} light_cache_lightmap_t;
+
+typedef struct {
+	vec3_t origin;
+	vec3_t normal;
+	vec3_t ambient;
+	vec3_t diffuse;
+	vec3_t direction;
+	vec3_t radiosity[MAX_BOUNCES];
+} light_cache_luxel_t;
+
+typedef struct {
+	uint64_t key;
+	light_cache_luxel_t luxel;
+} light_cache_lightgrid_t;
+
+/**
+ * @brief The light sources binned to a node or leaf, and the region their traces may touch.
+ */
+typedef struct {
+	uint64_t hash;
+	box3_t bounds;
+	_Bool ambient;
+	_Bool sun;
+} light_cache_lights_t;
+
+static struct {
+	/**
+	 * @brief The hash of the global lighting parameters.
+	 */
+	uint64_t params;
+
+	/**
+	 * @brief The geometry grid and its summed hash table.
+	 */
+	box3_t bounds;
+	vec3i_t size;
+	vec3_t cell_size;
+	uint64_t *table;
+
+	/**
+	 * @brief The light sources of each node and leaf.
+	 */
+	light_cache_lights_t *node_lights;
+	light_cache_lights_t *leaf_lights;
+
+	/**
+	 * @brief The keys of this compilation.
+	 */
+	uint64_t *lightmap_keys;
+	uint64_t *lightgrid_keys;
+	size_t num_lightgrid;
+
+	/**
+	 * @brief The previous compilation, if any.
+	 */
+	void *buffer;
+	int64_t buffer_len;
+	light_cache_header_t header;
+	GHashTable *lightmaps;
+	const byte *lightgrid;
+
+	/**
+	 * @brief Statistics.
+	 */
+	SDL_atomic_t restored_lightmaps;
+	SDL_atomic_t restored_lightgrid;
+} cache;
+
+/**
+ * @brief Hashes `len` bytes of `data` into `hash`.
+ */
+static uint64_t LightCacheHash(uint64_t hash, const void *data, size_t len) {
+
+	const byte *b = data;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= b[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Finalizes the specified hash, so that its bits are evenly distributed.
+ */
+static uint64_t LightCacheMix(uint64_t hash) {
+
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebull;
+	hash ^= hash >> 31;
+
+	return hash;
+}
+
+#define HASH(hash, value) LightCacheHash(hash, &(value), sizeof(value))
+
+/**
+ * @return The grid cell containing the specified point, clamped to the grid.
+ */
+static vec3i_t LightCacheCell(const vec3_t point) {
+	vec3i_t cell;
+
+	for (int32_t i = 0; i < 3; i++) {
+		const float f = (point.xyz[i] - cache.bounds.mins.xyz[i]) / cache.cell_size.xyz[i];
+		cell.xyz[i] = Clampf(floorf(f), 0.f, cache.size.xyz[i] - 1);
+	}
+
+	return cell;
+}
+
+/**
+ * @return The summed hash table entry for the cell (x - 1, y - 1, z - 1).
+ */
+static inline uint64_t *LightCacheTable(int32_t x, int32_t y, int32_t z) {
+	return &cache.table[(z * (cache.size.y + 1) + y) * (cache.size.x + 1) + x];
+}
+
+/**
+ * @brief Hashes all collision brushes into the geometry grid, and builds the summed hash table.
+ */
+static void BuildLightCacheGrid(void) {
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	cache.bounds = Box3_Expand(bsp_file.models[0].bounds, 1.f);
+
+	const vec3_t size = Box3_Size(cache.bounds);
+	for (int32_t i = 0; i < 3; i++) {
+		cache.size.xyz[i] = Clampf(ceilf(size.xyz[i] / LIGHT_CACHE_CELL_SIZE), 1.f, LIGHT_CACHE_MAX_CELLS);
+		cache.cell_size.xyz[i] = size.xyz[i] / cache.size.xyz[i];
+	}
+
+	const vec3i_t s = cache.size;
+
+	uint64_t *cells = Mem_TagMalloc(s.x * s.y * s.z * sizeof(uint64_t), MEM_TAG_LIGHTCACHE);
+
+	const cm_bsp_brush_t *brush = bsp->brushes;
+	for (int32_t i = 0; i < bsp->file.num_brushes; i++, brush++) {
+
+		if (!brush->num_sides) {
+			continue;
+		}
+
+		uint64_t hash = LIGHT_CACHE_SEED;
+		hash = HASH(hash, brush->contents);
+
+		const cm_bsp_brush_side_t *side = brush->sides;
+		for (int32_t j = 0; j < brush->num_sides; j++, side++) {
+			hash = HASH(hash, side->plane->normal);
+			hash = HASH(hash, side->plane->dist);
+			if (side->texinfo) {
+				hash = HASH(hash, side->texinfo->flags);
+			}
+		}
+
+		hash = LightCacheMix(hash);
+
+		// brushes are summed into cells, so that their order is insignificant
+		const box3_t bounds = Box3_Expand(brush->bounds, BOX_EPSILON);
+
+		const vec3i_t mins = LightCacheCell(bounds.mins);
+		const vec3i_t maxs = LightCacheCell(bounds.maxs);
+
+		for (int32_t z = mins.z; z <= maxs.z; z++) {
+			for (int32_t y = mins.y; y <= maxs.y; y++) {
+				for (int32_t x = mins.x; x <= maxs.x; x++) {
+					cells[(z * s.y + y) * s.x + x] += hash;
+				}
+			}
+		}
+	}
+
+	cache.table = Mem_TagMalloc((s.x + 1) * (s.y + 1) * (s.z + 1) * sizeof(uint64_t), MEM_TAG_LIGHTCACHE);
+
+	for (int32_t z = 0; z < s.z; z++) {
+		for (int32_t y = 0; y < s.y; y++) {
+			for (int32_t x = 0; x < s.x; x++) {
+				const uint64_t cell = (z * s.y + y) * s.x + x;
+
+				*LightCacheTable(x + 1, y + 1, z + 1) = LightCacheMix(cell ^ LightCacheMix(cells[cell])) ^
+					*LightCacheTable(x, y + 1, z + 1) ^ *LightCacheTable(x + 1, y, z + 1) ^ *LightCacheTable(x + 1, y + 1, z) ^
+					*LightCacheTable(x, y, z + 1) ^ *LightCacheTable(x, y + 1, z) ^ *LightCacheTable(x + 1, y, z) ^
+					*LightCacheTable(x, y, z);
+			}
+		}
+	}
+
+	Mem_Free(cells);
+}
+
+/**
+ * @return The hash of all brushes within the specified region.
+ */
+static uint64_t HashLightCacheRegion(const box3_t bounds) {
+
+	const vec3i_t mins = LightCacheCell(bounds.mins);
+	const vec3i_t maxs = Vec3i_Add(LightCacheCell(bounds.maxs), Vec3i(1, 1, 1));
+
+	return *LightCacheTable(maxs.x, maxs.y, maxs.z) ^
+		*LightCacheTable(mins.x, maxs.y, maxs.z) ^ *LightCacheTable(maxs.x, mins.y, maxs.z) ^ *LightCacheTable(maxs.x, maxs.y, mins.z) ^
+		*LightCacheTable(mins.x, mins.y, maxs.z) ^ *LightCacheTable(mins.x, maxs.y, mins.z) ^ *LightCacheTable(maxs.x, mins.y, mins.z) ^
+		*LightCacheTable(mins.x, mins.y, mins.z);
+}
+
+/**
+ * @brief Hashes the parameters of the specified light source which affect lighting.
+ */
+static uint64_t HashLight(uint64_t hash, const light_t *light) {
+
+	hash = HASH(hash, light->type);
+	hash = HASH(hash, light->color);
+	hash = HASH(hash, light->radius);
+
+	switch (light->type) {
+		case LIGHT_AMBIENT:
+			break;
+		case LIGHT_SUN:
+			hash = HASH(hash, light->normal);
+			hash = HASH(hash, light->size);
+			break;
+		case LIGHT_SPOT:
+			hash = HASH(hash, light->normal);
+			hash = HASH(hash, light->theta);
+			// fall through
+		default:
+			hash = HASH(hash, light->atten);
+			hash = HASH(hash, light->origin);
+			hash = HASH(hash, light->size);
+			break;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Hashes the global lighting parameters that affect the cached terms. Brightness,
+ * saturation and contrast are applied when finalizing, and so do not invalidate the cache.
+ */
+static uint64_t HashLightParams(void) {
+
+	uint64_t hash = LIGHT_CACHE_SEED;
+
+	const int32_t version = LIGHT_CACHE_VERSION;
+
+	hash = HASH(hash, version);
+	hash = HASH(hash, antialias);
+	hash = HASH(hash, indirect);
+	hash = HASH(hash, luxel_size);
+	hash = HASH(hash, patch_size);
+	hash = HASH(hash, radiosity);
+	hash = HASH(hash, num_bounces);
+	hash = HASH(hash, lightscale_point);
+	hash = HASH(hash, lightscale_patch);
+
+	// unattenuated lights reach luxels in solids, regardless of the lights binned to them
+	for (guint i = 0; i < unattenuated_lights->len; i++) {
+		hash = HashLight(hash, g_ptr_array_index(unattenuated_lights, i));
+	}
+
+	return LightCacheMix(hash);
+}
+
+/**
+ * @brief Hashes the specified light sources, and resolves the region that their traces may touch.
+ */
+static light_cache_lights_t HashLightSources(const GPtrArray *lights) {
+
+	light_cache_lights_t out = {
+		.hash = LIGHT_CACHE_SEED,
+		.bounds = Box3_Null()
+	};
+
+	for (guint i = 0; i < lights->len; i++) {
+		const light_t *light = g_ptr_array_index(lights, i);
+
+		out.hash = HashLight(out.hash, light);
+
+		switch (light->type) {
+			case LIGHT_AMBIENT:
+				out.ambient = true;
+				break;
+			case LIGHT_SUN:
+				out.sun = true;
+				break;
+			default: {
+				// soft shadow samples are offset from the light origin by up to its size
+				const float radius = light->radius + (light->size + LIGHT_SIZE_STEP) * 2.f;
+				out.bounds = Box3_Union(out.bounds, Box3_FromCenterRadius(light->origin, radius));
+			}
+				break;
+		}
+	}
+
+	out.hash = LightCacheMix(out.hash);
+
+	return out;
+}
+
+/**
+ * @return The hash of the geometry that may occlude the specified receiver from the specified
+ * light sources.
+ */
+static uint64_t HashOccluders(const box3_t receiver, const light_cache_lights_t *lights, float ambient_radius) {
+
+	if (lights->sun) {
+		return HashLightCacheRegion(cache.bounds);
+	}
+
+	box3_t bounds = Box3_Union(receiver, lights->bounds);
+
+	if (lights->ambient) {
+		bounds = Box3_Union(bounds, Box3_Expand(receiver, ambient_radius));
+	}
+
+	return HashLightCacheRegion(bounds);
+}
+
+/**
+ * @brief Indexes the lightmaps of the previous compilation by key.
+ */
+static _Bool IndexLightCache(void) {
+
+	const byte *b = cache.buffer;
+	const byte *end = b + cache.buffer_len;
+
+	if (cache.buffer_len < (int64_t) sizeof(light_cache_header_t)) {
+		return false;
+	}
+
+	memcpy(&cache.header, b, sizeof(light_cache_header_t));
+	b += sizeof(light_cache_header_t);
+
+	if (cache.header.ident != LIGHT_CACHE_IDENT ||
+		cache.header.version != LIGHT_CACHE_VERSION ||
+		cache.header.params != cache.params) {
+		return false;
+	}
+
+	for (int32_t i = 0; i < cache.header.num_lightmaps; i++) {
+		light_cache_lightmap_t lm;
+
+		if (b + sizeof(lm) > end) {
+			return false;
+		}
+
+		memcpy(&lm, b, sizeof(lm));
+
+		if (lm.num_luxels < 0 || b + sizeof(lm) + lm.num_luxels * sizeof(light_cache_luxel_t) > end) {
+			return false;
+		}
+
+		g_hash_table_insert(cache.lightmaps, (gpointer) b, (gpointer) b);
+
+		b += sizeof(lm) + lm.num_luxels * sizeof(light_cache_luxel_t);
+	}
+
+	if (cache.header.num_lightgrid < 0 ||
+		b + cache.header.num_lightgrid * sizeof(light_cache_lightgrid_t) != end) {
+		return false;
+	}
+
+	cache.lightgrid = b;
+	return true;
+}
+
+/**
+ * @brief Loads the light cache of the previous compilation, and prepares to key this one.
+ * Must be called after the direct lights are built.
+ */
+void LoadLightCache(size_t num_lightgrid) {
+
+	memset(&cache, 0, sizeof(cache));
+
+	if (!lightcache) {
+		return;
+	}
+
+	const uint32_t start = SDL_GetTicks();
+
+	cache.params = HashLightParams();
+
+	BuildLightCacheGrid();
+
+	cache.node_lights = Mem_TagMalloc(bsp_file.num_nodes * sizeof(light_cache_lights_t), MEM_TAG_LIGHTCACHE);
+	for (int32_t i = 0; i < bsp_file.num_nodes; i++) {
+		if (node_lights[i]) {
+			cache.node_lights[i] = HashLightSources(node_lights[i]);
+		}
+	}
+
+	cache.leaf_lights = Mem_TagMalloc(bsp_file.num_leafs * sizeof(light_cache_lights_t), MEM_TAG_LIGHTCACHE);
+	for (int32_t i = 0; i < bsp_file.num_leafs; i++) {
+		if (leaf_lights[i]) {
+			cache.leaf_lights[i] = HashLightSources(leaf_lights[i]);
+		}
+	}
+
+	cache.lightmap_keys = Mem_TagMalloc(bsp_file.num_faces * sizeof(uint64_t), MEM_TAG_LIGHTCACHE);
+	cache.lightgrid_keys = Mem_TagMalloc(num_lightgrid * sizeof(uint64_t), MEM_TAG_LIGHTCACHE);
+	cache.num_lightgrid = num_lightgrid;
+
+	// the key of each lightmap record is its first member
+	cache.lightmaps = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+	const char *path = va("maps/%s.lightcache", map_base);
+
+	cache.buffer_len = Fs_Load(path, &cache.buffer);
+	if (cache.buffer_len == -1) {
+		cache.buffer = NULL;
+		Com_Verbose("No light cache found at %s\n", path);
+	} else if (!IndexLightCache()) {
+		Com_Verbose("Ignoring stale or malformed light cache %s\n", path);
+
+		g_hash_table_remove_all(cache.lightmaps);
+		cache.header.num_lightmaps = cache.header.num_lightgrid = 0;
+		cache.lightgrid = NULL;
+	}
+
+	Com_Verbose("Light cache: %d lightmaps, %d lightgrid luxels in %d ms\n",
+				cache.header.num_lightmaps, cache.header.num_lightgrid, SDL_GetTicks() - start);
+}
+
+/**
+ * @brief Copies the cached terms of the specified luxel.
+ */
+static void RestoreLuxel(luxel_t *luxel, const light_cache_luxel_t *in, _Bool direct, _Bool indirect) {
+
+	if (direct) {
+		luxel->origin = in->origin;
+		luxel->normal = in->normal;
+		luxel->ambient = in->ambient;
+		luxel->diffuse = in->diffuse;
+		luxel->direction = in->direction;
+	}
+
+	if (indirect) {
+		memcpy(luxel->radiosity, in->radiosity, sizeof(luxel->radiosity));
+	}
+}
+
+/**
+ * @return The cached lightmap record for the specified lightmap, or NULL.
+ */
+static const byte *CachedLightmap(const lightmap_t *lm, uint64_t key) {
+
+	const byte *record = g_hash_table_lookup(cache.lightmaps, &key);
+	if (record) {
+		light_cache_lightmap_t in;
+		memcpy(&in, record, sizeof(in));
+
+		if (in.num_luxels == (int32_t) lm->num_luxels) {
+			return record;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Keys the specified lightmap, and restores its direct lighting terms from the cache.
+ * @return True if the lightmap was restored, false if it must be lit.
+ */
+_Bool RestoreLightmap(int32_t face_num) {
+
+	if (!cache.lightmap_keys) {
+		return false;
+	}
+
+	const lightmap_t *lm = &lightmaps[face_num];
+	const light_cache_lights_t *lights = &cache.node_lights[lm->node - bsp_file.nodes];
+
+	const int32_t model_num = (int32_t) (lm->model - bsp_file.models);
+
+	uint64_t key = cache.params;
+
+	key = HASH(key, lights->hash);
+	key = HASH(key, model_num);
+	key = HASH(key, *lm->texinfo);
+	key = HASH(key, lm->matrix);
+	key = HASH(key, lm->inverse_matrix);
+	key = HASH(key, lm->st_mins);
+	key = HASH(key, lm->st_maxs);
+	key = HASH(key, lm->w);
+	key = HASH(key, lm->h);
+
+	const bsp_vertex_t *v = &bsp_file.vertexes[lm->face->first_vertex];
+	for (int32_t i = 0; i < lm->face->num_vertexes; i++, v++) {
+		key = HASH(key, v->position);
+		key = HASH(key, v->normal);
+	}
+
+	// ambient occlusion samples reach 64 luxels across the face, and 64 units from it
+	const float ambient_radius = Maxf(64.f * luxel_size, 64.f) * 1.5f;
+
+	const uint64_t occluders = HashOccluders(lm->face->bounds, lights, ambient_radius);
+	key = LightCacheMix(HASH(key, occluders));
+
+	cache.lightmap_keys[face_num] = key;
+
+	const byte *record = CachedLightmap(lm, key);
+	if (record == NULL) {
+		return false;
+	}
+
+	const byte *in = record + sizeof(light_cache_lightmap_t);
+	for (size_t i = 0; i < lm->num_luxels; i++, in += sizeof(light_cache_luxel_t)) {
+		light_cache_luxel_t luxel;
+		memcpy(&luxel, in, sizeof(luxel));
+
+		RestoreLuxel(&lm->luxels[i], &luxel, true, false);
+	}
+
+	SDL_AtomicAdd(&cache.restored_lightmaps, 1);
+	return true;
+}
+
+/**
+ * @brief Keys the specified lightgrid luxel, and restores its direct lighting terms from the
+ * cache. The luxel must be projected to its center.
+ * @return True if the luxel was restored, false if it must be lit.
+ */
+_Bool RestoreLightgridLuxel(int32_t luxel_num, luxel_t *luxel) {
+
+	if (!cache.lightgrid_keys) {
+		return false;
+	}
+
+	const box3_t bounds = Box3_FromCenterRadius(luxel->origin, BSP_LIGHTGRID_LUXEL_SIZE * .5f);
+
+	uint64_t key = cache.params;
+
+	key = HASH(key, luxel->s);
+	key = HASH(key, luxel->t);
+	key = HASH(key, luxel->u);
+	key = HASH(key, luxel->origin);
+
+	light_cache_lights_t lights = {
+		.bounds = Box3_Null()
+	};
+
+	int32_t leafs[64];
+	const size_t num_leafs = Cm_BoxLeafnums(bounds, leafs, lengthof(leafs), NULL, 0, NULL);
+
+	for (size_t i = 0; i < num_leafs; i++) {
+		const light_cache_lights_t *leaf = &cache.leaf_lights[leafs[i]];
+
+		key = HASH(key, leafs[i]);
+		key = HASH(key, leaf->hash);
+
+		lights.bounds = Box3_Union(lights.bounds, leaf->bounds);
+		lights.ambient |= leaf->ambient;
+		lights.sun |= leaf->sun;
+	}
+
+	// ambient occlusion samples are the corners of a cube 256 units from the luxel
+	const uint64_t occluders = HashOccluders(bounds, &lights, 256.f * 1.75f);
+	key = LightCacheMix(HASH(key, occluders));
+
+	cache.lightgrid_keys[luxel_num] = key;
+
+	if ((size_t) cache.header.num_lightgrid != cache.num_lightgrid) {
+		return false;
+	}
+
+	light_cache_lightgrid_t in;
+	memcpy(&in, cache.lightgrid + luxel_num * sizeof(in), sizeof(in));
+
+	if (in.key != key) {
+		return false;
+	}
+
+	RestoreLuxel(luxel, &in.luxel, true, false);
+
+	SDL_AtomicAdd(&cache.restored_lightgrid, 1);
+	return true;
+}
+
+/**
+ * @return The key of the indirect lighting, which depends on every lightmap and lightgrid luxel.
+ */
+static uint64_t IndirectLightCacheKey(void) {
+
+	uint64_t key = cache.params;
+
+	key = LightCacheHash(key, cache.lightmap_keys, bsp_file.num_faces * sizeof(uint64_t));
+	key = LightCacheHash(key, cache.lightgrid_keys, cache.num_lightgrid * sizeof(uint64_t));
+
+	// zero is reserved for caches without indirect lighting
+	return LightCacheMix(key) ?: 1;
+}
+
+/**
+ * @brief Restores the indirect lighting terms, if every lightmap and lightgrid luxel
+ * was restored from the cache.
+ * @return True if indirect lighting was restored, false if it must be calculated.
+ */
+_Bool RestoreIndirectLighting(void) {
+
+	if (!cache.lightmap_keys) {
+		return false;
+	}
+
+	const int32_t restored_lightmaps = SDL_AtomicGet(&cache.restored_lightmaps);
+	const int32_t restored_lightgrid = SDL_AtomicGet(&cache.restored_lightgrid);
+
+	Com_Print("Light cache: restored %d lightmaps, %d of %zu lightgrid luxels\n",
+			  restored_lightmaps, restored_lightgrid, cache.num_lightgrid);
+
+	if (restored_lightgrid != (int32_t) cache.num_lightgrid) {
+		return false;
+	}
+
+	if (cache.header.indirect != IndirectLightCacheKey()) {
+		return false;
+	}
+
+	for (int32_t i = 0; i < bsp_file.num_faces; i++) {
+		const lightmap_t *lm = &lightmaps[i];
+
+		if (lm->texinfo->flags & SURF_MASK_NO_LIGHTMAP) {
+			continue;
+		}
+
+		const byte *record = CachedLightmap(lm, cache.lightmap_keys[i]);
+		if (record == NULL) {
+			return false; // should never happen
+		}
+
+		const byte *in = record + sizeof(light_cache_lightmap_t);
+		for (size_t j = 0; j < lm->num_luxels; j++, in += sizeof(light_cache_luxel_t)) {
+			light_cache_luxel_t luxel;
+			memcpy(&luxel, in, sizeof(luxel));
+
+			RestoreLuxel(&lm->luxels[j], &luxel, false, true);
+		}
+	}
+
+	for (size_t i = 0; i < cache.num_lightgrid; i++) {
+		light_cache_lightgrid_t in;
+		memcpy(&in, cache.lightgrid + i * sizeof(in), sizeof(in));
+
+		RestoreLuxel(LightgridLuxel((int32_t) i), &in.luxel, false, true);
+	}
+
+	Com_Print("Light cache: restored indirect lighting\n");
+	return true;
+}
+
+/**
+ * @brief Copies the cacheable terms of the specified luxel.
+ */
+static light_cache_luxel_t CacheLuxel(const luxel_t *luxel) {
+
+	light_cache_luxel_t out = {
+		.origin = luxel->origin,
+		.normal = luxel->normal,
+		.ambient = luxel->ambient,
+		.diffuse = luxel->diffuse,
+		.direction = luxel->direction,
+	};
+
+	memcpy(out.radiosity, luxel->radiosity, sizeof(out.radiosity));
+
+	return out;
+}
+
+/**
+ * @brief Writes the direct and indirect lighting terms of this compilation. Must be called
+ * after indirect lighting, and before finalizing.
+ */
+void WriteLightCache(void) {
+
+	if (!cache.lightmap_keys) {
+		return;
+	}
+
+	const char *path = va("maps/%s.lightcache", map_base);
+
+	file_t *file = Fs_OpenWrite(path);
+	if (file == NULL) {
+		Com_Warn("Failed to open %s\n", path);
+		return;
+	}
+
+	light_cache_header_t header = {
+		.ident = LIGHT_CACHE_IDENT,
+		.version = LIGHT_CACHE_VERSION,
+		.params = cache.params,
+		.indirect = IndirectLightCacheKey(),
+		.num_lightgrid = (int32_t) cache.num_lightgrid
+	};
+
+	for (int32_t i = 0; i < bsp_file.num_faces; i++) {
+		if (!(lightmaps[i].texinfo->flags & SURF_MASK_NO_LIGHTMAP)) {
+			header.num_lightmaps++;
+		}
+	}
+
+	Fs_Write(file, &header, sizeof(header), 1);
+
+	for (int32_t i = 0; i < bsp_file.num_faces; i++) {
+		const lightmap_t *lm = &lightmaps[i];
+
+		if (lm->texinfo->flags & SURF_MASK_NO_LIGHTMAP) {
+			continue;
+		}
+
+		const light_cache_lightmap_t out = {
+			.key = cache.lightmap_keys[i],
+			.face_num = i,
+			.num_luxels = (int32_t) lm->num_luxels
+		};
+
+		Fs_Write(file, &out, sizeof(out), 1);
+
+		for (size_t j = 0; j < lm->num_luxels; j++) {
+			const light_cache_luxel_t luxel = CacheLuxel(&lm->luxels[j]);
+			Fs_Write(file, &luxel, sizeof(luxel), 1);
+		}
+	}
+
+	for (size_t i = 0; i < cache.num_lightgrid; i++) {
+		const light_cache_lightgrid_t out = {
+			.key = cache.lightgrid_keys[i],
+			.luxel = CacheLuxel(LightgridLuxel((int32_t) i))
+		};
+
+		Fs_Write(file, &out, sizeof(out), 1);
+	}
+
+	Fs_Close(file);
+
+	Com_Verbose("Wrote light cache %s\n", path);
+}
+
+/**
+ * @brief Frees the light cache.
+ */
+void FreeLightCache(void) {
+
+	if (cache.lightmaps) {
+		g_hash_table_destroy(cache.lightmaps);
+	}
+
+	if (cache.buffer) {
+		Fs_Free(cache.buffer);
+	}
+
+	Mem_FreeTag(MEM_TAG_LIGHTCACHE);
+
+	memset(&cache, 0, sizeof(cache));
+}
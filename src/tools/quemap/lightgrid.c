@@ -21,6 +21,7 @@
 
 #include "bsp.h"
 #include "lightmap.h"
+#include "lightcache.h"
 #include "lightgrid.h"
 #include "points.h"
 #include "qlight.h"
@@ -234,15 +235,19 @@ static void LightLightgridLuxel(const GPtrArray *lights, luxel_t *luxel, float s
 			const vec3_t points[] = CUBE_8;
 			float sample_fraction = 1.f / lengthof(points);
 
-			float exposure = 0.f;
+			vec3_t ends[lengthof(points)];
 
 			for (size_t i = 0; i < lengthof(points); i++) {
+				ends[i] = Vec3_Fmaf(luxel->origin, 256.f, points[i]);
+			}
 
-				const vec3_t point = Vec3_Fmaf(luxel->origin, 256.f, points[i]);
+			cm_trace_t traces[lengthof(points)];
+			Light_TracePacket(luxel->origin, ends, lengthof(ends), 0, CONTENTS_SOLID, traces);
 
-				const cm_trace_t trace = Light_Trace(luxel->origin, point, 0, CONTENTS_SOLID);
+			float exposure = 0.f;
 
-				exposure += sample_fraction * trace.fraction;
+			for (size_t i = 0; i < lengthof(points); i++) {
+				exposure += sample_fraction * traces[i].fraction;
 			}
 
 			intensity *= exposure;
@@ -251,25 +256,21 @@ static void LightLightgridLuxel(const GPtrArray *lights, luxel_t *luxel, float s
 
 			const vec3_t sun_origin = Vec3_Fmaf(luxel->origin, -MAX_WORLD_DIST, light->normal);
 
-			cm_trace_t trace = Light_Trace(luxel->origin, sun_origin, 0, CONTENTS_SOLID);
-			if (!(trace.texinfo && (trace.texinfo->flags & SURF_SKY))) {
+			if (!Light_Visible(luxel->origin, &sun_origin, 1, 0, CONTENTS_SOLID, true)) {
 				float exposure = 0.f;
 
 				const int32_t num_samples = ceilf(light->size / LIGHT_SIZE_STEP);
 				for (int32_t i = 0; i < num_samples; i++) {
 
 					const vec3_t points[] = CUBE_8;
-					for (size_t j = 0; j < lengthof(points); j++) {
+					vec3_t ends[lengthof(points)];
 
-						const vec3_t point = Vec3_Fmaf(sun_origin, i * LIGHT_SIZE_STEP, points[j]);
-
-						trace = Light_Trace(luxel->origin, point, 0, CONTENTS_SOLID);
-						if (!(trace.texinfo && (trace.texinfo->flags & SURF_SKY))) {
-							continue;
-						}
+					for (size_t j = 0; j < lengthof(points); j++) {
+						ends[j] = Vec3_Fmaf(sun_origin, i * LIGHT_SIZE_STEP, points[j]);
+					}
 
+					if (Light_Visible(luxel->origin, ends, lengthof(ends), 0, CONTENTS_SOLID, true)) {
 						exposure += 1.f / num_samples;
-						break;
 					}
 				}
 
@@ -277,25 +278,21 @@ static void LightLightgridLuxel(const GPtrArray *lights, luxel_t *luxel, float s
 			}
 
 		} else {
-			cm_trace_t trace = Light_Trace(luxel->origin, light->origin, 0, CONTENTS_SOLID);
-			if (trace.fraction < 1.f) {
+			if (!Light_Visible(luxel->origin, &light->origin, 1, 0, CONTENTS_SOLID, false)) {
 				float exposure = 0.f;
 
 				const int32_t num_samples = ceilf(light->size / LIGHT_SIZE_STEP);
 				for (int32_t i = 0; i < num_samples; i++) {
 
 					const vec3_t points[] = CUBE_8;
-					for (size_t j = 0; j < lengthof(points); j++) {
-
-						const vec3_t point = Vec3_Fmaf(light->origin, (i + 1) * LIGHT_SIZE_STEP, points[j]);
+					vec3_t ends[lengthof(points)];
 
-						trace = Light_Trace(luxel->origin, point, 0, CONTENTS_SOLID);
-						if (trace.fraction < 1.f) {
-							continue;
-						}
+					for (size_t j = 0; j < lengthof(points); j++) {
+						ends[j] = Vec3_Fmaf(light->origin, (i + 1) * LIGHT_SIZE_STEP, points[j]);
+					}
 
+					if (Light_Visible(luxel->origin, ends, lengthof(ends), 0, CONTENTS_SOLID, false)) {
 						exposure += 1.f / num_samples;
-						break;
 					}
 				}
 
@@ -329,6 +326,13 @@ static void LightLightgridLuxel(const GPtrArray *lights, luxel_t *luxel, float s
 	}
 }
 
+/**
+ * @return The lightgrid luxel with the specified number.
+ */
+luxel_t *LightgridLuxel(int32_t luxel_num) {
+	return &lg.luxels[luxel_num];
+}
+
 /**
  * @brief
  */
@@ -346,6 +350,12 @@ void DirectLightgrid(int32_t luxel_num) {
 
 	luxel_t *l = &lg.luxels[luxel_num];
 
+	ProjectLightgridLuxel(l, 0.f, 0.f, 0.f);
+
+	if (RestoreLightgridLuxel(luxel_num, l)) {
+		return;
+	}
+
 	float contribution = 0.f;
 
 	for (size_t i = 0; i < lengthof(offsets) && contribution < 1.f; i++) {
@@ -21,7 +21,10 @@
 
 #pragma once
 
+#include "lightmap.h"
+
 size_t BuildLightgrid(void);
+luxel_t *LightgridLuxel(int32_t luxel_num);
 void DirectLightgrid(int32_t luxel_num);
 void IndirectLightgrid(int32_t luxel_num);
 void FogLightgrid(int32_t luxel_num);
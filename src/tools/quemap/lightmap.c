@@ -21,6 +21,7 @@
 
 #include "bsp.h"
 #include "light.h"
+#include "lightcache.h"
 #include "lightmap.h"
 #include "patch.h"
 #include "points.h"
@@ -349,7 +350,7 @@ static void LightLightmapLuxel(const GPtrArray *lights, const lightmap_t *lightm
 			const vec3_t points[] = DOME_COSINE_36X;
 			float sample_fraction = 1.f / lengthof(points);
 
-			float exposure = 0.f;
+			vec3_t ends[lengthof(points)];
 
 			for (size_t i = 0; i < lengthof(points); i++) {
 
@@ -365,11 +366,16 @@ static void LightLightmapLuxel(const GPtrArray *lights, const lightmap_t *lightm
 				sample.x += s;
 				sample.y += t;
 
-				const vec3_t point = Mat4_Transform(lightmap->inverse_matrix, sample);
+				ends[i] = Mat4_Transform(lightmap->inverse_matrix, sample);
+			}
+
+			cm_trace_t traces[lengthof(points)];
+			Light_TracePacket(luxel->origin, ends, lengthof(ends), head_node, CONTENTS_SOLID, traces);
 
-				const cm_trace_t trace = Light_Trace(luxel->origin, point, head_node, CONTENTS_SOLID);
+			float exposure = 0.f;
 
-				exposure += sample_fraction * trace.fraction;
+			for (size_t i = 0; i < lengthof(points); i++) {
+				exposure += sample_fraction * traces[i].fraction;
 			}
 
 			intensity *= exposure;
@@ -378,25 +384,21 @@ static void LightLightmapLuxel(const GPtrArray *lights, const lightmap_t *lightm
 
 			const vec3_t sun_origin = Vec3_Fmaf(luxel->origin, -MAX_WORLD_DIST, light->normal);
 
-			cm_trace_t trace = Light_Trace(luxel->origin, sun_origin, head_node, CONTENTS_SOLID);
-			if (!(trace.texinfo && (trace.texinfo->flags & SURF_SKY))) {
+			if (!Light_Visible(luxel->origin, &sun_origin, 1, head_node, CONTENTS_SOLID, true)) {
 				float exposure = 0.f;
 
 				const int32_t num_samples = ceilf(light->size / LIGHT_SIZE_STEP);
 				for (int32_t i = 0; i < num_samples; i++) {
 
 					const vec3_t points[] = CUBE_8;
-					for (size_t j = 0; j < lengthof(points); j++) {
+					vec3_t ends[lengthof(points)];
 
-						const vec3_t point = Vec3_Fmaf(sun_origin, i * LIGHT_SIZE_STEP, points[j]);
-
-						trace = Light_Trace(luxel->origin, point, head_node, CONTENTS_SOLID);
-						if (!(trace.texinfo && (trace.texinfo->flags & SURF_SKY))) {
-							continue;
-						}
+					for (size_t j = 0; j < lengthof(points); j++) {
+						ends[j] = Vec3_Fmaf(sun_origin, i * LIGHT_SIZE_STEP, points[j]);
+					}
 
+					if (Light_Visible(luxel->origin, ends, lengthof(ends), head_node, CONTENTS_SOLID, true)) {
 						exposure += 1.f / num_samples;
-						break;
 					}
 				}
 
@@ -404,25 +406,21 @@ static void LightLightmapLuxel(const GPtrArray *lights, const lightmap_t *lightm
 			}
 
 		} else {
-			cm_trace_t trace = Light_Trace(luxel->origin, light->origin, head_node, CONTENTS_SOLID);
-			if (trace.fraction < 1.f) {
+			if (!Light_Visible(luxel->origin, &light->origin, 1, head_node, CONTENTS_SOLID, false)) {
 				float exposure = 0.f;
 
 				const int32_t num_samples = ceilf(light->size / LIGHT_SIZE_STEP);
 				for (int32_t i = 0; i < num_samples; i++) {
 
 					const vec3_t points[] = CUBE_8;
-					for (size_t j = 0; j < lengthof(points); j++) {
+					vec3_t ends[lengthof(points)];
 
-						const vec3_t point = Vec3_Fmaf(light->origin, (i + 1) * LIGHT_SIZE_STEP, points[j]);
-
-						trace = Light_Trace(luxel->origin, point, head_node, CONTENTS_SOLID);
-						if (trace.fraction < 1.f) {
-							continue;
-						}
+					for (size_t j = 0; j < lengthof(points); j++) {
+						ends[j] = Vec3_Fmaf(light->origin, (i + 1) * LIGHT_SIZE_STEP, points[j]);
+					}
 
+					if (Light_Visible(luxel->origin, ends, lengthof(ends), head_node, CONTENTS_SOLID, false)) {
 						exposure += 1.f / num_samples;
-						break;
 					}
 				}
 
@@ -456,6 +454,55 @@ static void LightLightmapLuxel(const GPtrArray *lights, const lightmap_t *lightm
 	}
 }
 
+/**
+ * @brief Lights the luxel at its current sample position. When verifying the ray tracer, the
+ * sample is lit again with the ray tracer into `verify`, replaying the same jitter, so that the
+ * two luxels differ only by the tracers.
+ */
+static void LightLightmapSample(const GPtrArray *lights, const lightmap_t *lightmap, luxel_t *luxel,
+								luxel_t *verify, float scale) {
+
+	if (verify == NULL) {
+		LightLightmapLuxel(lights, lightmap, luxel, scale);
+		return;
+	}
+
+	const guint32 seed = g_rand_int(InitRandom());
+
+	g_rand_set_seed(InitRandom(), seed);
+	LightLightmapLuxel(lights, lightmap, luxel, scale);
+
+	verify->origin = luxel->origin;
+	verify->normal = luxel->normal;
+
+	g_rand_set_seed(InitRandom(), seed);
+
+	Light_VerifyRayTracer(true);
+	LightLightmapLuxel(lights, lightmap, verify, scale);
+	Light_VerifyRayTracer(false);
+}
+
+/**
+ * @brief Compares a luxel lit with the collision model to its ray traced counterpart, before
+ * either is normalized by its sample contribution.
+ */
+static void VerifyLightmapLuxel(const luxel_t *luxel, const luxel_t *verify, float contribution) {
+
+	if (contribution <= 0.f) {
+		return;
+	}
+
+	float error = 0.f;
+
+	for (int32_t i = 0; i < 3; i++) {
+		error = Maxf(error, fabsf(luxel->ambient.xyz[i] - verify->ambient.xyz[i]));
+		error = Maxf(error, fabsf(luxel->diffuse.xyz[i] - verify->diffuse.xyz[i]));
+		error = Maxf(error, fabsf(luxel->radiosity[bounce].xyz[i] - verify->radiosity[bounce].xyz[i]));
+	}
+
+	Light_VerifyLuxel(error / Minf(contribution, 1.f));
+}
+
 /**
  * @brief Calculates direct lighting for the given face. Luxels are projected into world space.
  * We then query the light sources that intersect the lightmap's node, and accumulate their ambient,
@@ -475,11 +522,17 @@ void DirectLightmap(int32_t face_num) {
 		return;
 	}
 
+	if (RestoreLightmap(face_num)) {
+		return;
+	}
+
 	const GPtrArray *lights = node_lights[lm->node - bsp_file.nodes];
 
 	luxel_t *l = lm->luxels;
 	for (size_t i = 0; i < lm->num_luxels; i++, l++) {
 
+		luxel_t verify = *l;
+
 		float contribution = 0.0;
 
 		for (size_t j = 0; j < lengthof(offsets) && contribution < 1.f; j++) {
@@ -495,7 +548,11 @@ void DirectLightmap(int32_t face_num) {
 
 			contribution += weight;
 
-			LightLightmapLuxel(lights, lm, l, weight);
+			LightLightmapSample(lights, lm, l, raytrace_verify ? &verify : NULL, weight);
+		}
+
+		if (raytrace_verify) {
+			VerifyLightmapLuxel(l, &verify, contribution);
 		}
 
 		if (contribution > 0.f) {
@@ -543,6 +600,8 @@ void IndirectLightmap(int32_t face_num) {
 	luxel_t *l = lm->luxels;
 	for (size_t i = 0; i < lm->num_luxels; i++, l++) {
 
+		luxel_t verify = *l;
+
 		float contribution = 0.f;
 
 		for (size_t j = 0; j < lengthof(offsets) && contribution < 1.f; j++) {
@@ -556,7 +615,11 @@ void IndirectLightmap(int32_t face_num) {
 
 			contribution += weight;
 
-			LightLightmapLuxel(lights, lm, l, weight);
+			LightLightmapSample(lights, lm, l, raytrace_verify ? &verify : NULL, weight);
+		}
+
+		if (raytrace_verify) {
+			VerifyLightmapLuxel(l, &verify, contribution);
 		}
 
 		if (contribution > 0.f && contribution < 1.f) {
@@ -668,45 +731,58 @@ void EmitLightmap(void) {
 		nodes[i]->h = lm->h;
 	}
 
-	int32_t width;
-	for (width = MIN_BSP_LIGHTMAP_WIDTH; width <= MAX_BSP_LIGHTMAP_WIDTH; width += 256) {
+	// binary search the smallest width to which the lightmaps pack, and blit only that
 
-		const int32_t layer_bytes = width * width * BSP_LIGHTMAP_BPP;
+	const int32_t steps = (MAX_BSP_LIGHTMAP_WIDTH - MIN_BSP_LIGHTMAP_WIDTH) / 256;
 
-		bsp_file.lightmap_size = sizeof(bsp_lightmap_t) + layer_bytes * BSP_LIGHTMAP_LAYERS;
+	if (Atlas_Pack(atlas, 0, MAX_BSP_LIGHTMAP_WIDTH, MAX_BSP_LIGHTMAP_WIDTH)) {
+		Com_Error(ERROR_FATAL, "MAX_BSP_LIGHTMAP_WIDTH\n");
+	}
 
-		Bsp_AllocLump(&bsp_file, BSP_LUMP_LIGHTMAP, bsp_file.lightmap_size);
- 		memset(bsp_file.lightmap, 0, bsp_file.lightmap_size);
+	int32_t lo = 0, hi = steps;
+	while (lo < hi) {
+		const int32_t mid = (lo + hi) / 2;
+		const int32_t width = MIN_BSP_LIGHTMAP_WIDTH + mid * 256;
 
-		bsp_file.lightmap->width = width;
+		if (Atlas_Pack(atlas, 0, width, width) == 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
 
-		byte *out = (byte *) bsp_file.lightmap + sizeof(bsp_lightmap_t);
+	const int32_t width = MIN_BSP_LIGHTMAP_WIDTH + lo * 256;
 
-		SDL_Surface *ambient = CreateLightmapSurfaceFrom(width, width, out + 0 * layer_bytes);
-		SDL_Surface *diffuse = CreateLightmapSurfaceFrom(width, width, out + 1 * layer_bytes);
-		SDL_Surface *direction = CreateLightmapSurfaceFrom(width, width, out + 2 * layer_bytes);
+	if (Atlas_Pack(atlas, 0, width, width)) {
+		Com_Error(ERROR_FATAL, "Failed to pack lightmaps at %d\n", width);
+	}
 
-		if (Atlas_Compile(atlas, 0, ambient, diffuse, direction) == 0) {
+	Com_Verbose("Packed %u lightmaps into %dx%d\n", atlas->nodes->len, width, width);
 
-//			IMG_SavePNG(ambient, va("/tmp/%s_lm_ambient.png", map_base));
-//			IMG_SavePNG(diffuse, va("/tmp/%s_lm_diffuse.png", map_base));
-//			IMG_SavePNG(direction, va("/tmp/%s_lm_direction.png", map_base));
+	const int32_t layer_bytes = width * width * BSP_LIGHTMAP_BPP;
 
-			SDL_FreeSurface(ambient);
-			SDL_FreeSurface(diffuse);
-			SDL_FreeSurface(direction);
+	bsp_file.lightmap_size = sizeof(bsp_lightmap_t) + layer_bytes * BSP_LIGHTMAP_LAYERS;
 
-			break;
-		}
+	Bsp_AllocLump(&bsp_file, BSP_LUMP_LIGHTMAP, bsp_file.lightmap_size);
+	memset(bsp_file.lightmap, 0, bsp_file.lightmap_size);
 
-		SDL_FreeSurface(ambient);
-		SDL_FreeSurface(diffuse);
-		SDL_FreeSurface(direction);
-	}
+	bsp_file.lightmap->width = width;
 
-	if (width > MAX_BSP_LIGHTMAP_WIDTH) {
-		Com_Error(ERROR_FATAL, "MAX_BSP_LIGHTMAP_WIDTH\n");
-	}
+	byte *out = (byte *) bsp_file.lightmap + sizeof(bsp_lightmap_t);
+
+	SDL_Surface *ambient = CreateLightmapSurfaceFrom(width, width, out + 0 * layer_bytes);
+	SDL_Surface *diffuse = CreateLightmapSurfaceFrom(width, width, out + 1 * layer_bytes);
+	SDL_Surface *direction = CreateLightmapSurfaceFrom(width, width, out + 2 * layer_bytes);
+
+	Atlas_Blit(atlas, ambient, diffuse, direction);
+
+//	IMG_SavePNG(ambient, va("/tmp/%s_lm_ambient.png", map_base));
+//	IMG_SavePNG(diffuse, va("/tmp/%s_lm_diffuse.png", map_base));
+//	IMG_SavePNG(direction, va("/tmp/%s_lm_direction.png", map_base));
+
+	SDL_FreeSurface(ambient);
+	SDL_FreeSurface(diffuse);
+	SDL_FreeSurface(direction);
 
 	for (int32_t i = 0; i < bsp_file.num_faces; i++) {
 		lightmap_t *lm = &lightmaps[i];
@@ -220,6 +220,9 @@ static void Check_LIGHT_Options(int32_t argc) {
 		if (!g_strcmp0(Com_Argv(i), "--no-indirect")) {
 			indirect = false;
 			Com_Verbose("indirect: false\n");
+		} else if (!g_strcmp0(Com_Argv(i), "--no-light-cache")) {
+			lightcache = false;
+			Com_Verbose("light cache: false\n");
 		} else if (!g_strcmp0(Com_Argv(i), "--antialias")) {
 			antialias = true;
 			Com_Verbose("antialias: true\n");
@@ -251,6 +254,12 @@ static void Check_LIGHT_Options(int32_t argc) {
 			patch_size = (int32_t) strtol(Com_Argv(i + 1), NULL, 10);
 			Com_Verbose("patch size: %d\n", patch_size);
 			i++;
+		} else if (!g_strcmp0(Com_Argv(i), "--raytrace")) {
+			raytrace = true;
+			Com_Verbose("raytrace: true\n");
+		} else if (!g_strcmp0(Com_Argv(i), "--raytrace-verify")) {
+			raytrace_verify = true;
+			Com_Verbose("raytrace verify: true\n");
 		} else {
 			break;
 		}
@@ -292,6 +301,7 @@ static void PrintHelpMessage(void) {
 	Com_Print("-p --path <game directory> - add the path to the search directory\n");
 	Com_Print("-w --wpath <game directory> - add the write path to the search directory\n");
 	Com_Print("-connect <host> - use GtkRadiant's BSP monitoring server\n");
+	Com_Print("--profile - write a CPU profile of the compilation to the profiles directory\n");
 	Com_Print("\n");
 
 	Com_Print("-mat               MAT stage options:\n");
@@ -319,6 +329,9 @@ static void PrintHelpMessage(void) {
 	Com_Print(" --saturation <float> - saturation (default 1.0)\n");
 	Com_Print(" --luxel-size <float> - luxel size (default 4)\n");
 	Com_Print(" --patch-size <float> - patch size (default 16)\n");
+	Com_Print(" --raytrace - trace lighting with the ray tracer instead of the collision model\n");
+	Com_Print(" --raytrace-verify - compare the ray tracer to the collision model, query by query and luxel by luxel\n");
+	Com_Print(" --no-light-cache - don't reuse or write the light cache of previous compilations\n");
 	Com_Print("\n");
 
 	Com_Print("-zip               ZIP stage options:\n");
@@ -342,6 +355,7 @@ static void PrintHelpMessage(void) {
  */
 int32_t main(int32_t argc, char **argv) {
 	int32_t num_threads = 0;
+	_Bool do_profile = false;
 	_Bool do_mat = false;
 	_Bool do_bsp = false;
 	_Bool do_light = false;
@@ -401,6 +415,11 @@ int32_t main(int32_t argc, char **argv) {
 			is_monitor = Mon_Connect(Com_Argv(i + 1));
 			continue;
 		}
+
+		if (!g_strcmp0(Com_Argv(i), "--profile")) {
+			do_profile = true;
+			continue;
+		}
 	}
 
 	// read compiling options
@@ -463,6 +482,11 @@ int32_t main(int32_t argc, char **argv) {
 		g_snprintf(bsp_name, sizeof(bsp_name), "maps/%s.bsp", map_base);
 	}
 
+	// fine zones would overwrite the early phases of the compile in each thread's ring
+	if (do_profile) {
+		Profile_Capture(0, PROFILE_COARSE);
+	}
+
 	// start timer
 	const uint32_t start = SDL_GetTicks();
 
@@ -483,5 +507,7 @@ int32_t main(int32_t argc, char **argv) {
 	const uint32_t end = SDL_GetTicks();
 	Com_Print("\n%s finished in %dms\n", Com_Argv(0), end - start);
 
+	Profile_Stop();
+
 	Com_Shutdown(NULL);
 }
@@ -22,6 +22,7 @@
 #include "bsp.h"
 #include "portal.h"
 #include "prtfile.h"
+#include "vis.h"
 
 static file_t *prtfile;
 static int32_t num_vis_clusters; /* clusters the player can be in */
@@ -217,5 +218,7 @@ void WritePortalFile(tree_t *tree) {
 	// issues made us do this after writebsp...
 	SaveClusters_r(tree->head_node);
 
+	EmitVis(tree, num_vis_clusters);
+
 	Com_Verbose("--- WritePortalFile complete ---\n");
 }
@@ -44,16 +44,24 @@ _Bool only_ents = false;
 _Bool leaked = false;
 
 /**
- * @brief
+ * @brief Creates, subtracts and partitions the brushes of the specified entity.
  */
-static void ProcessWorldModel(const entity_t *e, bsp_model_t *out) {
+static tree_t *BuildModelTree(const entity_t *e) {
 
 	csg_brush_t *brushes = MakeBrushes(e->first_brush, e->num_brushes);
 	if (!no_csg) {
 		brushes = SubtractBrushes(brushes);
 	}
 
-	tree_t *tree = BuildTree(brushes);
+	return BuildTree(brushes);
+}
+
+/**
+ * @brief
+ */
+static void ProcessWorldModel(const entity_t *e, bsp_model_t *out) {
+
+	tree_t *tree = BuildModelTree(e);
 
 	MakeTreePortals(tree);
 
@@ -88,16 +96,29 @@ static void ProcessWorldModel(const entity_t *e, bsp_model_t *out) {
 }
 
 /**
- * @brief
+ * @brief An inline model, whose tree is built concurrently with those of other inline models.
  */
-static void ProcessInlineModel(const entity_t *e, bsp_model_t *out) {
+typedef struct {
+	const entity_t *entity;
+	tree_t *tree;
+} inline_model_t;
 
-	csg_brush_t *brushes = MakeBrushes(e->first_brush, e->num_brushes);
-	if (!no_csg) {
-		brushes = SubtractBrushes(brushes);
+/**
+ * @brief JobRangeFunc that builds the trees for a range of inline models.
+ */
+static void BuildInlineModelTrees(int32_t begin, int32_t end, void *data) {
+
+	inline_model_t *models = data;
+
+	for (int32_t i = begin; i < end; i++) {
+		models[i].tree = BuildModelTree(models[i].entity);
 	}
+}
 
-	tree_t *tree = BuildTree(brushes);
+/**
+ * @brief
+ */
+static void ProcessInlineModel(tree_t *tree, bsp_model_t *out) {
 
 	MakeTreePortals(tree);
 
@@ -119,10 +140,26 @@ static void ProcessInlineModel(const entity_t *e, bsp_model_t *out) {
 }
 
 /**
- * @brief
+ * @brief Prints the specified entity's class name and origin.
+ */
+static const char *ProcessModelHeader(const entity_t *e) {
+
+	const char *class_name = ValueForKey(e, "classname", "Unknown");
+
+	const vec3_t origin = VectorForKey(e, "origin", Vec3_Zero());
+	Com_Print("%s @ %s\n", class_name, vtos(origin));
+
+	return class_name;
+}
+
+/**
+ * @brief Processes the world model, and then the inline models. The inline model trees
+ * are built concurrently, and are then emitted in entity order.
  */
 static void ProcessModels(void) {
 
+	GArray *inline_models = g_array_new(false, false, sizeof(inline_model_t));
+
 	for (int32_t i = 0; i < num_entities; i++) {
 		const entity_t *e = entities + i;
 
@@ -130,19 +167,57 @@ static void ProcessModels(void) {
 			continue;
 		}
 
-		const vec3_t origin = VectorForKey(e, "origin", Vec3_Zero());
-		Com_Print("%s @ %s\n", ValueForKey(e, "classname", "Unknown"), vtos(origin));
+		if (i > 0) {
+			const inline_model_t model = { .entity = e };
+			g_array_append_val(inline_models, model);
+			continue;
+		}
+
+		const char *class_name = ProcessModelHeader(e);
+
+		const uint32_t start = SDL_GetTicks();
 
 		bsp_model_t *mod = BeginModel(e);
-		if (i == 0) {
-			ProcessWorldModel(e, mod);
-		} else {
-			ProcessInlineModel(e, mod);
-		}
+		ProcessWorldModel(e, mod);
 		EndModel(mod);
 
+		Com_Print("Processed %s (%d brushes) in %d ms\n\n", class_name, e->num_brushes, SDL_GetTicks() - start);
+	}
+
+	if (inline_models->len) {
+
+		const uint32_t start = SDL_GetTicks();
+
+		// every tree's head node volume is bounded by the same planes, which must be
+		// created before trees are built concurrently, as FindPlane is not thread safe
+		FreeBrush(BrushFromBounds(Box3f(MAX_WORLD_AXIAL, MAX_WORLD_AXIAL, MAX_WORLD_AXIAL)));
+
+		WorkQuiet(true);
+
+		Job_ParallelFor(inline_models->len, 1, BuildInlineModelTrees, inline_models->data);
+
+		WorkQuiet(false);
+
+		WorkReport("Building inline trees", SDL_GetTicks() - start);
 		Com_Print("\n");
 	}
+
+	for (guint i = 0; i < inline_models->len; i++) {
+		const inline_model_t *model = &g_array_index(inline_models, inline_model_t, i);
+		const entity_t *e = model->entity;
+
+		const char *class_name = ProcessModelHeader(e);
+
+		const uint32_t start = SDL_GetTicks();
+
+		bsp_model_t *mod = BeginModel(e);
+		ProcessInlineModel(model->tree, mod);
+		EndModel(mod);
+
+		Com_Print("Processed %s (%d brushes) in %d ms\n\n", class_name, e->num_brushes, SDL_GetTicks() - start);
+	}
+
+	g_array_free(inline_models, true);
 }
 
 /**
@@ -22,7 +22,10 @@
 #include "qlight.h"
 
 _Bool indirect = true;
+_Bool lightcache = true;
 _Bool antialias = false;
+_Bool raytrace = false;
+_Bool raytrace_verify = false;
 
 float brightness = 1.0;
 float saturation = 1.0;
@@ -55,29 +58,271 @@ int32_t Light_PointContents(const vec3_t p, int32_t head_node) {
 	return contents;
 }
 
+/**
+ * @brief Lighting collision detection against the collision model.
+ */
+static cm_trace_t Light_TraceBsp(const vec3_t start, const vec3_t end, int32_t head_node, int32_t mask) {
+
+	cm_trace_t trace = Cm_BoxTrace(start, end, Box3_Zero(), 0, mask, NULL, NULL);
+
+	if (head_node) {
+		cm_trace_t tr = Cm_BoxTrace(start, end, Box3_Zero(), head_node, mask, NULL, NULL);
+		if (tr.fraction < trace.fraction) {
+			trace = tr;
+		}
+	}
+
+	return trace;
+}
+
+/**
+ * @brief When verifying the ray tracer, lighting is calculated with the collision model, and
+ * every query is repeated with the ray tracer. Because both tracers see the same rays, the
+ * comparison is exact, despite the jittered sampling of the lighting passes. Lightmaps are
+ * also lit a second time with the ray tracer, and compared luxel by luxel.
+ */
+static struct {
+	SDL_SpinLock lock;
+	size_t queries;
+	size_t mismatches;
+	float max_error;
+	uint64_t bsp_time;
+	uint64_t raytrace_time;
+	size_t luxels;
+	size_t luxel_mismatches;
+	float luxel_max_error;
+	double luxel_error;
+} light_verify;
+
+/**
+ * @brief While verifying, the ray tracer serves the calling thread's queries if this is set.
+ */
+static _Thread_local _Bool light_verify_raytrace;
+
+/**
+ * @brief Accumulates the results of a verified query.
+ */
+static void Light_Verify(int32_t queries, int32_t mismatches, float error, uint64_t bsp_time, uint64_t raytrace_time) {
+
+	SDL_AtomicLock(&light_verify.lock);
+
+	light_verify.queries += queries;
+	light_verify.mismatches += mismatches;
+	light_verify.max_error = Maxf(light_verify.max_error, error);
+	light_verify.bsp_time += bsp_time;
+	light_verify.raytrace_time += raytrace_time;
+
+	SDL_AtomicUnlock(&light_verify.lock);
+}
+
+/**
+ * @brief While verifying the ray tracer, selects the tracer that serves the calling thread's
+ * queries. Queries served by the collision model are also repeated with the ray tracer.
+ */
+void Light_VerifyRayTracer(_Bool enabled) {
+	light_verify_raytrace = enabled;
+}
+
+/**
+ * @brief Accumulates the difference of a luxel lit with both tracers.
+ * @param error The largest difference of any color component, in lightmap byte steps.
+ */
+void Light_VerifyLuxel(float error) {
+
+	SDL_AtomicLock(&light_verify.lock);
+
+	light_verify.luxels++;
+	light_verify.luxel_mismatches += error > LIGHT_VERIFY_TOLERANCE;
+	light_verify.luxel_max_error = Maxf(light_verify.luxel_max_error, error);
+	light_verify.luxel_error += error;
+
+	SDL_AtomicUnlock(&light_verify.lock);
+}
+
+/**
+ * @return True if the two traces would light a luxel differently.
+ */
+static _Bool Light_TraceMismatch(const cm_trace_t *a, const cm_trace_t *b) {
+
+	const _Bool a_sky = a->texinfo && (a->texinfo->flags & SURF_SKY);
+	const _Bool b_sky = b->texinfo && (b->texinfo->flags & SURF_SKY);
+
+	return a_sky != b_sky || (a->fraction < 1.f) != (b->fraction < 1.f) || fabsf(a->fraction - b->fraction) > 1.f / 255.f;
+}
+
 /**
  * @brief Lighting collision detection.
  * @details Lighting traces are clipped to the world, and to the entity for the given lightmap.
  * This way, inline models will self-shadow, but will not cast shadows on each other or on the
  * world.
- * @param lm The lightmap.
  * @param start The starting point.
  * @param end The desired end point.
+ * @param head_node The head node of the lightmap's inline model, or 0.
  * @param mask The contents mask to clip to.
  * @return The trace.
  */
 cm_trace_t Light_Trace(const vec3_t start, const vec3_t end, int32_t head_node, int32_t mask) {
+	cm_trace_t traces[1];
 
-	cm_trace_t trace = Cm_BoxTrace(start, end, Box3_Zero(), 0, mask, NULL, NULL);
+	Light_TracePacket(start, &end, 1, head_node, mask, traces);
 
-	if (head_node) {
-		cm_trace_t tr = Cm_BoxTrace(start, end, Box3_Zero(), head_node, mask, NULL, NULL);
-		if (tr.fraction < trace.fraction) {
-			trace = tr;
+	return traces[0];
+}
+
+/**
+ * @brief Traces `count` rays from `start` to each of `ends`. With the ray tracer, the rays are
+ * traced in packets.
+ */
+void Light_TracePacket(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask,
+					   cm_trace_t *traces) {
+
+	if (raytrace_verify && !light_verify_raytrace) {
+
+		for (int32_t i = 0; i < count; i += RAY_PACKET_SIZE) {
+			const int32_t n = Mini(count - i, RAY_PACKET_SIZE);
+			cm_trace_t tr[RAY_PACKET_SIZE];
+
+			const uint64_t t0 = SDL_GetPerformanceCounter();
+
+			for (int32_t j = 0; j < n; j++) {
+				traces[i + j] = Light_TraceBsp(start, ends[i + j], head_node, mask);
+			}
+
+			const uint64_t t1 = SDL_GetPerformanceCounter();
+
+			RayTracePacket(start, ends + i, n, head_node, mask, RAY_NEAREST, tr);
+
+			const uint64_t t2 = SDL_GetPerformanceCounter();
+
+			int32_t mismatches = 0;
+			float error = 0.f;
+
+			for (int32_t j = 0; j < n; j++) {
+				mismatches += Light_TraceMismatch(&traces[i + j], &tr[j]);
+				error = Maxf(error, fabsf(traces[i + j].fraction - tr[j].fraction));
+			}
+
+			Light_Verify(n, mismatches, error, t1 - t0, t2 - t1);
+		}
+
+	} else if (raytrace || raytrace_verify) {
+		RayTracePacket(start, ends, count, head_node, mask, RAY_NEAREST, traces);
+	} else {
+		for (int32_t i = 0; i < count; i++) {
+			traces[i] = Light_TraceBsp(start, ends[i], head_node, mask);
 		}
 	}
+}
 
-	return trace;
+/**
+ * @brief Occlusion query with the collision model.
+ */
+static _Bool Light_VisibleBsp(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node,
+							  int32_t mask, _Bool sky) {
+
+	for (int32_t i = 0; i < count; i++) {
+		const cm_trace_t trace = Light_TraceBsp(start, ends[i], head_node, mask);
+
+		if (sky) {
+			if (trace.texinfo && (trace.texinfo->flags & SURF_SKY)) {
+				return true;
+			}
+		} else if (trace.fraction == 1.f) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Occlusion query with the ray tracer.
+ */
+static _Bool Light_VisibleRayTrace(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node,
+								   int32_t mask, _Bool sky) {
+
+	for (int32_t i = 0; i < count; i += RAY_PACKET_SIZE) {
+		const int32_t n = Mini(count - i, RAY_PACKET_SIZE);
+		cm_trace_t traces[RAY_PACKET_SIZE];
+
+		RayTracePacket(start, ends + i, n, head_node, mask, sky ? RAY_NEAREST : RAY_OCCLUSION, traces);
+
+		for (int32_t j = 0; j < n; j++) {
+			if (sky) {
+				if (traces[j].texinfo && (traces[j].texinfo->flags & SURF_SKY)) {
+					return true;
+				}
+			} else if (traces[j].fraction == 1.f) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Lighting occlusion query.
+ * @param start The starting point.
+ * @param ends The sample points of the light source.
+ * @param count The number of sample points.
+ * @param head_node The head node of the lightmap's inline model, or 0.
+ * @param mask The contents mask to clip to.
+ * @param sky If true, a sample point is visible if the nearest intersection is a sky surface.
+ * Otherwise, it is visible if there are no intersections at all.
+ * @return True if any of the sample points is visible from `start`.
+ */
+_Bool Light_Visible(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask,
+					_Bool sky) {
+
+	if (raytrace_verify && !light_verify_raytrace) {
+		const uint64_t t0 = SDL_GetPerformanceCounter();
+
+		const _Bool visible = Light_VisibleBsp(start, ends, count, head_node, mask, sky);
+
+		const uint64_t t1 = SDL_GetPerformanceCounter();
+
+		const _Bool rt_visible = Light_VisibleRayTrace(start, ends, count, head_node, mask, sky);
+
+		const uint64_t t2 = SDL_GetPerformanceCounter();
+
+		Light_Verify(1, visible != rt_visible, 0.f, t1 - t0, t2 - t1);
+
+		return visible;
+	} else if (raytrace || raytrace_verify) {
+		return Light_VisibleRayTrace(start, ends, count, head_node, mask, sky);
+	} else {
+		return Light_VisibleBsp(start, ends, count, head_node, mask, sky);
+	}
+}
+
+/**
+ * @brief Reports the ray tracer verification results.
+ */
+static void Light_VerifyReport(void) {
+
+	const double ms = 1000.0 / SDL_GetPerformanceFrequency();
+
+	Com_Print("\nRay tracer verification: %zu queries, %zu mismatches, max fraction error %g\n",
+			  light_verify.queries, light_verify.mismatches, light_verify.max_error);
+	Com_Print("Collision model %.0f ms, ray tracer %.0f ms\n",
+			  light_verify.bsp_time * ms, light_verify.raytrace_time * ms);
+
+	if (light_verify.mismatches) {
+		Com_Warn("Ray tracer lighting differs in %.4f%% of queries\n",
+				 100.0 * light_verify.mismatches / light_verify.queries);
+	}
+
+	if (light_verify.luxels) {
+		Com_Print("Lightmaps: %zu luxels, %zu differ by more than %g, max error %g, mean error %g\n",
+				  light_verify.luxels, light_verify.luxel_mismatches, LIGHT_VERIFY_TOLERANCE,
+				  light_verify.luxel_max_error, light_verify.luxel_error / light_verify.luxels);
+
+		if (light_verify.luxel_mismatches) {
+			Com_Warn("Ray traced lightmaps differ in %.4f%% of luxels\n",
+					 100.0 * light_verify.luxel_mismatches / light_verify.luxels);
+		}
+	}
 }
 
 /**
@@ -95,6 +340,11 @@ static void LightWorld(void) {
 		bsp_models[i] = Cm_Model(va("*%d", i));
 	}
 
+	// and build the ray tracer, if requested
+	if (raytrace || raytrace_verify) {
+		BuildRayTracer();
+	}
+
 	// resolve global lighting parameters from worldspawn
 
 	const cm_entity_t *e = Cm_Bsp()->entities[0];
@@ -154,11 +404,14 @@ static void LightWorld(void) {
 	// build lights out of patches and entities
 	BuildDirectLights();
 
+	// load the light cache of the previous compilation
+	LoadLightCache(num_lightgrid);
+
 	// ambient and diffuse lighting
 	Work("Direct lightmaps", DirectLightmap, bsp_file.num_faces);
 	Work("Direct lightgrid", DirectLightgrid, (int32_t) num_lightgrid);
 
-	if (indirect && radiosity > 0.f) {
+	if (indirect && radiosity > 0.f && !RestoreIndirectLighting()) {
 		for (bounce = 0; bounce < num_bounces; bounce++) {
 
 			// build indirect lights from lightmapped patches
@@ -170,9 +423,22 @@ static void LightWorld(void) {
 		}
 	}
 
+	// write the light cache for the next compilation
+	WriteLightCache();
+	FreeLightCache();
+
 	// free the light sources
 	FreeLights();
 
+	// and the ray tracer
+	if (raytrace || raytrace_verify) {
+		FreeRayTracer();
+
+		if (raytrace_verify) {
+			Light_VerifyReport();
+		}
+	}
+
 	// finalize it and write it to per-face textures
 	Work("Finalizing lightmaps", FinalizeLightmap, bsp_file.num_faces);
 	Work("Finalizing lightgrid", FinalizeLightgrid, (int32_t) num_lightgrid);
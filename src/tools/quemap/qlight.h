@@ -23,15 +23,26 @@
 
 #include "fog.h"
 #include "light.h"
+#include "lightcache.h"
 #include "lightgrid.h"
 #include "lightmap.h"
 #include "material.h"
 #include "patch.h"
 #include "quemap.h"
+#include "raytrace.h"
 #include "writebsp.h"
 
 extern _Bool antialias;
 extern _Bool indirect;
+extern _Bool lightcache;
+extern _Bool raytrace;
+extern _Bool raytrace_verify;
+
+/**
+ * @brief The largest difference in any color component of a luxel, in lightmap byte steps,
+ * that is tolerated between the collision model and the ray tracer when verifying.
+ */
+#define LIGHT_VERIFY_TOLERANCE 1.f
 
 extern float brightness;
 extern float saturation;
@@ -49,5 +60,11 @@ extern float lightscale_patch;
 
 int32_t Light_PointContents(const vec3_t p, int32_t head_node);
 cm_trace_t Light_Trace(const vec3_t start, const vec3_t end, int32_t head_node, int32_t mask);
+void Light_TracePacket(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask,
+					   cm_trace_t *traces);
+_Bool Light_Visible(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask,
+					_Bool sky);
+void Light_VerifyRayTracer(_Bool enabled);
+void Light_VerifyLuxel(float error);
 
 int32_t LIGHT_Main(void);
@@ -47,12 +47,15 @@ enum {
 	MEM_TAG_TREE,
 	MEM_TAG_PORTAL,
 	MEM_TAG_FACE,
+	MEM_TAG_VIS,
 	MEM_TAG_QLIGHT,
 	MEM_TAG_PATCH,
 	MEM_TAG_ASSET,
 	MEM_TAG_LIGHT,
 	MEM_TAG_LIGHTMAP,
 	MEM_TAG_LIGHTGRID,
+	MEM_TAG_RAYTRACE,
+	MEM_TAG_LIGHTCACHE,
 	MEM_TAG_QMAT,
 	MEM_TAG_QZIP
 };
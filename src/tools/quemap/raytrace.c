@@ -0,0 +1,640 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "raytrace.h"
+
+/*
+ * The ray tracer is a bounding volume hierarchy over the collision brushes of each
+ * BSP model, built with the surface area heuristic. Rays are clipped to brushes
+ * exactly as Cm_BoxTrace clips point traces, so that the two are interchangeable
+ * for lighting, but without walking the BSP tree or testing brushes twice.
+ */
+
+#define RAY_SAH_BINS 16
+#define RAY_LEAF_BRUSHES 4
+#define RAY_MAX_LEAF_BRUSHES 16
+#define RAY_MAX_SAH_DEPTH 40
+#define RAY_STACK_SIZE 128
+
+/**
+ * @brief The hierarchy nodes. The first child of an interior node immediately
+ * follows it, and the second child is referenced explicitly.
+ */
+typedef struct {
+	box3_t bounds;
+	int32_t child;
+	int32_t axis;
+	int32_t first_brush;
+	int32_t num_brushes;
+} ray_node_t;
+
+/**
+ * @brief The hierarchy for one BSP model.
+ */
+typedef struct {
+	int32_t head_node;
+	const cm_bsp_brush_t **brushes;
+	int32_t num_brushes;
+	ray_node_t *nodes;
+	int32_t num_nodes;
+} ray_tree_t;
+
+/**
+ * @brief Brushes are binned by the centers of their bounds while building.
+ */
+typedef struct {
+	box3_t bounds;
+	vec3_t center;
+	const cm_bsp_brush_t *brush;
+} ray_primitive_t;
+
+/**
+ * @brief Ray packets, as structures of arrays.
+ */
+typedef struct {
+	float start[3][RAY_PACKET_SIZE];
+	float end[3][RAY_PACKET_SIZE];
+	float inv_dir[3][RAY_PACKET_SIZE];
+	float fraction[RAY_PACKET_SIZE];
+	int32_t active[RAY_PACKET_SIZE];
+	int32_t start_solid[RAY_PACKET_SIZE];
+	int32_t all_solid[RAY_PACKET_SIZE];
+	const cm_bsp_brush_t *brush[RAY_PACKET_SIZE];
+	const cm_bsp_brush_side_t *side[RAY_PACKET_SIZE];
+	int32_t mask;
+	ray_mode_t mode;
+} ray_packet_t;
+
+static ray_tree_t *ray_trees;
+static int32_t num_ray_trees;
+
+/**
+ * @brief Gathers the brushes referenced by the leafs of the specified subtree.
+ */
+static void GatherRayBrushes_r(const cm_bsp_t *bsp, int32_t node_num, byte *visited, GArray *primitives) {
+
+	if (node_num < 0) {
+		const cm_bsp_leaf_t *leaf = &bsp->leafs[-1 - node_num];
+
+		for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
+			const int32_t brush_num = bsp->leaf_brushes[leaf->first_leaf_brush + i];
+
+			if (visited[brush_num]) {
+				continue;
+			}
+
+			visited[brush_num] = true;
+
+			const cm_bsp_brush_t *brush = &bsp->brushes[brush_num];
+			if (!brush->num_sides) {
+				continue;
+			}
+
+			// brushes are expanded as Cm_BoxTrace expands point traces
+			const ray_primitive_t primitive = {
+				.bounds = Box3_Expand(brush->bounds, BOX_EPSILON),
+				.center = Box3_Center(brush->bounds),
+				.brush = brush
+			};
+
+			g_array_append_val(primitives, primitive);
+		}
+		return;
+	}
+
+	const cm_bsp_node_t *node = &bsp->nodes[node_num];
+
+	GatherRayBrushes_r(bsp, node->children[0], visited, primitives);
+	GatherRayBrushes_r(bsp, node->children[1], visited, primitives);
+}
+
+/**
+ * @return The surface area of the specified bounds.
+ */
+static float RayBoundsArea(const box3_t bounds) {
+
+	const vec3_t size = Box3_Size(bounds);
+
+	return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+/**
+ * @brief Comparator for median splits, which sorts primitives along the given axis.
+ */
+static gint RayPrimitiveCmp(gconstpointer a, gconstpointer b, gpointer data) {
+
+	const int32_t axis = *(int32_t *) data;
+
+	const float ca = ((const ray_primitive_t *) a)->center.xyz[axis];
+	const float cb = ((const ray_primitive_t *) b)->center.xyz[axis];
+
+	return ca < cb ? -1 : ca > cb ? 1 : 0;
+}
+
+/**
+ * @brief Finds the cheapest binned split of the specified primitives.
+ * @return The split axis, or -1 if no split is cheaper than a leaf.
+ */
+static int32_t FindRaySplit(const ray_primitive_t *primitives, int32_t count, const box3_t bounds,
+							const box3_t centers, int32_t *split_bin) {
+
+	const float area = RayBoundsArea(bounds);
+
+	float best_cost = count; // the cost of a leaf, in brush tests
+	int32_t best_axis = -1;
+
+	for (int32_t axis = 0; axis < 3; axis++) {
+
+		const float min = centers.mins.xyz[axis];
+		const float extent = centers.maxs.xyz[axis] - min;
+
+		if (extent <= 0.f) {
+			continue;
+		}
+
+		int32_t counts[RAY_SAH_BINS] = { 0 };
+		box3_t bins[RAY_SAH_BINS];
+
+		for (int32_t i = 0; i < RAY_SAH_BINS; i++) {
+			bins[i] = Box3_Null();
+		}
+
+		const ray_primitive_t *p = primitives;
+		for (int32_t i = 0; i < count; i++, p++) {
+			const int32_t b = Mini((int32_t) ((p->center.xyz[axis] - min) * RAY_SAH_BINS / extent), RAY_SAH_BINS - 1);
+
+			counts[b]++;
+			bins[b] = Box3_Union(bins[b], p->bounds);
+		}
+
+		float right_area[RAY_SAH_BINS];
+		int32_t right_count[RAY_SAH_BINS];
+
+		box3_t right = Box3_Null();
+		int32_t num_right = 0;
+
+		for (int32_t i = RAY_SAH_BINS - 1; i > 0; i--) {
+			right = Box3_Union(right, bins[i]);
+			num_right += counts[i];
+
+			right_area[i] = num_right ? RayBoundsArea(right) : 0.f;
+			right_count[i] = num_right;
+		}
+
+		box3_t left = Box3_Null();
+		int32_t num_left = 0;
+
+		for (int32_t i = 0; i < RAY_SAH_BINS - 1; i++) {
+			left = Box3_Union(left, bins[i]);
+			num_left += counts[i];
+
+			if (num_left == 0 || right_count[i + 1] == 0) {
+				continue;
+			}
+
+			const float cost = 1.f + (RayBoundsArea(left) * num_left + right_area[i + 1] * right_count[i + 1]) / area;
+
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_axis = axis;
+				*split_bin = i;
+			}
+		}
+	}
+
+	return best_axis;
+}
+
+/**
+ * @brief Recursively builds the hierarchy for the specified primitives.
+ * @return The node number.
+ */
+static int32_t BuildRayNode(ray_tree_t *tree, ray_primitive_t *primitives, int32_t first, int32_t count, int32_t depth) {
+
+	const int32_t node_num = tree->num_nodes++;
+	ray_node_t *node = &tree->nodes[node_num];
+
+	box3_t bounds = Box3_Null(), centers = Box3_Null();
+
+	ray_primitive_t *p = primitives + first;
+	for (int32_t i = 0; i < count; i++, p++) {
+		bounds = Box3_Union(bounds, p->bounds);
+		centers = Box3_Append(centers, p->center);
+	}
+
+	node->bounds = bounds;
+
+	int32_t axis = -1, mid = 0;
+
+	if (count > RAY_LEAF_BRUSHES) {
+
+		if (depth < RAY_MAX_SAH_DEPTH) {
+			int32_t split_bin;
+
+			axis = FindRaySplit(primitives + first, count, bounds, centers, &split_bin);
+			if (axis != -1) {
+
+				const float min = centers.mins.xyz[axis];
+				const float extent = centers.maxs.xyz[axis] - min;
+
+				int32_t i = first, j = first + count - 1;
+				while (i <= j) {
+					const int32_t b = Mini((int32_t) ((primitives[i].center.xyz[axis] - min) * RAY_SAH_BINS / extent),
+										   RAY_SAH_BINS - 1);
+					if (b <= split_bin) {
+						i++;
+					} else {
+						const ray_primitive_t swap = primitives[i];
+						primitives[i] = primitives[j];
+						primitives[j--] = swap;
+					}
+				}
+
+				mid = i - first;
+			}
+		}
+
+		// fall back on median splits for oversized leafs and for pathologically deep trees
+		if (axis == -1 && (count > RAY_MAX_LEAF_BRUSHES || depth >= RAY_MAX_SAH_DEPTH)) {
+
+			const vec3_t size = Box3_Size(centers);
+			axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+
+			g_qsort_with_data(primitives + first, count, sizeof(ray_primitive_t), RayPrimitiveCmp, &axis);
+
+			mid = count / 2;
+		}
+	}
+
+	if (axis == -1) {
+		node->first_brush = first;
+		node->num_brushes = count;
+
+		for (int32_t i = first; i < first + count; i++) {
+			tree->brushes[i] = primitives[i].brush;
+		}
+
+		return node_num;
+	}
+
+	node->axis = axis;
+
+	BuildRayNode(tree, primitives, first, mid, depth + 1);
+
+	const int32_t child = BuildRayNode(tree, primitives, first + mid, count - mid, depth + 1);
+	tree->nodes[node_num].child = child;
+
+	return node_num;
+}
+
+/**
+ * @brief Builds the hierarchy for the BSP model with the specified head node.
+ */
+static void BuildRayTree(ray_tree_t *tree, int32_t head_node) {
+
+	const cm_bsp_t *bsp = Cm_Bsp();
+
+	tree->head_node = head_node;
+
+	byte *visited = Mem_TagMalloc(bsp->file.num_brushes, MEM_TAG_RAYTRACE);
+	GArray *primitives = g_array_new(false, false, sizeof(ray_primitive_t));
+
+	GatherRayBrushes_r(bsp, head_node, visited, primitives);
+
+	tree->num_brushes = primitives->len;
+
+	if (tree->num_brushes) {
+		tree->brushes = Mem_TagMalloc(tree->num_brushes * sizeof(cm_bsp_brush_t *), MEM_TAG_RAYTRACE);
+		tree->nodes = Mem_TagMalloc(tree->num_brushes * 2 * sizeof(ray_node_t), MEM_TAG_RAYTRACE);
+
+		BuildRayNode(tree, (ray_primitive_t *) primitives->data, 0, tree->num_brushes, 0);
+	}
+
+	g_array_free(primitives, true);
+	Mem_Free(visited);
+}
+
+/**
+ * @brief Builds the ray tracing hierarchies for all BSP models. The collision
+ * model must be loaded.
+ */
+void BuildRayTracer(void) {
+
+	const uint32_t start = SDL_GetTicks();
+
+	num_ray_trees = Cm_NumModels();
+	ray_trees = Mem_TagMalloc(num_ray_trees * sizeof(ray_tree_t), MEM_TAG_RAYTRACE);
+
+	int32_t num_brushes = 0, num_nodes = 0;
+
+	for (int32_t i = 0; i < num_ray_trees; i++) {
+		BuildRayTree(&ray_trees[i], Cm_Bsp()->models[i].head_node);
+
+		num_brushes += ray_trees[i].num_brushes;
+		num_nodes += ray_trees[i].num_nodes;
+	}
+
+	Com_Verbose("Ray tracer: %d brushes, %d nodes in %d ms\n", num_brushes, num_nodes, SDL_GetTicks() - start);
+}
+
+/**
+ * @return The hierarchy for the specified head node.
+ */
+static const ray_tree_t *RayTreeForHeadNode(int32_t head_node) {
+
+	for (int32_t i = 0; i < num_ray_trees; i++) {
+		if (ray_trees[i].head_node == head_node) {
+			return &ray_trees[i];
+		}
+	}
+
+	Com_Error(ERROR_FATAL, "Invalid head node: %d\n", head_node);
+}
+
+/**
+ * @return True if any active ray in the packet intersects the specified bounds
+ * before its current fraction.
+ */
+static _Bool RayPacketIntersectsBounds(const ray_packet_t *packet, const box3_t *bounds) {
+
+	int32_t hit = 0;
+
+	for (int32_t i = 0; i < RAY_PACKET_SIZE; i++) {
+
+		float enter = 0.f, leave = packet->fraction[i];
+
+		for (int32_t j = 0; j < 3; j++) {
+			const float t0 = (bounds->mins.xyz[j] - packet->start[j][i]) * packet->inv_dir[j][i];
+			const float t1 = (bounds->maxs.xyz[j] - packet->start[j][i]) * packet->inv_dir[j][i];
+
+			enter = Maxf(enter, Minf(t0, t1));
+			leave = Minf(leave, Maxf(t0, t1));
+		}
+
+		hit |= packet->active[i] & (enter <= leave);
+	}
+
+	return hit;
+}
+
+/**
+ * @brief Clips every active ray in the packet to the specified brush. This mirrors
+ * Cm_TraceToBrush for point traces, so that fractions are identical.
+ */
+static void RayPacketClipBrush(ray_packet_t *packet, const cm_bsp_brush_t *brush) {
+
+	float enter[RAY_PACKET_SIZE], leave[RAY_PACKET_SIZE];
+	int32_t start_outside[RAY_PACKET_SIZE], end_outside[RAY_PACKET_SIZE], miss[RAY_PACKET_SIZE];
+	const cm_bsp_brush_side_t *clip_side[RAY_PACKET_SIZE];
+
+	for (int32_t i = 0; i < RAY_PACKET_SIZE; i++) {
+		enter[i] = -1.f;
+		leave[i] = 1.f;
+		start_outside[i] = end_outside[i] = 0;
+		miss[i] = !packet->active[i];
+		clip_side[i] = NULL;
+	}
+
+	const cm_bsp_brush_side_t *side = brush->sides;
+	for (int32_t j = 0; j < brush->num_sides; j++, side++) {
+
+		const cm_bsp_plane_t *plane = side->plane;
+
+		for (int32_t i = 0; i < RAY_PACKET_SIZE; i++) {
+
+			const float d1 = packet->start[0][i] * plane->normal.x +
+							 packet->start[1][i] * plane->normal.y +
+							 packet->start[2][i] * plane->normal.z - plane->dist;
+			const float d2 = packet->end[0][i] * plane->normal.x +
+							 packet->end[1][i] * plane->normal.y +
+							 packet->end[2][i] * plane->normal.z - plane->dist;
+
+			start_outside[i] |= d1 > 0.f;
+			end_outside[i] |= d2 > 0.f;
+
+			if (d1 > 0.f && (d2 > TRACE_EPSILON || d2 >= d1)) {
+				miss[i] = 1;
+			} else if (d1 <= 0.f && d2 <= 0.f) {
+				continue;
+			} else if (d1 > d2) {
+				const float f = Maxf(0.f, (d1 - TRACE_EPSILON) / (d1 - d2));
+				if (f > enter[i]) {
+					enter[i] = f;
+					clip_side[i] = side;
+				}
+			} else {
+				const float f = Minf(1.f, (d1 + TRACE_EPSILON) / (d1 - d2));
+				if (f < leave[i]) {
+					leave[i] = f;
+				}
+			}
+		}
+	}
+
+	for (int32_t i = 0; i < RAY_PACKET_SIZE; i++) {
+
+		if (miss[i]) {
+			continue;
+		}
+
+		if (!start_outside[i]) {
+			packet->start_solid[i] = true;
+			if (!end_outside[i]) {
+				packet->all_solid[i] = true;
+				packet->fraction[i] = 0.f;
+				packet->brush[i] = brush;
+				packet->active[i] = false;
+			}
+		} else if (enter[i] < leave[i]) {
+			if (enter[i] > -1.f && enter[i] < packet->fraction[i]) {
+				packet->fraction[i] = Maxf(0.f, enter[i]);
+				packet->brush[i] = brush;
+				packet->side[i] = clip_side[i];
+
+				if (packet->mode == RAY_OCCLUSION) {
+					packet->active[i] = false;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @return True if any ray in the packet remains active.
+ */
+static _Bool RayPacketActive(const ray_packet_t *packet) {
+
+	int32_t active = 0;
+
+	for (int32_t i = 0; i < RAY_PACKET_SIZE; i++) {
+		active |= packet->active[i];
+	}
+
+	return active;
+}
+
+/**
+ * @brief Traces the packet through the specified hierarchy, front to back.
+ */
+static void RayPacketTraceTree(ray_packet_t *packet, const ray_tree_t *tree) {
+
+	if (tree->num_nodes == 0) {
+		return;
+	}
+
+	int32_t stack[RAY_STACK_SIZE];
+	int32_t depth = 0;
+
+	stack[depth++] = 0;
+
+	// order children by the direction of the first active ray
+	int32_t lead = 0;
+	while (!packet->active[lead]) {
+		lead++;
+	}
+
+	while (depth) {
+		const int32_t node_num = stack[--depth];
+		const ray_node_t *node = &tree->nodes[node_num];
+
+		if (!RayPacketIntersectsBounds(packet, &node->bounds)) {
+			continue;
+		}
+
+		if (node->num_brushes) {
+			for (int32_t i = 0; i < node->num_brushes; i++) {
+				const cm_bsp_brush_t *brush = tree->brushes[node->first_brush + i];
+
+				if (brush->contents & packet->mask) {
+					RayPacketClipBrush(packet, brush);
+				}
+			}
+
+			if (!RayPacketActive(packet)) {
+				return;
+			}
+
+			continue;
+		}
+
+		if (packet->inv_dir[node->axis][lead] < 0.f) {
+			stack[depth++] = node_num + 1;
+			stack[depth++] = node->child;
+		} else {
+			stack[depth++] = node->child;
+			stack[depth++] = node_num + 1;
+		}
+	}
+}
+
+/**
+ * @brief Traces up to RAY_PACKET_SIZE rays from `start` to each of `ends`.
+ */
+static void RayTracePacket_(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask,
+							ray_mode_t mode, cm_trace_t *traces) {
+
+	ray_packet_t packet = {
+		.mask = mask,
+		.mode = mode
+	};
+
+	for (int32_t i = 0; i < count; i++) {
+		for (int32_t j = 0; j < 3; j++) {
+			const float dir = ends[i].xyz[j] - start.xyz[j];
+
+			packet.start[j][i] = start.xyz[j];
+			packet.end[j][i] = ends[i].xyz[j];
+			packet.inv_dir[j][i] = dir == 0.f ? 1e30f : 1.f / dir;
+		}
+
+		packet.fraction[i] = 1.f;
+		packet.active[i] = true;
+	}
+
+	RayPacketTraceTree(&packet, RayTreeForHeadNode(0));
+
+	if (head_node && RayPacketActive(&packet)) {
+		RayPacketTraceTree(&packet, RayTreeForHeadNode(head_node));
+	}
+
+	for (int32_t i = 0; i < count; i++) {
+		cm_trace_t *trace = &traces[i];
+
+		memset(trace, 0, sizeof(*trace));
+
+		trace->fraction = packet.fraction[i];
+		trace->start_solid = packet.start_solid[i];
+		trace->all_solid = packet.all_solid[i];
+
+		if (packet.brush[i]) {
+			trace->contents = packet.brush[i]->contents;
+		}
+
+		if (packet.side[i]) {
+			trace->plane = *packet.side[i]->plane;
+			trace->texinfo = packet.side[i]->texinfo;
+		}
+
+		if (trace->fraction == 0.f) {
+			trace->end = start;
+		} else if (trace->fraction == 1.f) {
+			trace->end = ends[i];
+		} else {
+			trace->end = Vec3_Mix(start, ends[i], trace->fraction);
+		}
+	}
+}
+
+/**
+ * @brief Traces rays from `start` to each of `ends` against the world and the
+ * optional inline model at `head_node`, as Light_Trace would.
+ * @param mode In RAY_OCCLUSION mode, rays terminate on their first intersection,
+ * so only `fraction < 1` is meaningful in the resulting traces.
+ */
+void RayTracePacket(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask,
+					ray_mode_t mode, cm_trace_t *traces) {
+
+	for (int32_t i = 0; i < count; i += RAY_PACKET_SIZE) {
+		RayTracePacket_(start, ends + i, Mini(count - i, RAY_PACKET_SIZE), head_node, mask, mode, traces + i);
+	}
+}
+
+/**
+ * @brief Traces a single ray, resolving its nearest intersection.
+ */
+cm_trace_t RayTrace(const vec3_t start, const vec3_t end, int32_t head_node, int32_t mask) {
+	cm_trace_t trace;
+
+	RayTracePacket_(start, &end, 1, head_node, mask, RAY_NEAREST, &trace);
+
+	return trace;
+}
+
+/**
+ * @brief Frees the ray tracing hierarchies.
+ */
+void FreeRayTracer(void) {
+
+	Mem_FreeTag(MEM_TAG_RAYTRACE);
+
+	ray_trees = NULL;
+	num_ray_trees = 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "quemap.h"
+
+/**
+ * @brief The number of rays traced together in a packet. Packets are laid out as
+ * structures of arrays, so that the per-ray loops vectorize.
+ */
+#define RAY_PACKET_SIZE 8
+
+/**
+ * @brief Ray tracing modes.
+ */
+typedef enum {
+	/**
+	 * @brief Resolve the nearest intersection of each ray.
+	 */
+	RAY_NEAREST,
+
+	/**
+	 * @brief Resolve only whether each ray is obstructed, terminating on any intersection.
+	 */
+	RAY_OCCLUSION
+} ray_mode_t;
+
+void BuildRayTracer(void);
+cm_trace_t RayTrace(const vec3_t start, const vec3_t end, int32_t head_node, int32_t mask);
+void RayTracePacket(const vec3_t start, const vec3_t *ends, int32_t count, int32_t head_node, int32_t mask,
+					ray_mode_t mode, cm_trace_t *traces);
+void FreeRayTracer(void);
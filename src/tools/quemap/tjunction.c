@@ -23,102 +23,243 @@
 #include "portal.h"
 #include "qbsp.h"
 
+/**
+ * @brief The size of the grid cells by which face vertexes are indexed.
+ */
+#define TJUNCTION_CELL_SIZE 64.f
+
 static SDL_atomic_t c_tjunctions;
+static SDL_atomic_t c_tjunction_tests;
 static GPtrArray *faces;
-static SDL_SpinLock *faces_locks;
-static int32_t largest_winding = 0;
 
 /**
- * @brief
+ * @brief The face vertexes, snapshotted before any t-junctions are fixed, and indexed
+ * by grid cell. Vertexes inserted into windings are vertexes of other faces, so the
+ * snapshot includes every vertex that may be inserted.
  */
-static void FixTJunctions_(int32_t face_num) {
-	static _Thread_local cm_winding_t *face_winding, *f_winding;
+static struct {
+	/**
+	 * @brief The vertexes of all faces, in face order.
+	 */
+	vec3_t *points;
+
+	/**
+	 * @brief The index of the face each vertex belongs to.
+	 */
+	int32_t *point_faces;
+
+	/**
+	 * @brief The bounds of each face, expanded to include vertexes that test as on its edges.
+	 */
+	box3_t *bounds;
+
+	/**
+	 * @brief The vertex indexes in each grid cell, in ascending order.
+	 */
+	GHashTable *cells;
+} tjunction_index;
 
-	if (!face_winding) {
-		face_winding = Cm_AllocWinding(largest_winding);
-		f_winding = Cm_AllocWinding(largest_winding);
-	}
+/**
+ * @return The grid cell containing the specified coordinate.
+ */
+static int32_t TJunctionCell(float f) {
+	return (int32_t) floorf(Clampf(f, -MAX_WORLD_COORD, MAX_WORLD_COORD) / TJUNCTION_CELL_SIZE);
+}
 
-	face_t *face = g_ptr_array_index(faces, face_num);
+/**
+ * @return The hash table key for the specified grid cell.
+ */
+static gpointer TJunctionCellKey(int32_t x, int32_t y, int32_t z) {
+	const int32_t offset = MAX_WORLD_COORD / TJUNCTION_CELL_SIZE + 1;
+	return GINT_TO_POINTER((x + offset) | ((y + offset) << 10) | ((z + offset) << 20));
+}
 
-	SDL_SpinLock *face_lock = &faces_locks[face_num];
+/**
+ * @brief Snapshots the vertexes of all faces, indexing them by grid cell.
+ */
+static void BuildTJunctionIndex(void) {
 
-	const plane_t *plane = &planes[face->plane_num];
+	size_t num_points = 0;
+	for (guint i = 0; i < faces->len; i++) {
+		const face_t *face = g_ptr_array_index(faces, i);
+		num_points += face->w->num_points;
+	}
 
-	// Make a copy of face->w for testing
-	SDL_AtomicLock(face_lock);
-	memcpy(face_winding, face->w, sizeof(cm_winding_t) + (face->w->num_points * sizeof(vec3_t)));
-	SDL_AtomicUnlock(face_lock);
+	tjunction_index.points = Mem_Malloc(num_points * sizeof(vec3_t));
+	tjunction_index.point_faces = Mem_Malloc(num_points * sizeof(int32_t));
+	tjunction_index.bounds = Mem_Malloc(faces->len * sizeof(box3_t));
+	tjunction_index.cells = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_array_unref);
 
-	for (size_t s = 0; s < faces->len; s++) {
+	int32_t p = 0;
+	for (guint i = 0; i < faces->len; i++) {
+		const face_t *face = g_ptr_array_index(faces, i);
 
-		const face_t *f = g_ptr_array_index(faces, s);
-		if (face == f) {
-			continue;
+		// vertexes are considered colinear with an edge within an angle of sqrt(2 * COLINEAR_EPSILON),
+		// so they may lie slightly off of long edges
+		float edge_length = 0.f;
+		for (int32_t j = 0; j < face->w->num_points; j++) {
+			const vec3_t v0 = face->w->points[j];
+			const vec3_t v1 = face->w->points[(j + 1) % face->w->num_points];
+
+			edge_length = Maxf(edge_length, Vec3_Distance(v0, v1));
 		}
-		
-		SDL_SpinLock *f_lock = &faces_locks[s];
 
-		SDL_AtomicLock(f_lock);
-		memcpy(f_winding, f->w, sizeof(cm_winding_t) + (f->w->num_points * sizeof(vec3_t)));
-		SDL_AtomicUnlock(f_lock);
+		const float expansion = ON_EPSILON + edge_length * sqrtf(2.f * COLINEAR_EPSILON) * .5f;
 
-		for (int32_t i = 0; i < f_winding->num_points; i++) {
-			const vec3_t v = f_winding->points[i];
+		tjunction_index.bounds[i] = Box3_Expand(Cm_WindingBounds(face->w), expansion);
 
-			const double d = Vec3_Dot(v, plane->normal) - plane->dist;
-			if (d > ON_EPSILON || d < -ON_EPSILON) {
-				continue; // v is not on face's plane
+		for (int32_t j = 0; j < face->w->num_points; j++, p++) {
+			const vec3_t v = face->w->points[j];
+
+			tjunction_index.points[p] = v;
+			tjunction_index.point_faces[p] = i;
+
+			gpointer key = TJunctionCellKey(TJunctionCell(v.x), TJunctionCell(v.y), TJunctionCell(v.z));
+			GArray *cell = g_hash_table_lookup(tjunction_index.cells, key);
+
+			if (!cell) {
+				cell = g_array_new(false, false, sizeof(int32_t));
+				g_hash_table_insert(tjunction_index.cells, key, cell);
 			}
 
-			// v is on face's plane, so test it against face's edges
+			g_array_append_val(cell, p);
+		}
+	}
+}
 
-			for (int32_t j = 0; j < face_winding->num_points; j++) {
+/**
+ * @brief Frees the face vertex snapshot and index.
+ */
+static void FreeTJunctionIndex(void) {
 
-				const vec3_t v0 = face_winding->points[(j + 0) % face_winding->num_points];
-				const vec3_t v1 = face_winding->points[(j + 1) % face_winding->num_points];
+	Mem_Free(tjunction_index.points);
+	Mem_Free(tjunction_index.point_faces);
+	Mem_Free(tjunction_index.bounds);
 
-				vec3_t a;
-				const float a_dist = Vec3_DistanceDir(v0, v, &a);
+	g_hash_table_destroy(tjunction_index.cells);
 
-				vec3_t b;
-				const float b_dist = Vec3_DistanceDir(v1, v, &b);
+	memset(&tjunction_index, 0, sizeof(tjunction_index));
+}
 
-				if (a_dist < ON_EPSILON || b_dist < ON_EPSILON) {
-					break; // face already includes v
-				}
+/**
+ * @brief GCompareFunc for sorting vertex indexes.
+ */
+static gint TJunctionPointCmp(gconstpointer a, gconstpointer b) {
+	return *(const int32_t *) a - *(const int32_t *) b;
+}
+
+/**
+ * @brief Populates points with the indexes of the vertexes of other faces that lie within
+ * the bounds of the specified face, in ascending order.
+ */
+static void TJunctionPointsForFace(int32_t face_num, GArray *points) {
+
+	const box3_t bounds = tjunction_index.bounds[face_num];
+
+	const int32_t x0 = TJunctionCell(bounds.mins.x), x1 = TJunctionCell(bounds.maxs.x);
+	const int32_t y0 = TJunctionCell(bounds.mins.y), y1 = TJunctionCell(bounds.maxs.y);
+	const int32_t z0 = TJunctionCell(bounds.mins.z), z1 = TJunctionCell(bounds.maxs.z);
+
+	for (int32_t z = z0; z <= z1; z++) {
+		for (int32_t y = y0; y <= y1; y++) {
+			for (int32_t x = x0; x <= x1; x++) {
 
-				const float d = Vec3_Dot(a, b);
-				if (d > -1.0 + COLINEAR_EPSILON) {
-					continue; // v is not on the edge v0 <-> v1
+				const GArray *cell = g_hash_table_lookup(tjunction_index.cells, TJunctionCellKey(x, y, z));
+				if (!cell) {
+					continue;
 				}
 
-				// v sits between v0 and v1, so add it to the face
-				cm_winding_t *w = Cm_AllocWinding(face_winding->num_points + 1);
-				w->num_points = face_winding->num_points + 1;
-
-				for (int32_t k = 0; k < w->num_points; k++) {
-					if (k <= j) {
-						w->points[k] = face_winding->points[k];
-					} else if (k == j + 1) {
-						w->points[k] = v;
-					} else {
-						w->points[k] = face_winding->points[k - 1];
+				for (guint i = 0; i < cell->len; i++) {
+					const int32_t p = g_array_index(cell, int32_t, i);
+
+					if (tjunction_index.point_faces[p] == face_num) {
+						continue;
+					}
+
+					if (!Box3_ContainsPoint(bounds, tjunction_index.points[p])) {
+						continue;
 					}
+
+					g_array_append_val(points, p);
 				}
+			}
+		}
+	}
 
-				SDL_AtomicLock(face_lock);
+	// visit the vertexes in face order, as an exhaustive search would
+	g_array_sort(points, TJunctionPointCmp);
+}
+
+/**
+ * @brief
+ */
+static void FixTJunctions_(int32_t face_num) {
+	static _Thread_local GArray *points;
+
+	if (!points) {
+		points = g_array_new(false, false, sizeof(int32_t));
+	}
+
+	face_t *face = g_ptr_array_index(faces, face_num);
+
+	const plane_t *plane = &planes[face->plane_num];
 
-				// Copy back to face, and copy to temp winding
-				Cm_FreeWinding(face->w);
-				face->w = w;
-				memcpy(face_winding, face->w, sizeof(cm_winding_t) + (face->w->num_points * sizeof(vec3_t)));
+	g_array_set_size(points, 0);
+	TJunctionPointsForFace(face_num, points);
 
-				SDL_AtomicUnlock(face_lock);
+	SDL_AtomicAdd(&c_tjunction_tests, points->len);
 
-				SDL_AtomicAdd(&c_tjunctions, 1);
-				break;
+	for (guint i = 0; i < points->len; i++) {
+		const vec3_t v = tjunction_index.points[g_array_index(points, int32_t, i)];
+
+		const double d = Vec3_Dot(v, plane->normal) - plane->dist;
+		if (d > ON_EPSILON || d < -ON_EPSILON) {
+			continue; // v is not on face's plane
+		}
+
+		// v is on face's plane, so test it against face's edges
+		// other faces are tested against the snapshot, so only this thread accesses face->w
+		const cm_winding_t *face_winding = face->w;
+
+		for (int32_t j = 0; j < face_winding->num_points; j++) {
+
+			const vec3_t v0 = face_winding->points[(j + 0) % face_winding->num_points];
+			const vec3_t v1 = face_winding->points[(j + 1) % face_winding->num_points];
+
+			vec3_t a;
+			const float a_dist = Vec3_DistanceDir(v0, v, &a);
+
+			vec3_t b;
+			const float b_dist = Vec3_DistanceDir(v1, v, &b);
+
+			if (a_dist < ON_EPSILON || b_dist < ON_EPSILON) {
+				break; // face already includes v
+			}
+
+			const float d = Vec3_Dot(a, b);
+			if (d > -1.0 + COLINEAR_EPSILON) {
+				continue; // v is not on the edge v0 <-> v1
 			}
+
+			// v sits between v0 and v1, so add it to the face
+			cm_winding_t *w = Cm_AllocWinding(face_winding->num_points + 1);
+			w->num_points = face_winding->num_points + 1;
+
+			for (int32_t k = 0; k < w->num_points; k++) {
+				if (k <= j) {
+					w->points[k] = face_winding->points[k];
+				} else if (k == j + 1) {
+					w->points[k] = v;
+				} else {
+					w->points[k] = face_winding->points[k - 1];
+				}
+			}
+
+			Cm_FreeWinding(face->w);
+			face->w = w;
+
+			SDL_AtomicAdd(&c_tjunctions, 1);
+			break;
 		}
 	}
 }
@@ -141,8 +282,6 @@ static void FixTJunctions_r(node_t *node) {
 			continue;
 		}
 		g_ptr_array_add(faces, face);
-
-		largest_winding = MAX(largest_winding, face->w->num_points);
 	}
 }
 
@@ -153,18 +292,23 @@ void FixTJunctions(node_t *node) {
 
 	Com_Verbose("--- FixTJunctions ---\n");
 	SDL_AtomicSet(&c_tjunctions, 0);
+	SDL_AtomicSet(&c_tjunction_tests, 0);
 
 	faces = g_ptr_array_new();
 	FixTJunctions_r(node);
 
-	largest_winding = sizeof(cm_winding_t) + (sizeof(vec3_t) * largest_winding);
+	const uint32_t start = SDL_GetTicks();
 
-	faces_locks = Mem_Malloc(sizeof(SDL_SpinLock) * faces->len);
+	BuildTJunctionIndex();
+
+	Com_Verbose("Indexed %u faces in %u ms\n", faces->len, SDL_GetTicks() - start);
 
 	Work("Fixing t-junctions", FixTJunctions_, faces->len);
 
 	Com_Verbose("%5i fixed tjunctions\n", SDL_AtomicGet(&c_tjunctions));
+	Com_Verbose("%5i vertexes tested\n", SDL_AtomicGet(&c_tjunction_tests));
+
+	FreeTJunctionIndex();
 
-	Mem_Free(faces_locks);
 	g_ptr_array_free(faces, true);
 }
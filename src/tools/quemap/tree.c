@@ -190,15 +190,75 @@ static int32_t SelectSplitSideHeuristic(const brush_side_t *side, const csg_brus
 	return value;
 }
 
+/**
+ * @brief Split planes are evaluated in parallel when there are at least this many
+ * candidates multiplied by brushes.
+ */
+#define PARALLEL_SPLIT_WORK 0x2000
+
+/**
+ * @brief Children with at least this many brushes are built in parallel.
+ */
+#define PARALLEL_TREE_BRUSHES 64
+
+/**
+ * @brief A candidate split plane, and its heuristic value if it splits the node volume.
+ */
+typedef struct {
+	const brush_side_t *side;
+	int32_t plane_num;
+	_Bool valid;
+	int32_t value;
+} split_candidate_t;
+
+/**
+ * @brief The candidate split planes for a node.
+ */
+typedef struct {
+	const node_t *node;
+	const csg_brush_t *brushes;
+	GArray *candidates;
+} split_candidates_t;
+
+/**
+ * @brief JobRangeFunc that evaluates a range of candidate split planes.
+ */
+static void EvaluateSplitCandidates(int32_t begin, int32_t end, void *data) {
+
+	const split_candidates_t *split = data;
+
+	for (int32_t i = begin; i < end; i++) {
+		split_candidate_t *c = &g_array_index(split->candidates, split_candidate_t, i);
+
+		csg_brush_t *front, *back;
+		SplitBrush(split->node->volume, c->plane_num, &front, &back);
+		c->valid = (front && back);
+		if (front) {
+			FreeBrush(front);
+		}
+		if (back) {
+			FreeBrush(back);
+		}
+		if (c->valid) {
+			c->value = SelectSplitSideHeuristic(c->side, split->brushes);
+		}
+	}
+}
+
 /**
  * @return The original brush side from brushes with the highest heuristic value.
+ * @remark Candidates are evaluated concurrently, but are selected in brush order, so
+ * that the same side is chosen as by a serial search.
  */
 static const brush_side_t *SelectSplitSide(node_t *node, csg_brush_t *brushes) {
+	static _Thread_local byte *plane_bits;
+	static _Thread_local int32_t plane_bits_size;
 
-	const brush_side_t *best_side = NULL;
-	int32_t best_value = INT32_MIN;
-
-	GPtrArray *cache = g_ptr_array_new();
+	if (plane_bits_size < num_planes) {
+		plane_bits_size = num_planes;
+		plane_bits = g_realloc(plane_bits, (plane_bits_size + 7) >> 3);
+		memset(plane_bits, 0, (plane_bits_size + 7) >> 3);
+	}
 
 	_Bool have_structural = false;
 	for (const csg_brush_t *brush = brushes; brush; brush = brush->next) {
@@ -210,8 +270,20 @@ static const brush_side_t *SelectSplitSide(node_t *node, csg_brush_t *brushes) {
 		}
 	}
 
+	split_candidates_t split = {
+		.node = node,
+		.brushes = brushes,
+		.candidates = g_array_new(false, false, sizeof(split_candidate_t))
+	};
+
+	int32_t num_brushes = 0;
+
+	// gather each plane once, from the first side that references it; planes that do not
+	// split the volume never will, so those need not be tried twice either
 	for (const csg_brush_t *brush = brushes; brush; brush = brush->next) {
 
+		num_brushes++;
+
 		if (brush->original->contents & CONTENTS_DETAIL) {
 			if (have_structural) {
 				continue;
@@ -231,34 +303,48 @@ static const brush_side_t *SelectSplitSide(node_t *node, csg_brush_t *brushes) {
 			assert(side->winding);
 
 			const int32_t plane_num = side->plane_num ^ 1;
-			if (g_ptr_array_find(cache, (gconstpointer) (intptr_t) plane_num, NULL)) {
+			if (plane_bits[plane_num >> 3] & (1 << (plane_num & 7))) {
 				continue;
 			}
 
-			csg_brush_t *front, *back;
-			SplitBrush(node->volume, plane_num, &front, &back);
-			const _Bool valid_split = (front && back);
-			if (front) {
-				FreeBrush(front);
-			}
-			if (back) {
-				FreeBrush(back);
-			}
-			if (!valid_split) {
-				continue;
-			}
+			plane_bits[plane_num >> 3] |= (1 << (plane_num & 7));
 
-			const int32_t value = SelectSplitSideHeuristic(side, brushes);
-			if (value > best_value) {
-				best_side = side->original;
-				best_value = value;
-			}
+			const split_candidate_t c = {
+				.side = side,
+				.plane_num = plane_num
+			};
+
+			g_array_append_val(split.candidates, c);
+		}
+	}
+
+	// clear the bits for the next node, before any other work may run on this thread
+	for (guint i = 0; i < split.candidates->len; i++) {
+		const int32_t plane_num = g_array_index(split.candidates, split_candidate_t, i).plane_num;
+		plane_bits[plane_num >> 3] &= ~(1 << (plane_num & 7));
+	}
+
+	const int32_t count = (int32_t) split.candidates->len;
+
+	if (count * num_brushes >= PARALLEL_SPLIT_WORK) {
+		Job_ParallelFor(count, 1, EvaluateSplitCandidates, &split);
+	} else {
+		EvaluateSplitCandidates(0, count, &split);
+	}
+
+	const brush_side_t *best_side = NULL;
+	int32_t best_value = INT32_MIN;
+
+	for (int32_t i = 0; i < count; i++) {
+		const split_candidate_t *c = &g_array_index(split.candidates, split_candidate_t, i);
 
-			g_ptr_array_add(cache, (gpointer) (intptr_t) plane_num);
+		if (c->valid && c->value > best_value) {
+			best_side = c->side->original;
+			best_value = c->value;
 		}
 	}
 
-	g_ptr_array_free(cache, true);
+	g_array_free(split.candidates, true);
 
 	return best_side;
 }
@@ -313,6 +399,16 @@ static void SplitBrushes(csg_brush_t *brushes, const node_t *node, csg_brush_t *
 	}
 }
 
+/**
+ * @brief A subtree to be built by a job.
+ */
+typedef struct {
+	node_t *node;
+	csg_brush_t *brushes;
+} build_tree_t;
+
+static void BuildTree_Job(void *data);
+
 /**
  * @brief
  */
@@ -341,14 +437,40 @@ static node_t *BuildTree_r(node_t *node, csg_brush_t *brushes) {
 
 	SplitBrush(node->volume, node->plane_num, &node->children[0]->volume, &node->children[1]->volume);
 
-	// recursively process children
-	for (int32_t i = 0; i < 2; i++) {
-		node->children[i] = BuildTree_r(node->children[i], children[i]);
+	// recursively process children, in parallel if both are sizable
+	if (CountBrushes(children[0]) >= PARALLEL_TREE_BRUSHES &&
+		CountBrushes(children[1]) >= PARALLEL_TREE_BRUSHES) {
+
+		build_tree_t back = {
+			.node = node->children[1],
+			.brushes = children[1]
+		};
+
+		job_counter_t counter = {};
+		Job_Run(&counter, BuildTree_Job, &back);
+
+		node->children[0] = BuildTree_r(node->children[0], children[0]);
+
+		Job_Wait(&counter);
+	} else {
+		for (int32_t i = 0; i < 2; i++) {
+			node->children[i] = BuildTree_r(node->children[i], children[i]);
+		}
 	}
 
 	return node;
 }
 
+/**
+ * @brief JobFunc for building a subtree.
+ */
+static void BuildTree_Job(void *data) {
+
+	build_tree_t *build = data;
+
+	build->node = BuildTree_r(build->node, build->brushes);
+}
+
 /**
  * @brief
  * @remark The incoming list will be freed before exiting
@@ -397,7 +519,7 @@ tree_t *BuildTree(csg_brush_t *brushes) {
 
 	BuildTree_r(tree->head_node, brushes);
 
-	Com_Print("\r%-24s [100%%] %d ms\n", "Building tree", SDL_GetTicks() - start);
+	WorkReport("Building tree", SDL_GetTicks() - start);
 
 	return tree;
 }
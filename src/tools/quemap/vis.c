@@ -0,0 +1,340 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "bsp.h"
+#include "vis.h"
+
+/**
+ * @brief Vis portals are one-way views from one cluster into another. Each portal written to
+ * the .prt file yields two vis portals, one facing each way.
+ */
+typedef struct {
+	const cm_winding_t *winding;
+	vec3_t normal; // facing into the cluster this portal leads to
+	double dist;
+	int32_t cluster; // the cluster this portal leads to
+	byte *front; // portals which are at least partially in front of this portal
+	byte *flood; // portals which may be seen through this portal
+} vis_portal_t;
+
+/**
+ * @brief Clusters own the vis portals which lead out of them.
+ */
+typedef struct {
+	GPtrArray *portals;
+} vis_cluster_t;
+
+static struct {
+	GArray *portals;
+	vis_cluster_t *clusters;
+	int32_t num_clusters;
+
+	size_t portal_bytes;
+	size_t cluster_bytes;
+
+	byte *pvs;
+	byte *phs;
+} vis;
+
+#define VIS_BIT(bits, n) ((bits)[(n) >> 3] & (1 << ((n) & 7)))
+#define VIS_SET_BIT(bits, n) ((bits)[(n) >> 3] |= (1 << ((n) & 7)))
+
+/**
+ * @brief Adds a vis portal leading into `to`, facing along `normal`.
+ */
+static void AddVisPortal(const portal_t *p, const node_t *to, const vec3_t normal, double dist) {
+
+	const vis_portal_t portal = {
+		.winding = p->winding,
+		.normal = normal,
+		.dist = dist,
+		.cluster = to->cluster
+	};
+
+	g_array_append_val(vis.portals, portal);
+}
+
+/**
+ * @brief Gathers the vis portals of all clusters in the tree, mirroring WritePortalFile_r.
+ */
+static void GatherVisPortals_r(const node_t *node) {
+
+	// decision node
+	if (node->plane_num != PLANE_NUM_LEAF && !(node->split_side->contents & CONTENTS_DETAIL)) {
+		GatherVisPortals_r(node->children[0]);
+		GatherVisPortals_r(node->children[1]);
+		return;
+	}
+
+	if (node->contents & CONTENTS_SOLID) {
+		return;
+	}
+
+	int32_t s;
+	for (const portal_t *p = node->portals; p; p = p->next[s]) {
+		s = (p->nodes[1] == node);
+
+		if (!p->winding || p->nodes[0] != node) {
+			continue;
+		}
+
+		if (!Portal_VisFlood(p)) {
+			continue;
+		}
+
+		const node_t *front = p->nodes[0], *back = p->nodes[1];
+		if (front->cluster < 0 || back->cluster < 0) {
+			continue;
+		}
+
+		AddVisPortal(p, back, Vec3_Negate(p->plane.normal), -p->plane.dist);
+		AddVisPortal(p, front, p->plane.normal, p->plane.dist);
+	}
+}
+
+/**
+ * @brief Assigns each vis portal to the cluster it leads out of.
+ */
+static void LinkVisPortals(void) {
+
+	vis.clusters = Mem_TagMalloc(sizeof(vis_cluster_t) * vis.num_clusters, MEM_TAG_VIS);
+
+	for (int32_t i = 0; i < vis.num_clusters; i++) {
+		vis.clusters[i].portals = g_ptr_array_new();
+	}
+
+	for (guint i = 0; i < vis.portals->len; i++) {
+
+		// vis portals are added in pairs, each leading out of its sibling's cluster
+		vis_portal_t *p = &g_array_index(vis.portals, vis_portal_t, i);
+		const vis_portal_t *sibling = &g_array_index(vis.portals, vis_portal_t, i ^ 1);
+
+		g_ptr_array_add(vis.clusters[sibling->cluster].portals, p);
+	}
+}
+
+/**
+ * @brief Floods through all portals in front of the source portal, beginning with the
+ * cluster the source portal leads to.
+ */
+static void FloodVisPortal(vis_portal_t *src) {
+
+	const guint num_portals = vis.portals->len;
+
+	int32_t *stack = Mem_TagMalloc(sizeof(int32_t) * num_portals, MEM_TAG_VIS);
+	int32_t depth = 0;
+
+	stack[depth++] = src->cluster;
+
+	while (depth) {
+		const vis_cluster_t *cluster = &vis.clusters[stack[--depth]];
+
+		for (guint i = 0; i < cluster->portals->len; i++) {
+			const vis_portal_t *p = g_ptr_array_index(cluster->portals, i);
+			const int32_t portal_num = (int32_t) (p - (vis_portal_t *) vis.portals->data);
+
+			if (!VIS_BIT(src->front, portal_num)) {
+				continue;
+			}
+
+			if (VIS_BIT(src->flood, portal_num)) {
+				continue;
+			}
+
+			VIS_SET_BIT(src->flood, portal_num);
+			stack[depth++] = p->cluster;
+		}
+	}
+
+	Mem_Free(stack);
+}
+
+/**
+ * @brief Determines which portals are at least partially in front of the specified portal,
+ * while the specified portal is at least partially behind them. Then floods through them to
+ * produce a conservative set of portals which may be seen through it.
+ */
+static void BaseVis(int32_t portal_num) {
+
+	vis_portal_t *p = &g_array_index(vis.portals, vis_portal_t, portal_num);
+
+	p->front = Mem_TagMalloc(vis.portal_bytes, MEM_TAG_VIS);
+	p->flood = Mem_TagMalloc(vis.portal_bytes, MEM_TAG_VIS);
+
+	for (guint i = 0; i < vis.portals->len; i++) {
+
+		if ((int32_t) i == portal_num) {
+			continue;
+		}
+
+		const vis_portal_t *q = &g_array_index(vis.portals, vis_portal_t, i);
+
+		int32_t j;
+		for (j = 0; j < q->winding->num_points; j++) {
+			if (Vec3_Dot(q->winding->points[j], p->normal) - p->dist > ON_EPSILON) {
+				break;
+			}
+		}
+
+		if (j == q->winding->num_points) {
+			continue; // no points in front
+		}
+
+		for (j = 0; j < p->winding->num_points; j++) {
+			if (Vec3_Dot(p->winding->points[j], q->normal) - q->dist < -ON_EPSILON) {
+				break;
+			}
+		}
+
+		if (j == p->winding->num_points) {
+			continue; // no points behind
+		}
+
+		VIS_SET_BIT(p->front, i);
+	}
+
+	FloodVisPortal(p);
+
+	Mem_Free(p->front);
+	p->front = NULL;
+}
+
+/**
+ * @brief Merges the flooded portals of all portals leading out of the specified cluster
+ * into its potentially visible set.
+ */
+static void ClusterPVS(int32_t cluster_num) {
+
+	const vis_cluster_t *cluster = &vis.clusters[cluster_num];
+
+	byte *portals = Mem_TagMalloc(vis.portal_bytes, MEM_TAG_VIS);
+
+	for (guint i = 0; i < cluster->portals->len; i++) {
+		const vis_portal_t *p = g_ptr_array_index(cluster->portals, i);
+		const int32_t portal_num = (int32_t) (p - (vis_portal_t *) vis.portals->data);
+
+		for (size_t j = 0; j < vis.portal_bytes; j++) {
+			portals[j] |= p->flood[j];
+		}
+
+		VIS_SET_BIT(portals, portal_num);
+	}
+
+	byte *pvs = vis.pvs + cluster_num * vis.cluster_bytes;
+
+	for (guint i = 0; i < vis.portals->len; i++) {
+		if (VIS_BIT(portals, i)) {
+			VIS_SET_BIT(pvs, g_array_index(vis.portals, vis_portal_t, i).cluster);
+		}
+	}
+
+	VIS_SET_BIT(pvs, cluster_num);
+
+	Mem_Free(portals);
+}
+
+/**
+ * @brief The potentially hearable set of a cluster is the union of the potentially visible
+ * sets of all clusters it can see.
+ */
+static void ClusterPHS(int32_t cluster_num) {
+
+	const byte *pvs = vis.pvs + cluster_num * vis.cluster_bytes;
+	byte *phs = vis.phs + cluster_num * vis.cluster_bytes;
+
+	for (int32_t i = 0; i < vis.num_clusters; i++) {
+		if (VIS_BIT(pvs, i)) {
+			const byte *other = vis.pvs + i * vis.cluster_bytes;
+			for (size_t j = 0; j < vis.cluster_bytes; j++) {
+				phs[j] |= other[j];
+			}
+		}
+	}
+}
+
+/**
+ * @brief Frees all vis working memory.
+ */
+static void FreeVis(void) {
+
+	for (guint i = 0; i < vis.portals->len; i++) {
+		Mem_Free(g_array_index(vis.portals, vis_portal_t, i).flood);
+	}
+
+	g_array_free(vis.portals, true);
+
+	for (int32_t i = 0; i < vis.num_clusters; i++) {
+		g_ptr_array_free(vis.clusters[i].portals, true);
+	}
+
+	Mem_Free(vis.clusters);
+
+	memset(&vis, 0, sizeof(vis));
+}
+
+/**
+ * @brief Calculates the potentially visible and potentially hearable sets for all clusters
+ * of the world model, and emits them to the vis lump. This must be called after the clusters
+ * have been numbered and the cluster portals created.
+ */
+void EmitVis(tree_t *tree, int32_t num_clusters) {
+
+	bsp_file.vis_size = 0;
+
+	if (num_clusters == 0) {
+		return;
+	}
+
+	vis.cluster_bytes = (num_clusters + 7) >> 3;
+
+	const size_t size = sizeof(bsp_vis_t) + 2 * num_clusters * vis.cluster_bytes;
+	if (size >= MAX_BSP_VIS_SIZE) {
+		Com_Warn("%d clusters exceeds MAX_BSP_VIS_SIZE, skipping vis\n", num_clusters);
+		return;
+	}
+
+	vis.num_clusters = num_clusters;
+	vis.portals = g_array_new(false, false, sizeof(vis_portal_t));
+
+	GatherVisPortals_r(tree->head_node);
+
+	LinkVisPortals();
+
+	vis.portal_bytes = (vis.portals->len + 7) >> 3;
+
+	Bsp_AllocLump(&bsp_file, BSP_LUMP_VIS, size);
+	memset(bsp_file.vis, 0, size);
+
+	bsp_file.vis_size = (int32_t) size;
+	bsp_file.vis->num_clusters = num_clusters;
+	bsp_file.vis->cluster_bytes = (int32_t) vis.cluster_bytes;
+
+	vis.pvs = (byte *) bsp_file.vis + sizeof(bsp_vis_t);
+	vis.phs = vis.pvs + num_clusters * vis.cluster_bytes;
+
+	Work("Base vis", BaseVis, vis.portals->len);
+	Work("Cluster PVS", ClusterPVS, num_clusters);
+	Work("Cluster PHS", ClusterPHS, num_clusters);
+
+	Com_Verbose("%5i vis portals\n", vis.portals->len);
+
+	FreeVis();
+}
@@ -27,55 +27,51 @@ typedef struct {
 	SDL_mutex *lock; // mutex on all running work
 	const char *name; // the work name
 	WorkFunc func; // the work function
-	int32_t index; // current work cycle
+	SDL_atomic_t done; // completed work cycles
 	int32_t count; // total work cycles
 	int32_t percent; // last fraction of work completed
+	SDL_SpinLock progress; // held while reporting progress
 } work_t;
 
 static work_t work;
 
 /**
- * @brief Return an iteration of work, updating progress when appropriate.
+ * @brief Accounts for completed iterations of work, updating progress when appropriate.
  */
-static int32_t GetWork(void) {
+static void WorkDone(int32_t count) {
 
-	int32_t w = -1;
-	WorkLock();
+	const int32_t done = SDL_AtomicAdd(&work.done, count) + count;
+	const int32_t p = ceilf(100.0 * done / work.count);
 
-	if (Com_WasInit(QUEMAP)) {
-		if (work.index < work.count) {
+	if (p != work.percent && SDL_AtomicTryLock(&work.progress)) {
 
-			// update work percent and output progress
-			const int32_t p = ceilf(100.0 * work.index / work.count);
-			if (p != work.percent) {
-				if (work.name) {
-					Com_Print("\r%-24s [%3d%%]", work.name, p);
-				}
-				work.percent = p;
+		if (p > work.percent) {
+			if (work.name) {
+				Com_Print("\r%-24s [%3d%%]", work.name, p);
 			}
-
-			// assign the next work iteration
-			w = work.index++;
+			work.percent = p;
 		}
-	}
 
-	WorkUnlock();
-	return w;
+		SDL_AtomicUnlock(&work.progress);
+	}
 }
 
 /**
- * @brief Shared work entry point by all threads. Retrieve and perform
- * chunks of work iteratively until work is finished.
+ * @brief JobRangeFunc shared by all threads. Performs a range of work, which the
+ * job system sizes and balances across threads as work is stolen.
  */
-static void RunWorkFunc(void *p) {
+static void RunWorkFunc(int32_t begin, int32_t end, void *data) {
+
+	PROFILE_SCOPE_FINE(work.name ?: "Work");
 
-	while (true) {
-		const int32_t w = GetWork();
-		if (w == -1) {
+	for (int32_t w = begin; w < end; w++) {
+		if (!Com_WasInit(QUEMAP)) {
 			break;
 		}
 		work.func(w);
 	}
+
+	WorkDone(end - begin);
 }
 
 /**
@@ -103,34 +99,46 @@ void Work(const char *name, WorkFunc func, int32_t count) {
 	work.name = name;
 	work.count = count;
 	work.func = func;
-	work.index = 0;
 	work.percent = -1;
 
 	const uint32_t start = SDL_GetTicks();
 
-	const int32_t thread_count = Thread_Count();
-
-	if (thread_count == 0) {
-		RunWorkFunc(0);
-	} else {
-		thread_t *threads[thread_count];
+	PROFILE_SCOPE(name ?: "Work");
 
-		for (int32_t i = 0; i < thread_count; i++) {
-			threads[i] = Thread_Create(RunWorkFunc, NULL, 0);
-		}
-
-		for (int32_t i = 0; i < thread_count; i++) {
-			Thread_Wait(threads[i]);
-		}
-	}
+	Job_ParallelFor(count, 1, RunWorkFunc, NULL);
 
 	SDL_DestroyMutex(work.lock);
 
 	const uint32_t end = SDL_GetTicks();
 
 	if (work.name) {
-		Com_Print(" %d ms\n", end - start);
+		WorkReport(work.name, end - start);
+	}
+}
+
+/**
+ * @brief While set, progress and completion of work are not reported.
+ */
+static SDL_atomic_t work_quiet;
+
+/**
+ * @brief Suppresses progress reporting while work is performed concurrently with other
+ * work, such as when building several trees at once.
+ */
+void WorkQuiet(_Bool quiet) {
+	SDL_AtomicAdd(&work_quiet, quiet ? 1 : -1);
+}
+
+/**
+ * @brief Reports the completion of the named work, which may have been performed serially.
+ */
+void WorkReport(const char *name, uint32_t ms) {
+
+	if (SDL_AtomicGet(&work_quiet)) {
+		return;
 	}
+
+	Com_Print("\r%-24s [100%%] %d ms\n", name, ms);
 }
 
 /**
@@ -142,10 +150,21 @@ void Progress(const char *progress, int32_t percent) {
 	static char *string = "-\\|/-|";
 	static int32_t index = 0;
 	static int32_t last_percent;
+	static SDL_SpinLock lock;
+
+	if (SDL_AtomicGet(&work_quiet)) {
+		return;
+	}
+
+	// progress may be reported from several threads, in which case one suffices
+	if (!SDL_AtomicTryLock(&lock)) {
+		return;
+	}
 
 	if (Mon_IsConnected() && percent != 0 && percent != 100) {
 		static uint32_t last_ticks;
 		if (SDL_GetTicks() - last_ticks < 200) {
+			SDL_AtomicUnlock(&lock);
 			return;
 		}
 		last_ticks = SDL_GetTicks();
@@ -160,4 +179,6 @@ void Progress(const char *progress, int32_t percent) {
 			last_percent = percent;
 		}
 	}
+
+	SDL_AtomicUnlock(&lock);
 }
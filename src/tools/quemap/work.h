@@ -28,4 +28,6 @@ typedef void (*WorkFunc)(int32_t);
 void WorkLock(void);
 void WorkUnlock(void);
 void Work(const char *name, WorkFunc func, int32_t count);
+void WorkQuiet(_Bool quiet);
+void WorkReport(const char *name, uint32_t ms);
 void Progress(const char *name, int32_t percent);
@@ -455,8 +455,12 @@ void EndBSPFile(void) {
 	EmitBrushes();
 	EmitEntities();
 
+	BuildPhongSpatialHash();
+
 	Work("Phong shading", PhongVertex, bsp_file.num_vertexes);
-	
+
+	FreePhongSpatialHash();
+
 	EmitTangents();
 }
 